@@ -0,0 +1,471 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include <vesper_cmcp/vsp_cmcp_client.h>
+#include <vesper_cmcp/vsp_cmcp_server.h>
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_time.h>
+#include <vesper_util/vsp_util.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Number of clients connected to the server if not specified otherwise. */
+#define VSP_BENCH_DEFAULT_CLIENT_COUNT 4
+
+/** Number of round trips per client and configuration if not specified
+ * otherwise. */
+#define VSP_BENCH_DEFAULT_ROUND_TRIPS 1000
+
+/** Time in milliseconds to wait for an echoed message before it is counted as
+ * lost. */
+#define VSP_BENCH_TIMEOUT 1000
+
+/** Command ID of all benchmark messages. */
+#define VSP_BENCH_COMMAND_ID 1
+
+/** Data list item ID of the sequence number identifying echoed messages. */
+#define VSP_BENCH_SEQUENCE_ITEM_ID 0xFFFF
+
+/** Length of a CMCP message header in bytes. */
+#define VSP_BENCH_MESSAGE_HEADER_LENGTH 6
+
+/** Length of a data list item header in bytes for items shorter than
+ * 64 KiB. */
+#define VSP_BENCH_ITEM_HEADER_LENGTH 4
+
+/** Number of benchmarked transports. */
+#define VSP_BENCH_TRANSPORT_COUNT 3
+
+/** Number of benchmarked data list item counts. */
+#define VSP_BENCH_ITEM_COUNT_COUNT 3
+
+/** Number of benchmarked payload sizes. */
+#define VSP_BENCH_PAYLOAD_SIZE_COUNT 5
+
+/** Largest benchmarked payload size in bytes. */
+#define VSP_BENCH_MAX_PAYLOAD_SIZE 16384
+
+/** Transport names, server publish and server subscribe socket addresses. */
+static const char *vsp_bench_transports[VSP_BENCH_TRANSPORT_COUNT][3] = {
+    {"inproc", "inproc://vesper-bench-publish",
+        "inproc://vesper-bench-subscribe"},
+    {"ipc", "ipc:///tmp/vesper-bench-publish.ipc",
+        "ipc:///tmp/vesper-bench-subscribe.ipc"},
+    {"tcp", "tcp://127.0.0.1:7581", "tcp://127.0.0.1:7582"}
+};
+
+/** Number of data list items the payload of a message is split into. */
+static const int vsp_bench_item_counts[VSP_BENCH_ITEM_COUNT_COUNT] =
+    {1, 4, 16};
+
+/** Total payload sizes of a message in bytes. */
+static const int vsp_bench_payload_sizes[VSP_BENCH_PAYLOAD_SIZE_COUNT] =
+    {16, 256, 1024, 4096, VSP_BENCH_MAX_PAYLOAD_SIZE};
+
+/** Data of a benchmark client, owned by its own sending thread. */
+struct vsp_bench_peer {
+    /** CMCP client connected to the benchmark server. */
+    vsp_cmcp_client *cmcp_client;
+    /** Mutex protecting sequence, echoed and time_echoed. */
+    pthread_mutex_t mutex;
+    /** Condition variable signaling echoed messages to the sending thread. */
+    pthread_cond_t echo_condition;
+    /** Sequence number of the message sent last, also referenced by its
+     * data list item. Only changed by the sending thread. */
+    uint32_t sequence;
+    /** Non-zero if the message sent last was echoed. */
+    int echoed;
+    /** Monotonic time in nanoseconds when the message sent last was
+     * echoed. */
+    uint64_t time_echoed;
+    /** Sending thread of this client. */
+    pthread_t thread;
+    /** Measured round trip times in seconds. */
+    double *round_trip_times;
+    /** Number of successful round trips in the current configuration. */
+    int round_trip_count;
+    /** Number of lost messages in the current configuration. */
+    int lost_count;
+};
+
+/** Define type vsp_bench_peer to avoid 'struct' keyword. */
+typedef struct vsp_bench_peer vsp_bench_peer;
+
+/** Parameters of the currently benchmarked configuration. */
+struct vsp_bench_config {
+    /** Number of data list items per message. */
+    int item_count;
+    /** Length of every data list item in bytes. */
+    int item_length;
+    /** Number of round trips per client. */
+    int round_trips;
+};
+
+/** Define type vsp_bench_config to avoid 'struct' keyword. */
+typedef struct vsp_bench_config vsp_bench_config;
+
+/** Currently benchmarked configuration, read by all sending threads. */
+static vsp_bench_config vsp_bench_current_config;
+
+/** Payload data referenced by all data list items. */
+static uint8_t vsp_bench_payload[VSP_BENCH_MAX_PAYLOAD_SIZE];
+
+/** Client announcement callback function accepting all clients. */
+static int vsp_bench_announcement_cb(void *callback_param,
+    uint16_t client_id);
+
+/** Server message callback function echoing every message to its sender. */
+static void vsp_bench_server_message_cb(void *callback_param,
+    uint16_t client_id, uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist);
+
+/** Client message callback function signaling the sending thread. */
+static void vsp_bench_client_message_cb(void *callback_param,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
+
+/** Sending thread of a client running the round trips of a configuration. */
+static void *vsp_bench_run_peer(void *param);
+
+/** Compare two double values, used to sort round trip times. */
+static int vsp_bench_compare_double(const void *a, const void *b);
+
+/** Run all configurations of a transport and print the results.
+ * Returns non-zero and sets vsp_error_num() if failed. */
+static int vsp_bench_run_transport(int transport_index, int client_count,
+    int round_trips);
+
+/** Run a single configuration with all connected clients and print the
+ * results. */
+static void vsp_bench_run_config(const char *transport_name,
+    vsp_bench_peer *peers, int client_count);
+
+int vsp_bench_announcement_cb(void *callback_param, uint16_t client_id)
+{
+    /* accept every client */
+    (void) callback_param;
+    (void) client_id;
+    return 0;
+}
+
+void vsp_bench_server_message_cb(void *callback_param,
+    uint16_t client_id, uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist)
+{
+    int ret;
+
+    /* echo message; the data list is valid until this callback returns */
+    ret = vsp_cmcp_server_send((vsp_cmcp_server*) callback_param, client_id,
+        command_id, cmcp_datalist);
+    /* failures are counted as lost messages by the client */
+    VSP_CHECK(ret == 0, /* failures are silently ignored */);
+}
+
+void vsp_bench_client_message_cb(void *callback_param,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
+{
+    vsp_bench_peer *peer;
+    uint64_t time_echoed;
+    uint32_t sequence;
+    int ret;
+
+    time_echoed = vsp_time_monotonic_nanoseconds();
+    /* ignore foreign messages */
+    VSP_CHECK(command_id == VSP_BENCH_COMMAND_ID, return);
+    ret = vsp_cmcp_datalist_get_u32(cmcp_datalist, VSP_BENCH_SEQUENCE_ITEM_ID,
+        1, &sequence);
+    VSP_CHECK(ret == 0, return);
+
+    peer = (vsp_bench_peer*) callback_param;
+    pthread_mutex_lock(&peer->mutex);
+    /* echoes arriving after their timeout belong to an earlier message */
+    if (sequence == peer->sequence && peer->echoed == 0) {
+        peer->echoed = 1;
+        peer->time_echoed = time_echoed;
+        /* wake up sending thread */
+        pthread_cond_signal(&peer->echo_condition);
+    }
+    pthread_mutex_unlock(&peer->mutex);
+}
+
+void *vsp_bench_run_peer(void *param)
+{
+    vsp_bench_peer *peer;
+    vsp_cmcp_datalist *cmcp_datalist;
+    struct timespec time_timeout;
+    uint64_t time_sent;
+    int echoed;
+    int index;
+    int ret;
+
+    peer = (vsp_bench_peer*) param;
+    peer->round_trip_count = 0;
+    peer->lost_count = 0;
+
+    /* build message payload: all items reference the same payload data */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    VSP_ASSERT(cmcp_datalist != NULL);
+    for (index = 0; index < vsp_bench_current_config.item_count; ++index) {
+        ret = vsp_cmcp_datalist_add_item(cmcp_datalist, index,
+            vsp_bench_current_config.item_length, vsp_bench_payload);
+        VSP_ASSERT(ret == 0);
+    }
+    /* the sequence number is read when sending, so it is never stale */
+    ret = vsp_cmcp_datalist_add_u32(cmcp_datalist, VSP_BENCH_SEQUENCE_ITEM_ID,
+        1, &peer->sequence);
+    VSP_ASSERT(ret == 0);
+
+    for (index = 0; index < vsp_bench_current_config.round_trips; ++index) {
+        /* send message with the next sequence number */
+        pthread_mutex_lock(&peer->mutex);
+        ++peer->sequence;
+        peer->echoed = 0;
+        pthread_mutex_unlock(&peer->mutex);
+        time_sent = vsp_time_monotonic_nanoseconds();
+        ret = vsp_cmcp_client_send(peer->cmcp_client, VSP_BENCH_COMMAND_ID,
+            cmcp_datalist);
+        if (ret != 0) {
+            /* message could not be sent */
+            ++peer->lost_count;
+            continue;
+        }
+
+        /* wait for the echo of this message */
+        vsp_time_real_timespec_from_now(&time_timeout, VSP_BENCH_TIMEOUT);
+        ret = 0;
+        pthread_mutex_lock(&peer->mutex);
+        while (peer->echoed == 0 && ret == 0) {
+            ret = pthread_cond_timedwait(&peer->echo_condition, &peer->mutex,
+                &time_timeout);
+        }
+        echoed = peer->echoed;
+        pthread_mutex_unlock(&peer->mutex);
+        if (echoed == 0) {
+            /* echo timed out */
+            ++peer->lost_count;
+            continue;
+        }
+
+        /* store round trip time; time_echoed is not changed any more */
+        peer->round_trip_times[peer->round_trip_count] =
+            (peer->time_echoed - time_sent) / 1e9;
+        ++peer->round_trip_count;
+    }
+
+    vsp_cmcp_datalist_free(cmcp_datalist);
+    return (void*) 0;
+}
+
+int vsp_bench_compare_double(const void *a, const void *b)
+{
+    double difference;
+
+    difference = *(const double*) a - *(const double*) b;
+    return (difference > 0) - (difference < 0);
+}
+
+void vsp_bench_run_config(const char *transport_name,
+    vsp_bench_peer *peers, int client_count)
+{
+    double *round_trip_times;
+    uint64_t time_start;
+    double time_elapsed;
+    int round_trip_count, lost_count;
+    int message_length;
+    int index;
+    int ret;
+
+    /* start all sending threads at once and wait for them to finish */
+    time_start = vsp_time_monotonic_nanoseconds();
+    for (index = 0; index < client_count; ++index) {
+        ret = pthread_create(&peers[index].thread, NULL, vsp_bench_run_peer,
+            &peers[index]);
+        VSP_ASSERT(ret == 0);
+    }
+    for (index = 0; index < client_count; ++index) {
+        ret = pthread_join(peers[index].thread, NULL);
+        VSP_ASSERT(ret == 0);
+    }
+    time_elapsed = (vsp_time_monotonic_nanoseconds() - time_start) / 1e9;
+
+    /* merge round trip times of all clients */
+    VSP_ALLOC_N(round_trip_times, sizeof(double) * client_count
+        * vsp_bench_current_config.round_trips);
+    round_trip_count = 0;
+    lost_count = 0;
+    for (index = 0; index < client_count; ++index) {
+        memcpy(round_trip_times + round_trip_count,
+            peers[index].round_trip_times,
+            sizeof(double) * peers[index].round_trip_count);
+        round_trip_count += peers[index].round_trip_count;
+        lost_count += peers[index].lost_count;
+    }
+    qsort(round_trip_times, round_trip_count, sizeof(double),
+        vsp_bench_compare_double);
+
+    /* every round trip consists of two messages */
+    message_length = VSP_BENCH_MESSAGE_HEADER_LENGTH
+        + vsp_bench_current_config.item_count
+        * (VSP_BENCH_ITEM_HEADER_LENGTH + vsp_bench_current_config.item_length)
+        + VSP_BENCH_ITEM_HEADER_LENGTH + sizeof(uint32_t);
+    if (round_trip_count > 0) {
+        printf("%-8s %6d %8d %12.0f %10.2f %9.1f %9.1f %9.1f %6d\n",
+            transport_name, vsp_bench_current_config.item_count,
+            vsp_bench_current_config.item_count
+            * vsp_bench_current_config.item_length,
+            2 * round_trip_count / time_elapsed,
+            2.0 * round_trip_count * message_length / time_elapsed
+            / (1024 * 1024),
+            round_trip_times[(int) (0.5 * (round_trip_count - 1))] * 1e6,
+            round_trip_times[(int) (0.99 * (round_trip_count - 1))] * 1e6,
+            round_trip_times[(int) (0.999 * (round_trip_count - 1))] * 1e6,
+            lost_count);
+    } else {
+        printf("%-8s %6d %8d %12s %10s %9s %9s %9s %6d\n",
+            transport_name, vsp_bench_current_config.item_count,
+            vsp_bench_current_config.item_count
+            * vsp_bench_current_config.item_length,
+            "-", "-", "-", "-", "-", lost_count);
+    }
+    fflush(stdout);
+
+    VSP_FREE(round_trip_times);
+}
+
+int vsp_bench_run_transport(int transport_index, int client_count,
+    int round_trips)
+{
+    vsp_cmcp_server *cmcp_server;
+    vsp_bench_peer *peers;
+    int item_index, size_index;
+    int index;
+    int ret;
+    int success;
+
+    success = 0;
+    VSP_ALLOC_N(peers, sizeof(vsp_bench_peer) * client_count);
+    memset(peers, 0, sizeof(vsp_bench_peer) * client_count);
+    for (index = 0; index < client_count; ++index) {
+        ret = pthread_mutex_init(&peers[index].mutex, NULL);
+        VSP_ASSERT(ret == 0);
+        ret = pthread_cond_init(&peers[index].echo_condition, NULL);
+        VSP_ASSERT(ret == 0);
+    }
+
+    /* start echo server */
+    cmcp_server = vsp_cmcp_server_create();
+    VSP_CHECK(cmcp_server != NULL, success = -1; goto cleanup);
+    vsp_cmcp_server_set_callback_param(cmcp_server, cmcp_server);
+    vsp_cmcp_server_set_announcement_cb(cmcp_server,
+        vsp_bench_announcement_cb);
+    vsp_cmcp_server_set_message_cb(cmcp_server, vsp_bench_server_message_cb);
+    ret = vsp_cmcp_server_bind(cmcp_server,
+        vsp_bench_transports[transport_index][1],
+        vsp_bench_transports[transport_index][2]);
+    VSP_CHECK(ret == 0, success = -1; goto cleanup);
+
+    /* connect all clients */
+    for (index = 0; index < client_count; ++index) {
+        VSP_ALLOC_N(peers[index].round_trip_times,
+            sizeof(double) * round_trips);
+        peers[index].cmcp_client = vsp_cmcp_client_create();
+        VSP_CHECK(peers[index].cmcp_client != NULL,
+            success = -1; goto cleanup);
+        vsp_cmcp_client_set_callback_param(peers[index].cmcp_client,
+            &peers[index]);
+        vsp_cmcp_client_set_message_cb(peers[index].cmcp_client,
+            vsp_bench_client_message_cb);
+        ret = vsp_cmcp_client_connect(peers[index].cmcp_client,
+            vsp_bench_transports[transport_index][2],
+            vsp_bench_transports[transport_index][1]);
+        VSP_CHECK(ret == 0, success = -1; goto cleanup);
+    }
+
+    /* sweep data list item counts and payload sizes */
+    vsp_bench_current_config.round_trips = round_trips;
+    for (item_index = 0; item_index < VSP_BENCH_ITEM_COUNT_COUNT;
+        ++item_index) {
+        for (size_index = 0; size_index < VSP_BENCH_PAYLOAD_SIZE_COUNT;
+            ++size_index) {
+            vsp_bench_current_config.item_count =
+                vsp_bench_item_counts[item_index];
+            vsp_bench_current_config.item_length =
+                vsp_bench_payload_sizes[size_index]
+                / vsp_bench_item_counts[item_index];
+            vsp_bench_run_config(vsp_bench_transports[transport_index][0],
+                peers, client_count);
+        }
+    }
+
+    cleanup:
+        /* disconnect clients before stopping the server */
+        for (index = 0; index < client_count; ++index) {
+            if (peers[index].cmcp_client != NULL) {
+                vsp_cmcp_client_free(peers[index].cmcp_client);
+            }
+            pthread_cond_destroy(&peers[index].echo_condition);
+            pthread_mutex_destroy(&peers[index].mutex);
+            if (peers[index].round_trip_times != NULL) {
+                VSP_FREE(peers[index].round_trip_times);
+            }
+        }
+        if (cmcp_server != NULL) {
+            vsp_cmcp_server_free(cmcp_server);
+        }
+        VSP_FREE(peers);
+        /* vsp_error_num() is already set in case of failure */
+        return success;
+}
+
+/**
+ * Run the benchmark over all transports.
+ * Usage: vesper-bench [client_count [round_trips]]
+ */
+int main(int argc, char **argv)
+{
+    int client_count;
+    int round_trips;
+    int index;
+    int ret;
+    int success;
+
+    client_count = VSP_BENCH_DEFAULT_CLIENT_COUNT;
+    round_trips = VSP_BENCH_DEFAULT_ROUND_TRIPS;
+    if (argc > 1) {
+        client_count = atoi(argv[1]);
+    }
+    if (argc > 2) {
+        round_trips = atoi(argv[2]);
+    }
+    VSP_CHECK(client_count > 0 && round_trips > 0,
+        fprintf(stderr, "Usage: %s [client_count [round_trips]]\n", argv[0]);
+        return 1);
+
+    /* fill payload with arbitrary data */
+    for (index = 0; index < VSP_BENCH_MAX_PAYLOAD_SIZE; ++index) {
+        vsp_bench_payload[index] = (uint8_t) index;
+    }
+
+    printf("%d clients, %d round trips per client and configuration\n\n",
+        client_count, round_trips);
+    printf("%-8s %6s %8s %12s %10s %9s %9s %9s %6s\n", "transp.", "items",
+        "payload", "msg/s", "MiB/s", "p50/us", "p99/us", "p999/us", "lost");
+
+    success = 0;
+    for (index = 0; index < VSP_BENCH_TRANSPORT_COUNT; ++index) {
+        ret = vsp_bench_run_transport(index, client_count, round_trips);
+        if (ret != 0) {
+            fprintf(stderr, "%s: %s\n", vsp_bench_transports[index][0],
+                vsp_error_str(vsp_error_num()));
+            success = 1;
+        }
+    }
+    return success;
+}
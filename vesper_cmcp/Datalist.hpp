@@ -0,0 +1,257 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#if !defined DATALIST_HPP_INCLUDED
+#define DATALIST_HPP_INCLUDED
+
+#include "vsp_cmcp_datalist.h"
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace Vesper {
+
+/**
+ * Typed data list functions for values of type T, selected at compile time.
+ * Only specialized for the types supported by the typed vsp_cmcp_datalist
+ * functions, so using other types fails to compile.
+ */
+template<typename T>
+struct DatalistType;
+
+/** Typed data list functions for unsigned 8-bit integers. */
+template<>
+struct DatalistType<uint8_t> {
+    static int add(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, uint8_t *values)
+    {
+        return vsp_cmcp_datalist_add_u8(cmcp_datalist, dataItemId, count,
+            values);
+    }
+    static int get(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, uint8_t *values)
+    {
+        return vsp_cmcp_datalist_get_u8(cmcp_datalist, dataItemId, count,
+            values);
+    }
+};
+
+/** Typed data list functions for unsigned 16-bit integers. */
+template<>
+struct DatalistType<uint16_t> {
+    static int add(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, uint16_t *values)
+    {
+        return vsp_cmcp_datalist_add_u16(cmcp_datalist, dataItemId, count,
+            values);
+    }
+    static int get(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, uint16_t *values)
+    {
+        return vsp_cmcp_datalist_get_u16(cmcp_datalist, dataItemId, count,
+            values);
+    }
+};
+
+/** Typed data list functions for unsigned 32-bit integers. */
+template<>
+struct DatalistType<uint32_t> {
+    static int add(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, uint32_t *values)
+    {
+        return vsp_cmcp_datalist_add_u32(cmcp_datalist, dataItemId, count,
+            values);
+    }
+    static int get(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, uint32_t *values)
+    {
+        return vsp_cmcp_datalist_get_u32(cmcp_datalist, dataItemId, count,
+            values);
+    }
+};
+
+/** Typed data list functions for unsigned 64-bit integers. */
+template<>
+struct DatalistType<uint64_t> {
+    static int add(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, uint64_t *values)
+    {
+        return vsp_cmcp_datalist_add_u64(cmcp_datalist, dataItemId, count,
+            values);
+    }
+    static int get(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, uint64_t *values)
+    {
+        return vsp_cmcp_datalist_get_u64(cmcp_datalist, dataItemId, count,
+            values);
+    }
+};
+
+/** Typed data list functions for 32-bit floating point numbers. */
+template<>
+struct DatalistType<float> {
+    static int add(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, float *values)
+    {
+        return vsp_cmcp_datalist_add_f32(cmcp_datalist, dataItemId, count,
+            values);
+    }
+    static int get(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, float *values)
+    {
+        return vsp_cmcp_datalist_get_f32(cmcp_datalist, dataItemId, count,
+            values);
+    }
+};
+
+/** Typed data list functions for 64-bit floating point numbers. */
+template<>
+struct DatalistType<double> {
+    static int add(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, double *values)
+    {
+        return vsp_cmcp_datalist_add_f64(cmcp_datalist, dataItemId, count,
+            values);
+    }
+    static int get(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+        uint32_t count, double *values)
+    {
+        return vsp_cmcp_datalist_get_f64(cmcp_datalist, dataItemId, count,
+            values);
+    }
+};
+
+/**
+ * Element type and number of elements of a value stored as one data list item.
+ * Single values are stored as items holding one element.
+ */
+template<typename T>
+struct DatalistValue {
+    typedef T Element;
+    static const uint32_t count = 1;
+    static Element *data(T &value)
+    {
+        return &value;
+    }
+};
+
+/** Fixed size arrays are stored as items holding all their elements. */
+template<typename T, std::size_t N>
+struct DatalistValue<T[N]> {
+    typedef T Element;
+    static const uint32_t count = N;
+    static Element *data(T (&value)[N])
+    {
+        return value;
+    }
+};
+
+/**
+ * Add a single value or fixed size array as data list item.
+ * Only a pointer to the value is stored, so it has to be accessible until the
+ * data list is freed.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+template<typename T>
+int datalistAdd(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+    T &value)
+{
+    return DatalistType<typename DatalistValue<T>::Element>::add(
+        cmcp_datalist, dataItemId, DatalistValue<T>::count,
+        DatalistValue<T>::data(value));
+}
+
+/**
+ * Copy a single value or fixed size array from a data list item.
+ * Returns non-zero and sets vsp_error_num() if failed or the item length does
+ * not match the value.
+ */
+template<typename T>
+int datalistGet(vsp_cmcp_datalist *cmcp_datalist, uint16_t dataItemId,
+    T &value)
+{
+    return DatalistType<typename DatalistValue<T>::Element>::get(
+        cmcp_datalist, dataItemId, DatalistValue<T>::count,
+        DatalistValue<T>::data(value));
+}
+
+/**
+ * Member of struct type S stored as data list item with ID dataItemId.
+ * The member has to be a supported value or a fixed size array of them.
+ */
+template<uint16_t dataItemId, typename S, typename T, T S::*member>
+struct DatalistField {
+    static int add(vsp_cmcp_datalist *cmcp_datalist, S &value)
+    {
+        return datalistAdd(cmcp_datalist, dataItemId, value.*member);
+    }
+    static int get(vsp_cmcp_datalist *cmcp_datalist, S &value)
+    {
+        return datalistGet(cmcp_datalist, dataItemId, value.*member);
+    }
+};
+
+/**
+ * Encoding of a struct as data list items, one DatalistField per member.
+ * The list of fields is resolved at compile time, e.g.:
+ *
+ *     struct Pose { double position[3]; uint32_t flags; };
+ *     typedef Vesper::DatalistStruct<
+ *         Vesper::DatalistField<1, Pose, double[3], &Pose::position>,
+ *         Vesper::DatalistField<2, Pose, uint32_t, &Pose::flags> > PoseItems;
+ *     PoseItems::add(cmcp_datalist, pose);
+ *
+ * add() stores pointers to the members, so the struct has to be accessible
+ * until the data list is freed. get() stops at the first missing item.
+ * Both return non-zero and set vsp_error_num() if failed.
+ */
+template<typename... Fields>
+struct DatalistStruct;
+
+/** Encoding of a struct without further members. */
+template<>
+struct DatalistStruct<> {
+    template<typename S>
+    static int add(vsp_cmcp_datalist *, S &)
+    {
+        return 0;
+    }
+    template<typename S>
+    static int get(vsp_cmcp_datalist *, S &)
+    {
+        return 0;
+    }
+};
+
+/** Encoding of the first member followed by the remaining members. */
+template<typename Field, typename... Fields>
+struct DatalistStruct<Field, Fields...> {
+    template<typename S>
+    static int add(vsp_cmcp_datalist *cmcp_datalist, S &value)
+    {
+        int ret = Field::add(cmcp_datalist, value);
+        if (ret != 0) {
+            return ret;
+        }
+        return DatalistStruct<Fields...>::add(cmcp_datalist, value);
+    }
+    template<typename S>
+    static int get(vsp_cmcp_datalist *cmcp_datalist, S &value)
+    {
+        int ret = Field::get(cmcp_datalist, value);
+        if (ret != 0) {
+            return ret;
+        }
+        return DatalistStruct<Fields...>::get(cmcp_datalist, value);
+    }
+};
+
+} /* namespace Vesper */
+
+#endif /* !defined DATALIST_HPP_INCLUDED */
@@ -0,0 +1,73 @@
+/**
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "vsp_cmcp_buffer.h"
+
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
+#include <nanomsg/nn.h>
+
+/** Received message buffer shared by all its references. */
+struct vsp_cmcp_buffer {
+    /** Number of references; the buffer is freed when it drops to zero. */
+    unsigned int reference_count;
+    /** Non-zero if the memory was allocated by nanomsg, otherwise it was
+     * allocated with VSP_ALLOC_N(). */
+    int nanomsg_memory;
+    /** Memory holding the received message. */
+    void *memory;
+};
+
+vsp_cmcp_buffer *vsp_cmcp_buffer_create(void *memory, int nanomsg_memory)
+{
+    vsp_cmcp_buffer *cmcp_buffer;
+
+    /* check parameter */
+    VSP_ASSERT(memory != NULL);
+
+    /* allocate memory */
+    VSP_ALLOC(cmcp_buffer, vsp_cmcp_buffer);
+    /* initialize struct data */
+    cmcp_buffer->reference_count = 1;
+    cmcp_buffer->nanomsg_memory = nanomsg_memory;
+    cmcp_buffer->memory = memory;
+    /* return struct pointer */
+    return cmcp_buffer;
+}
+
+void vsp_cmcp_buffer_retain(vsp_cmcp_buffer *cmcp_buffer)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_buffer != NULL);
+
+    /* the caller holds a reference, so the buffer cannot be freed meanwhile */
+    __atomic_add_fetch(&cmcp_buffer->reference_count, 1, __ATOMIC_RELAXED);
+}
+
+void vsp_cmcp_buffer_free(vsp_cmcp_buffer *cmcp_buffer)
+{
+    int ret;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_buffer != NULL);
+
+    /* the last reference frees the buffer after all others were dropped */
+    if (__atomic_sub_fetch(&cmcp_buffer->reference_count, 1,
+        __ATOMIC_ACQ_REL) > 0) {
+        return;
+    }
+
+    /* free received message, then the buffer object */
+    if (cmcp_buffer->nanomsg_memory) {
+        ret = nn_freemsg(cmcp_buffer->memory);
+        VSP_ASSERT(ret == 0);
+    } else {
+        VSP_FREE(cmcp_buffer->memory);
+    }
+    VSP_FREE(cmcp_buffer);
+}
@@ -0,0 +1,55 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#if !defined VSP_CMCP_BUFFER_H_INCLUDED
+#define VSP_CMCP_BUFFER_H_INCLUDED
+
+#include <vesper_util/vsp_api.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif /* defined __cplusplus */
+
+/** Received message buffer taken over from a message callback function, see
+ * vsp_cmcp_datalist_take_buffer(). Pointers to data list items of the message
+ * stay valid as long as the buffer is referenced.
+ * Buffers are reference counted and may be shared by several threads. */
+struct vsp_cmcp_buffer;
+
+/** Define type vsp_cmcp_buffer to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_buffer vsp_cmcp_buffer;
+
+/**
+ * Add a reference to a vsp_cmcp_buffer object, e.g. before handing it over to
+ * another thread. Every reference has to be dropped with
+ * vsp_cmcp_buffer_free().
+ */
+VSP_API void vsp_cmcp_buffer_retain(vsp_cmcp_buffer *cmcp_buffer);
+
+/**
+ * Drop a reference to a vsp_cmcp_buffer object and free it together with the
+ * received message when the last reference is dropped.
+ * Object should be returned by vsp_cmcp_datalist_take_buffer().
+ */
+VSP_API void vsp_cmcp_buffer_free(vsp_cmcp_buffer *cmcp_buffer);
+
+/* Internal functions used by other CMCP modules, not part of the API. */
+
+/**
+ * Create new vsp_cmcp_buffer object holding one reference to the specified
+ * received message, see vsp_cmcp_datalist_attach_buffer().
+ * Returned pointer should be freed with vsp_cmcp_buffer_free().
+ */
+vsp_cmcp_buffer *vsp_cmcp_buffer_create(void *memory, int nanomsg_memory);
+
+#if defined __cplusplus
+}
+#endif /* defined __cplusplus */
+
+#endif /* !defined VSP_CMCP_BUFFER_H_INCLUDED */
@@ -9,12 +9,15 @@
 #include "vsp_cmcp_client.h"
 #include "vsp_cmcp_command.h"
 #include "vsp_cmcp_node.h"
+#include "vsp_cmcp_queue.h"
 #include "vsp_cmcp_state.h"
+#include "vsp_cmcp_stream.h"
 
 #include <vesper_util/vsp_error.h>
 #include <vesper_util/vsp_random.h>
 #include <vesper_util/vsp_time.h>
 #include <vesper_util/vsp_util.h>
+#include <string.h>
 
 /** vsp_cmcp_node finite state machine flag. */
 typedef enum {
@@ -41,14 +44,35 @@ struct vsp_cmcp_client {
     vsp_cmcp_state *state;
     /** Randomly generated nonce used for temporary node indentification. */
     uint64_t nonce;
+    /** Protocol features supported by the connected server. */
+    uint32_t server_features;
     /** The time when the connection to server times out. */
     struct timespec time_connection_timeout;
     /** Callback function parameter. */
     void *callback_param;
     /** Message callback function. */
     vsp_cmcp_client_message_cb message_cb;
+    /** Capacity of the receive queue, or zero to invoke the message callback
+     * function without queueing messages. */
+    int receive_queue_capacity;
+    /** Queue handing received messages to vsp_cmcp_client_process_messages(),
+     * created on connecting if receive_queue_capacity is positive, or NULL. */
+    vsp_cmcp_queue *receive_queue;
+    /** Message object reused to parse every message popped from the receive
+     * queue, or NULL. */
+    vsp_cmcp_message *queue_message;
     /** Disconnection callback function. */
     vsp_cmcp_client_disconnect_cb disconnect_cb;
+    /** Outgoing and incoming streams. */
+    vsp_cmcp_stream_table *stream_table;
+    /** Stream chunk callback function. */
+    vsp_cmcp_client_stream_cb stream_cb;
+    /** Trace callback function. */
+    vsp_cmcp_trace_cb trace_cb;
+    /** Sequence gap callback function. */
+    vsp_cmcp_gap_cb gap_cb;
+    /** Bit set of joined multicast groups, only accessed atomically. */
+    uint32_t joined_groups[VSP_CMCP_GROUP_COUNT / 32];
 };
 
 /** Connect to server and establish connection using handshake.
@@ -60,15 +84,55 @@ static int vsp_cmcp_client_establish_connection(vsp_cmcp_client *cmcp_client);
  * Returns non-zero and sets vsp_error_num() if failed. */
 static int vsp_cmcp_client_send_announcement(vsp_cmcp_client *cmcp_client);
 
+/** Send a command joining or leaving a multicast group to the server.
+ * Returns non-zero and sets vsp_error_num() if failed. */
+static int vsp_cmcp_client_send_group_command(vsp_cmcp_client *cmcp_client,
+    uint16_t group_id, uint16_t command_id);
+
+/** Unsubscribe from all joined multicast groups, as the server removed the
+ * client from them when the connection was lost. */
+static void vsp_cmcp_client_leave_all_groups(vsp_cmcp_client *cmcp_client);
+
+/** Check if the multicast group is joined. Returns non-zero if it is. */
+static int vsp_cmcp_client_has_joined_group(vsp_cmcp_client *cmcp_client,
+    uint16_t group_id);
+
 /** Regular callback function invoked by cmcp_node.
- * This function will be called regularly. */
-static void vsp_cmcp_client_regular_callback(void *param);
+ * This function will be called regularly.
+ * Returns the number of milliseconds until the connection times out, or -1 if
+ * not connected. */
+static int vsp_cmcp_client_regular_callback(void *param);
 
 /** Message callback function invoked by cmcp_node.
  * This function will be called for every received message. */
 static void vsp_cmcp_client_message_callback(void *param,
     vsp_cmcp_message *cmcp_message);
 
+/** Take the message currently handled by the message callback function and
+ * append it to the receive queue. If the queue is full, the message is
+ * dropped. */
+static void vsp_cmcp_client_queue_message(vsp_cmcp_client *cmcp_client,
+    uint16_t sender_id);
+
+/** Pop and free all messages of the receive queue without handling them. */
+static void vsp_cmcp_client_clear_receive_queue(vsp_cmcp_client *cmcp_client);
+
+/** Trace callback function invoked by cmcp_node.
+ * This function will be called for every received traced message. */
+static void vsp_cmcp_client_trace_callback(void *param,
+    const vsp_cmcp_trace *cmcp_trace);
+
+/** Gap callback function invoked by cmcp_node.
+ * This function will be called for every gap in the sequence numbers of
+ * received traced messages. */
+static void vsp_cmcp_client_gap_callback(void *param, uint16_t sender_id,
+    uint16_t topic_id, uint32_t expected_sequence, uint32_t lost_count);
+
+/** Stream chunk callback function invoked by stream_table.
+ * This function will be called for every received stream chunk. */
+static void vsp_cmcp_client_stream_callback(void *param, uint16_t server_id,
+    uint16_t stream_id, uint32_t chunk_length, void *chunk_data);
+
 /** Handle an internal CMCP control message. */
 void vsp_cmcp_client_handle_control_message(vsp_cmcp_client *cmcp_client,
     uint16_t sender_id, uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
@@ -90,11 +154,32 @@ vsp_cmcp_client *vsp_cmcp_client_create(void)
     /* initialize state struct */
     cmcp_client->state = vsp_cmcp_state_create(VSP_CMCP_CLIENT_DISCONNECTED);
     /* vsp_error_num() is set by vsp_cmcp_state_create() */
-    VSP_CHECK(cmcp_client->state != NULL, VSP_FREE(cmcp_client); return NULL);
+    VSP_CHECK(cmcp_client->state != NULL,
+        vsp_cmcp_node_free(cmcp_client->cmcp_node); VSP_FREE(cmcp_client);
+        return NULL);
+    /* initialize stream table */
+    cmcp_client->stream_table = vsp_cmcp_stream_table_create(
+        cmcp_client->cmcp_node, vsp_cmcp_client_stream_callback, cmcp_client);
+    /* vsp_error_num() is set by vsp_cmcp_stream_table_create() */
+    VSP_CHECK(cmcp_client->stream_table != NULL,
+        vsp_cmcp_state_free(cmcp_client->state);
+        vsp_cmcp_node_free(cmcp_client->cmcp_node); VSP_FREE(cmcp_client);
+        return NULL);
+    /* server features are received when connecting */
+    cmcp_client->server_features = 0;
     /* initialize callback parameter and functions */
     cmcp_client->callback_param = NULL;
     cmcp_client->message_cb = NULL;
     cmcp_client->disconnect_cb = NULL;
+    cmcp_client->stream_cb = NULL;
+    cmcp_client->trace_cb = NULL;
+    cmcp_client->gap_cb = NULL;
+    /* invoke message callback function from reception thread by default */
+    cmcp_client->receive_queue_capacity = 0;
+    cmcp_client->receive_queue = NULL;
+    cmcp_client->queue_message = NULL;
+    /* no multicast groups joined yet */
+    memset(cmcp_client->joined_groups, 0, sizeof(cmcp_client->joined_groups));
     /* return struct pointer */
     return cmcp_client;
 }
@@ -111,14 +196,25 @@ void vsp_cmcp_client_free(vsp_cmcp_client *cmcp_client)
         /* disconnect client from server */
         ret = vsp_cmcp_node_create_send_message(cmcp_client->cmcp_node,
             VSP_CMCP_MESSAGE_TYPE_CONTROL, cmcp_client->server_id,
-            cmcp_client->id, VSP_CMCP_COMMAND_CLIENT_DISCONNECT, NULL);
+            cmcp_client->id, VSP_CMCP_COMMAND_CLIENT_DISCONNECT, NULL, 0);
         /* check for errors */
         VSP_CHECK(ret == 0, /* failures are silently ignored */);
     }
 
+    if (cmcp_client->receive_queue != NULL) {
+        /* stop reception thread, then drop messages not processed yet */
+        vsp_cmcp_node_stop(cmcp_client->cmcp_node);
+        vsp_cmcp_client_clear_receive_queue(cmcp_client);
+        vsp_cmcp_queue_free(cmcp_client->receive_queue);
+        vsp_cmcp_message_free(cmcp_client->queue_message);
+    }
+
     /* free node base type */
     vsp_cmcp_node_free(cmcp_client->cmcp_node);
 
+    /* free stream table */
+    vsp_cmcp_stream_table_free(cmcp_client->stream_table);
+
     /* free state struct */
     vsp_cmcp_state_free(cmcp_client->state);
 
@@ -146,6 +242,182 @@ void vsp_cmcp_client_set_message_cb(vsp_cmcp_client *cmcp_client,
     cmcp_client->message_cb = message_cb;
 }
 
+void vsp_cmcp_client_set_stream_cb(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_client_stream_cb stream_cb)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL, return);
+
+    /* set callback function */
+    cmcp_client->stream_cb = stream_cb;
+}
+
+void vsp_cmcp_client_set_trace_cb(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_trace_cb trace_cb)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL, return);
+
+    /* set callback function; peers are only asked for trace data if set */
+    cmcp_client->trace_cb = trace_cb;
+    vsp_cmcp_node_set_trace_callback(cmcp_client->cmcp_node,
+        trace_cb != NULL ? vsp_cmcp_client_trace_callback : NULL);
+}
+
+void vsp_cmcp_client_set_gap_cb(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_gap_cb gap_cb)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL, return);
+
+    /* set callback function; peers are only asked for trace data if set */
+    cmcp_client->gap_cb = gap_cb;
+    vsp_cmcp_node_set_gap_callback(cmcp_client->cmcp_node,
+        gap_cb != NULL ? vsp_cmcp_client_gap_callback : NULL);
+}
+
+int vsp_cmcp_client_set_receive_batch_size(vsp_cmcp_client *cmcp_client,
+    int batch_size)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL && batch_size > 0,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* set batch size of node base type */
+    vsp_cmcp_node_set_receive_batch_size(cmcp_client->cmcp_node, batch_size);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_client_set_reactor(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_reactor *cmcp_reactor)
+{
+    /* check parameter; reactor may be NULL */
+    VSP_CHECK(cmcp_client != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    /* set reactor of node base type; fails if sockets are initialized */
+    return vsp_cmcp_node_set_reactor(cmcp_client->cmcp_node, cmcp_reactor);
+}
+
+int vsp_cmcp_client_set_receive_queue(vsp_cmcp_client *cmcp_client,
+    int capacity)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL && capacity >= 0,
+        vsp_error_set_num(EINVAL); return -1);
+    /* check if receive queue is not yet created */
+    VSP_CHECK(cmcp_client->receive_queue == NULL,
+        vsp_error_set_num(EALREADY); return -1);
+
+    /* set capacity of receive queue created on connecting */
+    cmcp_client->receive_queue_capacity = capacity;
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_client_get_receive_fd(vsp_cmcp_client *cmcp_client)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL && cmcp_client->receive_queue != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    return vsp_cmcp_queue_get_fd(cmcp_client->receive_queue);
+}
+
+int vsp_cmcp_client_process_messages(vsp_cmcp_client *cmcp_client,
+    int max_count)
+{
+    int count;
+    int data_length;
+    void *message_buffer;
+    uint16_t server_id;
+    vsp_cmcp_datalist *cmcp_datalist;
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL && cmcp_client->receive_queue != NULL
+        && max_count > 0, vsp_error_set_num(EINVAL); return -1);
+
+    for (count = 0; count < max_count; ++count) {
+        ret = vsp_cmcp_queue_pop(cmcp_client->receive_queue, &server_id,
+            &data_length, &message_buffer);
+        if (ret != 0) {
+            /* no more queued messages */
+            break;
+        }
+        /* parse message in place; it was already checked when received */
+        ret = vsp_cmcp_message_parse(cmcp_client->queue_message, data_length,
+            message_buffer);
+        if (ret == 0 && cmcp_client->message_cb != NULL) {
+            /* callback function registered; invoke it, letting it take over
+             * the message buffer */
+            cmcp_datalist =
+                vsp_cmcp_message_get_datalist(cmcp_client->queue_message);
+            vsp_cmcp_datalist_attach_buffer(cmcp_datalist, message_buffer, 1);
+            cmcp_client->message_cb(cmcp_client->callback_param,
+                vsp_cmcp_message_get_command_id(cmcp_client->queue_message),
+                cmcp_datalist);
+            if (vsp_cmcp_datalist_detach_buffer(cmcp_datalist) != 0) {
+                /* message buffer is owned by the callback function now */
+                continue;
+            }
+        }
+        vsp_cmcp_node_free_message(message_buffer);
+    }
+
+    /* keep file descriptor readable if messages are left */
+    vsp_cmcp_queue_acknowledge(cmcp_client->receive_queue);
+
+    return count;
+}
+
+int vsp_cmcp_client_get_receive_queue_stats(vsp_cmcp_client *cmcp_client,
+    int *queued_count, uint64_t *dropped_count)
+{
+    /* check parameters; statistics pointers may be NULL */
+    VSP_CHECK(cmcp_client != NULL && cmcp_client->receive_queue != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    if (queued_count != NULL) {
+        *queued_count = vsp_cmcp_queue_get_count(cmcp_client->receive_queue);
+    }
+    if (dropped_count != NULL) {
+        *dropped_count =
+            vsp_cmcp_queue_get_drop_count(cmcp_client->receive_queue);
+    }
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_client_get_stats(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_stats *cmcp_stats)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL && cmcp_stats != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* copy counters of node base type */
+    vsp_cmcp_node_get_stats(cmcp_client->cmcp_node, cmcp_stats);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_client_get_latency(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_latency_type latency_type, vsp_cmcp_latency *cmcp_latency)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL && cmcp_latency != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* vsp_error_num() is set by vsp_cmcp_node_get_latency() */
+    return vsp_cmcp_node_get_latency(cmcp_client->cmcp_node, latency_type,
+        cmcp_latency);
+}
+
 int vsp_cmcp_client_connect(vsp_cmcp_client *cmcp_client,
     const char *publish_address, const char *subscribe_address)
 {
@@ -161,6 +433,17 @@ int vsp_cmcp_client_connect(vsp_cmcp_client *cmcp_client,
     /* check for errors */
     VSP_CHECK(ret == 0, return -1);
 
+    if (cmcp_client->receive_queue_capacity > 0) {
+        /* create receive queue before messages are received */
+        cmcp_client->receive_queue = vsp_cmcp_queue_create(
+            cmcp_client->receive_queue_capacity);
+        /* in case of failure vsp_error_num() is already set */
+        VSP_ASSERT(cmcp_client->receive_queue != NULL);
+        cmcp_client->queue_message = vsp_cmcp_message_create_view();
+        /* in case of failure vsp_error_num() is already set */
+        VSP_ASSERT(cmcp_client->queue_message != NULL);
+    }
+
     /* start worker thread */
     vsp_cmcp_node_start(cmcp_client->cmcp_node);
 
@@ -185,10 +468,17 @@ int vsp_cmcp_client_send(vsp_cmcp_client *cmcp_client,
     VSP_CHECK(vsp_cmcp_state_get(cmcp_client->state)
         == VSP_CMCP_CLIENT_CONNECTED, vsp_error_set_num(ENOTCONN); return -1);
 
-    /* send message */
+    /* check if server is able to receive large data list items */
+    VSP_CHECK(cmcp_datalist == NULL
+        || vsp_cmcp_datalist_has_large_items(cmcp_datalist) == 0
+        || (cmcp_client->server_features & VSP_CMCP_FEATURE_LARGE_ITEMS) != 0,
+        vsp_error_set_num(EMSGSIZE); return -1);
+
+    /* send message, traced if requested by the server */
     ret = vsp_cmcp_node_create_send_message(cmcp_client->cmcp_node,
         VSP_CMCP_MESSAGE_TYPE_DATA, cmcp_client->id, cmcp_client->id,
-        command_id, cmcp_datalist);
+        command_id, cmcp_datalist,
+        (cmcp_client->server_features & VSP_CMCP_FEATURE_TRACE) != 0);
 
     /* vsp_error_num() is set by vsp_cmcp_node_create_send_message() */
     VSP_CHECK(ret == 0, return -1);
@@ -197,6 +487,215 @@ int vsp_cmcp_client_send(vsp_cmcp_client *cmcp_client,
     return 0;
 }
 
+int vsp_cmcp_client_send_batch(vsp_cmcp_client *cmcp_client,
+    int message_count, const uint16_t *command_ids,
+    vsp_cmcp_datalist **cmcp_datalists)
+{
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL && message_count > 0 && command_ids != NULL
+        && cmcp_datalists != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    /* check connection state */
+    VSP_CHECK(vsp_cmcp_state_get(cmcp_client->state)
+        == VSP_CMCP_CLIENT_CONNECTED, vsp_error_set_num(ENOTCONN); return -1);
+
+    /* send batch message, traced if requested by the server */
+    ret = vsp_cmcp_node_create_send_batch(cmcp_client->cmcp_node,
+        VSP_CMCP_MESSAGE_TYPE_DATA, cmcp_client->id, cmcp_client->id,
+        message_count, command_ids, cmcp_datalists,
+        (cmcp_client->server_features & VSP_CMCP_FEATURE_TRACE) != 0);
+
+    /* vsp_error_num() is set by vsp_cmcp_node_create_send_batch() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* messages sent successfully */
+    return 0;
+}
+
+int vsp_cmcp_client_join_group(vsp_cmcp_client *cmcp_client,
+    uint16_t group_id)
+{
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL && group_id < VSP_CMCP_GROUP_COUNT,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* check connection state */
+    VSP_CHECK(vsp_cmcp_state_get(cmcp_client->state)
+        == VSP_CMCP_CLIENT_CONNECTED, vsp_error_set_num(ENOTCONN); return -1);
+
+    /* subscribe before notifying the server, so no group message is missed
+     * after the server handled the notification */
+    __atomic_fetch_or(&cmcp_client->joined_groups[group_id / 32],
+        (uint32_t) 1 << (group_id % 32), __ATOMIC_RELAXED);
+    vsp_cmcp_node_subscribe(cmcp_client->cmcp_node,
+        VSP_CMCP_GROUP_TOPIC_ID + group_id);
+    ret = vsp_cmcp_client_send_group_command(cmcp_client, group_id,
+        VSP_CMCP_COMMAND_CLIENT_JOIN_GROUP);
+    /* vsp_error_num() is set by vsp_cmcp_client_send_group_command() */
+    VSP_CHECK(ret == 0, vsp_cmcp_node_unsubscribe(cmcp_client->cmcp_node,
+        VSP_CMCP_GROUP_TOPIC_ID + group_id);
+        __atomic_fetch_and(&cmcp_client->joined_groups[group_id / 32],
+        ~((uint32_t) 1 << (group_id % 32)), __ATOMIC_RELAXED); return -1);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_client_leave_group(vsp_cmcp_client *cmcp_client,
+    uint16_t group_id)
+{
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL && group_id < VSP_CMCP_GROUP_COUNT,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* check connection state */
+    VSP_CHECK(vsp_cmcp_state_get(cmcp_client->state)
+        == VSP_CMCP_CLIENT_CONNECTED, vsp_error_set_num(ENOTCONN); return -1);
+
+    /* notify server, then stop receiving group messages */
+    ret = vsp_cmcp_client_send_group_command(cmcp_client, group_id,
+        VSP_CMCP_COMMAND_CLIENT_LEAVE_GROUP);
+    /* vsp_error_num() is set by vsp_cmcp_client_send_group_command() */
+    VSP_CHECK(ret == 0, return -1);
+    vsp_cmcp_node_unsubscribe(cmcp_client->cmcp_node,
+        VSP_CMCP_GROUP_TOPIC_ID + group_id);
+    __atomic_fetch_and(&cmcp_client->joined_groups[group_id / 32],
+        ~((uint32_t) 1 << (group_id % 32)), __ATOMIC_RELAXED);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_client_send_group_command(vsp_cmcp_client *cmcp_client,
+    uint16_t group_id, uint16_t command_id)
+{
+    vsp_cmcp_datalist *cmcp_datalist;
+    int ret;
+
+    /* create data list containing the group ID */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    /* vsp_error_num() is set by vsp_cmcp_datalist_create() */
+    VSP_CHECK(cmcp_datalist != NULL, return -1);
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist,
+        VSP_CMCP_PARAMETER_GROUP_ID, sizeof(group_id), &group_id);
+    /* vsp_error_num() is set by vsp_cmcp_datalist_add_item() */
+    VSP_CHECK(ret == 0, vsp_cmcp_datalist_free(cmcp_datalist); return -1);
+
+    /* send command to the server */
+    ret = vsp_cmcp_node_create_send_message(cmcp_client->cmcp_node,
+        VSP_CMCP_MESSAGE_TYPE_CONTROL, cmcp_client->server_id,
+        cmcp_client->id, command_id, cmcp_datalist, 0);
+    vsp_cmcp_datalist_free(cmcp_datalist);
+    /* vsp_error_num() is set by vsp_cmcp_node_create_send_message() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* success */
+    return 0;
+}
+
+void vsp_cmcp_client_leave_all_groups(vsp_cmcp_client *cmcp_client)
+{
+    int index;
+    uint32_t joined_groups;
+    uint16_t group_id;
+
+    for (index = 0; index < VSP_CMCP_GROUP_COUNT / 32; ++index) {
+        /* clear groups first, so their messages are not handled anymore */
+        joined_groups = __atomic_exchange_n(&cmcp_client->joined_groups[index],
+            0, __ATOMIC_RELAXED);
+        for (group_id = (uint16_t) (index * 32); joined_groups != 0;
+            ++group_id, joined_groups >>= 1) {
+            if ((joined_groups & 1) != 0) {
+                vsp_cmcp_node_unsubscribe(cmcp_client->cmcp_node,
+                    VSP_CMCP_GROUP_TOPIC_ID + group_id);
+            }
+        }
+    }
+}
+
+int vsp_cmcp_client_has_joined_group(vsp_cmcp_client *cmcp_client,
+    uint16_t group_id)
+{
+    return (__atomic_load_n(&cmcp_client->joined_groups[group_id / 32],
+        __ATOMIC_RELAXED) & ((uint32_t) 1 << (group_id % 32))) != 0;
+}
+
+int vsp_cmcp_client_stream_open(vsp_cmcp_client *cmcp_client,
+    uint16_t stream_id)
+{
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    /* check connection state */
+    VSP_CHECK(vsp_cmcp_state_get(cmcp_client->state)
+        == VSP_CMCP_CLIENT_CONNECTED, vsp_error_set_num(ENOTCONN); return -1);
+
+    /* open stream */
+    ret = vsp_cmcp_stream_open(cmcp_client->stream_table,
+        cmcp_client->server_id, stream_id);
+    /* vsp_error_num() is set by vsp_cmcp_stream_open() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_client_stream_push(vsp_cmcp_client *cmcp_client,
+    uint16_t stream_id, uint32_t chunk_length, void *chunk_data)
+{
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL && chunk_length > 0 && chunk_data != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* check connection state */
+    VSP_CHECK(vsp_cmcp_state_get(cmcp_client->state)
+        == VSP_CMCP_CLIENT_CONNECTED, vsp_error_set_num(ENOTCONN); return -1);
+
+    /* check if server is able to receive large chunks */
+    VSP_CHECK(chunk_length < VSP_CMCP_DATALIST_EXTENDED_LENGTH
+        || (cmcp_client->server_features & VSP_CMCP_FEATURE_LARGE_ITEMS) != 0,
+        vsp_error_set_num(EMSGSIZE); return -1);
+
+    /* send chunk, waiting for credit if necessary */
+    ret = vsp_cmcp_stream_push(cmcp_client->stream_table,
+        cmcp_client->server_id, cmcp_client->id, cmcp_client->server_id,
+        stream_id, chunk_length, chunk_data);
+    /* vsp_error_num() is set by vsp_cmcp_stream_push() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_client_stream_close(vsp_cmcp_client *cmcp_client,
+    uint16_t stream_id)
+{
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_client != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    /* close stream, waiting for the server to process all chunks */
+    ret = vsp_cmcp_stream_close(cmcp_client->stream_table,
+        cmcp_client->server_id, cmcp_client->id, cmcp_client->server_id,
+        stream_id);
+    /* vsp_error_num() is set by vsp_cmcp_stream_close() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* success */
+    return 0;
+}
+
 int vsp_cmcp_client_establish_connection(vsp_cmcp_client *cmcp_client)
 {
     int ret;
@@ -224,28 +723,44 @@ int vsp_cmcp_client_establish_connection(vsp_cmcp_client *cmcp_client)
     return 0;
 }
 
-void vsp_cmcp_client_regular_callback(void *param)
+int vsp_cmcp_client_regular_callback(void *param)
 {
     vsp_cmcp_client *cmcp_client;
+    struct timespec time_now;
 
     /* check parameters; failures are silently ignored */
-    VSP_CHECK(param != NULL, return);
+    VSP_CHECK(param != NULL, return -1);
 
     cmcp_client = (vsp_cmcp_client*) param;
 
-    if (vsp_cmcp_state_get(cmcp_client->state) == VSP_CMCP_CLIENT_CONNECTED
-        && vsp_time_real_timespec_passed(
-        &cmcp_client->time_connection_timeout) == 0) {
+    /* no deadline if not connected */
+    VSP_CHECK(vsp_cmcp_state_get(cmcp_client->state)
+        == VSP_CMCP_CLIENT_CONNECTED, return -1);
+
+    vsp_time_real_timespec(&time_now);
+    if (vsp_time_timespec_passed(&cmcp_client->time_connection_timeout,
+        &time_now) == 0) {
         /* connection to server timed out */
+        vsp_cmcp_node_count_timeout(cmcp_client->cmcp_node);
         vsp_cmcp_state_set(cmcp_client->state,
             VSP_CMCP_CLIENT_DISCONNECTED);
+        /* drop incoming streams and wake up blocked stream senders */
+        vsp_cmcp_stream_remove_peer(cmcp_client->stream_table,
+            cmcp_client->server_id);
+        /* stop receiving messages of groups the server removed us from */
+        vsp_cmcp_client_leave_all_groups(cmcp_client);
         /* connection establishment will not be automatically retried */
         /* inform about lost connection by invoking callback function */
         if (cmcp_client->disconnect_cb != NULL) {
             /* callback function registered; invoke it */
             cmcp_client->disconnect_cb(cmcp_client->callback_param);
         }
+        return -1;
     }
+
+    /* return time until connection times out */
+    return (int) vsp_time_timespec_milliseconds_until(
+        &cmcp_client->time_connection_timeout, &time_now);
 }
 
 void vsp_cmcp_client_message_callback(void *param,
@@ -292,11 +807,18 @@ void vsp_cmcp_client_message_callback(void *param,
         vsp_cmcp_client_handle_control_message(cmcp_client, sender_id,
             command_id, cmcp_datalist);
     } else {
-        /* check if message is broadcasted or directed to this node */
+        /* check if message is broadcasted, directed to this node or sent to
+         * a joined multicast group */
         VSP_CHECK(topic_id == VSP_CMCP_SERVER_BROADCAST_TOPIC_ID
-            || topic_id == cmcp_client->id, return);
+            || topic_id == cmcp_client->id
+            || (topic_id >= VSP_CMCP_GROUP_TOPIC_ID
+            && vsp_cmcp_client_has_joined_group(cmcp_client,
+            topic_id - VSP_CMCP_GROUP_TOPIC_ID)), return);
         /* handle data message */
-        if (cmcp_client->message_cb != NULL) {
+        if (cmcp_client->receive_queue != NULL) {
+            /* hand message buffer over to the application thread */
+            vsp_cmcp_client_queue_message(cmcp_client, sender_id);
+        } else if (cmcp_client->message_cb != NULL) {
             /* callback function registered; invoke it */
             cmcp_client->message_cb(cmcp_client->callback_param, command_id,
                 cmcp_datalist);
@@ -304,11 +826,92 @@ void vsp_cmcp_client_message_callback(void *param,
     }
 }
 
+void vsp_cmcp_client_queue_message(vsp_cmcp_client *cmcp_client,
+    uint16_t sender_id)
+{
+    void *message_buffer;
+    int data_length;
+    int ret;
+
+    /* take message buffer without copying it */
+    message_buffer = vsp_cmcp_node_take_message(cmcp_client->cmcp_node,
+        &data_length);
+    ret = vsp_cmcp_queue_push(cmcp_client->receive_queue, sender_id,
+        data_length, message_buffer);
+    if (ret != 0) {
+        /* queue is full: drop message; the drop is counted by the queue */
+        vsp_cmcp_node_free_message(message_buffer);
+    }
+}
+
+void vsp_cmcp_client_clear_receive_queue(vsp_cmcp_client *cmcp_client)
+{
+    void *message_buffer;
+    int data_length;
+    uint16_t server_id;
+
+    while (vsp_cmcp_queue_pop(cmcp_client->receive_queue, &server_id,
+            &data_length, &message_buffer) == 0) {
+        vsp_cmcp_node_free_message(message_buffer);
+    }
+}
+
+void vsp_cmcp_client_trace_callback(void *param,
+    const vsp_cmcp_trace *cmcp_trace)
+{
+    vsp_cmcp_client *cmcp_client;
+
+    /* check parameters; failures are silently ignored */
+    VSP_CHECK(param != NULL && cmcp_trace != NULL, return);
+
+    cmcp_client = (vsp_cmcp_client*) param;
+
+    if (cmcp_client->trace_cb != NULL) {
+        /* callback function registered; invoke it */
+        cmcp_client->trace_cb(cmcp_client->callback_param, cmcp_trace);
+    }
+}
+
+void vsp_cmcp_client_gap_callback(void *param, uint16_t sender_id,
+    uint16_t topic_id, uint32_t expected_sequence, uint32_t lost_count)
+{
+    vsp_cmcp_client *cmcp_client;
+
+    /* check parameter; failures are silently ignored */
+    VSP_CHECK(param != NULL, return);
+
+    cmcp_client = (vsp_cmcp_client*) param;
+
+    if (cmcp_client->gap_cb != NULL) {
+        /* callback function registered; invoke it */
+        cmcp_client->gap_cb(cmcp_client->callback_param, sender_id, topic_id,
+            expected_sequence, lost_count);
+    }
+}
+
+void vsp_cmcp_client_stream_callback(void *param, uint16_t server_id,
+    uint16_t stream_id, uint32_t chunk_length, void *chunk_data)
+{
+    vsp_cmcp_client *cmcp_client;
+
+    cmcp_client = (vsp_cmcp_client*) param;
+
+    /* streams are only accepted from the connected server */
+    (void) server_id;
+
+    if (cmcp_client->stream_cb != NULL) {
+        /* callback function registered; invoke it */
+        cmcp_client->stream_cb(cmcp_client->callback_param, stream_id,
+            chunk_length, chunk_data);
+    }
+}
+
 void vsp_cmcp_client_handle_control_message(vsp_cmcp_client *cmcp_client,
     uint16_t sender_id, uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
 {
     int ret, state;
-    uint64_t *client_nonce;
+    uint64_t client_nonce;
+    uint32_t server_features;
 
     /* get current state */
     state = vsp_cmcp_state_get(cmcp_client->state);
@@ -332,14 +935,19 @@ void vsp_cmcp_client_handle_control_message(vsp_cmcp_client *cmcp_client,
             && (command_id == VSP_CMCP_COMMAND_SERVER_ACK_CLIENT
             || command_id == VSP_CMCP_COMMAND_SERVER_NACK_CLIENT), return);
         /* get client nonce */
-        client_nonce = vsp_cmcp_datalist_get_data_item(cmcp_datalist,
-            VSP_CMCP_PARAMETER_NONCE, sizeof(uint64_t));
+        ret = vsp_cmcp_datalist_get_u64(cmcp_datalist,
+            VSP_CMCP_PARAMETER_NONCE, 1, &client_nonce);
         /* check data list item (nonce); failures are silently ignored */
-        VSP_CHECK(client_nonce != NULL, return);
+        VSP_CHECK(ret == 0, return);
         /* ignore message if nonce does not match the nonce of this node */
-        VSP_CHECK(*client_nonce == cmcp_client->nonce, return);
+        VSP_CHECK(client_nonce == cmcp_client->nonce, return);
 
         if (command_id == VSP_CMCP_COMMAND_SERVER_ACK_CLIENT) {
+            /* get server features; older servers do not send them */
+            ret = vsp_cmcp_datalist_get_u32(cmcp_datalist,
+                VSP_CMCP_PARAMETER_FEATURES, 1, &server_features);
+            cmcp_client->server_features = (ret == 0
+                ? server_features : 0) & VSP_CMCP_FEATURES;
             /* acknowledge received, connected */
             vsp_cmcp_state_set(cmcp_client->state, VSP_CMCP_CLIENT_CONNECTED);
             /* initialize timeout time */
@@ -348,14 +956,26 @@ void vsp_cmcp_client_handle_control_message(vsp_cmcp_client *cmcp_client,
                 VSP_CMCP_NODE_CONNECTION_TIMEOUT);
         } else if (command_id == VSP_CMCP_COMMAND_SERVER_NACK_CLIENT) {
             /* negative acknowledge received, rejected */
+            vsp_cmcp_node_count_nack(cmcp_client->cmcp_node);
             vsp_cmcp_state_set(cmcp_client->state,
                 VSP_CMCP_CLIENT_TRYING_TO_CONNECT);
-            /* client ID is already registered to server; regenerate node ID */
+            /* client ID is already registered to server; regenerate node ID
+             * and receive messages directed to the new ID instead */
+            vsp_cmcp_node_unsubscribe(cmcp_client->cmcp_node, cmcp_client->id);
             vsp_cmcp_node_generate_id(cmcp_client->cmcp_node);
             cmcp_client->id = vsp_cmcp_node_get_id(cmcp_client->cmcp_node);
+            vsp_cmcp_node_subscribe(cmcp_client->cmcp_node, cmcp_client->id);
             /* connection establishment will be automatically retried when next
              * server heartbeat signal is received */
         }
+    } else if (state == VSP_CMCP_CLIENT_CONNECTED
+        && sender_id == cmcp_client->server_id
+        && command_id >= VSP_CMCP_COMMAND_STREAM_CHUNK
+        && command_id <= VSP_CMCP_COMMAND_STREAM_CREDIT) {
+        /* stream message received from connected server */
+        vsp_cmcp_stream_handle_message(cmcp_client->stream_table,
+            cmcp_client->server_id, cmcp_client->id, sender_id, command_id,
+            cmcp_datalist);
     }
 }
 
@@ -363,10 +983,12 @@ int vsp_cmcp_client_send_announcement(vsp_cmcp_client *cmcp_client)
 {
     int ret;
     int success;
+    uint32_t features;
     vsp_cmcp_datalist *cmcp_datalist;
 
     /* initialize local variables */
     success = 0;
+    features = vsp_cmcp_node_get_features(cmcp_client->cmcp_node);
     cmcp_datalist = NULL;
 
     /* create identification nonce */
@@ -381,10 +1003,15 @@ int vsp_cmcp_client_send_announcement(vsp_cmcp_client *cmcp_client)
         sizeof(uint64_t), &cmcp_client->nonce);
     /* vsp_error_num() is set by vsp_cmcp_datalist_add_item() */
     VSP_CHECK(ret == 0, goto error_exit);
+    /* add supported protocol features as a data list item */
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist,
+        VSP_CMCP_PARAMETER_FEATURES, sizeof(uint32_t), &features);
+    /* vsp_error_num() is set by vsp_cmcp_datalist_add_item() */
+    VSP_CHECK(ret == 0, goto error_exit);
     /* send message */
     ret = vsp_cmcp_node_create_send_message(cmcp_client->cmcp_node,
         VSP_CMCP_MESSAGE_TYPE_CONTROL, cmcp_client->server_id, cmcp_client->id,
-        VSP_CMCP_COMMAND_CLIENT_ANNOUNCE, cmcp_datalist);
+        VSP_CMCP_COMMAND_CLIENT_ANNOUNCE, cmcp_datalist, 0);
     /* vsp_error_num() is set by vsp_cmcp_node_create_send_message() */
     VSP_CHECK(ret == 0, goto error_exit);
 
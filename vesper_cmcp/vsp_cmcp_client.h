@@ -11,6 +11,8 @@
 #define VSP_CMCP_CLIENT_H_INCLUDED
 
 #include "vsp_cmcp_datalist.h"
+#include "vsp_cmcp_reactor.h"
+#include "vsp_cmcp_stats.h"
 
 #include <vesper_util/vsp_api.h>
 #include <stdint.h>
@@ -35,6 +37,13 @@ typedef void (*vsp_cmcp_client_message_cb)(void*, uint16_t, vsp_cmcp_datalist*);
  * vsp_cmcp_client_set_callback_param(). */
 typedef void (*vsp_cmcp_client_disconnect_cb)(void*);
 
+/** Callback function invoked for every received stream chunk.
+ * The parameters are the callback parameter set by
+ * vsp_cmcp_client_set_callback_param(), the stream ID, the chunk length and
+ * the chunk data. The end of a stream is signaled by chunk length zero and
+ * chunk data NULL. */
+typedef void (*vsp_cmcp_client_stream_cb)(void*, uint16_t, uint32_t, void*);
+
 /**
  * Create new vsp_cmcp_client object.
  * Returned pointer should be freed with vsp_cmcp_client_free().
@@ -69,6 +78,129 @@ VSP_API void vsp_cmcp_client_set_message_cb(vsp_cmcp_client *cmcp_client,
 VSP_API void vsp_cmcp_client_set_disconnect_cb(vsp_cmcp_client *cmcp_client,
     vsp_cmcp_client_disconnect_cb disconnect_cb);
 
+/**
+ * Set callback function invoked for every received stream chunk.
+ * Chunks of a stream are passed in order, followed by the end of the stream.
+ * If stream_cb is NULL, the callback function is cleared and received chunks
+ * are dropped; flow control credit is returned to the sender anyway.
+ */
+VSP_API void vsp_cmcp_client_set_stream_cb(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_client_stream_cb stream_cb);
+
+/**
+ * Set callback function invoked with the send time and sequence number of
+ * every received data message, see vsp_cmcp_trace.
+ * Only if this or the gap callback function is set, the server is asked to
+ * wrap its data messages with trace data, which costs 18 bytes per message.
+ * This is negotiated when connecting, so the callback function should be set
+ * before vsp_cmcp_client_connect().
+ * If trace_cb is NULL, the callback function is cleared.
+ */
+VSP_API void vsp_cmcp_client_set_trace_cb(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_trace_cb trace_cb);
+
+/**
+ * Set callback function invoked when the sequence numbers of data messages
+ * received from the server skip one or more numbers, see vsp_cmcp_gap_cb.
+ * Gaps are counted in vsp_cmcp_stats with or without callback function, but
+ * only detected if the server wraps its data messages with trace data, i.e.
+ * if this or the trace callback function is set before
+ * vsp_cmcp_client_connect().
+ * If gap_cb is NULL, the callback function is cleared.
+ */
+VSP_API void vsp_cmcp_client_set_gap_cb(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_gap_cb gap_cb);
+
+/**
+ * Set maximum number of messages received in a batch by the internal message
+ * reception thread before heartbeats and the connection timeout are handled
+ * again. Larger batches reduce the overhead per message under high load.
+ * The default value is 64 (VSP_CMCP_NODE_DEFAULT_RECEIVE_BATCH_SIZE).
+ * This function should be called before vsp_cmcp_client_connect().
+ * Returns non-zero and sets vsp_error_num() if batch_size is not positive.
+ */
+VSP_API int vsp_cmcp_client_set_receive_batch_size(
+    vsp_cmcp_client *cmcp_client, int batch_size);
+
+/**
+ * Receive messages in a thread of the specified reactor instead of an own
+ * internal message reception thread. Many servers and clients can share the
+ * threads of one reactor. The reactor must not be freed before this client.
+ * Callback functions of all nodes of a reactor thread are invoked from that
+ * thread, so they should return quickly. They may bind, connect and free
+ * other servers and clients of the same reactor, but must not free this
+ * client.
+ * This function has to be called before vsp_cmcp_client_connect().
+ * cmcp_reactor may be NULL to use an own reception thread.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_client_set_reactor(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_reactor *cmcp_reactor);
+
+/**
+ * Hand received messages over to an application thread instead of invoking
+ * the message callback function from the reception thread.
+ * Received message buffers are appended to a bounded lock-free queue without
+ * copying them. The application waits until the file descriptor returned by
+ * vsp_cmcp_client_get_receive_fd() is readable, e.g. with poll(), and calls
+ * vsp_cmcp_client_process_messages() to invoke the message callback function
+ * for queued messages. If the queue is full, further messages are dropped and
+ * counted, see vsp_cmcp_client_get_receive_queue_stats(). The disconnection
+ * callback function is still invoked from the reception thread, possibly
+ * before all queued messages were processed.
+ * capacity is rounded up to a power of two. The default value is 0, invoking
+ * the message callback function from the reception thread.
+ * This function has to be called before vsp_cmcp_client_connect().
+ * Returns non-zero and sets vsp_error_num() if capacity is negative or the
+ * queue is already created.
+ */
+VSP_API int vsp_cmcp_client_set_receive_queue(vsp_cmcp_client *cmcp_client,
+    int capacity);
+
+/**
+ * Get file descriptor that is readable while messages are queued.
+ * The file descriptor must only be used for waiting, not for reading.
+ * Returns -1 and sets vsp_error_num() if no receive queue is used.
+ */
+VSP_API int vsp_cmcp_client_get_receive_fd(vsp_cmcp_client *cmcp_client);
+
+/**
+ * Invoke the message callback function for at most max_count queued messages
+ * in the calling thread. Must not be called by several threads at once.
+ * Returns the number of processed messages, or -1 and sets vsp_error_num()
+ * if no receive queue is used or max_count is not positive.
+ */
+VSP_API int vsp_cmcp_client_process_messages(vsp_cmcp_client *cmcp_client,
+    int max_count);
+
+/**
+ * Get the number of currently queued messages and the number of messages
+ * dropped so far because the receive queue was full.
+ * queued_count and dropped_count may be NULL.
+ * Returns non-zero and sets vsp_error_num() if no receive queue is used.
+ */
+VSP_API int vsp_cmcp_client_get_receive_queue_stats(
+    vsp_cmcp_client *cmcp_client, int *queued_count, uint64_t *dropped_count);
+
+/**
+ * Get a snapshot of the message and connection counters of this client.
+ * May be called from any thread at any time.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_client_get_stats(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_stats *cmcp_stats);
+
+/**
+ * Get percentiles of the durations of handling received messages or of
+ * sending messages, depending on latency_type. A slow message callback
+ * function shows up in the handling durations before it delays heartbeats
+ * long enough to let peers time out.
+ * May be called from any thread at any time.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_client_get_latency(vsp_cmcp_client *cmcp_client,
+    vsp_cmcp_latency_type latency_type, vsp_cmcp_latency *cmcp_latency);
+
 /**
  * Initialize sockets and establish connection.
  * An internal message reception thread is started.
@@ -86,6 +218,72 @@ VSP_API int vsp_cmcp_client_connect(vsp_cmcp_client *cmcp_client,
 VSP_API int vsp_cmcp_client_send(vsp_cmcp_client *cmcp_client,
     uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
 
+/**
+ * Send several messages to the connected server, packed into a single network
+ * message. The server receives them as separate messages in the same order.
+ * message_count command IDs and data lists are read from the specified arrays;
+ * data list entries may be NULL. Each data list has to be shorter than 64 KiB.
+ * The specified command IDs have to be lower than 2^15, i.e. MSB cleared.
+ * This function blocks until the message could be sent.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_client_send_batch(vsp_cmcp_client *cmcp_client,
+    int message_count, const uint16_t *command_ids,
+    vsp_cmcp_datalist **cmcp_datalists);
+
+/**
+ * Join a multicast group of the connected server, so that messages the
+ * server sends to the group using vsp_cmcp_server_send_group() are received
+ * like messages sent to this client. group_id has to be lower than 256.
+ * The server is notified asynchronously; messages sent to the group before
+ * the server handled the notification may be missed. All groups are left
+ * when the connection to the server times out, as the server removes timed
+ * out clients from their groups.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_client_join_group(vsp_cmcp_client *cmcp_client,
+    uint16_t group_id);
+
+/**
+ * Leave a multicast group joined with vsp_cmcp_client_join_group().
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_client_leave_group(vsp_cmcp_client *cmcp_client,
+    uint16_t group_id);
+
+/**
+ * Open a stream to the connected server, used to transfer a large payload as
+ * a sequence of chunks without buffering all of it.
+ * The stream ID is chosen by the caller and has to be unused for this client.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_client_stream_open(vsp_cmcp_client *cmcp_client,
+    uint16_t stream_id);
+
+/**
+ * Send the next chunk of an open stream to the connected server.
+ * This function blocks while the server has not yet processed too many
+ * previously sent chunks, so the memory used by a stream stays bounded.
+ * It must not be called from a callback function of this client: credit is
+ * received by the thread invoking the callbacks, so waiting would block it
+ * until the connection times out.
+ * If the connection times out, waiting is stopped and this function fails;
+ * the stream still has to be closed.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_client_stream_push(vsp_cmcp_client *cmcp_client,
+    uint16_t stream_id, uint32_t chunk_length, void *chunk_data);
+
+/**
+ * Close an open stream to the connected server.
+ * This function blocks until the server processed all chunks.
+ * It must not be called from a callback function of this client, for the
+ * same reason as vsp_cmcp_client_stream_push().
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_client_stream_close(vsp_cmcp_client *cmcp_client,
+    uint16_t stream_id);
+
 #if defined __cplusplus
 }
 #endif /* defined __cplusplus */
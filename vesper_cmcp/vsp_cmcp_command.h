@@ -21,7 +21,8 @@ typedef enum {
     /** Server heartbeat signal command. No parameters required. */
     VSP_CMCP_COMMAND_SERVER_HEARTBEAT,
     /** Acknowledge signal when registering a new client.
-     * Parameters: VSP_CMCP_PARAMETER_NONCE. */
+     * Parameters: VSP_CMCP_PARAMETER_NONCE, VSP_CMCP_PARAMETER_FEATURES
+     * (optional). */
     VSP_CMCP_COMMAND_SERVER_ACK_CLIENT,
     /** Negative acknowledge when rejecting a new client.
      * Parameters: VSP_CMCP_PARAMETER_NONCE. */
@@ -33,23 +34,106 @@ typedef enum {
  * Necessary data list parameters have to be listed here. */
 typedef enum {
     /** Command to announce client connection to server.
-     * Parameters: VSP_CMCP_PARAMETER_NONCE. */
+     * Parameters: VSP_CMCP_PARAMETER_NONCE, VSP_CMCP_PARAMETER_FEATURES
+     * (optional). */
     VSP_CMCP_COMMAND_CLIENT_ANNOUNCE,
     /** Client heartbeat signal command. No parameters required. */
     VSP_CMCP_COMMAND_CLIENT_HEARTBEAT,
     /** Client disconnection command. No parameters required. */
-    VSP_CMCP_COMMAND_CLIENT_DISCONNECT
+    VSP_CMCP_COMMAND_CLIENT_DISCONNECT,
+    /** Command to receive data messages sent to a multicast group.
+     * The client subscribes to the group topic before sending it.
+     * Parameters: VSP_CMCP_PARAMETER_GROUP_ID. */
+    VSP_CMCP_COMMAND_CLIENT_JOIN_GROUP,
+    /** Command to stop receiving data messages sent to a multicast group.
+     * Parameters: VSP_CMCP_PARAMETER_GROUP_ID. */
+    VSP_CMCP_COMMAND_CLIENT_LEAVE_GROUP
 } vsp_cmcp_client_command_id;
 
+/** Internal message commands handled by the node base type of servers and
+ * clients, used to frame other messages. These commands are reserved at the
+ * upper end of the command ID range and are never passed to the server or
+ * client message handlers. */
+typedef enum {
+    /** Several messages packed into a single control message.
+     * The message header is followed by records, each consisting of 2 bytes
+     * command ID (including message type flag), 2 bytes data list length and
+     * the data list. Records use topic and sender ID of the batch message. */
+    VSP_CMCP_COMMAND_NODE_BATCH = 0x7fff,
+    /** Another message prefixed with its send time and sequence number.
+     * The message header is followed by a trace header, see
+     * VSP_CMCP_MESSAGE_TRACE_HEADER_LENGTH, and the complete traced message
+     * including its own header. Only sent to peers requesting
+     * VSP_CMCP_FEATURE_TRACE. */
+    VSP_CMCP_COMMAND_NODE_TRACE = 0x7ffe
+} vsp_cmcp_node_command_id;
+
+/** Internal message commands used by servers and clients to transfer streams
+ * of chunks with credit-based flow control, see vsp_cmcp_stream.h.
+ * These commands are reserved below the node commands and are never passed to
+ * the server or client message handlers. */
+typedef enum {
+    /** Next chunk of a stream.
+     * Parameters: VSP_CMCP_PARAMETER_STREAM_ID,
+     * VSP_CMCP_PARAMETER_STREAM_SEQUENCE (chunk index starting at zero),
+     * VSP_CMCP_PARAMETER_STREAM_CHUNK_LENGTH,
+     * VSP_CMCP_PARAMETER_STREAM_CHUNK. */
+    VSP_CMCP_COMMAND_STREAM_CHUNK = 0x7ff0,
+    /** End of a stream.
+     * Parameters: VSP_CMCP_PARAMETER_STREAM_ID,
+     * VSP_CMCP_PARAMETER_STREAM_SEQUENCE (number of chunks sent). */
+    VSP_CMCP_COMMAND_STREAM_CLOSE,
+    /** Receiver has processed chunks and grants credit for more.
+     * Parameters: VSP_CMCP_PARAMETER_STREAM_ID,
+     * VSP_CMCP_PARAMETER_STREAM_SEQUENCE (number of chunks processed). */
+    VSP_CMCP_COMMAND_STREAM_CREDIT
+} vsp_cmcp_stream_command_id;
+
 /** Internal message command parameters used for CMCP handshake as well as
  * connection establishment and maintaining.
  * The data type and size (in bytes) has to be specified. */
 typedef enum {
     /** A randomly generated nonce used for temporary node indentification.
      * Type: uint64_t. Size: 8 bytes. */
-    VSP_CMCP_PARAMETER_NONCE
+    VSP_CMCP_PARAMETER_NONCE,
+    /** Protocol features supported by the sending node, a combination of
+     * vsp_cmcp_feature_flag values. Nodes not sending this parameter support
+     * none of them. Type: uint32_t. Size: 4 bytes. */
+    VSP_CMCP_PARAMETER_FEATURES,
+    /** Stream identifier chosen by the sending node.
+     * Type: uint16_t. Size: 2 bytes. */
+    VSP_CMCP_PARAMETER_STREAM_ID,
+    /** Stream chunk sequence number or chunk count.
+     * Type: uint32_t. Size: 4 bytes. */
+    VSP_CMCP_PARAMETER_STREAM_SEQUENCE,
+    /** Length of VSP_CMCP_PARAMETER_STREAM_CHUNK.
+     * Type: uint32_t. Size: 4 bytes. */
+    VSP_CMCP_PARAMETER_STREAM_CHUNK_LENGTH,
+    /** Stream chunk data.
+     * Type: binary. Size: VSP_CMCP_PARAMETER_STREAM_CHUNK_LENGTH bytes. */
+    VSP_CMCP_PARAMETER_STREAM_CHUNK,
+    /** Multicast group number lower than VSP_CMCP_GROUP_COUNT; messages to
+     * the group use topic ID VSP_CMCP_GROUP_TOPIC_ID plus this number.
+     * Type: uint16_t. Size: 2 bytes. */
+    VSP_CMCP_PARAMETER_GROUP_ID
 } vsp_cmcp_command_parameter_id;
 
+/** Optional protocol features negotiated during CMCP handshake.
+ * Features may only be used when the peer announced support for them. */
+typedef enum {
+    /** Data list items of VSP_CMCP_DATALIST_EXTENDED_LENGTH bytes or more,
+     * stored using the extended item length encoding. */
+    VSP_CMCP_FEATURE_LARGE_ITEMS = 1,
+    /** Data messages sent to the announcing node wrapped into
+     * VSP_CMCP_COMMAND_NODE_TRACE messages. Only announced by nodes having a
+     * trace callback function. */
+    VSP_CMCP_FEATURE_TRACE = 2
+} vsp_cmcp_feature_flag;
+
+/** Protocol features supported by this implementation. */
+#define VSP_CMCP_FEATURES ((uint32_t) (VSP_CMCP_FEATURE_LARGE_ITEMS \
+    | VSP_CMCP_FEATURE_TRACE))
+
 #if defined __cplusplus
 }
 #endif /* defined __cplusplus */
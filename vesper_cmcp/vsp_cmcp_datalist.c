@@ -14,16 +14,68 @@
 
 /** State and other data used for network connection. */
 struct vsp_cmcp_datalist {
-    /** Data list item IDs. */
-    uint16_t data_item_ids[VSP_CMCP_DATALIST_MAX_ITEMS];
-    /** Data list item lengths. */
-    uint16_t data_item_lengths[VSP_CMCP_DATALIST_MAX_ITEMS];
-    /** Data list item data pointers. */
-    void *data_item_pointers[VSP_CMCP_DATALIST_MAX_ITEMS];
+    /** Inline storage of data list item data pointers. */
+    void *inline_item_pointers[VSP_CMCP_DATALIST_INLINE_ITEMS];
+    /** Inline storage of data list item lengths. */
+    uint32_t inline_item_lengths[VSP_CMCP_DATALIST_INLINE_ITEMS];
+    /** Inline storage of data list item IDs. */
+    uint16_t inline_item_ids[VSP_CMCP_DATALIST_INLINE_ITEMS];
+    /** Data list item data pointers, in inline storage or arena. */
+    void **data_item_pointers;
+    /** Data list item lengths, in inline storage or arena. */
+    uint32_t *data_item_lengths;
+    /** Data list item IDs, in inline storage or arena. */
+    uint16_t *data_item_ids;
+    /** Open addressing hash index over item IDs, storing item index + 1 per
+     * slot and zero for empty slots. NULL while inline storage is used. */
+    uint16_t *data_item_index;
+    /** Memory block holding item arrays and hash index of grown data lists.
+     * NULL while inline storage is used. Kept when the list is cleared. */
+    void *arena;
+    /** Number of items that fit into the current storage. */
+    int data_item_capacity;
     /** Number of stored data list items. */
-    uint16_t data_item_count;
+    int data_item_count;
+    /** Number of items using the extended length encoding. */
+    int large_item_count;
+    /** Length of the binary data array storing all list items, updated
+     * whenever an item is added. */
+    int data_length;
+    /** Received message the items point into while it is passed to a message
+     * callback function, or NULL. */
+    void *buffer_memory;
+    /** Non-zero if buffer_memory was allocated by nanomsg. */
+    int buffer_nanomsg_memory;
+    /** Buffer object created when the message is taken over first, or NULL.
+     * The data list holds one reference until the buffer is detached. */
+    vsp_cmcp_buffer *cmcp_buffer;
 };
 
+/** Add data list item holding count values of value_size bytes each.
+ * Returns non-zero and sets vsp_error_num() if failed. */
+static int vsp_cmcp_datalist_add_values(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint32_t value_size, void *values);
+
+/** Copy count values of value_size bytes each of a data list item to values.
+ * Returns non-zero and sets vsp_error_num() if failed. */
+static int vsp_cmcp_datalist_get_values(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint32_t value_size, void *values);
+
+/** Remove all items without releasing grown storage. */
+static void vsp_cmcp_datalist_clear(vsp_cmcp_datalist *cmcp_datalist);
+
+/** Double item capacity, moving all items to a new arena and rebuilding the
+ * hash index. */
+static void vsp_cmcp_datalist_grow(vsp_cmcp_datalist *cmcp_datalist);
+
+/** Get the first hash index slot to probe for the specified item ID. */
+static int vsp_cmcp_datalist_hash(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id);
+
+/** Store the item at the specified index in the hash index. */
+static void vsp_cmcp_datalist_index_item(vsp_cmcp_datalist *cmcp_datalist,
+    int index);
+
 /** Search for a specific data list item by its ID.
  * Returns item index if found and -1 else. */
 static int vsp_cmcp_datalist_find_item(vsp_cmcp_datalist *cmcp_datalist,
@@ -34,8 +86,18 @@ vsp_cmcp_datalist *vsp_cmcp_datalist_create(void)
     vsp_cmcp_datalist *cmcp_datalist;
     /* allocate memory */
     VSP_ALLOC(cmcp_datalist, vsp_cmcp_datalist);
-    /* initialize struct data: set number of list items to zero */
-    cmcp_datalist->data_item_count = 0;
+    /* initialize struct data: use inline storage */
+    cmcp_datalist->data_item_pointers = cmcp_datalist->inline_item_pointers;
+    cmcp_datalist->data_item_ids = cmcp_datalist->inline_item_ids;
+    cmcp_datalist->data_item_lengths = cmcp_datalist->inline_item_lengths;
+    cmcp_datalist->data_item_index = NULL;
+    cmcp_datalist->arena = NULL;
+    cmcp_datalist->data_item_capacity = VSP_CMCP_DATALIST_INLINE_ITEMS;
+    cmcp_datalist->buffer_memory = NULL;
+    cmcp_datalist->buffer_nanomsg_memory = 0;
+    cmcp_datalist->cmcp_buffer = NULL;
+    /* set number of list items to zero */
+    vsp_cmcp_datalist_clear(cmcp_datalist);
     /* return struct pointer */
     return cmcp_datalist;
 }
@@ -46,26 +108,47 @@ void vsp_cmcp_datalist_free(vsp_cmcp_datalist *cmcp_datalist)
     VSP_CHECK(cmcp_datalist != NULL, return);
 
     /* free memory */
+    if (cmcp_datalist->arena != NULL) {
+        VSP_FREE(cmcp_datalist->arena);
+    }
     VSP_FREE(cmcp_datalist);
 }
 
-vsp_cmcp_datalist *vsp_cmcp_datalist_create_parse(uint16_t data_length,
+vsp_cmcp_datalist *vsp_cmcp_datalist_create_parse(uint32_t data_length,
     void *data_pointer)
 {
     int ret;
-    uint16_t data_item_id;
-    uint16_t data_item_length;
-    void *data_item_pointer;
-    /* using byte pointer for safe pointer arithmetic */
-    uint8_t *current_data_pointer;
     vsp_cmcp_datalist *cmcp_datalist;
 
     /* check parameter */
     VSP_CHECK(data_pointer != NULL, vsp_error_set_num(EINVAL); return NULL);
     /* allocate memory */
-    VSP_ALLOC(cmcp_datalist, vsp_cmcp_datalist);
-    /* initialize struct data: set number of list items to zero */
-    cmcp_datalist->data_item_count = 0;
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    /* vsp_error_num() is set by vsp_cmcp_datalist_create() */
+    VSP_CHECK(cmcp_datalist != NULL, return NULL);
+    /* parse data list items */
+    ret = vsp_cmcp_datalist_parse(cmcp_datalist, data_length, data_pointer);
+    /* vsp_error_num() is set by vsp_cmcp_datalist_parse() */
+    VSP_CHECK(ret == 0, vsp_cmcp_datalist_free(cmcp_datalist); return NULL);
+    /* return struct pointer */
+    return cmcp_datalist;
+}
+
+int vsp_cmcp_datalist_parse(vsp_cmcp_datalist *cmcp_datalist,
+    uint32_t data_length, void *data_pointer)
+{
+    int ret;
+    uint16_t data_item_id;
+    uint32_t data_item_length;
+    void *data_item_pointer;
+    /* using byte pointer for safe pointer arithmetic */
+    uint8_t *current_data_pointer;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_datalist != NULL && data_pointer != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+    /* clear struct data, keeping grown storage for reuse */
+    vsp_cmcp_datalist_clear(cmcp_datalist);
     /* add data list items */
     current_data_pointer = data_pointer;
     while (data_length >= 4) {
@@ -77,6 +160,16 @@ vsp_cmcp_datalist *vsp_cmcp_datalist_create_parse(uint16_t data_length,
         current_data_pointer += 2;
         data_length -= 2;
 
+        /* extended item length: 4 bytes length follow */
+        if (data_item_length == VSP_CMCP_DATALIST_EXTENDED_LENGTH) {
+            if (data_length < 4) {
+                break;
+            }
+            memcpy(&data_item_length, current_data_pointer, 4);
+            current_data_pointer += 4;
+            data_length -= 4;
+        }
+
         /* check if as much data available as specified in data_item_length */
         if (data_length < data_item_length) {
             break;
@@ -91,36 +184,24 @@ vsp_cmcp_datalist *vsp_cmcp_datalist_create_parse(uint16_t data_length,
             data_item_length, data_item_pointer);
         VSP_CHECK(ret == 0, /* failures are silently ignored */);
     }
-    /* return struct pointer */
-    return cmcp_datalist;
+    /* success */
+    return 0;
 }
 
 int vsp_cmcp_datalist_get_data_length(vsp_cmcp_datalist *cmcp_datalist)
 {
-    /* max. 64 KiB of data allowed */
-    uint16_t data_length;
-    uint16_t index;
-
     /* check parameter */
     VSP_CHECK(cmcp_datalist != NULL, vsp_error_set_num(EINVAL); return -1);
 
-    data_length = 0;
-    /* calculate data length */
-    for (index = 0; index < cmcp_datalist->data_item_count; ++index) {
-        /* 2 bytes per data item id and length */
-        data_length += 4;
-        /* additional bytes per data item */
-        data_length += cmcp_datalist->data_item_lengths[index];
-    }
-
-    return data_length;
+    /* data length is accumulated when adding items */
+    return cmcp_datalist->data_length;
 }
 
 int vsp_cmcp_datalist_get_data(vsp_cmcp_datalist *cmcp_datalist,
     void *data_pointer)
 {
-    uint16_t index;
-    uint16_t data_item_length;
+    int index;
+    uint32_t data_item_length;
     /* using byte pointer for safe pointer arithmetic */
     uint8_t *current_data_pointer;
 
@@ -136,8 +217,17 @@ int vsp_cmcp_datalist_get_data(vsp_cmcp_datalist *cmcp_datalist,
         current_data_pointer += 2;
 
         data_item_length = cmcp_datalist->data_item_lengths[index];
-        *(uint16_t*) current_data_pointer = data_item_length;
-        current_data_pointer += 2;
+        if (data_item_length < VSP_CMCP_DATALIST_EXTENDED_LENGTH) {
+            *(uint16_t*) current_data_pointer = (uint16_t) data_item_length;
+            current_data_pointer += 2;
+        } else {
+            /* extended item length: marker followed by 4 bytes length */
+            *(uint16_t*) current_data_pointer =
+                VSP_CMCP_DATALIST_EXTENDED_LENGTH;
+            current_data_pointer += 2;
+            memcpy(current_data_pointer, &data_item_length, 4);
+            current_data_pointer += 4;
+        }
 
         if (data_item_length > 0) {
             memcpy(current_data_pointer,
@@ -151,7 +241,7 @@ int vsp_cmcp_datalist_get_data(vsp_cmcp_datalist *cmcp_datalist,
 }
 
 int vsp_cmcp_datalist_add_item(vsp_cmcp_datalist *cmcp_datalist,
-    uint16_t data_item_id, uint16_t data_item_length, void *data_item_pointer)
+    uint16_t data_item_id, uint32_t data_item_length, void *data_item_pointer)
 {
     /* check parameters */
     VSP_CHECK(cmcp_datalist != NULL && data_item_pointer != NULL,
@@ -161,24 +251,55 @@ int vsp_cmcp_datalist_add_item(vsp_cmcp_datalist *cmcp_datalist,
     VSP_CHECK(cmcp_datalist->data_item_count < VSP_CMCP_DATALIST_MAX_ITEMS,
         vsp_error_set_num(ENOMEM); return -1);
 
+    /* check total data length; item needs up to 8 bytes header */
+    VSP_CHECK(cmcp_datalist->data_length
+        <= VSP_CMCP_DATALIST_MAX_DATA_LENGTH - 8
+        && data_item_length <= (uint32_t) (VSP_CMCP_DATALIST_MAX_DATA_LENGTH
+        - 8 - cmcp_datalist->data_length),
+        vsp_error_set_num(EMSGSIZE); return -1);
+
     /* check data list item was not added yet */
     VSP_CHECK(vsp_cmcp_datalist_find_item(cmcp_datalist, data_item_id) == -1,
         vsp_error_set_num(EALREADY); return -1);
 
+    /* make room for another item */
+    if (cmcp_datalist->data_item_count == cmcp_datalist->data_item_capacity) {
+        vsp_cmcp_datalist_grow(cmcp_datalist);
+    }
+
     /* add data list item */
     cmcp_datalist->data_item_ids[cmcp_datalist->data_item_count] = data_item_id;
     cmcp_datalist->data_item_lengths[cmcp_datalist->data_item_count] =
         data_item_length;
     cmcp_datalist->data_item_pointers[cmcp_datalist->data_item_count] =
         data_item_pointer;
+    if (cmcp_datalist->data_item_index != NULL) {
+        vsp_cmcp_datalist_index_item(cmcp_datalist,
+            cmcp_datalist->data_item_count);
+    }
     ++cmcp_datalist->data_item_count;
+    /* 2 bytes per data item id and length, additional bytes per data item */
+    cmcp_datalist->data_length += 4 + data_item_length;
+    if (data_item_length >= VSP_CMCP_DATALIST_EXTENDED_LENGTH) {
+        /* 4 more bytes for extended item length */
+        cmcp_datalist->data_length += 4;
+        ++cmcp_datalist->large_item_count;
+    }
 
     /* success */
     return 0;
 }
 
+int vsp_cmcp_datalist_has_large_items(vsp_cmcp_datalist *cmcp_datalist)
+{
+    /* check parameter */
+    VSP_CHECK(cmcp_datalist != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    return cmcp_datalist->large_item_count > 0;
+}
+
 void *vsp_cmcp_datalist_get_data_item(vsp_cmcp_datalist *cmcp_datalist,
-    uint16_t data_item_id, uint16_t data_item_length)
+    uint16_t data_item_id, uint32_t data_item_length)
 {
     int index;
 
@@ -199,16 +320,300 @@ void *vsp_cmcp_datalist_get_data_item(vsp_cmcp_datalist *cmcp_datalist,
     return cmcp_datalist->data_item_pointers[index];
 }
 
-int vsp_cmcp_datalist_find_item(vsp_cmcp_datalist *cmcp_datalist,
+int vsp_cmcp_datalist_get_item_length(vsp_cmcp_datalist *cmcp_datalist,
     uint16_t data_item_id)
 {
     int index;
 
+    /* check parameter */
+    VSP_CHECK(cmcp_datalist != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    /* search for data ID */
+    index = vsp_cmcp_datalist_find_item(cmcp_datalist, data_item_id);
+    VSP_CHECK(index != -1, vsp_error_set_num(EINVAL); return -1);
+
+    /* item lengths are limited by the maximum data length */
+    return (int) cmcp_datalist->data_item_lengths[index];
+}
+
+int vsp_cmcp_datalist_add_values(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint32_t value_size, void *values)
+{
+    /* check parameters; other parameters are checked when adding the item */
+    VSP_CHECK(count > 0 && count <= UINT32_MAX / value_size && values != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* vsp_error_num() is set by vsp_cmcp_datalist_add_item() */
+    return vsp_cmcp_datalist_add_item(cmcp_datalist, data_item_id,
+        count * value_size, values);
+}
+
+int vsp_cmcp_datalist_get_values(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint32_t value_size, void *values)
+{
+    void *data_item_pointer;
+
+    /* check parameters */
+    VSP_CHECK(count > 0 && count <= UINT32_MAX / value_size && values != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* get item of matching length */
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist,
+        data_item_id, count * value_size);
+    /* vsp_error_num() is set by vsp_cmcp_datalist_get_data_item() */
+    VSP_CHECK(data_item_pointer != NULL, return -1);
+
+    /* item data is not aligned, so copy it instead of dereferencing it */
+    memcpy(values, data_item_pointer, count * value_size);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_datalist_add_u8(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint8_t *values)
+{
+    return vsp_cmcp_datalist_add_values(cmcp_datalist, data_item_id, count,
+        sizeof(uint8_t), values);
+}
+
+int vsp_cmcp_datalist_get_u8(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint8_t *values)
+{
+    return vsp_cmcp_datalist_get_values(cmcp_datalist, data_item_id, count,
+        sizeof(uint8_t), values);
+}
+
+int vsp_cmcp_datalist_add_u16(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint16_t *values)
+{
+    return vsp_cmcp_datalist_add_values(cmcp_datalist, data_item_id, count,
+        sizeof(uint16_t), values);
+}
+
+int vsp_cmcp_datalist_get_u16(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint16_t *values)
+{
+    return vsp_cmcp_datalist_get_values(cmcp_datalist, data_item_id, count,
+        sizeof(uint16_t), values);
+}
+
+int vsp_cmcp_datalist_add_u32(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint32_t *values)
+{
+    return vsp_cmcp_datalist_add_values(cmcp_datalist, data_item_id, count,
+        sizeof(uint32_t), values);
+}
+
+int vsp_cmcp_datalist_get_u32(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint32_t *values)
+{
+    return vsp_cmcp_datalist_get_values(cmcp_datalist, data_item_id, count,
+        sizeof(uint32_t), values);
+}
+
+int vsp_cmcp_datalist_add_u64(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint64_t *values)
+{
+    return vsp_cmcp_datalist_add_values(cmcp_datalist, data_item_id, count,
+        sizeof(uint64_t), values);
+}
+
+int vsp_cmcp_datalist_get_u64(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint64_t *values)
+{
+    return vsp_cmcp_datalist_get_values(cmcp_datalist, data_item_id, count,
+        sizeof(uint64_t), values);
+}
+
+int vsp_cmcp_datalist_add_f32(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, float *values)
+{
+    return vsp_cmcp_datalist_add_values(cmcp_datalist, data_item_id, count,
+        sizeof(float), values);
+}
+
+int vsp_cmcp_datalist_get_f32(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, float *values)
+{
+    return vsp_cmcp_datalist_get_values(cmcp_datalist, data_item_id, count,
+        sizeof(float), values);
+}
+
+int vsp_cmcp_datalist_add_f64(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, double *values)
+{
+    return vsp_cmcp_datalist_add_values(cmcp_datalist, data_item_id, count,
+        sizeof(double), values);
+}
+
+int vsp_cmcp_datalist_get_f64(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, double *values)
+{
+    return vsp_cmcp_datalist_get_values(cmcp_datalist, data_item_id, count,
+        sizeof(double), values);
+}
+
+vsp_cmcp_buffer *vsp_cmcp_datalist_take_buffer(
+    vsp_cmcp_datalist *cmcp_datalist)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_datalist != NULL && cmcp_datalist->buffer_memory != NULL,
+        vsp_error_set_num(EINVAL); return NULL);
+
+    if (cmcp_datalist->cmcp_buffer == NULL) {
+        /* first taker: wrap received message, owned by the data list until
+         * it is detached */
+        cmcp_datalist->cmcp_buffer = vsp_cmcp_buffer_create(
+            cmcp_datalist->buffer_memory,
+            cmcp_datalist->buffer_nanomsg_memory);
+    }
+    /* add reference of the caller */
+    vsp_cmcp_buffer_retain(cmcp_datalist->cmcp_buffer);
+    return cmcp_datalist->cmcp_buffer;
+}
+
+void vsp_cmcp_datalist_attach_buffer(vsp_cmcp_datalist *cmcp_datalist,
+    void *buffer_memory, int nanomsg_memory)
+{
+    /* check parameters */
+    VSP_ASSERT(cmcp_datalist != NULL && buffer_memory != NULL
+        && cmcp_datalist->buffer_memory == NULL);
+
+    /* buffer object is only created if the message is taken over */
+    cmcp_datalist->buffer_memory = buffer_memory;
+    cmcp_datalist->buffer_nanomsg_memory = nanomsg_memory;
+}
+
+int vsp_cmcp_datalist_detach_buffer(vsp_cmcp_datalist *cmcp_datalist)
+{
+    vsp_cmcp_buffer *cmcp_buffer;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_datalist != NULL
+        && cmcp_datalist->buffer_memory != NULL);
+
+    cmcp_buffer = cmcp_datalist->cmcp_buffer;
+    cmcp_datalist->buffer_memory = NULL;
+    cmcp_datalist->cmcp_buffer = NULL;
+    if (cmcp_buffer == NULL) {
+        /* message was not taken over */
+        return 0;
+    }
+    /* drop reference of the data list; the last taker frees the message */
+    vsp_cmcp_buffer_free(cmcp_buffer);
+    return 1;
+}
+
+void vsp_cmcp_datalist_clear(vsp_cmcp_datalist *cmcp_datalist)
+{
+    cmcp_datalist->data_item_count = 0;
+    cmcp_datalist->large_item_count = 0;
+    cmcp_datalist->data_length = 0;
+    if (cmcp_datalist->data_item_index != NULL) {
+        /* two index slots per item */
+        memset(cmcp_datalist->data_item_index, 0,
+            2 * cmcp_datalist->data_item_capacity * sizeof(uint16_t));
+    }
+}
+
+void vsp_cmcp_datalist_grow(vsp_cmcp_datalist *cmcp_datalist)
+{
+    int capacity;
+    int index;
+    void *arena;
+    void **data_item_pointers;
+    uint32_t *data_item_lengths;
+    uint16_t *data_item_ids;
+
+    capacity = 2 * cmcp_datalist->data_item_capacity;
+    /* arena layout ordered by alignment: pointers, lengths, IDs and
+     * two index slots per item to keep the index at most half full */
+    VSP_ALLOC_N(arena, capacity * (sizeof(void*) + sizeof(uint32_t)
+        + 3 * sizeof(uint16_t)));
+    data_item_pointers = arena;
+    data_item_lengths = (uint32_t*) (data_item_pointers + capacity);
+    data_item_ids = (uint16_t*) (data_item_lengths + capacity);
+
+    /* move items to new arena */
+    memcpy(data_item_pointers, cmcp_datalist->data_item_pointers,
+        cmcp_datalist->data_item_count * sizeof(void*));
+    memcpy(data_item_ids, cmcp_datalist->data_item_ids,
+        cmcp_datalist->data_item_count * sizeof(uint16_t));
+    memcpy(data_item_lengths, cmcp_datalist->data_item_lengths,
+        cmcp_datalist->data_item_count * sizeof(uint32_t));
+    if (cmcp_datalist->arena != NULL) {
+        VSP_FREE(cmcp_datalist->arena);
+    }
+    cmcp_datalist->arena = arena;
+    cmcp_datalist->data_item_pointers = data_item_pointers;
+    cmcp_datalist->data_item_ids = data_item_ids;
+    cmcp_datalist->data_item_lengths = data_item_lengths;
+    cmcp_datalist->data_item_index = data_item_ids + capacity;
+    cmcp_datalist->data_item_capacity = capacity;
+
+    /* rebuild hash index */
+    memset(cmcp_datalist->data_item_index, 0,
+        2 * capacity * sizeof(uint16_t));
     for (index = 0; index < cmcp_datalist->data_item_count; ++index) {
+        vsp_cmcp_datalist_index_item(cmcp_datalist, index);
+    }
+}
+
+int vsp_cmcp_datalist_hash(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id)
+{
+    /* multiplicative hashing spreads sequential IDs over the index; the
+     * number of index slots is a power of two */
+    return (int) ((data_item_id * 40503UL) >> 3)
+        & (2 * cmcp_datalist->data_item_capacity - 1);
+}
+
+void vsp_cmcp_datalist_index_item(vsp_cmcp_datalist *cmcp_datalist,
+    int index)
+{
+    int slot;
+    int mask;
+
+    mask = 2 * cmcp_datalist->data_item_capacity - 1;
+    slot = vsp_cmcp_datalist_hash(cmcp_datalist,
+        cmcp_datalist->data_item_ids[index]);
+    /* linear probing; the index is never full */
+    while (cmcp_datalist->data_item_index[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    cmcp_datalist->data_item_index[slot] = (uint16_t) (index + 1);
+}
+
+int vsp_cmcp_datalist_find_item(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id)
+{
+    int index;
+    int slot;
+    int mask;
+
+    if (cmcp_datalist->data_item_index == NULL) {
+        /* small inline list: linear search is fastest */
+        for (index = 0; index < cmcp_datalist->data_item_count; ++index) {
+            if (cmcp_datalist->data_item_ids[index] == data_item_id) {
+                /* data ID found */
+                return index;
+            }
+        }
+        /* data ID not found */
+        return -1;
+    }
+
+    mask = 2 * cmcp_datalist->data_item_capacity - 1;
+    slot = vsp_cmcp_datalist_hash(cmcp_datalist, data_item_id);
+    /* probe until an empty slot is reached */
+    while (cmcp_datalist->data_item_index[slot] != 0) {
+        index = cmcp_datalist->data_item_index[slot] - 1;
         if (cmcp_datalist->data_item_ids[index] == data_item_id) {
             /* data ID found */
             return index;
         }
+        slot = (slot + 1) & mask;
     }
 
     /* data ID not found */
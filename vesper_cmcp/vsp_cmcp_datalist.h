@@ -10,6 +10,8 @@
 #if !defined VSP_CMCP_DATALIST_H_INCLUDED
 #define VSP_CMCP_DATALIST_H_INCLUDED
 
+#include "vsp_cmcp_buffer.h"
+
 #include <vesper_util/vsp_api.h>
 #include <stdint.h>
 
@@ -18,7 +20,22 @@ extern "C" {
 #endif /* defined __cplusplus */
 
 /** Maximum number of items per data list */
-#define VSP_CMCP_DATALIST_MAX_ITEMS 16
+#define VSP_CMCP_DATALIST_MAX_ITEMS 16384
+
+/** Number of items stored inside the data list object itself. Lists with at
+ * most this many items need no further memory allocation and are searched
+ * linearly; larger lists are moved to a growing memory block with a hash index
+ * over item IDs. */
+#define VSP_CMCP_DATALIST_INLINE_ITEMS 16
+
+/** Maximum length of the binary data array storing all list items. */
+#define VSP_CMCP_DATALIST_MAX_DATA_LENGTH 0x7fff0000
+
+/** Item length field value marking an extended item length.
+ * Items of at least this length are stored with 2 bytes ID, 2 bytes marker and
+ * 4 bytes length. Peers have to support VSP_CMCP_FEATURE_LARGE_ITEMS to receive
+ * such items. */
+#define VSP_CMCP_DATALIST_EXTENDED_LENGTH 0xffff
 
 /**
  * Data list storing any number of data list items.
@@ -51,11 +68,24 @@ VSP_API void vsp_cmcp_datalist_free(vsp_cmcp_datalist *cmcp_datalist);
  * Returned pointer should be freed with vsp_cmcp_datalist_free().
  * Returns NULL and sets vsp_error_num() if failed.
  */
-VSP_API vsp_cmcp_datalist *vsp_cmcp_datalist_create_parse(uint16_t data_length,
+VSP_API vsp_cmcp_datalist *vsp_cmcp_datalist_create_parse(uint32_t data_length,
     void *data_pointer);
 
 /**
- * Calculate necessary length of a binary data array storing all list items.
+ * Clear vsp_cmcp_datalist object and fill it with items parsed from binary
+ * data. This allows reusing a data list object for every received message
+ * without allocating memory.
+ * The data will not be copied and only pointers to it are stored, so the data
+ * has to be accessible as long as the data list items are used.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_datalist_parse(vsp_cmcp_datalist *cmcp_datalist,
+    uint32_t data_length, void *data_pointer);
+
+/**
+ * Get necessary length of a binary data array storing all list items.
+ * The length is accumulated while adding items, so this function does not
+ * iterate over the data list.
  * Returns negative value and sets vsp_error_num() if failed.
  */
 VSP_API int vsp_cmcp_datalist_get_data_length(vsp_cmcp_datalist *cmcp_datalist);
@@ -73,19 +103,137 @@ VSP_API int vsp_cmcp_datalist_get_data(vsp_cmcp_datalist *cmcp_datalist,
  * Add a data list item to the data list.
  * The data will not be copied and only a pointer to it is stored, so the data
  * has to be accessible until vsp_cmcp_datalist_free() is called.
+ * Adding an item takes constant time on average, including the check for
+ * duplicate item IDs.
  * Returns non-zero and sets vsp_error_num() if failed.
  */
 VSP_API int vsp_cmcp_datalist_add_item(vsp_cmcp_datalist *cmcp_datalist,
-    uint16_t data_item_id, uint16_t data_item_length, void *data_item_pointer);
+    uint16_t data_item_id, uint32_t data_item_length, void *data_item_pointer);
+
+/**
+ * Check if the data list contains items using the extended length encoding,
+ * i.e. items of at least VSP_CMCP_DATALIST_EXTENDED_LENGTH bytes.
+ * Returns negative value and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_datalist_has_large_items(vsp_cmcp_datalist *cmcp_datalist);
 
 /**
  * Get pointer to data stored in the data list.
  * The data should be immediately copied for further use, as no accessibility of
  * the data can be guaranteed after vsp_cmcp_datalist_free() was called.
+ * Data of a received message stays accessible after the message callback
+ * function returned if the message is taken over with
+ * vsp_cmcp_datalist_take_buffer().
  * Returns NULL and sets vsp_error_num() if failed or length does not match.
  */
 VSP_API void *vsp_cmcp_datalist_get_data_item(vsp_cmcp_datalist *cmcp_datalist,
-    uint16_t data_item_id, uint16_t data_item_length);
+    uint16_t data_item_id, uint32_t data_item_length);
+
+/**
+ * Get the data length of a data list item in bytes, e.g. to find the number of
+ * values of an array item.
+ * Returns negative value and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_datalist_get_item_length(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id);
+
+/*
+ * Typed data list items.
+ * The following functions add and read items holding count values of a fixed
+ * size type, i.e. a single value if count is 1 or an array otherwise. Values
+ * are stored in host byte order without padding, like items added with
+ * vsp_cmcp_datalist_add_item().
+ * Adding an item stores a pointer to the values, which have to be accessible
+ * until vsp_cmcp_datalist_free() is called.
+ * Reading an item copies exactly count values to the specified array, so the
+ * item data may be stored at any offset of a received message and the copied
+ * values are naturally aligned. Reading fails if the item length does not
+ * match count values.
+ * Return non-zero and set vsp_error_num() if failed.
+ */
+
+/** Add data list item holding count unsigned 8-bit integers. */
+VSP_API int vsp_cmcp_datalist_add_u8(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint8_t *values);
+
+/** Copy count unsigned 8-bit integers of a data list item to values. */
+VSP_API int vsp_cmcp_datalist_get_u8(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint8_t *values);
+
+/** Add data list item holding count unsigned 16-bit integers. */
+VSP_API int vsp_cmcp_datalist_add_u16(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint16_t *values);
+
+/** Copy count unsigned 16-bit integers of a data list item to values. */
+VSP_API int vsp_cmcp_datalist_get_u16(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint16_t *values);
+
+/** Add data list item holding count unsigned 32-bit integers. */
+VSP_API int vsp_cmcp_datalist_add_u32(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint32_t *values);
+
+/** Copy count unsigned 32-bit integers of a data list item to values. */
+VSP_API int vsp_cmcp_datalist_get_u32(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint32_t *values);
+
+/** Add data list item holding count unsigned 64-bit integers. */
+VSP_API int vsp_cmcp_datalist_add_u64(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint64_t *values);
+
+/** Copy count unsigned 64-bit integers of a data list item to values. */
+VSP_API int vsp_cmcp_datalist_get_u64(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, uint64_t *values);
+
+/** Add data list item holding count 32-bit floating point numbers. */
+VSP_API int vsp_cmcp_datalist_add_f32(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, float *values);
+
+/** Copy count 32-bit floating point numbers of a data list item to values. */
+VSP_API int vsp_cmcp_datalist_get_f32(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, float *values);
+
+/** Add data list item holding count 64-bit floating point numbers. */
+VSP_API int vsp_cmcp_datalist_add_f64(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, double *values);
+
+/** Copy count 64-bit floating point numbers of a data list item to values. */
+VSP_API int vsp_cmcp_datalist_get_f64(vsp_cmcp_datalist *cmcp_datalist,
+    uint16_t data_item_id, uint32_t count, double *values);
+
+/**
+ * Take over the received message a data list passed to a message callback
+ * function points into, so that pointers returned by
+ * vsp_cmcp_datalist_get_data_item() stay valid after the callback function
+ * returned. The message is not copied. Has to be called from the message
+ * callback function; the data list itself must not be used afterwards.
+ * Every call adds a reference, e.g. for each record of a batch message sharing
+ * the same buffer; every reference has to be dropped with
+ * vsp_cmcp_buffer_free().
+ * Returns NULL and sets vsp_error_num() if failed or the data list does not
+ * belong to a received message.
+ */
+VSP_API vsp_cmcp_buffer *vsp_cmcp_datalist_take_buffer(
+    vsp_cmcp_datalist *cmcp_datalist);
+
+/* Internal functions used by other CMCP modules, not part of the API. */
+
+/**
+ * Let message callback functions take over the received message the data list
+ * items point into with vsp_cmcp_datalist_take_buffer(), until
+ * vsp_cmcp_datalist_detach_buffer() is called.
+ * buffer_memory has to be allocated by nanomsg if nanomsg_memory is non-zero,
+ * otherwise with VSP_ALLOC_N().
+ */
+void vsp_cmcp_datalist_attach_buffer(vsp_cmcp_datalist *cmcp_datalist,
+    void *buffer_memory, int nanomsg_memory);
+
+/**
+ * Detach the received message attached with vsp_cmcp_datalist_attach_buffer()
+ * after the message callback functions returned.
+ * Returns non-zero if the message was taken over; it is freed with its last
+ * buffer reference then. Otherwise the caller still has to free it.
+ */
+int vsp_cmcp_datalist_detach_buffer(vsp_cmcp_datalist *cmcp_datalist);
 
 #if defined __cplusplus
 }
@@ -0,0 +1,306 @@
+/**
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "vsp_cmcp_dispatch.h"
+
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
+#include <pthread.h>
+
+/** Queued message. The serialized data list follows the struct in memory. */
+struct vsp_cmcp_dispatch_item {
+    /** Next queued message of the same worker, or NULL. */
+    struct vsp_cmcp_dispatch_item *next;
+    /** Sender ID. */
+    uint16_t sender_id;
+    /** Command ID. */
+    uint16_t command_id;
+    /** Non-zero if a data list follows the struct. */
+    int has_datalist;
+    /** Length of the serialized data list. */
+    uint32_t data_length;
+};
+
+/** Define type vsp_cmcp_dispatch_item to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_dispatch_item vsp_cmcp_dispatch_item;
+
+/** Worker thread and its message queue. */
+struct vsp_cmcp_dispatch_worker {
+    /** Thread handle. */
+    pthread_t thread;
+    /** Mutex locking the queue. */
+    pthread_mutex_t mutex;
+    /** Condition signaled when a message is queued or the worker stops. */
+    pthread_cond_t condition;
+    /** First queued message, or NULL. */
+    vsp_cmcp_dispatch_item *first;
+    /** Last queued message, or NULL. */
+    vsp_cmcp_dispatch_item *last;
+    /** Number of queued messages and events. */
+    int count;
+    /** Non-zero while the worker should keep waiting for messages. */
+    int running;
+    /** Data list object reused to parse every queued message. */
+    vsp_cmcp_datalist *cmcp_datalist;
+    /** Dispatcher owning this worker. */
+    struct vsp_cmcp_dispatch *cmcp_dispatch;
+};
+
+/** Define type vsp_cmcp_dispatch_worker to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_dispatch_worker vsp_cmcp_dispatch_worker;
+
+/** Pool of worker threads invoking message callbacks. */
+struct vsp_cmcp_dispatch {
+    /** Number of worker threads. */
+    int worker_count;
+    /** Maximum number of messages queued for every worker. */
+    int queue_capacity;
+    /** Number of messages dropped because a worker queue was full. */
+    uint64_t drop_count;
+    /** Worker threads and their queues. */
+    vsp_cmcp_dispatch_worker *workers;
+    /** Callback function parameter. */
+    void *callback_param;
+    /** Callback function invoked for every message. */
+    vsp_cmcp_dispatch_cb dispatch_callback;
+};
+
+/** Loop handling queued messages, running in every worker thread. */
+static void *vsp_cmcp_dispatch_run(void *param);
+
+vsp_cmcp_dispatch *vsp_cmcp_dispatch_create(int worker_count,
+    int queue_capacity, vsp_cmcp_dispatch_cb dispatch_callback,
+    void *callback_param)
+{
+    vsp_cmcp_dispatch *cmcp_dispatch;
+    vsp_cmcp_dispatch_worker *worker;
+    int index;
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(worker_count > 0 && queue_capacity > 0
+        && dispatch_callback != NULL, vsp_error_set_num(EINVAL); return NULL);
+
+    /* allocate memory */
+    VSP_ALLOC(cmcp_dispatch, vsp_cmcp_dispatch);
+    VSP_ALLOC_N(cmcp_dispatch->workers,
+        worker_count * sizeof(vsp_cmcp_dispatch_worker));
+    cmcp_dispatch->worker_count = worker_count;
+    cmcp_dispatch->queue_capacity = queue_capacity;
+    cmcp_dispatch->drop_count = 0;
+    cmcp_dispatch->callback_param = callback_param;
+    cmcp_dispatch->dispatch_callback = dispatch_callback;
+
+    /* initialize and start worker threads */
+    for (index = 0; index < worker_count; ++index) {
+        worker = &cmcp_dispatch->workers[index];
+        pthread_mutex_init(&worker->mutex, NULL);
+        pthread_cond_init(&worker->condition, NULL);
+        worker->first = NULL;
+        worker->last = NULL;
+        worker->count = 0;
+        worker->running = 1;
+        worker->cmcp_datalist = vsp_cmcp_datalist_create();
+        /* in case of failure vsp_error_num() is already set */
+        VSP_ASSERT(worker->cmcp_datalist != NULL);
+        worker->cmcp_dispatch = cmcp_dispatch;
+        ret = pthread_create(&worker->thread, NULL, vsp_cmcp_dispatch_run,
+            worker);
+        /* check for pthread errors */
+        VSP_ASSERT(ret == 0);
+    }
+
+    /* return struct pointer */
+    return cmcp_dispatch;
+}
+
+void vsp_cmcp_dispatch_free(vsp_cmcp_dispatch *cmcp_dispatch)
+{
+    vsp_cmcp_dispatch_worker *worker;
+    int index;
+    int ret;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_dispatch != NULL);
+
+    for (index = 0; index < cmcp_dispatch->worker_count; ++index) {
+        worker = &cmcp_dispatch->workers[index];
+        /* stop worker after its queue is empty */
+        pthread_mutex_lock(&worker->mutex);
+        worker->running = 0;
+        pthread_cond_signal(&worker->condition);
+        pthread_mutex_unlock(&worker->mutex);
+        ret = pthread_join(worker->thread, NULL);
+        /* check if thread has successfully stopped */
+        VSP_ASSERT(ret == 0);
+        /* clean up */
+        VSP_ASSERT(worker->first == NULL);
+        vsp_cmcp_datalist_free(worker->cmcp_datalist);
+        pthread_cond_destroy(&worker->condition);
+        pthread_mutex_destroy(&worker->mutex);
+    }
+
+    /* free memory */
+    VSP_FREE(cmcp_dispatch->workers);
+    VSP_FREE(cmcp_dispatch);
+}
+
+int vsp_cmcp_dispatch_push(vsp_cmcp_dispatch *cmcp_dispatch,
+    uint16_t sender_id, uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
+{
+    vsp_cmcp_dispatch_worker *worker;
+    vsp_cmcp_dispatch_item *item;
+    int data_length;
+    int ret;
+
+    /* check parameters; data list may be NULL */
+    VSP_ASSERT(cmcp_dispatch != NULL);
+
+    /* get serialized data list length */
+    data_length = 0;
+    if (cmcp_datalist != NULL) {
+        data_length = vsp_cmcp_datalist_get_data_length(cmcp_datalist);
+        /* vsp_error_num() is set by vsp_cmcp_datalist_get_data_length() */
+        VSP_CHECK(data_length >= 0, return -1);
+    }
+
+    /* copy message, as the received buffer is freed after the callback */
+    VSP_ALLOC_N(item, sizeof(vsp_cmcp_dispatch_item) + data_length);
+    item->next = NULL;
+    item->sender_id = sender_id;
+    item->command_id = command_id;
+    item->has_datalist = (cmcp_datalist != NULL);
+    item->data_length = (uint32_t) data_length;
+    if (cmcp_datalist != NULL) {
+        ret = vsp_cmcp_datalist_get_data(cmcp_datalist, item + 1);
+        /* vsp_error_num() is set by vsp_cmcp_datalist_get_data() */
+        VSP_CHECK(ret == 0, VSP_FREE(item); return -1);
+    }
+
+    /* choose worker by sender ID; client IDs are odd, so skip the first bit */
+    worker = &cmcp_dispatch->workers[
+        (sender_id >> 1) % cmcp_dispatch->worker_count];
+
+    /* append message to worker queue */
+    pthread_mutex_lock(&worker->mutex);
+    if (cmcp_datalist != NULL
+        && worker->count >= cmcp_dispatch->queue_capacity) {
+        /* queue is full; drop and count message, but never drop events */
+        pthread_mutex_unlock(&worker->mutex);
+        VSP_FREE(item);
+        __atomic_add_fetch(&cmcp_dispatch->drop_count, 1, __ATOMIC_RELAXED);
+        vsp_error_set_num(EAGAIN);
+        return -1;
+    }
+    if (worker->last == NULL) {
+        worker->first = item;
+        /* worker may be waiting for messages */
+        pthread_cond_signal(&worker->condition);
+    } else {
+        worker->last->next = item;
+    }
+    worker->last = item;
+    ++worker->count;
+    pthread_mutex_unlock(&worker->mutex);
+
+    /* success */
+    return 0;
+}
+
+void *vsp_cmcp_dispatch_run(void *param)
+{
+    vsp_cmcp_dispatch_worker *worker;
+    vsp_cmcp_dispatch *cmcp_dispatch;
+    vsp_cmcp_dispatch_item *item;
+    int ret;
+
+    /* check parameter */
+    VSP_ASSERT(param != NULL);
+
+    /* initialize local variables */
+    worker = (vsp_cmcp_dispatch_worker*) param;
+    cmcp_dispatch = worker->cmcp_dispatch;
+
+    pthread_mutex_lock(&worker->mutex);
+    while (worker->running || worker->first != NULL) {
+        if (worker->first == NULL) {
+            /* wait for messages */
+            pthread_cond_wait(&worker->condition, &worker->mutex);
+            continue;
+        }
+
+        /* take first message from queue */
+        item = worker->first;
+        worker->first = item->next;
+        if (worker->first == NULL) {
+            worker->last = NULL;
+        }
+        --worker->count;
+        pthread_mutex_unlock(&worker->mutex);
+
+        if (!item->has_datalist) {
+            /* invoke callback function for event without data list */
+            cmcp_dispatch->dispatch_callback(cmcp_dispatch->callback_param,
+                item->sender_id, item->command_id, NULL);
+        } else {
+            /* parse data list in place and invoke callback function, which
+             * may take over the item holding the copied data */
+            ret = vsp_cmcp_datalist_parse(worker->cmcp_datalist,
+                item->data_length, item + 1);
+            if (ret == 0) {
+                vsp_cmcp_datalist_attach_buffer(worker->cmcp_datalist, item,
+                    0);
+                cmcp_dispatch->dispatch_callback(
+                    cmcp_dispatch->callback_param, item->sender_id,
+                    item->command_id, worker->cmcp_datalist);
+                if (vsp_cmcp_datalist_detach_buffer(worker->cmcp_datalist)
+                    != 0) {
+                    /* item is owned by the callback function now */
+                    item = NULL;
+                }
+            }
+        }
+        if (item != NULL) {
+            VSP_FREE(item);
+        }
+
+        pthread_mutex_lock(&worker->mutex);
+    }
+    pthread_mutex_unlock(&worker->mutex);
+
+    /* success */
+    return (void*) 0;
+}
+
+int vsp_cmcp_dispatch_get_count(vsp_cmcp_dispatch *cmcp_dispatch)
+{
+    vsp_cmcp_dispatch_worker *worker;
+    int index;
+    int count;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_dispatch != NULL);
+
+    /* sum up queued messages of all workers */
+    count = 0;
+    for (index = 0; index < cmcp_dispatch->worker_count; ++index) {
+        worker = &cmcp_dispatch->workers[index];
+        pthread_mutex_lock(&worker->mutex);
+        count += worker->count;
+        pthread_mutex_unlock(&worker->mutex);
+    }
+    return count;
+}
+
+uint64_t vsp_cmcp_dispatch_get_drop_count(vsp_cmcp_dispatch *cmcp_dispatch)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_dispatch != NULL);
+
+    return __atomic_load_n(&cmcp_dispatch->drop_count, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,78 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#if !defined VSP_CMCP_DISPATCH_H_INCLUDED
+#define VSP_CMCP_DISPATCH_H_INCLUDED
+
+#include "vsp_cmcp_datalist.h"
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif /* defined __cplusplus */
+
+/** Callback function invoked by a worker thread for every dispatched message.
+ * The parameters are the callback parameter, the sender ID, the command ID and
+ * the data list, which is only valid until the callback function returns.
+ * The data list is NULL for events pushed without data list. */
+typedef void (*vsp_cmcp_dispatch_cb)(void*, uint16_t, uint16_t,
+    vsp_cmcp_datalist*);
+
+/** Pool of worker threads invoking message callbacks outside of the
+ * reception thread. Every sender ID is assigned to one worker, so messages of
+ * a sender are handled in the order they were received, while messages of
+ * different senders are handled in parallel. The queue of every worker is
+ * bounded; messages exceeding it are dropped and counted. */
+struct vsp_cmcp_dispatch;
+
+/** Define type vsp_cmcp_dispatch to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_dispatch vsp_cmcp_dispatch;
+
+/**
+ * Create new vsp_cmcp_dispatch object and start worker_count worker threads,
+ * each queuing at most queue_capacity messages.
+ * worker_count and queue_capacity have to be positive.
+ * Returned pointer should be freed with vsp_cmcp_dispatch_free().
+ * Returns NULL and sets vsp_error_num() if failed.
+ */
+vsp_cmcp_dispatch *vsp_cmcp_dispatch_create(int worker_count,
+    int queue_capacity, vsp_cmcp_dispatch_cb dispatch_callback,
+    void *callback_param);
+
+/**
+ * Handle all queued messages, stop worker threads and free vsp_cmcp_dispatch
+ * object. No messages may be pushed anymore.
+ * Object should be created with vsp_cmcp_dispatch_create().
+ */
+void vsp_cmcp_dispatch_free(vsp_cmcp_dispatch *cmcp_dispatch);
+
+/**
+ * Copy the data list and queue it for the worker assigned to the sender ID.
+ * cmcp_datalist may be NULL to queue an event, e.g. the disconnection of the
+ * sender, behind all messages of the sender queued before.
+ * Events are never dropped, even if the queue of the worker is full.
+ * Returns non-zero, counts a dropped message and sets vsp_error_num() to
+ * EAGAIN if the queue of the worker is full.
+ * Returns non-zero and sets vsp_error_num() if failed otherwise.
+ */
+int vsp_cmcp_dispatch_push(vsp_cmcp_dispatch *cmcp_dispatch,
+    uint16_t sender_id, uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
+
+/** Get the number of messages and events currently queued for all workers. */
+int vsp_cmcp_dispatch_get_count(vsp_cmcp_dispatch *cmcp_dispatch);
+
+/** Get the number of messages dropped because a worker queue was full. */
+uint64_t vsp_cmcp_dispatch_get_drop_count(vsp_cmcp_dispatch *cmcp_dispatch);
+
+#if defined __cplusplus
+}
+#endif /* defined __cplusplus */
+
+#endif /* !defined VSP_CMCP_DISPATCH_H_INCLUDED */
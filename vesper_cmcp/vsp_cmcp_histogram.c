@@ -0,0 +1,213 @@
+/**
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "vsp_cmcp_histogram.h"
+
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
+#include <string.h>
+
+/** Number of bits selecting the linear sub-bucket within a power of two. */
+#define VSP_CMCP_HISTOGRAM_SUB_BUCKET_BITS 3
+
+/** Number of linear sub-buckets per power of two. */
+#define VSP_CMCP_HISTOGRAM_SUB_BUCKET_COUNT \
+    (1 << VSP_CMCP_HISTOGRAM_SUB_BUCKET_BITS)
+
+/** Largest power of two with own buckets, about 34 seconds in nanoseconds. */
+#define VSP_CMCP_HISTOGRAM_MAX_POWER 35
+
+/** Number of buckets per shard. Values smaller than the number of sub-buckets
+ * have exact buckets, followed by the sub-buckets of each power of two. */
+#define VSP_CMCP_HISTOGRAM_BUCKET_COUNT ((VSP_CMCP_HISTOGRAM_MAX_POWER \
+    - VSP_CMCP_HISTOGRAM_SUB_BUCKET_BITS + 2) \
+    * VSP_CMCP_HISTOGRAM_SUB_BUCKET_COUNT)
+
+/** Histogram of durations with logarithmic buckets. */
+struct vsp_cmcp_histogram {
+    /** Number of bucket shards. */
+    int shard_count;
+    /** Bucket counters of all shards, only accessed atomically. */
+    uint64_t *buckets;
+};
+
+/** Get the index of the bucket counting the specified value. */
+static int vsp_cmcp_histogram_get_index(uint64_t value);
+
+/** Get the largest value counted by the bucket with the specified index. */
+static uint64_t vsp_cmcp_histogram_get_upper_bound(int index);
+
+/** Get the upper bound of the bucket in which the share of permille per mille
+ * of all merged counts is reached. */
+static uint64_t vsp_cmcp_histogram_get_percentile(const uint64_t *counts,
+    uint64_t total_count, int permille);
+
+/** Number of threads that have been assigned a thread number. */
+static unsigned int vsp_cmcp_histogram_thread_count = 0;
+
+/** Thread number of the calling thread, assigned round-robin on its first
+ * recording. Zero until assigned. */
+static __thread unsigned int vsp_cmcp_histogram_thread_number = 0;
+
+vsp_cmcp_histogram *vsp_cmcp_histogram_create(int shard_count)
+{
+    vsp_cmcp_histogram *cmcp_histogram;
+
+    /* check parameter */
+    VSP_CHECK(shard_count > 0, vsp_error_set_num(EINVAL); return NULL);
+
+    /* allocate memory */
+    VSP_ALLOC(cmcp_histogram, vsp_cmcp_histogram);
+    VSP_ALLOC_N(cmcp_histogram->buckets, shard_count
+        * VSP_CMCP_HISTOGRAM_BUCKET_COUNT * sizeof(uint64_t));
+    /* initialize struct data */
+    cmcp_histogram->shard_count = shard_count;
+    memset(cmcp_histogram->buckets, 0, shard_count
+        * VSP_CMCP_HISTOGRAM_BUCKET_COUNT * sizeof(uint64_t));
+    /* return struct pointer */
+    return cmcp_histogram;
+}
+
+void vsp_cmcp_histogram_free(vsp_cmcp_histogram *cmcp_histogram)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_histogram != NULL);
+
+    /* free memory */
+    VSP_FREE(cmcp_histogram->buckets);
+    VSP_FREE(cmcp_histogram);
+}
+
+void vsp_cmcp_histogram_record(vsp_cmcp_histogram *cmcp_histogram,
+    uint64_t nanoseconds)
+{
+    uint64_t *buckets;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_histogram != NULL);
+
+    /* counters are only read for snapshots, so no ordering is needed */
+    buckets = cmcp_histogram->buckets + vsp_cmcp_histogram_get_shard(
+        cmcp_histogram) * VSP_CMCP_HISTOGRAM_BUCKET_COUNT;
+    __atomic_fetch_add(&buckets[vsp_cmcp_histogram_get_index(nanoseconds)], 1,
+        __ATOMIC_RELAXED);
+}
+
+void vsp_cmcp_histogram_get_latency(vsp_cmcp_histogram *cmcp_histogram,
+    vsp_cmcp_latency *cmcp_latency)
+{
+    uint64_t counts[VSP_CMCP_HISTOGRAM_BUCKET_COUNT];
+    uint64_t total_count;
+    int shard;
+    int index;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_histogram != NULL && cmcp_latency != NULL);
+
+    /* merge shards */
+    total_count = 0;
+    for (index = 0; index < VSP_CMCP_HISTOGRAM_BUCKET_COUNT; ++index) {
+        counts[index] = 0;
+        for (shard = 0; shard < cmcp_histogram->shard_count; ++shard) {
+            counts[index] += __atomic_load_n(&cmcp_histogram->buckets[
+                shard * VSP_CMCP_HISTOGRAM_BUCKET_COUNT + index],
+                __ATOMIC_RELAXED);
+        }
+        total_count += counts[index];
+    }
+    /* store percentiles; the maximum is reached at the full share */
+    cmcp_latency->count = total_count;
+    cmcp_latency->p50 =
+        vsp_cmcp_histogram_get_percentile(counts, total_count, 500);
+    cmcp_latency->p90 =
+        vsp_cmcp_histogram_get_percentile(counts, total_count, 900);
+    cmcp_latency->p99 =
+        vsp_cmcp_histogram_get_percentile(counts, total_count, 990);
+    cmcp_latency->p999 =
+        vsp_cmcp_histogram_get_percentile(counts, total_count, 999);
+    cmcp_latency->max =
+        vsp_cmcp_histogram_get_percentile(counts, total_count, 1000);
+}
+
+uint64_t vsp_cmcp_histogram_get_percentile(const uint64_t *counts,
+    uint64_t total_count, int permille)
+{
+    uint64_t rank_count;
+    int index;
+
+    /* no durations recorded */
+    VSP_CHECK(total_count > 0, return 0);
+
+    /* walk buckets until the share is reached */
+    rank_count = 0;
+    for (index = 0; index < VSP_CMCP_HISTOGRAM_BUCKET_COUNT - 1; ++index) {
+        rank_count += counts[index];
+        if (rank_count * 1000 >= total_count * (uint64_t) permille) {
+            break;
+        }
+    }
+    return vsp_cmcp_histogram_get_upper_bound(index);
+}
+
+int vsp_cmcp_histogram_get_index(uint64_t value)
+{
+    int power;
+
+    /* small values have exact buckets */
+    if (value < VSP_CMCP_HISTOGRAM_SUB_BUCKET_COUNT) {
+        return (int) value;
+    }
+
+    /* position of the highest set bit selects the power of two */
+    power = 63 - __builtin_clzll(value);
+    if (power > VSP_CMCP_HISTOGRAM_MAX_POWER) {
+        return VSP_CMCP_HISTOGRAM_BUCKET_COUNT - 1;
+    }
+
+    /* the following bits select the linear sub-bucket */
+    return (power - VSP_CMCP_HISTOGRAM_SUB_BUCKET_BITS + 1)
+        * VSP_CMCP_HISTOGRAM_SUB_BUCKET_COUNT
+        + (int) ((value >> (power - VSP_CMCP_HISTOGRAM_SUB_BUCKET_BITS))
+        & (VSP_CMCP_HISTOGRAM_SUB_BUCKET_COUNT - 1));
+}
+
+uint64_t vsp_cmcp_histogram_get_upper_bound(int index)
+{
+    int shift;
+    uint64_t lower_bound;
+
+    /* small values have exact buckets */
+    if (index < VSP_CMCP_HISTOGRAM_SUB_BUCKET_COUNT) {
+        return (uint64_t) index;
+    }
+
+    /* inverse of vsp_cmcp_histogram_get_index() */
+    shift = index / VSP_CMCP_HISTOGRAM_SUB_BUCKET_COUNT - 1;
+    lower_bound = (uint64_t) (VSP_CMCP_HISTOGRAM_SUB_BUCKET_COUNT
+        + index % VSP_CMCP_HISTOGRAM_SUB_BUCKET_COUNT) << shift;
+    return lower_bound + ((uint64_t) 1 << shift) - 1;
+}
+
+int vsp_cmcp_histogram_get_shard(vsp_cmcp_histogram *cmcp_histogram)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_histogram != NULL);
+
+    if (cmcp_histogram->shard_count == 1) {
+        return 0;
+    }
+
+    /* consecutive thread numbers use different shards; thread numbers are
+     * shared by all histograms, so concurrent writers rarely share a shard */
+    if (vsp_cmcp_histogram_thread_number == 0) {
+        vsp_cmcp_histogram_thread_number = __atomic_add_fetch(
+            &vsp_cmcp_histogram_thread_count, 1, __ATOMIC_RELAXED);
+    }
+    return (int) ((vsp_cmcp_histogram_thread_number - 1)
+        % (unsigned int) cmcp_histogram->shard_count);
+}
@@ -0,0 +1,72 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#if !defined VSP_CMCP_HISTOGRAM_H_INCLUDED
+#define VSP_CMCP_HISTOGRAM_H_INCLUDED
+
+#include "vsp_cmcp_stats.h"
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif /* defined __cplusplus */
+
+/** Histogram of durations with logarithmic buckets: every power of two is
+ * split into eight linear sub-buckets, so recorded values are rounded by at
+ * most 12.5 percent. Recording only increments a bucket counter without
+ * locking. Concurrent writers mostly use separate shards of buckets, selected
+ * by thread, which are merged when reading percentiles. */
+struct vsp_cmcp_histogram;
+
+/** Define type vsp_cmcp_histogram to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_histogram vsp_cmcp_histogram;
+
+/**
+ * Create new vsp_cmcp_histogram object with shard_count shards of buckets.
+ * Use one shard if durations are only recorded by a single thread.
+ * shard_count has to be positive.
+ * Returned pointer should be freed with vsp_cmcp_histogram_free().
+ * Returns NULL and sets vsp_error_num() if failed.
+ */
+vsp_cmcp_histogram *vsp_cmcp_histogram_create(int shard_count);
+
+/**
+ * Free vsp_cmcp_histogram object.
+ * Object should be created with vsp_cmcp_histogram_create().
+ */
+void vsp_cmcp_histogram_free(vsp_cmcp_histogram *cmcp_histogram);
+
+/**
+ * Record a duration in nanoseconds. Durations beyond the largest bucket are
+ * counted in the largest bucket. May be called from any thread.
+ */
+void vsp_cmcp_histogram_record(vsp_cmcp_histogram *cmcp_histogram,
+    uint64_t nanoseconds);
+
+/**
+ * Get the index of the bucket shard the calling thread records into.
+ * Threads of the whole process are numbered round-robin on first use, so
+ * concurrent writers of one histogram rarely share a shard. Sharing a shard
+ * is safe, as counters are incremented atomically, but slower.
+ */
+int vsp_cmcp_histogram_get_shard(vsp_cmcp_histogram *cmcp_histogram);
+
+/**
+ * Merge all shards and store the number of recorded durations and their
+ * percentiles in the specified struct. May be called from any thread.
+ */
+void vsp_cmcp_histogram_get_latency(vsp_cmcp_histogram *cmcp_histogram,
+    vsp_cmcp_latency *cmcp_latency);
+
+#if defined __cplusplus
+}
+#endif /* defined __cplusplus */
+
+#endif /* !defined VSP_CMCP_HISTOGRAM_H_INCLUDED */
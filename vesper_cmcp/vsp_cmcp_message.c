@@ -7,9 +7,11 @@
  */
 
 #include "vsp_cmcp_message.h"
+#include "vsp_cmcp_command.h"
 
 #include <vesper_util/vsp_error.h>
 #include <vesper_util/vsp_util.h>
+#include <string.h>
 
 /** Message action: send or receive message. */
 typedef enum {
@@ -69,20 +71,60 @@ void vsp_cmcp_message_free(vsp_cmcp_message *cmcp_message)
     VSP_FREE(cmcp_message);
 }
 
-vsp_cmcp_message *vsp_cmcp_message_create_parse(uint16_t data_length,
+vsp_cmcp_message *vsp_cmcp_message_create_view(void)
+{
+    vsp_cmcp_message *cmcp_message;
+    /* allocate memory */
+    VSP_ALLOC(cmcp_message, vsp_cmcp_message);
+    /* initialize struct data */
+    cmcp_message->type = VSP_CMCP_MESSAGE_TYPE_CONTROL;
+    cmcp_message->action = VSP_CMCP_MESSAGE_ACTION_RECEIVE;
+    cmcp_message->topic_id = 0;
+    cmcp_message->sender_id = 0;
+    cmcp_message->command_id = 0;
+    /* create empty data list reused for all parsed messages */
+    cmcp_message->cmcp_datalist = vsp_cmcp_datalist_create();
+    /* vsp_error_num() is set by vsp_cmcp_datalist_create() */
+    VSP_CHECK(cmcp_message->cmcp_datalist != NULL,
+        VSP_FREE(cmcp_message); return NULL);
+    /* return struct pointer */
+    return cmcp_message;
+}
+
+vsp_cmcp_message *vsp_cmcp_message_create_parse(uint32_t data_length,
     void *data_pointer)
 {
-    /* using short int pointer for safe pointer arithmetic */
-    uint16_t *current_data_pointer;
+    int ret;
     vsp_cmcp_message *cmcp_message;
 
     /* check parameters */
-    VSP_ASSERT(data_length >= VSP_CMCP_MESSAGE_HEADER_LENGTH);
     VSP_ASSERT(data_pointer != NULL);
     /* allocate memory */
-    VSP_ALLOC(cmcp_message, vsp_cmcp_message);
-    /* initialize struct data */
-    cmcp_message->action = VSP_CMCP_MESSAGE_ACTION_RECEIVE;
+    cmcp_message = vsp_cmcp_message_create_view();
+    /* vsp_error_num() is set by vsp_cmcp_message_create_view() */
+    VSP_CHECK(cmcp_message != NULL, return NULL);
+    /* parse message data */
+    ret = vsp_cmcp_message_parse(cmcp_message, data_length, data_pointer);
+    /* vsp_error_num() is set by vsp_cmcp_message_parse() */
+    VSP_CHECK(ret == 0, vsp_cmcp_message_free(cmcp_message); return NULL);
+
+    /* return struct pointer */
+    return cmcp_message;
+}
+
+int vsp_cmcp_message_parse(vsp_cmcp_message *cmcp_message,
+    uint32_t data_length, void *data_pointer)
+{
+    /* using short int pointer for safe pointer arithmetic */
+    uint16_t *current_data_pointer;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_message != NULL && data_pointer != NULL);
+    VSP_ASSERT(cmcp_message->action == VSP_CMCP_MESSAGE_ACTION_RECEIVE);
+    /* received data is untrusted: check length instead of aborting */
+    VSP_CHECK(data_length >= VSP_CMCP_MESSAGE_HEADER_LENGTH,
+        vsp_error_set_num(EPROTO); return -1);
+    /* parse message header */
     current_data_pointer = data_pointer;
     cmcp_message->topic_id = *current_data_pointer;
     ++current_data_pointer;
@@ -92,35 +134,56 @@ vsp_cmcp_message *vsp_cmcp_message_create_parse(uint16_t data_length,
     ++current_data_pointer;
     /* get message type */
     cmcp_message->type = cmcp_message->command_id & 1;
-    /* parse data list values */
-    cmcp_message->cmcp_datalist = vsp_cmcp_datalist_create_parse(
+    /* batch records are parsed by vsp_cmcp_message_parse_batch_record() and
+     * traced messages by vsp_cmcp_message_parse_trace() */
+    if (vsp_cmcp_message_is_batch(cmcp_message)
+        || vsp_cmcp_message_is_trace(cmcp_message)) {
+        data_length = VSP_CMCP_MESSAGE_HEADER_LENGTH;
+    }
+    /* parse data list values into the existing data list */
+    return vsp_cmcp_datalist_parse(cmcp_message->cmcp_datalist,
         data_length - VSP_CMCP_MESSAGE_HEADER_LENGTH, current_data_pointer);
-    /* vsp_error_num() is set by vsp_cmcp_datalist_create_parse() */
-    VSP_CHECK(cmcp_message->cmcp_datalist != NULL,
-        VSP_FREE(cmcp_message); return NULL);
-
-    /* return struct pointer */
-    return cmcp_message;
 }
 
 int vsp_cmcp_message_get_data_length(vsp_cmcp_message *cmcp_message)
 {
-    int data_length;
-
     /* check parameter */
     VSP_ASSERT(cmcp_message != NULL);
 
     /* check message action */
     VSP_ASSERT(cmcp_message->action == VSP_CMCP_MESSAGE_ACTION_SEND);
 
+    return vsp_cmcp_message_get_inline_data_length(
+        cmcp_message->cmcp_datalist);
+}
+
+void vsp_cmcp_message_get_data(vsp_cmcp_message *cmcp_message,
+    void *data_pointer)
+{
+    /* check parameters */
+    VSP_ASSERT(cmcp_message != NULL && data_pointer != NULL);
+
+    /* check message action */
+    VSP_ASSERT(cmcp_message->action == VSP_CMCP_MESSAGE_ACTION_SEND);
+
+    /* command ID is stored with message type flag; restore plain ID */
+    vsp_cmcp_message_get_inline_data(cmcp_message->type,
+        cmcp_message->topic_id, cmcp_message->sender_id,
+        cmcp_message->command_id >> 1, cmcp_message->cmcp_datalist,
+        data_pointer);
+}
+
+int vsp_cmcp_message_get_inline_data_length(vsp_cmcp_datalist *cmcp_datalist)
+{
+    int data_length;
+
     /* calculate data length */
     data_length = 0;
 
     /* empty data list value is allowed, then only message header is created */
-    if (cmcp_message->cmcp_datalist != NULL) {
+    if (cmcp_datalist != NULL) {
         /* add data list length */
-        data_length =
-            vsp_cmcp_datalist_get_data_length(cmcp_message->cmcp_datalist);
+        data_length = vsp_cmcp_datalist_get_data_length(cmcp_datalist);
         VSP_ASSERT(data_length >= 0);
     }
 
@@ -129,37 +192,222 @@ int vsp_cmcp_message_get_data_length(vsp_cmcp_message *cmcp_message)
     return data_length;
 }
 
-void vsp_cmcp_message_get_data(vsp_cmcp_message *cmcp_message,
-    void *data_pointer)
+void vsp_cmcp_message_get_inline_data(vsp_cmcp_message_type message_type,
+    uint16_t topic_id, uint16_t sender_id, uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist, void *data_pointer)
 {
     int ret;
     /* using short int pointer for safe pointer arithmetic */
     uint16_t *current_data_pointer;
 
     /* check parameters */
-    VSP_ASSERT(cmcp_message != NULL && data_pointer != NULL);
-
-    /* check message action */
-    VSP_ASSERT(cmcp_message->action == VSP_CMCP_MESSAGE_ACTION_SEND);
+    VSP_ASSERT((message_type == VSP_CMCP_MESSAGE_TYPE_CONTROL
+        || message_type == VSP_CMCP_MESSAGE_TYPE_DATA)
+        && data_pointer != NULL);
 
     /* store message header */
     current_data_pointer = data_pointer;
-    *current_data_pointer = cmcp_message->topic_id;
+    *current_data_pointer = topic_id;
     ++current_data_pointer;
-    *current_data_pointer = cmcp_message->sender_id;
+    *current_data_pointer = sender_id;
     ++current_data_pointer;
-    *current_data_pointer = cmcp_message->command_id;
+    *current_data_pointer = (command_id << 1) | message_type;
     ++current_data_pointer;
 
     /* empty data list value is allowed, then only message header is created */
-    if (cmcp_message->cmcp_datalist != NULL) {
+    if (cmcp_datalist != NULL) {
         /* store data list values */
-        ret = vsp_cmcp_datalist_get_data(cmcp_message->cmcp_datalist,
-            current_data_pointer);
+        ret = vsp_cmcp_datalist_get_data(cmcp_datalist, current_data_pointer);
         VSP_ASSERT(ret == 0);
     }
 }
 
+int vsp_cmcp_message_get_batch_data_length(int message_count,
+    vsp_cmcp_datalist **cmcp_datalists)
+{
+    int data_length;
+    int datalist_length;
+    int index;
+
+    /* check parameters */
+    VSP_ASSERT(message_count > 0 && cmcp_datalists != NULL);
+
+    data_length = VSP_CMCP_MESSAGE_HEADER_LENGTH;
+    for (index = 0; index < message_count; ++index) {
+        datalist_length = 0;
+        if (cmcp_datalists[index] != NULL) {
+            datalist_length =
+                vsp_cmcp_datalist_get_data_length(cmcp_datalists[index]);
+        }
+        /* record data length is stored as 2 bytes */
+        VSP_CHECK(datalist_length >= 0 && datalist_length <= 0xffff,
+            vsp_error_set_num(EMSGSIZE); return -1);
+        data_length += VSP_CMCP_MESSAGE_RECORD_HEADER_LENGTH + datalist_length;
+    }
+
+    return data_length;
+}
+
+void vsp_cmcp_message_get_batch_data(vsp_cmcp_message_type message_type,
+    uint16_t topic_id, uint16_t sender_id, int message_count,
+    const uint16_t *command_ids, vsp_cmcp_datalist **cmcp_datalists,
+    void *data_pointer)
+{
+    int ret;
+    int index;
+    uint16_t datalist_length;
+    /* using byte pointer for safe pointer arithmetic */
+    uint8_t *current_data_pointer;
+
+    /* check parameters */
+    VSP_ASSERT((message_type == VSP_CMCP_MESSAGE_TYPE_CONTROL
+        || message_type == VSP_CMCP_MESSAGE_TYPE_DATA) && message_count > 0
+        && command_ids != NULL && cmcp_datalists != NULL
+        && data_pointer != NULL);
+
+    /* store batch message header; records are always control-framed */
+    vsp_cmcp_message_get_inline_data(VSP_CMCP_MESSAGE_TYPE_CONTROL, topic_id,
+        sender_id, VSP_CMCP_COMMAND_NODE_BATCH, NULL, data_pointer);
+    current_data_pointer = data_pointer;
+    current_data_pointer += VSP_CMCP_MESSAGE_HEADER_LENGTH;
+
+    /* store records */
+    for (index = 0; index < message_count; ++index) {
+        datalist_length = 0;
+        if (cmcp_datalists[index] != NULL) {
+            datalist_length =
+                vsp_cmcp_datalist_get_data_length(cmcp_datalists[index]);
+        }
+        *(uint16_t*) current_data_pointer =
+            (command_ids[index] << 1) | message_type;
+        current_data_pointer += 2;
+        *(uint16_t*) current_data_pointer = datalist_length;
+        current_data_pointer += 2;
+        if (cmcp_datalists[index] != NULL) {
+            ret = vsp_cmcp_datalist_get_data(cmcp_datalists[index],
+                current_data_pointer);
+            VSP_ASSERT(ret == 0);
+            current_data_pointer += datalist_length;
+        }
+    }
+}
+
+int vsp_cmcp_message_is_batch(vsp_cmcp_message *cmcp_message)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_message != NULL);
+    return cmcp_message->type == VSP_CMCP_MESSAGE_TYPE_CONTROL
+        && (cmcp_message->command_id >> 1) == VSP_CMCP_COMMAND_NODE_BATCH;
+}
+
+int vsp_cmcp_message_parse_batch_record(vsp_cmcp_message *cmcp_message,
+    int data_length, void *data_pointer, int *offset)
+{
+    uint16_t command_id;
+    uint16_t datalist_length;
+    /* using byte pointer for safe pointer arithmetic */
+    uint8_t *current_data_pointer;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_message != NULL && data_pointer != NULL && offset != NULL);
+    VSP_ASSERT(cmcp_message->action == VSP_CMCP_MESSAGE_ACTION_RECEIVE);
+    VSP_ASSERT(*offset >= VSP_CMCP_MESSAGE_HEADER_LENGTH);
+
+    /* check if a complete record header is left */
+    VSP_CHECK(data_length - *offset >= VSP_CMCP_MESSAGE_RECORD_HEADER_LENGTH,
+        vsp_error_set_num(ENOMSG); return -1);
+    current_data_pointer = data_pointer;
+    current_data_pointer += *offset;
+    command_id = *(uint16_t*) current_data_pointer;
+    current_data_pointer += 2;
+    datalist_length = *(uint16_t*) current_data_pointer;
+    current_data_pointer += 2;
+    /* check if as much data available as specified in record header */
+    VSP_CHECK(data_length - *offset - VSP_CMCP_MESSAGE_RECORD_HEADER_LENGTH
+        >= datalist_length, vsp_error_set_num(EPROTO); return -1);
+    *offset += VSP_CMCP_MESSAGE_RECORD_HEADER_LENGTH + datalist_length;
+
+    /* record inherits topic and sender ID of the batch message */
+    cmcp_message->command_id = command_id;
+    cmcp_message->type = command_id & 1;
+    return vsp_cmcp_datalist_parse(cmcp_message->cmcp_datalist,
+        datalist_length, current_data_pointer);
+}
+
+void vsp_cmcp_message_get_trace_data(uint16_t topic_id, uint16_t sender_id,
+    uint64_t send_time, uint32_t sequence, void *data_pointer)
+{
+    /* using byte pointer for safe pointer arithmetic */
+    uint8_t *current_data_pointer;
+
+    /* check parameter */
+    VSP_ASSERT(data_pointer != NULL);
+
+    /* store trace message header */
+    vsp_cmcp_message_get_inline_data(VSP_CMCP_MESSAGE_TYPE_CONTROL, topic_id,
+        sender_id, VSP_CMCP_COMMAND_NODE_TRACE, NULL, data_pointer);
+    current_data_pointer = data_pointer;
+    current_data_pointer += VSP_CMCP_MESSAGE_HEADER_LENGTH;
+
+    /* store trace header; the send time is not aligned to 8 bytes */
+    memcpy(current_data_pointer, &send_time, sizeof(send_time));
+    current_data_pointer += sizeof(send_time);
+    memcpy(current_data_pointer, &sequence, sizeof(sequence));
+}
+
+int vsp_cmcp_message_is_trace(vsp_cmcp_message *cmcp_message)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_message != NULL);
+    return cmcp_message->type == VSP_CMCP_MESSAGE_TYPE_CONTROL
+        && (cmcp_message->command_id >> 1) == VSP_CMCP_COMMAND_NODE_TRACE;
+}
+
+int vsp_cmcp_message_parse_trace(vsp_cmcp_message *cmcp_message,
+    uint32_t data_length, void *data_pointer, uint64_t *send_time,
+    uint32_t *sequence)
+{
+    int ret;
+    uint16_t topic_id;
+    uint16_t sender_id;
+    /* using byte pointer for safe pointer arithmetic */
+    uint8_t *current_data_pointer;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_message != NULL && data_pointer != NULL
+        && send_time != NULL && sequence != NULL);
+    VSP_ASSERT(vsp_cmcp_message_is_trace(cmcp_message));
+
+    /* received data is untrusted: check length instead of aborting */
+    VSP_CHECK(data_length >= VSP_CMCP_MESSAGE_HEADER_LENGTH
+        + VSP_CMCP_MESSAGE_TRACE_HEADER_LENGTH,
+        vsp_error_set_num(EPROTO); return -1);
+    current_data_pointer = data_pointer;
+    current_data_pointer += VSP_CMCP_MESSAGE_HEADER_LENGTH;
+
+    /* parse trace header */
+    memcpy(send_time, current_data_pointer, sizeof(*send_time));
+    current_data_pointer += sizeof(*send_time);
+    memcpy(sequence, current_data_pointer, sizeof(*sequence));
+    current_data_pointer += sizeof(*sequence);
+
+    /* parse traced message, which has to be sent on the same topic */
+    topic_id = cmcp_message->topic_id;
+    sender_id = cmcp_message->sender_id;
+    ret = vsp_cmcp_message_parse(cmcp_message, data_length
+        - VSP_CMCP_MESSAGE_HEADER_LENGTH - VSP_CMCP_MESSAGE_TRACE_HEADER_LENGTH,
+        current_data_pointer);
+    /* vsp_error_num() is set by vsp_cmcp_message_parse() */
+    VSP_CHECK(ret == 0, return -1);
+    VSP_CHECK(cmcp_message->topic_id == topic_id
+        && cmcp_message->sender_id == sender_id
+        && !vsp_cmcp_message_is_trace(cmcp_message),
+        vsp_error_set_num(EPROTO); return -1);
+
+    /* success */
+    return 0;
+}
+
 vsp_cmcp_message_type vsp_cmcp_message_get_type(vsp_cmcp_message *cmcp_message)
 {
     /* check parameter */
@@ -11,6 +11,7 @@
 #define VSP_CMCP_MESSAGE_H_INCLUDED
 
 #include "vsp_cmcp_datalist.h"
+#include "vsp_cmcp_packet.h"
 
 #include <vesper_util/vsp_api.h>
 #include <stdint.h>
@@ -23,6 +24,14 @@ extern "C" {
  * 2 bytes topic ID, 2 bytes sender ID, 2 bytes command ID. */
 #define VSP_CMCP_MESSAGE_HEADER_LENGTH 6
 
+/** Size of batch record headers in bytes:
+ * 2 bytes command ID, 2 bytes data list length. */
+#define VSP_CMCP_MESSAGE_RECORD_HEADER_LENGTH 4
+
+/** Size of trace headers in bytes, following the header of trace messages:
+ * 8 bytes monotonic send time in nanoseconds, 4 bytes sequence number. */
+#define VSP_CMCP_MESSAGE_TRACE_HEADER_LENGTH 12
+
 /** Message types. */
 typedef enum {
     /** Control message. */
@@ -51,12 +60,22 @@ vsp_cmcp_message *vsp_cmcp_message_create(vsp_cmcp_message_type message_type,
     uint16_t topic_id, uint16_t sender_id, uint16_t command_id,
     vsp_cmcp_datalist *cmcp_datalist);
 
+/**
+ * Create new empty vsp_cmcp_message object to parse received message data.
+ * The object can be reused for any number of received messages using
+ * vsp_cmcp_message_parse(), which does not allocate memory.
+ * This function creates an internal object of type vsp_cmcp_datalist.
+ * Returned pointer should be freed with vsp_cmcp_message_free().
+ * Returns NULL and sets vsp_error_num() if failed.
+ */
+vsp_cmcp_message *vsp_cmcp_message_create_view(void);
+
 /**
  * Free vsp_cmcp_message object.
- * Object should be created with vsp_cmcp_message_create() or
- * vsp_cmcp_message_create_parse().
+ * Object should be created with vsp_cmcp_message_create(),
+ * vsp_cmcp_message_create_view() or vsp_cmcp_message_create_parse().
  * Frees internal vsp_cmcp_datalist object when created with
- * vsp_cmcp_message_create_parse().
+ * vsp_cmcp_message_create_view() or vsp_cmcp_message_create_parse().
  */
 void vsp_cmcp_message_free(vsp_cmcp_message *cmcp_message);
 
@@ -68,9 +87,20 @@ void vsp_cmcp_message_free(vsp_cmcp_message *cmcp_message);
  * Returned pointer should be freed with vsp_cmcp_message_free().
  * Returns NULL and sets vsp_error_num() if failed.
  */
-vsp_cmcp_message *vsp_cmcp_message_create_parse(uint16_t data_length,
+vsp_cmcp_message *vsp_cmcp_message_create_parse(uint32_t data_length,
     void *data_pointer);
 
+/**
+ * Parse received binary data into an existing vsp_cmcp_message object.
+ * The object has to be created with vsp_cmcp_message_create_view() or
+ * vsp_cmcp_message_create_parse(); previously parsed data is replaced.
+ * No data is copied and no memory is allocated, so the data has to be
+ * accessible as long as the message and its data list are used.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+int vsp_cmcp_message_parse(vsp_cmcp_message *cmcp_message,
+    uint32_t data_length, void *data_pointer);
+
 /**
  * Calculate necessary length of a binary data array storing the message data.
  * This function should only be called for messages created with
@@ -88,6 +118,96 @@ int vsp_cmcp_message_get_data_length(vsp_cmcp_message *cmcp_message);
 void vsp_cmcp_message_get_data(vsp_cmcp_message *cmcp_message,
     void *data_pointer);
 
+/**
+ * Calculate necessary length of a binary data array storing a message with the
+ * specified data list, without creating a vsp_cmcp_message object.
+ * The specified vsp_cmcp_datalist object may be NULL, in this case only the
+ * message header length is returned.
+ */
+int vsp_cmcp_message_get_inline_data_length(vsp_cmcp_datalist *cmcp_datalist);
+
+/**
+ * Write message header and data list directly to the specified binary data
+ * array, without creating a vsp_cmcp_message object.
+ * The specified command_id has to be lower than 2^15, i.e. MSB cleared.
+ * The specified vsp_cmcp_datalist object may be NULL, in this case only the
+ * message header will be written.
+ * The specified array has to be at least as long as the number of bytes
+ * vsp_cmcp_message_get_inline_data_length() returns.
+ */
+void vsp_cmcp_message_get_inline_data(vsp_cmcp_message_type message_type,
+    uint16_t topic_id, uint16_t sender_id, uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist, void *data_pointer);
+
+/**
+ * Calculate necessary length of a binary data array storing a batch message
+ * with the specified data lists, see VSP_CMCP_COMMAND_NODE_BATCH.
+ * Data list entries may be NULL.
+ * Returns negative value and sets vsp_error_num() if a data list is too long
+ * to be stored in a batch record.
+ */
+int vsp_cmcp_message_get_batch_data_length(int message_count,
+    vsp_cmcp_datalist **cmcp_datalists);
+
+/**
+ * Write a batch message containing one record per command ID and data list
+ * to the specified binary data array, see VSP_CMCP_COMMAND_NODE_BATCH.
+ * The specified command IDs have to be lower than 2^15, i.e. MSB cleared.
+ * Data list entries may be NULL.
+ * The specified array has to be at least as long as the number of bytes
+ * vsp_cmcp_message_get_batch_data_length() returns.
+ */
+void vsp_cmcp_message_get_batch_data(vsp_cmcp_message_type message_type,
+    uint16_t topic_id, uint16_t sender_id, int message_count,
+    const uint16_t *command_ids, vsp_cmcp_datalist **cmcp_datalists,
+    void *data_pointer);
+
+/**
+ * Check if a parsed message is a batch message, see
+ * VSP_CMCP_COMMAND_NODE_BATCH. The data list of batch messages is empty.
+ */
+int vsp_cmcp_message_is_batch(vsp_cmcp_message *cmcp_message);
+
+/**
+ * Parse the next record of a received batch message into an existing
+ * vsp_cmcp_message object, as if it was received as a single message.
+ * offset is the byte offset of the record in the batch message data; it has to
+ * be initialized to VSP_CMCP_MESSAGE_HEADER_LENGTH and is advanced to the next
+ * record by this function.
+ * Returns zero if a record was parsed and non-zero if no valid record is left.
+ */
+int vsp_cmcp_message_parse_batch_record(vsp_cmcp_message *cmcp_message,
+    int data_length, void *data_pointer, int *offset);
+
+/**
+ * Write the message header and trace header of a trace message to the
+ * specified binary data array, see VSP_CMCP_COMMAND_NODE_TRACE.
+ * The traced message has to be written behind, at an offset of
+ * VSP_CMCP_MESSAGE_HEADER_LENGTH + VSP_CMCP_MESSAGE_TRACE_HEADER_LENGTH bytes,
+ * using the same topic and sender ID.
+ */
+void vsp_cmcp_message_get_trace_data(uint16_t topic_id, uint16_t sender_id,
+    uint64_t send_time, uint32_t sequence, void *data_pointer);
+
+/**
+ * Check if a parsed message is a trace message, see
+ * VSP_CMCP_COMMAND_NODE_TRACE. The data list of trace messages is empty.
+ */
+int vsp_cmcp_message_is_trace(vsp_cmcp_message *cmcp_message);
+
+/**
+ * Parse the trace header and the traced message of a received trace message
+ * into an existing vsp_cmcp_message object, replacing the trace message.
+ * The traced message may be a batch message; its records have to be parsed
+ * relative to the traced message at the offset
+ * VSP_CMCP_MESSAGE_HEADER_LENGTH + VSP_CMCP_MESSAGE_TRACE_HEADER_LENGTH.
+ * Returns non-zero and sets vsp_error_num() if the traced message is invalid,
+ * another trace message or does not match topic and sender ID.
+ */
+int vsp_cmcp_message_parse_trace(vsp_cmcp_message *cmcp_message,
+    uint32_t data_length, void *data_pointer, uint64_t *send_time,
+    uint32_t *sequence);
+
 /**
  * Get the message type.
  * cmcp_message must not be NULL. Aborts if failed.
@@ -116,7 +236,7 @@ uint16_t vsp_cmcp_message_get_command_id(vsp_cmcp_message *cmcp_message);
 /**
  * Get data list parsed by this message object.
  * This function should only be called for messages created with
- * vsp_cmcp_message_create_parse().
+ * vsp_cmcp_message_create_view() or vsp_cmcp_message_create_parse().
  */
 vsp_cmcp_datalist *vsp_cmcp_message_get_datalist(
     vsp_cmcp_message *cmcp_message);
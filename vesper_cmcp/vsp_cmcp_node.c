@@ -8,6 +8,8 @@
 
 #include "vsp_cmcp_node.h"
 #include "vsp_cmcp_command.h"
+#include "vsp_cmcp_histogram.h"
+#include "vsp_cmcp_sequence.h"
 #include "vsp_cmcp_state.h"
 
 #include <vesper_util/vsp_error.h>
@@ -16,10 +18,29 @@
 #include <vesper_util/vsp_util.h>
 #include <nanomsg/nn.h>
 #include <nanomsg/pubsub.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+/** Add a value to a counter of the node statistics. Counters are only read
+ * for snapshots, so no ordering with other memory accesses is needed. */
+#define VSP_CMCP_NODE_COUNT(counter, value) \
+    ((void) __atomic_fetch_add(&(counter), (uint64_t) (value), \
+    __ATOMIC_RELAXED))
+
+/** Number of bucket shards of the send latency histogram, as application
+ * threads may send messages concurrently. */
+#define VSP_CMCP_NODE_SEND_HISTOGRAM_SHARDS 4
+
+/** Length of the trace message header and trace header preceding traced
+ * messages, see VSP_CMCP_COMMAND_NODE_TRACE. */
+#define VSP_CMCP_NODE_TRACE_LENGTH \
+    (VSP_CMCP_MESSAGE_HEADER_LENGTH + VSP_CMCP_MESSAGE_TRACE_HEADER_LENGTH)
 
 /** Wall clock time in milliseconds between two heartbeat signals.
- * This is also the timeout of a receive call of a node. */
+ * This is also the longest time the reception thread waits for events. */
 const int VSP_CMCP_NODE_HEARTBEAT_TIME = 500;
 
 /** vsp_cmcp_node finite state machine flag. */
@@ -50,35 +71,114 @@ struct vsp_cmcp_node {
     int publish_socket;
     /** nanomsg socket number to receive messages. */
     int subscribe_socket;
+    /** File descriptor readable while messages can be received. */
+    int receive_fd;
+    /** Pipe used to wake up the reception thread, e.g. when stopping it.
+     * Index 0 is the read end, index 1 the write end. */
+    int wake_pipe[2];
     /** Reception thread. */
     pthread_t thread;
+    /** Reactor receiving messages instead of the reception thread,
+     * or NULL. */
+    vsp_cmcp_reactor *cmcp_reactor;
     /** Real time of next heartbeat. */
     double time_next_heartbeat;
+    /** Message object reused to parse every received message in place. */
+    vsp_cmcp_message *cmcp_message;
+    /** Buffer of the message currently handled, or NULL if it was taken by
+     * vsp_cmcp_node_take_message(). */
+    void *message_buffer;
+    /** Length of the buffer of the message currently handled. */
+    int message_length;
+    /** Maximum number of messages received per reception loop iteration. */
+    int receive_batch_size;
+    /** Counters, only accessed atomically. */
+    vsp_cmcp_stats stats;
+    /** Durations of handling received messages, recorded by the reception
+     * thread. */
+    vsp_cmcp_histogram *callback_histogram;
+    /** Durations of passing messages to nanomsg, recorded by sending
+     * threads. */
+    vsp_cmcp_histogram *send_histogram;
+    /** One-way latencies of received traced messages, recorded by the
+     * reception thread. */
+    vsp_cmcp_histogram *transit_histogram;
+    /** Mutex held while assigning a sequence number to a traced message. */
+    pthread_mutex_t trace_mutex;
+    /** Next sequence numbers of sent traced messages, only accessed with
+     * trace_mutex locked. */
+    vsp_cmcp_sequence *sent_sequences;
+    /** Next expected sequence numbers of received traced messages, only
+     * accessed by the reception thread. */
+    vsp_cmcp_sequence *received_sequences;
+    /** Trace callback function, or NULL. */
+    vsp_cmcp_trace_cb trace_callback;
+    /** Gap callback function, or NULL. Peers are not asked to trace messages
+     * if both trace and gap callback functions are NULL. */
+    vsp_cmcp_gap_cb gap_callback;
     /** Message callback function. */
     void (*message_callback)(void*, vsp_cmcp_message*);
     /** Regular callback function. */
-    void (*regular_callback)(void*);
+    int (*regular_callback)(void*);
     /** Message callback parameter. */
     void *callback_param;
 };
 
 /**
- * Send previously created message to the specified socket.
+ * Send zero-copy message buffer allocated by nn_allocmsg() to the publish
+ * socket of the node and count it. The buffer is owned by nanomsg afterwards,
+ * also in case of failure.
  * Blocks until message could be sent.
  * Returns non-zero and sets vsp_error_num() if failed.
  */
-static int vsp_cmcp_node_send_message(int socket,
-    vsp_cmcp_message *cmcp_message);
+static int vsp_cmcp_node_send_message(vsp_cmcp_node *cmcp_node,
+    int data_length, void *data_buffer);
 
 /** Event loop for message reception running in its own thread. */
 static void *vsp_cmcp_node_run(void *param);
 
-/** Check current time and send heartbeat if necessary. */
-static void vsp_cmcp_node_heartbeat(vsp_cmcp_node *cmcp_node);
+/** Parse a received message buffer, invoke the message callback function and
+ * free the buffer. Invalid messages are silently ignored. */
+static void vsp_cmcp_node_handle_message(vsp_cmcp_node *cmcp_node,
+    int data_length, void *message_buffer);
+
+/**
+ * Write trace message header and trace header for the next message sent to
+ * the topic ID to the beginning of the zero-copy message buffer and send it
+ * like vsp_cmcp_node_send_message(). The message data has to be written
+ * after the trace headers already.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+static int vsp_cmcp_node_send_traced_message(vsp_cmcp_node *cmcp_node,
+    uint16_t topic_id, uint16_t sender_id, int data_length,
+    void *data_buffer);
+
+/** Unwrap the received trace message currently handled, record its latency,
+ * check its sequence number and invoke the trace and gap callback functions.
+ * The traced message is parsed into the message object afterwards.
+ * Returns non-zero and sets vsp_error_num() if the message is invalid. */
+static int vsp_cmcp_node_handle_trace(vsp_cmcp_node *cmcp_node,
+    int data_length, void *message_buffer);
+
+/** Invoke the message callback function for the current message and record
+ * the time spent in it. */
+static void vsp_cmcp_node_invoke_callback(vsp_cmcp_node *cmcp_node);
+
+/** Check current time and send heartbeat if necessary.
+ * Returns the number of milliseconds until the next heartbeat. */
+static int vsp_cmcp_node_heartbeat(vsp_cmcp_node *cmcp_node);
+
+/** Create the non-blocking pipe used to wake up the reception thread.
+ * Returns non-zero and sets vsp_error_num() if failed; no pipe is left open
+ * in this case. */
+static int vsp_cmcp_node_open_wake_pipe(vsp_cmcp_node *cmcp_node);
+
+/** Close both ends of the wake-up pipe if open. */
+static void vsp_cmcp_node_close_wake_pipe(vsp_cmcp_node *cmcp_node);
 
 vsp_cmcp_node *vsp_cmcp_node_create(vsp_cmcp_node_type node_type,
     void (*message_callback)(void*, vsp_cmcp_message*),
-    void (*regular_callback)(void*), void *callback_param)
+    int (*regular_callback)(void*), void *callback_param)
 {
     vsp_cmcp_node *cmcp_node;
     /* check parameters */
@@ -95,7 +195,36 @@ vsp_cmcp_node *vsp_cmcp_node_create(vsp_cmcp_node_type node_type,
     vsp_cmcp_node_generate_id(cmcp_node);
     cmcp_node->publish_socket = -1;
     cmcp_node->subscribe_socket = -1;
+    cmcp_node->receive_fd = -1;
+    cmcp_node->wake_pipe[0] = -1;
+    cmcp_node->wake_pipe[1] = -1;
+    cmcp_node->cmcp_reactor = NULL;
     cmcp_node->time_next_heartbeat = vsp_time_real_double();
+    /* create message object reused by the reception thread */
+    cmcp_node->cmcp_message = vsp_cmcp_message_create_view();
+    /* in case of failure vsp_error_num() is already set */
+    VSP_ASSERT(cmcp_node->cmcp_message != NULL);
+    cmcp_node->message_buffer = NULL;
+    cmcp_node->message_length = 0;
+    cmcp_node->receive_batch_size = VSP_CMCP_NODE_DEFAULT_RECEIVE_BATCH_SIZE;
+    memset(&cmcp_node->stats, 0, sizeof(vsp_cmcp_stats));
+    cmcp_node->callback_histogram = vsp_cmcp_histogram_create(1);
+    cmcp_node->send_histogram =
+        vsp_cmcp_histogram_create(VSP_CMCP_NODE_SEND_HISTOGRAM_SHARDS);
+    cmcp_node->transit_histogram = vsp_cmcp_histogram_create(1);
+    /* in case of failure vsp_error_num() is already set */
+    VSP_ASSERT(cmcp_node->callback_histogram != NULL
+        && cmcp_node->send_histogram != NULL
+        && cmcp_node->transit_histogram != NULL);
+    /* messages are not traced until requested by a peer */
+    pthread_mutex_init(&cmcp_node->trace_mutex, NULL);
+    cmcp_node->sent_sequences = vsp_cmcp_sequence_create();
+    cmcp_node->received_sequences = vsp_cmcp_sequence_create();
+    /* in case of failure vsp_error_num() is already set */
+    VSP_ASSERT(cmcp_node->sent_sequences != NULL
+        && cmcp_node->received_sequences != NULL);
+    cmcp_node->trace_callback = NULL;
+    cmcp_node->gap_callback = NULL;
     cmcp_node->message_callback = message_callback;
     cmcp_node->regular_callback = regular_callback;
     cmcp_node->callback_param = callback_param;
@@ -126,8 +255,24 @@ void vsp_cmcp_node_free(vsp_cmcp_node *cmcp_node)
         ret = nn_close(cmcp_node->subscribe_socket);
         /* check for errors set by nanomsg */
         VSP_ASSERT(ret == 0);
+
+        /* close wake-up pipe */
+        vsp_cmcp_node_close_wake_pipe(cmcp_node);
     }
 
+    /* clean up reused message object */
+    vsp_cmcp_message_free(cmcp_node->cmcp_message);
+
+    /* clean up latency histograms */
+    vsp_cmcp_histogram_free(cmcp_node->callback_histogram);
+    vsp_cmcp_histogram_free(cmcp_node->send_histogram);
+    vsp_cmcp_histogram_free(cmcp_node->transit_histogram);
+
+    /* clean up trace sequence counters */
+    pthread_mutex_destroy(&cmcp_node->trace_mutex);
+    vsp_cmcp_sequence_free(cmcp_node->sent_sequences);
+    vsp_cmcp_sequence_free(cmcp_node->received_sequences);
+
     /* clean up state struct */
     vsp_cmcp_state_free(cmcp_node->state);
 
@@ -140,17 +285,19 @@ void vsp_cmcp_node_generate_id(vsp_cmcp_node *cmcp_node)
     /* check parameter */
     VSP_ASSERT(cmcp_node != NULL);
 
-    /* generate node ID that does not equal broadcast topic ID */
+    /* generate node ID that does not equal broadcast or group topic IDs */
     if (cmcp_node->node_type == VSP_CMCP_NODE_SERVER) {
         /* server node: ID is even (first bit cleared) */
         do {
             cmcp_node->id = (uint16_t) (vsp_random_get() << 1);
-        } while (cmcp_node->id == VSP_CMCP_SERVER_BROADCAST_TOPIC_ID);
+        } while (cmcp_node->id == VSP_CMCP_SERVER_BROADCAST_TOPIC_ID
+            || cmcp_node->id >= VSP_CMCP_GROUP_TOPIC_ID);
     } else {
         /* client node: ID is odd (first bit set) */
         do {
             cmcp_node->id = (uint16_t) (vsp_random_get() | 1);
-        } while (cmcp_node->id == VSP_CMCP_CLIENT_BROADCAST_TOPIC_ID);
+        } while (cmcp_node->id == VSP_CMCP_CLIENT_BROADCAST_TOPIC_ID
+            || cmcp_node->id >= VSP_CMCP_GROUP_TOPIC_ID);
     }
 }
 
@@ -162,10 +309,20 @@ uint16_t vsp_cmcp_node_get_id(vsp_cmcp_node *cmcp_node)
     return cmcp_node->id;
 }
 
+void vsp_cmcp_node_set_receive_batch_size(vsp_cmcp_node *cmcp_node,
+    int batch_size)
+{
+    /* check parameters */
+    VSP_ASSERT(cmcp_node != NULL && batch_size > 0);
+
+    cmcp_node->receive_batch_size = batch_size;
+}
+
 int vsp_cmcp_node_connect(vsp_cmcp_node *cmcp_node,
     const char *publish_address, const char *subscribe_address)
 {
     int ret;
+    size_t fd_length;
 
     /* check parameters */
     VSP_ASSERT(cmcp_node != NULL && publish_address != NULL
@@ -206,13 +363,20 @@ int vsp_cmcp_node_connect(vsp_cmcp_node *cmcp_node,
     /* cleanup both sockets if failed */
     VSP_CHECK(ret >= 0, nn_close(cmcp_node->publish_socket);
         nn_close(cmcp_node->subscribe_socket); return -1);
-    /* set receive timeout */
-    ret = nn_setsockopt(cmcp_node->subscribe_socket,
-        NN_SOL_SOCKET, NN_RCVTIMEO, &VSP_CMCP_NODE_HEARTBEAT_TIME, sizeof(int));
-    /* vsp_error_num() is set by nn_setsockopt() */
+    /* get file descriptor to wait for received messages */
+    fd_length = sizeof(int);
+    ret = nn_getsockopt(cmcp_node->subscribe_socket,
+        NN_SOL_SOCKET, NN_RCVFD, &cmcp_node->receive_fd, &fd_length);
+    /* vsp_error_num() is set by nn_getsockopt() */
     /* cleanup both sockets if failed */
     VSP_CHECK(ret >= 0, nn_close(cmcp_node->publish_socket);
         nn_close(cmcp_node->subscribe_socket); return -1);
+    /* create non-blocking pipe to wake up the reception thread */
+    ret = vsp_cmcp_node_open_wake_pipe(cmcp_node);
+    /* vsp_error_num() is set by vsp_cmcp_node_open_wake_pipe() */
+    /* cleanup both sockets if failed */
+    VSP_CHECK(ret == 0, nn_close(cmcp_node->publish_socket);
+        nn_close(cmcp_node->subscribe_socket); return -1);
 
     /* set state */
     vsp_cmcp_state_set(cmcp_node->state, VSP_CMCP_NODE_INITIALIZED);
@@ -240,6 +404,13 @@ void vsp_cmcp_node_start(vsp_cmcp_node *cmcp_node)
     VSP_ASSERT(vsp_cmcp_state_get(cmcp_node->state)
         == VSP_CMCP_NODE_INITIALIZED);
 
+    if (cmcp_node->cmcp_reactor != NULL) {
+        /* reactor thread receives messages from now on */
+        vsp_cmcp_state_set(cmcp_node->state, VSP_CMCP_NODE_RUNNING);
+        vsp_cmcp_reactor_attach(cmcp_node->cmcp_reactor, cmcp_node);
+        return;
+    }
+
     /* mark thread as starting */
     vsp_cmcp_state_set(cmcp_node->state, VSP_CMCP_NODE_STARTING);
 
@@ -275,6 +446,19 @@ void vsp_cmcp_node_stop(vsp_cmcp_node *cmcp_node)
     /* stop reception thread */
     vsp_cmcp_state_set(cmcp_node->state, VSP_CMCP_NODE_STOPPING);
 
+    if (cmcp_node->cmcp_reactor != NULL) {
+        /* wait until reactor thread does not use the node anymore */
+        vsp_cmcp_reactor_detach(cmcp_node->cmcp_reactor, cmcp_node);
+        vsp_cmcp_state_set(cmcp_node->state, VSP_CMCP_NODE_INITIALIZED);
+        return;
+    }
+
+    /* wake up reception thread; if the pipe is full, it is awake anyway */
+    ret = (int) write(cmcp_node->wake_pipe[1], "", 1);
+    /* check for errors; otherwise the thread stops after its next poll
+     * timeout */
+    VSP_CHECK(ret == 1 || errno == EAGAIN, /* failures are ignored */);
+
     /* wait for thread to join */
     ret = pthread_join(cmcp_node->thread, NULL);
 
@@ -286,29 +470,50 @@ void vsp_cmcp_node_stop(vsp_cmcp_node *cmcp_node)
         == VSP_CMCP_NODE_INITIALIZED);
 }
 
-int vsp_cmcp_node_send_message(int socket, vsp_cmcp_message *cmcp_message)
+int vsp_cmcp_node_set_reactor(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_reactor *cmcp_reactor)
 {
-    int ret;
-    int data_length;
-    void *data_buffer;
+    /* check parameter; reactor may be NULL */
+    VSP_ASSERT(cmcp_node != NULL);
+    /* check if sockets are not yet initialized */
+    VSP_CHECK(vsp_cmcp_state_get(cmcp_node->state)
+        == VSP_CMCP_NODE_UNINITIALIZED, vsp_error_set_num(EALREADY); return -1);
 
-    /* get message data length */
-    data_length = vsp_cmcp_message_get_data_length(cmcp_message);
-    /* check for errors */
-    VSP_ASSERT(data_length > 0);
+    cmcp_node->cmcp_reactor = cmcp_reactor;
 
-    /* allocate zero-copy message buffer */
-    data_buffer = nn_allocmsg(data_length, 0);
-    /* check for errors */
-    VSP_ASSERT(data_buffer != NULL);
+    /* success */
+    return 0;
+}
 
-    /* write message data to buffer */
-    vsp_cmcp_message_get_data(cmcp_message, data_buffer);
+int vsp_cmcp_node_get_receive_fd(vsp_cmcp_node *cmcp_node)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_node != NULL);
+
+    /* check if sockets are initialized */
+    VSP_ASSERT(vsp_cmcp_state_get(cmcp_node->state)
+        >= VSP_CMCP_NODE_INITIALIZED);
+
+    return cmcp_node->receive_fd;
+}
+
+int vsp_cmcp_node_send_message(vsp_cmcp_node *cmcp_node,
+    int data_length, void *data_buffer)
+{
+    int ret;
+    uint64_t time_start;
 
     /* actually send message to socket */
-    ret = nn_send(socket, &data_buffer, NN_MSG, 0);
+    time_start = vsp_time_monotonic_nanoseconds();
+    ret = nn_send(cmcp_node->publish_socket, &data_buffer, NN_MSG, 0);
     /* vsp_error_num() is set by nn_send() */
     VSP_CHECK(ret >= 0, goto error_exit);
+    vsp_cmcp_histogram_record(cmcp_node->send_histogram,
+        vsp_time_monotonic_nanoseconds() - time_start);
+
+    /* count sent message */
+    VSP_CMCP_NODE_COUNT(cmcp_node->stats.messages_sent, 1);
+    VSP_CMCP_NODE_COUNT(cmcp_node->stats.bytes_sent, data_length);
 
     /* success */
     return 0;
@@ -324,38 +529,138 @@ int vsp_cmcp_node_send_message(int socket, vsp_cmcp_message *cmcp_message)
 int vsp_cmcp_node_create_send_message(vsp_cmcp_node *cmcp_node,
     vsp_cmcp_message_type message_type,
     uint16_t topic_id, uint16_t sender_id, uint16_t command_id,
-    vsp_cmcp_datalist *cmcp_datalist)
+    vsp_cmcp_datalist *cmcp_datalist, int trace)
 {
-    int ret;
-    int success;
-    vsp_cmcp_message *cmcp_message;
-
-    /* clear state, no errors yet */
-    success = 0;
+    int data_length;
+    int offset;
+    void *data_buffer;
 
     /* check parameters; data list may be NULL */
     VSP_ASSERT(cmcp_node != NULL);
 
-    /* generate message */
-    cmcp_message = vsp_cmcp_message_create(message_type,
-        topic_id, sender_id, command_id, cmcp_datalist);
+    /* check if sockets are initialized */
+    VSP_ASSERT(vsp_cmcp_state_get(cmcp_node->state)
+        >= VSP_CMCP_NODE_INITIALIZED);
+
+    /* get message data length; data list length is known without iterating */
+    data_length = vsp_cmcp_message_get_inline_data_length(cmcp_datalist);
+    offset = (trace != 0 ? VSP_CMCP_NODE_TRACE_LENGTH : 0);
+
+    /* allocate zero-copy message buffer */
+    data_buffer = nn_allocmsg(offset + data_length, 0);
     /* check for errors */
-    VSP_ASSERT(cmcp_message != NULL);
+    VSP_ASSERT(data_buffer != NULL);
+
+    /* write message header and data list directly to buffer */
+    vsp_cmcp_message_get_inline_data(message_type, topic_id, sender_id,
+        command_id, cmcp_datalist, (uint8_t*) data_buffer + offset);
+
+    /* send message; vsp_error_num() is set by nn_send() */
+    if (trace != 0) {
+        return vsp_cmcp_node_send_traced_message(cmcp_node, topic_id,
+            sender_id, offset + data_length, data_buffer);
+    }
+    return vsp_cmcp_node_send_message(cmcp_node, offset + data_length,
+        data_buffer);
+}
+
+int vsp_cmcp_node_create_send_batch(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_message_type message_type, uint16_t topic_id, uint16_t sender_id,
+    int message_count, const uint16_t *command_ids,
+    vsp_cmcp_datalist **cmcp_datalists, int trace)
+{
+    int data_length;
+    int offset;
+    void *data_buffer;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_node != NULL && message_count > 0 && command_ids != NULL
+        && cmcp_datalists != NULL);
 
     /* check if sockets are initialized */
     VSP_ASSERT(vsp_cmcp_state_get(cmcp_node->state)
         >= VSP_CMCP_NODE_INITIALIZED);
-    /* send message */
-    ret = vsp_cmcp_node_send_message(cmcp_node->publish_socket, cmcp_message);
-    /* vsp_error_num() is set by nn_send() */
-    /* check for error, but do not directly return to avoid memory leaks */
-    VSP_CHECK(ret == 0, success = -1);
 
-    /* free message */
-    vsp_cmcp_message_free(cmcp_message);
+    /* get batch message data length */
+    data_length = vsp_cmcp_message_get_batch_data_length(message_count,
+        cmcp_datalists);
+    /* vsp_error_num() is set by vsp_cmcp_message_get_batch_data_length() */
+    VSP_CHECK(data_length > 0, return -1);
+    offset = (trace != 0 ? VSP_CMCP_NODE_TRACE_LENGTH : 0);
+
+    /* allocate zero-copy message buffer */
+    data_buffer = nn_allocmsg(offset + data_length, 0);
+    /* check for errors */
+    VSP_ASSERT(data_buffer != NULL);
+
+    /* write batch header and all records directly to buffer */
+    vsp_cmcp_message_get_batch_data(message_type, topic_id, sender_id,
+        message_count, command_ids, cmcp_datalists,
+        (uint8_t*) data_buffer + offset);
+
+    /* send message; vsp_error_num() is set by nn_send() */
+    if (trace != 0) {
+        return vsp_cmcp_node_send_traced_message(cmcp_node, topic_id,
+            sender_id, offset + data_length, data_buffer);
+    }
+    return vsp_cmcp_node_send_message(cmcp_node, offset + data_length,
+        data_buffer);
+}
+
+int vsp_cmcp_node_send_packet(vsp_cmcp_node *cmcp_node, uint16_t topic_id,
+    uint16_t sender_id, vsp_cmcp_packet *cmcp_packet, int trace)
+{
+    int data_length;
+    int offset;
+    void *data_buffer;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_node != NULL && cmcp_packet != NULL);
+
+    /* check if sockets are initialized */
+    VSP_ASSERT(vsp_cmcp_state_get(cmcp_node->state)
+        >= VSP_CMCP_NODE_INITIALIZED);
+
+    /* encoded message length is stored in the packet */
+    data_length = vsp_cmcp_packet_get_data_length(cmcp_packet);
+    offset = (trace != 0 ? VSP_CMCP_NODE_TRACE_LENGTH : 0);
+
+    /* allocate zero-copy message buffer */
+    data_buffer = nn_allocmsg(offset + data_length, 0);
+    /* check for errors */
+    VSP_ASSERT(data_buffer != NULL);
+
+    /* copy encoded message to buffer, writing only the IDs */
+    vsp_cmcp_packet_get_data(cmcp_packet, topic_id, sender_id,
+        (uint8_t*) data_buffer + offset);
 
-    /* vsp_error_num() is already set */
-    return success;
+    /* send message; vsp_error_num() is set by nn_send() */
+    if (trace != 0) {
+        return vsp_cmcp_node_send_traced_message(cmcp_node, topic_id,
+            sender_id, offset + data_length, data_buffer);
+    }
+    return vsp_cmcp_node_send_message(cmcp_node, offset + data_length,
+        data_buffer);
+}
+
+int vsp_cmcp_node_send_traced_message(vsp_cmcp_node *cmcp_node,
+    uint16_t topic_id, uint16_t sender_id, int data_length,
+    void *data_buffer)
+{
+    uint32_t sequence;
+
+    /* only take the sequence number under the lock, so concurrent senders do
+     * not wait for each other's blocking sends; receivers count a message
+     * overtaken by one with a higher sequence number as late */
+    pthread_mutex_lock(&cmcp_node->trace_mutex);
+    sequence = vsp_cmcp_sequence_next(cmcp_node->sent_sequences, sender_id,
+        topic_id);
+    pthread_mutex_unlock(&cmcp_node->trace_mutex);
+
+    vsp_cmcp_message_get_trace_data(topic_id, sender_id,
+        vsp_time_monotonic_nanoseconds(), sequence, data_buffer);
+    /* vsp_error_num() is set by vsp_cmcp_node_send_message() */
+    return vsp_cmcp_node_send_message(cmcp_node, data_length, data_buffer);
 }
 
 void vsp_cmcp_node_subscribe(vsp_cmcp_node *cmcp_node, uint16_t topic_id)
@@ -397,19 +702,20 @@ void vsp_cmcp_node_unsubscribe(vsp_cmcp_node *cmcp_node, uint16_t topic_id)
 void *vsp_cmcp_node_run(void *param)
 {
     vsp_cmcp_node *cmcp_node;
+    int timeout;
     int ret;
-    int data_length;
-    void *message_buffer;
-    vsp_cmcp_message *cmcp_message;
-    uint16_t sender_id;
+    char wake_buffer[16];
+    struct pollfd poll_fds[2];
 
     /* check parameter */
     VSP_ASSERT(param != NULL);
 
     /* initialize local variables */
     cmcp_node = (vsp_cmcp_node*) param;
-    message_buffer = NULL;
-    cmcp_message = NULL;
+    poll_fds[0].fd = cmcp_node->receive_fd;
+    poll_fds[0].events = POLLIN;
+    poll_fds[1].fd = cmcp_node->wake_pipe[0];
+    poll_fds[1].events = POLLIN;
 
     /* check if sockets are initialized and thread was started */
     VSP_ASSERT(vsp_cmcp_state_get(cmcp_node->state) == VSP_CMCP_NODE_STARTING);
@@ -419,43 +725,30 @@ void *vsp_cmcp_node_run(void *param)
 
     /* reception loop */
     while (vsp_cmcp_state_get(cmcp_node->state) == VSP_CMCP_NODE_RUNNING) {
-        /* send heartbeat */
-        vsp_cmcp_node_heartbeat(cmcp_node);
-
-        /* invoke regular callback function */
-        cmcp_node->regular_callback(cmcp_node->callback_param);
-
-        /* try to receive message */
-        data_length = nn_recv(cmcp_node->subscribe_socket,
-            &message_buffer, NN_MSG, 0);
-        /* check error: in case of failure just retry */
-        VSP_CHECK(data_length > 0, goto cleanup);
-        /* parse message data */
-        cmcp_message = vsp_cmcp_message_create_parse(data_length,
-            message_buffer);
-        /* check error: in case of failure clean up and retry */
-        VSP_CHECK(cmcp_message != NULL, goto cleanup);
-
-        /* filter out invalid messages; check if message has valid sender */
-        sender_id = vsp_cmcp_message_get_sender_id(cmcp_message);
-        VSP_CHECK(sender_id != VSP_CMCP_SERVER_BROADCAST_TOPIC_ID
-            && sender_id != VSP_CMCP_CLIENT_BROADCAST_TOPIC_ID, goto cleanup);
-
-        /* message successfully received; invoke callback function */
-        cmcp_node->message_callback(cmcp_node->callback_param, cmcp_message);
-
-        cleanup:
-            /* clean up */
-            if (cmcp_message != NULL) {
-                vsp_cmcp_message_free(cmcp_message);
-                cmcp_message = NULL;
-            }
-            if (message_buffer != NULL) {
-                ret = nn_freemsg(message_buffer);
-                VSP_ASSERT(ret == 0);
-                message_buffer = NULL;
-            }
+        /* send heartbeat and invoke regular callback function */
+        timeout = vsp_cmcp_node_process(cmcp_node);
+
+        /* sleep until a message is pending, the thread is woken up or the
+         * next heartbeat or callback deadline is reached */
+        poll_fds[0].revents = 0;
+        poll_fds[1].revents = 0;
+        ret = poll(poll_fds, 2, timeout);
+        if (ret <= 0) {
+            /* timed out or interrupted by a signal */
             continue;
+        }
+        if ((poll_fds[1].revents & POLLIN) != 0) {
+            /* drain wake-up pipe; the loop condition checks the state */
+            while (read(cmcp_node->wake_pipe[0], wake_buffer,
+                sizeof(wake_buffer)) > 0) {
+                /* nothing to do */
+            }
+        }
+        if ((poll_fds[0].revents & POLLIN) != 0) {
+            /* receive a batch of messages, so heartbeat and timeout handling
+             * runs once per batch */
+            vsp_cmcp_node_receive_batch(cmcp_node);
+        }
     }
 
     /* check if thread was requested to stop */
@@ -468,7 +761,253 @@ void *vsp_cmcp_node_run(void *param)
     return (void*) 0;
 }
 
-void vsp_cmcp_node_heartbeat(vsp_cmcp_node *cmcp_node)
+int vsp_cmcp_node_process(vsp_cmcp_node *cmcp_node)
+{
+    int timeout;
+    int callback_timeout;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_node != NULL);
+
+    /* send heartbeat */
+    timeout = vsp_cmcp_node_heartbeat(cmcp_node);
+
+    /* invoke regular callback function */
+    callback_timeout = cmcp_node->regular_callback(cmcp_node->callback_param);
+    if (callback_timeout >= 0 && callback_timeout < timeout) {
+        /* wake up for the next deadline of the callback function */
+        timeout = callback_timeout;
+    }
+    return timeout;
+}
+
+void vsp_cmcp_node_receive_batch(vsp_cmcp_node *cmcp_node)
+{
+    int data_length;
+    void *message_buffer;
+    int index;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_node != NULL);
+
+    for (index = 0; index < cmcp_node->receive_batch_size; ++index) {
+        message_buffer = NULL;
+        data_length = nn_recv(cmcp_node->subscribe_socket,
+            &message_buffer, NN_MSG, NN_DONTWAIT);
+        if (data_length < 0) {
+            /* no more pending messages */
+            break;
+        }
+        /* parse message, invoke callback and free message buffer */
+        vsp_cmcp_node_handle_message(cmcp_node, data_length, message_buffer);
+    }
+}
+
+void *vsp_cmcp_node_take_message(vsp_cmcp_node *cmcp_node, int *data_length)
+{
+    void *message_buffer;
+    vsp_cmcp_datalist *cmcp_datalist;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_node != NULL && data_length != NULL);
+
+    if (cmcp_node->message_buffer != NULL) {
+        /* hand over received buffer without copying */
+        message_buffer = cmcp_node->message_buffer;
+        *data_length = cmcp_node->message_length;
+        cmcp_node->message_buffer = NULL;
+        return message_buffer;
+    }
+
+    /* batch record or traced message shares the received buffer with other
+     * data: copy it into a new buffer */
+    cmcp_datalist = vsp_cmcp_message_get_datalist(cmcp_node->cmcp_message);
+    *data_length = vsp_cmcp_message_get_inline_data_length(cmcp_datalist);
+    message_buffer = nn_allocmsg(*data_length, 0);
+    /* check for errors */
+    VSP_ASSERT(message_buffer != NULL);
+    vsp_cmcp_message_get_inline_data(
+        vsp_cmcp_message_get_type(cmcp_node->cmcp_message),
+        vsp_cmcp_message_get_topic_id(cmcp_node->cmcp_message),
+        vsp_cmcp_message_get_sender_id(cmcp_node->cmcp_message),
+        vsp_cmcp_message_get_command_id(cmcp_node->cmcp_message),
+        cmcp_datalist, message_buffer);
+    return message_buffer;
+}
+
+void vsp_cmcp_node_free_message(void *message_buffer)
+{
+    int ret;
+
+    /* check parameter */
+    VSP_ASSERT(message_buffer != NULL);
+
+    ret = nn_freemsg(message_buffer);
+    VSP_ASSERT(ret == 0);
+}
+
+void vsp_cmcp_node_handle_message(vsp_cmcp_node *cmcp_node,
+    int data_length, void *message_buffer)
+{
+    int ret;
+    int offset;
+    int message_length;
+    uint8_t *message_data;
+    uint16_t sender_id;
+    vsp_cmcp_datalist *cmcp_datalist;
+
+    /* count received message */
+    VSP_CMCP_NODE_COUNT(cmcp_node->stats.messages_received, 1);
+    /* check received length */
+    VSP_CHECK(data_length > 0,
+        VSP_CMCP_NODE_COUNT(cmcp_node->stats.parse_failures, 1);
+        goto cleanup);
+    VSP_CMCP_NODE_COUNT(cmcp_node->stats.bytes_received, data_length);
+    /* parse message data in place, without allocating memory */
+    ret = vsp_cmcp_message_parse(cmcp_node->cmcp_message, data_length,
+        message_buffer);
+    /* check error: in case of failure clean up and ignore message */
+    VSP_CHECK(ret == 0,
+        VSP_CMCP_NODE_COUNT(cmcp_node->stats.parse_failures, 1);
+        goto cleanup);
+
+    /* filter out invalid messages; check if message has valid sender */
+    sender_id = vsp_cmcp_message_get_sender_id(cmcp_node->cmcp_message);
+    VSP_CHECK(sender_id != VSP_CMCP_SERVER_BROADCAST_TOPIC_ID
+        && sender_id != VSP_CMCP_CLIENT_BROADCAST_TOPIC_ID,
+        VSP_CMCP_NODE_COUNT(cmcp_node->stats.filtered_messages, 1);
+        goto cleanup);
+
+    /* unwrap traced message, which follows the trace header */
+    message_data = message_buffer;
+    message_length = data_length;
+    if (vsp_cmcp_message_is_trace(cmcp_node->cmcp_message)) {
+        ret = vsp_cmcp_node_handle_trace(cmcp_node, data_length,
+            message_buffer);
+        /* check error: in case of failure clean up and ignore message */
+        VSP_CHECK(ret == 0,
+            VSP_CMCP_NODE_COUNT(cmcp_node->stats.parse_failures, 1);
+            goto cleanup);
+        message_data += VSP_CMCP_NODE_TRACE_LENGTH;
+        message_length -= VSP_CMCP_NODE_TRACE_LENGTH;
+    }
+
+    /* let callback functions take over the received message, which is only
+     * wrapped into a buffer object if they do */
+    cmcp_datalist = vsp_cmcp_message_get_datalist(cmcp_node->cmcp_message);
+    vsp_cmcp_datalist_attach_buffer(cmcp_datalist, message_buffer, 1);
+
+    if (vsp_cmcp_message_is_batch(cmcp_node->cmcp_message)) {
+        /* unpack batch message: invoke callback function once per record,
+         * reusing the same message object and buffer */
+        offset = VSP_CMCP_MESSAGE_HEADER_LENGTH;
+        while (vsp_cmcp_message_parse_batch_record(cmcp_node->cmcp_message,
+                message_length, message_data, &offset) == 0) {
+            /* nested batch records are not supported, ignore them */
+            if (vsp_cmcp_message_is_batch(cmcp_node->cmcp_message)) {
+                continue;
+            }
+            vsp_cmcp_node_invoke_callback(cmcp_node);
+        }
+    } else if (message_length != data_length) {
+        /* traced message does not start at the beginning of the buffer, so
+         * it is copied if the callback function takes it */
+        vsp_cmcp_node_invoke_callback(cmcp_node);
+    } else {
+        /* message successfully received; invoke callback function, which
+         * may take the message buffer */
+        cmcp_node->message_buffer = message_buffer;
+        cmcp_node->message_length = data_length;
+        vsp_cmcp_node_invoke_callback(cmcp_node);
+        message_buffer = cmcp_node->message_buffer;
+        cmcp_node->message_buffer = NULL;
+    }
+
+    if (vsp_cmcp_datalist_detach_buffer(cmcp_datalist) != 0
+        || message_buffer == NULL) {
+        /* message buffer is owned by the callback function now */
+        return;
+    }
+
+    cleanup:
+        /* clean up */
+        ret = nn_freemsg(message_buffer);
+        VSP_ASSERT(ret == 0);
+}
+
+int vsp_cmcp_node_handle_trace(vsp_cmcp_node *cmcp_node, int data_length,
+    void *message_buffer)
+{
+    int ret;
+    vsp_cmcp_trace cmcp_trace;
+    vsp_cmcp_trace_cb trace_callback;
+    vsp_cmcp_gap_cb gap_callback;
+    int32_t difference;
+    uint32_t expected_sequence;
+
+    /* read trace header and parse traced message */
+    cmcp_trace.sender_id =
+        vsp_cmcp_message_get_sender_id(cmcp_node->cmcp_message);
+    cmcp_trace.topic_id =
+        vsp_cmcp_message_get_topic_id(cmcp_node->cmcp_message);
+    ret = vsp_cmcp_message_parse_trace(cmcp_node->cmcp_message, data_length,
+        message_buffer, &cmcp_trace.send_time, &cmcp_trace.sequence);
+    /* vsp_error_num() is set by vsp_cmcp_message_parse_trace() */
+    VSP_CHECK(ret == 0, return -1);
+    cmcp_trace.receive_time = vsp_time_monotonic_nanoseconds();
+
+    /* count message and record latency; clocks of different hosts may be
+     * offset, so negative latencies are recorded as zero */
+    VSP_CMCP_NODE_COUNT(cmcp_node->stats.traced_messages, 1);
+    vsp_cmcp_histogram_record(cmcp_node->transit_histogram,
+        cmcp_trace.receive_time > cmcp_trace.send_time
+        ? cmcp_trace.receive_time - cmcp_trace.send_time : 0);
+
+    /* invoke trace callback function if registered */
+    trace_callback = cmcp_node->trace_callback;
+    if (trace_callback != NULL) {
+        trace_callback(cmcp_node->callback_param, &cmcp_trace);
+    }
+
+    /* compare sequence number with the previous one of sender and topic */
+    difference = vsp_cmcp_sequence_check(cmcp_node->received_sequences,
+        cmcp_trace.sender_id, cmcp_trace.topic_id, cmcp_trace.sequence,
+        &expected_sequence);
+    if (difference < 0) {
+        /* message overtaken by a later one, which reported it as lost */
+        VSP_CMCP_NODE_COUNT(cmcp_node->stats.late_messages, 1);
+    } else if (difference > 0) {
+        /* messages missing; count them and invoke gap callback function */
+        VSP_CMCP_NODE_COUNT(cmcp_node->stats.sequence_gaps, 1);
+        VSP_CMCP_NODE_COUNT(cmcp_node->stats.lost_messages, difference);
+        gap_callback = cmcp_node->gap_callback;
+        if (gap_callback != NULL) {
+            gap_callback(cmcp_node->callback_param, cmcp_trace.sender_id,
+                cmcp_trace.topic_id, expected_sequence,
+                (uint32_t) difference);
+        }
+    }
+
+    /* success */
+    return 0;
+}
+
+void vsp_cmcp_node_invoke_callback(vsp_cmcp_node *cmcp_node)
+{
+    uint64_t time_start;
+    uint64_t duration;
+
+    /* measure time spent in callback function; a slow callback function
+     * delays heartbeats and may let peers time out */
+    time_start = vsp_time_monotonic_nanoseconds();
+    cmcp_node->message_callback(cmcp_node->callback_param,
+        cmcp_node->cmcp_message);
+    duration = vsp_time_monotonic_nanoseconds() - time_start;
+    VSP_CMCP_NODE_COUNT(cmcp_node->stats.callback_nanoseconds, duration);
+    vsp_cmcp_histogram_record(cmcp_node->callback_histogram, duration);
+}
+
+int vsp_cmcp_node_heartbeat(vsp_cmcp_node *cmcp_node)
 {
     double time_now;
     int ret;
@@ -476,8 +1015,9 @@ void vsp_cmcp_node_heartbeat(vsp_cmcp_node *cmcp_node)
 
     time_now = vsp_time_real_double();
     if (time_now < cmcp_node->time_next_heartbeat) {
-        /* not sending heartbeat yet; nothing to fail, hence success */
-        return;
+        /* not sending heartbeat yet; round up to whole milliseconds */
+        return (int) ((cmcp_node->time_next_heartbeat - time_now) * 1000.0)
+            + 1;
     }
 
     /* update time of next heartbeat */
@@ -494,7 +1034,163 @@ void vsp_cmcp_node_heartbeat(vsp_cmcp_node *cmcp_node)
     }
     ret = vsp_cmcp_node_create_send_message(cmcp_node,
         VSP_CMCP_MESSAGE_TYPE_CONTROL,
-        topic_id, cmcp_node->id, command_id, NULL);
+        topic_id, cmcp_node->id, command_id, NULL, 0);
     /* check for errors */
     VSP_ASSERT(ret == 0);
+    VSP_CMCP_NODE_COUNT(cmcp_node->stats.heartbeats_sent, 1);
+
+    /* next heartbeat is due after a full interval */
+    return VSP_CMCP_NODE_HEARTBEAT_TIME;
+}
+
+void vsp_cmcp_node_set_trace_callback(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_trace_cb trace_callback)
+{
+    /* check parameter; callback function may be NULL */
+    VSP_ASSERT(cmcp_node != NULL);
+
+    cmcp_node->trace_callback = trace_callback;
+}
+
+void vsp_cmcp_node_set_gap_callback(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_gap_cb gap_callback)
+{
+    /* check parameter; callback function may be NULL */
+    VSP_ASSERT(cmcp_node != NULL);
+
+    cmcp_node->gap_callback = gap_callback;
+}
+
+void vsp_cmcp_node_remove_sender(vsp_cmcp_node *cmcp_node, uint16_t sender_id)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_node != NULL);
+
+    vsp_cmcp_sequence_remove(cmcp_node->received_sequences, sender_id);
+}
+
+uint32_t vsp_cmcp_node_get_features(vsp_cmcp_node *cmcp_node)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_node != NULL);
+
+    /* request traced messages only if they are passed to a callback */
+    if (cmcp_node->trace_callback == NULL && cmcp_node->gap_callback == NULL) {
+        return VSP_CMCP_FEATURES & ~(uint32_t) VSP_CMCP_FEATURE_TRACE;
+    }
+    return VSP_CMCP_FEATURES;
+}
+
+void vsp_cmcp_node_count_nack(vsp_cmcp_node *cmcp_node)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_node != NULL);
+
+    VSP_CMCP_NODE_COUNT(cmcp_node->stats.nacks, 1);
+}
+
+void vsp_cmcp_node_count_timeout(vsp_cmcp_node *cmcp_node)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_node != NULL);
+
+    VSP_CMCP_NODE_COUNT(cmcp_node->stats.timeouts, 1);
+}
+
+void vsp_cmcp_node_get_stats(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_stats *cmcp_stats)
+{
+    vsp_cmcp_stats *stats;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_node != NULL && cmcp_stats != NULL);
+
+    /* read every counter atomically; they may be updated meanwhile */
+    stats = &cmcp_node->stats;
+    cmcp_stats->messages_sent =
+        __atomic_load_n(&stats->messages_sent, __ATOMIC_RELAXED);
+    cmcp_stats->bytes_sent =
+        __atomic_load_n(&stats->bytes_sent, __ATOMIC_RELAXED);
+    cmcp_stats->messages_received =
+        __atomic_load_n(&stats->messages_received, __ATOMIC_RELAXED);
+    cmcp_stats->bytes_received =
+        __atomic_load_n(&stats->bytes_received, __ATOMIC_RELAXED);
+    cmcp_stats->parse_failures =
+        __atomic_load_n(&stats->parse_failures, __ATOMIC_RELAXED);
+    cmcp_stats->filtered_messages =
+        __atomic_load_n(&stats->filtered_messages, __ATOMIC_RELAXED);
+    cmcp_stats->nacks = __atomic_load_n(&stats->nacks, __ATOMIC_RELAXED);
+    cmcp_stats->timeouts = __atomic_load_n(&stats->timeouts, __ATOMIC_RELAXED);
+    cmcp_stats->heartbeats_sent =
+        __atomic_load_n(&stats->heartbeats_sent, __ATOMIC_RELAXED);
+    cmcp_stats->callback_nanoseconds =
+        __atomic_load_n(&stats->callback_nanoseconds, __ATOMIC_RELAXED);
+    cmcp_stats->traced_messages =
+        __atomic_load_n(&stats->traced_messages, __ATOMIC_RELAXED);
+    cmcp_stats->sequence_gaps =
+        __atomic_load_n(&stats->sequence_gaps, __ATOMIC_RELAXED);
+    cmcp_stats->lost_messages =
+        __atomic_load_n(&stats->lost_messages, __ATOMIC_RELAXED);
+    cmcp_stats->late_messages =
+        __atomic_load_n(&stats->late_messages, __ATOMIC_RELAXED);
+}
+
+int vsp_cmcp_node_get_latency(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_latency_type latency_type, vsp_cmcp_latency *cmcp_latency)
+{
+    /* check parameters */
+    VSP_ASSERT(cmcp_node != NULL && cmcp_latency != NULL);
+
+    if (latency_type == VSP_CMCP_LATENCY_CALLBACK) {
+        vsp_cmcp_histogram_get_latency(cmcp_node->callback_histogram,
+            cmcp_latency);
+    } else if (latency_type == VSP_CMCP_LATENCY_SEND) {
+        vsp_cmcp_histogram_get_latency(cmcp_node->send_histogram,
+            cmcp_latency);
+    } else if (latency_type == VSP_CMCP_LATENCY_TRANSIT) {
+        vsp_cmcp_histogram_get_latency(cmcp_node->transit_histogram,
+            cmcp_latency);
+    } else {
+        /* unknown histogram type */
+        vsp_error_set_num(EINVAL);
+        return -1;
+    }
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_node_open_wake_pipe(vsp_cmcp_node *cmcp_node)
+{
+    int ret;
+
+    /* create pipe */
+    ret = pipe(cmcp_node->wake_pipe);
+    /* vsp_error_num() is set by pipe() */
+    VSP_CHECK(ret == 0, cmcp_node->wake_pipe[0] = -1;
+        cmcp_node->wake_pipe[1] = -1; return -1);
+
+    /* neither waking up nor draining the pipe may block */
+    ret = fcntl(cmcp_node->wake_pipe[0], F_SETFL, O_NONBLOCK);
+    if (ret != -1) {
+        ret = fcntl(cmcp_node->wake_pipe[1], F_SETFL, O_NONBLOCK);
+    }
+    /* vsp_error_num() is set by fcntl() */
+    VSP_CHECK(ret != -1, vsp_cmcp_node_close_wake_pipe(cmcp_node);
+        return -1);
+
+    /* success */
+    return 0;
+}
+
+void vsp_cmcp_node_close_wake_pipe(vsp_cmcp_node *cmcp_node)
+{
+    if (cmcp_node->wake_pipe[0] != -1) {
+        close(cmcp_node->wake_pipe[0]);
+        cmcp_node->wake_pipe[0] = -1;
+    }
+    if (cmcp_node->wake_pipe[1] != -1) {
+        close(cmcp_node->wake_pipe[1]);
+        cmcp_node->wake_pipe[1] = -1;
+    }
 }
@@ -12,6 +12,8 @@
 
 #include "vsp_cmcp_datalist.h"
 #include "vsp_cmcp_message.h"
+#include "vsp_cmcp_reactor.h"
+#include "vsp_cmcp_stats.h"
 
 #include <stdint.h>
 
@@ -25,14 +27,25 @@ extern "C" {
 /** Topic ID used to broadcast to all connected clients. */
 #define VSP_CMCP_CLIENT_BROADCAST_TOPIC_ID 1
 
+/** Topic ID of the first multicast group. Group topic IDs use the upper end
+ * of the ID range, which is never assigned to nodes. */
+#define VSP_CMCP_GROUP_TOPIC_ID 0xff00
+
+/** Number of multicast groups per server, numbered from zero. */
+#define VSP_CMCP_GROUP_COUNT 256
+
 /** Wall clock time in milliseconds between two heartbeat signals.
- * This is also the timeout of a receive call of a node. */
+ * This is also the longest time the reception thread waits for events. */
 const int VSP_CMCP_NODE_HEARTBEAT_TIME;
 
 /** Time interval in milliseconds. When a node has not received heartbeat
  * signals from a node peer for this amount of time, connection is timed out. */
 #define VSP_CMCP_NODE_CONNECTION_TIMEOUT 10000
 
+/** Default maximum number of messages received per reception loop iteration
+ * before heartbeats are sent and timeouts are checked again. */
+#define VSP_CMCP_NODE_DEFAULT_RECEIVE_BATCH_SIZE 64
+
 /** Node types. */
 typedef enum {
     /** Server node. */
@@ -55,13 +68,17 @@ typedef struct vsp_cmcp_node vsp_cmcp_node;
  * The message_callback function will be called whenever a message is received
  * and vsp_cmcp_node_start() has been invoked (reception thread is running).
  * The regular_callback function will be called regularly with a time interval
- * as specified in VSP_CMCP_NODE_HEARTBEAT_TIME, or more frequently.
+ * as specified in VSP_CMCP_NODE_HEARTBEAT_TIME, or more frequently, and at
+ * least once per batch of received messages. It returns the number of
+ * milliseconds after which it has to be called again, e.g. when the next peer
+ * times out, or a negative value if it has no deadline. The reception thread
+ * sleeps until that time, the next heartbeat or the next received message.
  * callback_param may be NULL.
  * Returns NULL and sets vsp_error_num() if failed.
  */
 vsp_cmcp_node *vsp_cmcp_node_create(vsp_cmcp_node_type node_type,
     void (*message_callback)(void*, vsp_cmcp_message*),
-    void (*regular_callback)(void*), void *callback_param);
+    int (*regular_callback)(void*), void *callback_param);
 
 /**
  * Free vsp_cmcp_node object.
@@ -77,6 +94,16 @@ void vsp_cmcp_node_generate_id(vsp_cmcp_node *cmcp_node);
 /** Get the network ID of this node. */
 uint16_t vsp_cmcp_node_get_id(vsp_cmcp_node *cmcp_node);
 
+/**
+ * Set maximum number of messages received per reception loop iteration.
+ * The reception thread waits until a message is pending, then pending
+ * messages are received without blocking. Heartbeats are sent, timeouts are
+ * checked and the regular callback function is invoked once per batch.
+ * batch_size has to be positive.
+ */
+void vsp_cmcp_node_set_receive_batch_size(vsp_cmcp_node *cmcp_node,
+    int batch_size);
+
 /**
  * Initialize and connect sockets.
  * Returns non-zero and sets vsp_error_num() if failed.
@@ -84,21 +111,103 @@ uint16_t vsp_cmcp_node_get_id(vsp_cmcp_node *cmcp_node);
 int vsp_cmcp_node_connect(vsp_cmcp_node *cmcp_node,
     const char *publish_address, const char *subscribe_address);
 
-/** Start message reception thread and wait until thread has started. */
+/**
+ * Let a reactor thread receive messages for this node instead of its own
+ * reception thread. Has to be called before vsp_cmcp_node_connect().
+ * The reactor must not be freed before the node.
+ * cmcp_reactor may be NULL to use an own reception thread again.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+int vsp_cmcp_node_set_reactor(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_reactor *cmcp_reactor);
+
+/** Start message reception thread and wait until thread has started.
+ * If a reactor is set, the node is attached to one of its threads instead. */
 void vsp_cmcp_node_start(vsp_cmcp_node *cmcp_node);
 
-/** Stop message reception thread and wait until thread has finished. */
+/** Stop message reception thread and wait until thread has finished.
+ * If a reactor is set, the node is detached from its reactor thread.
+ * Must not be called from a message or regular callback function. */
 void vsp_cmcp_node_stop(vsp_cmcp_node *cmcp_node);
 
+/**
+ * Send heartbeat if necessary and invoke the regular callback function.
+ * Returns the number of milliseconds until this function has to be called
+ * again. Used by the reception thread of the node or its reactor thread.
+ */
+int vsp_cmcp_node_process(vsp_cmcp_node *cmcp_node);
+
+/**
+ * Receive a batch of pending messages without blocking and handle them.
+ * Used by the reception thread of the node or its reactor thread.
+ */
+void vsp_cmcp_node_receive_batch(vsp_cmcp_node *cmcp_node);
+
+/**
+ * Get file descriptor that is readable while messages can be received.
+ * Sockets have to be initialized.
+ */
+int vsp_cmcp_node_get_receive_fd(vsp_cmcp_node *cmcp_node);
+
 /**
  * Create and send message to the publish socket of the node.
- * Blocks until message could be sent. Frees internally created message object.
+ * The message is written directly to a zero-copy nanomsg buffer, no
+ * intermediate vsp_cmcp_message object is allocated. Data list items are
+ * copied into this buffer once and nanomsg sends it without copying it again.
+ * If trace is non-zero, the message is wrapped into a trace message with the
+ * current time and the next sequence number of the topic ID, see
+ * VSP_CMCP_COMMAND_NODE_TRACE. Only peers requesting VSP_CMCP_FEATURE_TRACE
+ * are able to receive traced messages.
+ * Blocks until message could be sent.
  * Returns non-zero and sets vsp_error_num() if failed.
  */
 int vsp_cmcp_node_create_send_message(vsp_cmcp_node *cmcp_node,
     vsp_cmcp_message_type message_type,
     uint16_t topic_id, uint16_t sender_id, uint16_t command_id,
-    vsp_cmcp_datalist *cmcp_datalist);
+    vsp_cmcp_datalist *cmcp_datalist, int trace);
+
+/**
+ * Create and send several messages packed into a single batch message to the
+ * publish socket of the node, see VSP_CMCP_COMMAND_NODE_BATCH.
+ * All messages share message type, topic ID and sender ID.
+ * Entries of cmcp_datalists may be NULL.
+ * If trace is non-zero, the batch message is wrapped into a trace message,
+ * see vsp_cmcp_node_create_send_message().
+ * Blocks until message could be sent.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+int vsp_cmcp_node_create_send_batch(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_message_type message_type, uint16_t topic_id, uint16_t sender_id,
+    int message_count, const uint16_t *command_ids,
+    vsp_cmcp_datalist **cmcp_datalists, int trace);
+
+/**
+ * Send a message encoded in a vsp_cmcp_packet object to the publish socket of
+ * the node, using the specified topic and sender ID.
+ * Only the encoded buffer is copied, the data list is not encoded again.
+ * If trace is non-zero, the message is wrapped into a trace message,
+ * see vsp_cmcp_node_create_send_message().
+ * Blocks until message could be sent.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+int vsp_cmcp_node_send_packet(vsp_cmcp_node *cmcp_node, uint16_t topic_id,
+    uint16_t sender_id, vsp_cmcp_packet *cmcp_packet, int trace);
+
+/**
+ * Take ownership of the message currently passed to the message callback
+ * function, so that it stays valid after the callback function returned.
+ * The message is returned as nanomsg buffer and data_length is set to its
+ * length; it can be parsed with vsp_cmcp_message_parse() and has to be freed
+ * with vsp_cmcp_node_free_message(). A received message is returned without
+ * copying it; a record of a batch message is copied into a new buffer.
+ * Has to be called from the message callback function.
+ */
+void *vsp_cmcp_node_take_message(vsp_cmcp_node *cmcp_node, int *data_length);
+
+/**
+ * Free a message buffer returned by vsp_cmcp_node_take_message().
+ */
+void vsp_cmcp_node_free_message(void *message_buffer);
 
 /**
  * Subscribe the node to the specified topic ID.
@@ -110,6 +219,61 @@ void vsp_cmcp_node_subscribe(vsp_cmcp_node *cmcp_node, uint16_t topic_id);
  */
 void vsp_cmcp_node_unsubscribe(vsp_cmcp_node *cmcp_node, uint16_t topic_id);
 
+/**
+ * Set the function invoked with the trace data of every received traced
+ * message, or NULL. The callback parameter of the node is passed to it.
+ * Peers only trace messages if the function was set when they connected.
+ */
+void vsp_cmcp_node_set_trace_callback(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_trace_cb trace_callback);
+
+/**
+ * Set the function invoked for every gap in the sequence numbers of received
+ * traced messages, or NULL. The callback parameter of the node is passed to
+ * it. Peers only trace messages if the function was set when they connected.
+ */
+void vsp_cmcp_node_set_gap_callback(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_gap_cb gap_callback);
+
+/**
+ * Forget the expected sequence numbers of traced messages received from the
+ * sender, e.g. when it disconnected or timed out. Has to be called from the
+ * reception thread, e.g. by the message or regular callback function.
+ */
+void vsp_cmcp_node_remove_sender(vsp_cmcp_node *cmcp_node, uint16_t sender_id);
+
+/**
+ * Get the protocol features to announce to peers, see
+ * VSP_CMCP_PARAMETER_FEATURES. VSP_CMCP_FEATURE_TRACE is only included if a
+ * trace or gap callback function is set.
+ */
+uint32_t vsp_cmcp_node_get_features(vsp_cmcp_node *cmcp_node);
+
+/**
+ * Count a negative acknowledge sent or received by the node.
+ */
+void vsp_cmcp_node_count_nack(vsp_cmcp_node *cmcp_node);
+
+/**
+ * Count a timed out peer connection of the node.
+ */
+void vsp_cmcp_node_count_timeout(vsp_cmcp_node *cmcp_node);
+
+/**
+ * Copy the current counters of the node to the specified struct.
+ * May be called from any thread.
+ */
+void vsp_cmcp_node_get_stats(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_stats *cmcp_stats);
+
+/**
+ * Store the percentiles of the specified latency histogram of the node.
+ * May be called from any thread.
+ * Returns non-zero and sets vsp_error_num() if latency_type is unknown.
+ */
+int vsp_cmcp_node_get_latency(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_latency_type latency_type, vsp_cmcp_latency *cmcp_latency);
+
 #if defined __cplusplus
 }
 #endif /* defined __cplusplus */
@@ -0,0 +1,110 @@
+/**
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "vsp_cmcp_packet.h"
+#include "vsp_cmcp_message.h"
+
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
+#include <string.h>
+
+/** Encoded data message shared by all its references. */
+struct vsp_cmcp_packet {
+    /** Number of references; the packet is freed when it drops to zero. */
+    unsigned int reference_count;
+    /** Non-zero if the data list contains items using the extended length
+     * encoding. */
+    int large_items;
+    /** Length of the encoded message in bytes, including the header. */
+    int data_length;
+    /** Encoded message; topic and sender ID in the header are written when
+     * copying it for a destination. */
+    void *data_pointer;
+};
+
+vsp_cmcp_packet *vsp_cmcp_packet_create(uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist)
+{
+    vsp_cmcp_packet *cmcp_packet;
+
+    /* check parameters; data list may be NULL */
+    VSP_CHECK(command_id < 0x8000, vsp_error_set_num(EINVAL); return NULL);
+
+    /* allocate memory */
+    VSP_ALLOC(cmcp_packet, vsp_cmcp_packet);
+    /* initialize struct data */
+    cmcp_packet->reference_count = 1;
+    cmcp_packet->large_items = (cmcp_datalist != NULL
+        && vsp_cmcp_datalist_has_large_items(cmcp_datalist) != 0);
+    cmcp_packet->data_length =
+        vsp_cmcp_message_get_inline_data_length(cmcp_datalist);
+    VSP_ALLOC_N(cmcp_packet->data_pointer, cmcp_packet->data_length);
+    /* encode message once; IDs are written for every destination */
+    vsp_cmcp_message_get_inline_data(VSP_CMCP_MESSAGE_TYPE_DATA, 0, 0,
+        command_id, cmcp_datalist, cmcp_packet->data_pointer);
+    /* return struct pointer */
+    return cmcp_packet;
+}
+
+void vsp_cmcp_packet_retain(vsp_cmcp_packet *cmcp_packet)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_packet != NULL);
+
+    /* the caller holds a reference, so the packet cannot be freed meanwhile */
+    __atomic_add_fetch(&cmcp_packet->reference_count, 1, __ATOMIC_RELAXED);
+}
+
+void vsp_cmcp_packet_free(vsp_cmcp_packet *cmcp_packet)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_packet != NULL);
+
+    /* the last reference frees the packet after all others were dropped */
+    if (__atomic_sub_fetch(&cmcp_packet->reference_count, 1,
+        __ATOMIC_ACQ_REL) > 0) {
+        return;
+    }
+
+    /* free memory */
+    VSP_FREE(cmcp_packet->data_pointer);
+    VSP_FREE(cmcp_packet);
+}
+
+int vsp_cmcp_packet_get_data_length(vsp_cmcp_packet *cmcp_packet)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_packet != NULL);
+
+    return cmcp_packet->data_length;
+}
+
+int vsp_cmcp_packet_has_large_items(vsp_cmcp_packet *cmcp_packet)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_packet != NULL);
+
+    return cmcp_packet->large_items;
+}
+
+void vsp_cmcp_packet_get_data(vsp_cmcp_packet *cmcp_packet,
+    uint16_t topic_id, uint16_t sender_id, void *data_pointer)
+{
+    /* using short int pointer for safe pointer arithmetic */
+    uint16_t *current_data_pointer;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_packet != NULL && data_pointer != NULL);
+
+    /* copy encoded message, then write IDs of this destination */
+    memcpy(data_pointer, cmcp_packet->data_pointer, cmcp_packet->data_length);
+    current_data_pointer = data_pointer;
+    *current_data_pointer = topic_id;
+    ++current_data_pointer;
+    *current_data_pointer = sender_id;
+}
@@ -0,0 +1,83 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#if !defined VSP_CMCP_PACKET_H_INCLUDED
+#define VSP_CMCP_PACKET_H_INCLUDED
+
+#include "vsp_cmcp_datalist.h"
+
+#include <vesper_util/vsp_api.h>
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif /* defined __cplusplus */
+
+/** Data message encoded once into an immutable wire buffer, so that it can be
+ * sent to any number of destinations without encoding its data list again.
+ * Sending it only copies the buffer and writes topic and sender ID.
+ * Packets are reference counted and may be shared by several threads. */
+struct vsp_cmcp_packet;
+
+/** Define type vsp_cmcp_packet to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_packet vsp_cmcp_packet;
+
+/**
+ * Create new vsp_cmcp_packet object holding one reference and encode the
+ * specified command ID and data list into it.
+ * The specified command_id has to be lower than 2^15, i.e. MSB cleared.
+ * The specified vsp_cmcp_datalist object may be NULL. It is not referenced
+ * by the packet, so it may be freed or modified right after this call.
+ * Returned pointer should be freed with vsp_cmcp_packet_free().
+ * Returns NULL and sets vsp_error_num() if failed.
+ */
+VSP_API vsp_cmcp_packet *vsp_cmcp_packet_create(uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist);
+
+/**
+ * Add a reference to a vsp_cmcp_packet object, e.g. before handing it over to
+ * another thread. Every reference has to be dropped with
+ * vsp_cmcp_packet_free().
+ */
+VSP_API void vsp_cmcp_packet_retain(vsp_cmcp_packet *cmcp_packet);
+
+/**
+ * Drop a reference to a vsp_cmcp_packet object and free it when the last
+ * reference is dropped.
+ * Object should be created with vsp_cmcp_packet_create().
+ */
+VSP_API void vsp_cmcp_packet_free(vsp_cmcp_packet *cmcp_packet);
+
+/* Internal functions used by other CMCP modules, not part of the API. */
+
+/**
+ * Get the length of the message encoded in a vsp_cmcp_packet object.
+ */
+int vsp_cmcp_packet_get_data_length(vsp_cmcp_packet *cmcp_packet);
+
+/**
+ * Check if the data list encoded in a vsp_cmcp_packet object contains items
+ * using the extended length encoding.
+ */
+int vsp_cmcp_packet_has_large_items(vsp_cmcp_packet *cmcp_packet);
+
+/**
+ * Copy the message encoded in a vsp_cmcp_packet object to the specified
+ * binary data array and write the specified topic and sender ID to its header.
+ * The specified array has to be at least as long as the number of bytes
+ * vsp_cmcp_packet_get_data_length() returns.
+ */
+void vsp_cmcp_packet_get_data(vsp_cmcp_packet *cmcp_packet,
+    uint16_t topic_id, uint16_t sender_id, void *data_pointer);
+
+#if defined __cplusplus
+}
+#endif /* defined __cplusplus */
+
+#endif /* !defined VSP_CMCP_PACKET_H_INCLUDED */
@@ -0,0 +1,324 @@
+/**
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "vsp_cmcp_queue.h"
+
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+/** Initial number of events kept while the queue is full. */
+#define VSP_CMCP_QUEUE_INITIAL_EVENT_CAPACITY 8
+
+/** Queued message buffer. */
+struct vsp_cmcp_queue_entry {
+    /** Message buffer, or NULL for events without message. */
+    void *message_buffer;
+    /** Message buffer length. */
+    int data_length;
+    /** Sender ID. */
+    uint16_t sender_id;
+};
+
+/** Define type vsp_cmcp_queue_entry to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_queue_entry vsp_cmcp_queue_entry;
+
+/** Bounded single-producer single-consumer ring buffer. */
+struct vsp_cmcp_queue {
+    /** Number of entries minus one; the capacity is a power of two. */
+    unsigned int mask;
+    /** Ring buffer entries. */
+    vsp_cmcp_queue_entry *entries;
+    /** Number of entries popped so far, only written by the consumer. */
+    unsigned int head;
+    /** Number of entries pushed so far, only written by the producer. */
+    unsigned int tail;
+    /** Number of entries dropped because the queue was full, only written by
+     * the producer. */
+    uint64_t drop_count;
+    /** Sender IDs of events kept because the queue was full, oldest first,
+     * or NULL. Only used by the producer. */
+    uint16_t *kept_events;
+    /** Number of kept events. */
+    int kept_event_count;
+    /** Number of events fitting into the kept event list. */
+    int kept_event_capacity;
+    /** Pipe readable while entries may be queued. Index 0 is the read end,
+     * index 1 the write end. */
+    int wake_pipe[2];
+};
+
+/** Make the wake-up pipe readable; if it is full, it is readable anyway. */
+static void vsp_cmcp_queue_wake(vsp_cmcp_queue *cmcp_queue);
+
+/** Append an entry to the ring buffer and wake up the consumer if needed.
+ * Returns non-zero if the queue is full. */
+static int vsp_cmcp_queue_append(vsp_cmcp_queue *cmcp_queue,
+    uint16_t sender_id, int data_length, void *message_buffer);
+
+/** Keep an event that did not fit into the queue, after all kept events. */
+static void vsp_cmcp_queue_keep_event(vsp_cmcp_queue *cmcp_queue,
+    uint16_t sender_id);
+
+vsp_cmcp_queue *vsp_cmcp_queue_create(int capacity)
+{
+    vsp_cmcp_queue *cmcp_queue;
+    unsigned int entry_count;
+    int ret;
+
+    /* check parameter */
+    VSP_CHECK(capacity > 0, vsp_error_set_num(EINVAL); return NULL);
+
+    /* round capacity up to a power of two, so indices wrap by masking */
+    entry_count = 1;
+    while (entry_count < (unsigned int) capacity) {
+        entry_count <<= 1;
+    }
+
+    /* allocate memory */
+    VSP_ALLOC(cmcp_queue, vsp_cmcp_queue);
+    /* create non-blocking wake-up pipe */
+    ret = pipe(cmcp_queue->wake_pipe);
+    /* vsp_error_num() is set by pipe() */
+    VSP_CHECK(ret == 0, VSP_FREE(cmcp_queue); return NULL);
+    /* neither waking up nor draining the pipe may block */
+    ret = fcntl(cmcp_queue->wake_pipe[0], F_SETFL, O_NONBLOCK);
+    if (ret != -1) {
+        ret = fcntl(cmcp_queue->wake_pipe[1], F_SETFL, O_NONBLOCK);
+    }
+    /* vsp_error_num() is set by fcntl() */
+    VSP_CHECK(ret != -1, close(cmcp_queue->wake_pipe[0]);
+        close(cmcp_queue->wake_pipe[1]); VSP_FREE(cmcp_queue); return NULL);
+    /* initialize struct data */
+    VSP_ALLOC_N(cmcp_queue->entries,
+        entry_count * sizeof(vsp_cmcp_queue_entry));
+    cmcp_queue->mask = entry_count - 1;
+    cmcp_queue->head = 0;
+    cmcp_queue->tail = 0;
+    cmcp_queue->drop_count = 0;
+    cmcp_queue->kept_events = NULL;
+    cmcp_queue->kept_event_count = 0;
+    cmcp_queue->kept_event_capacity = 0;
+    /* return struct pointer */
+    return cmcp_queue;
+}
+
+void vsp_cmcp_queue_free(vsp_cmcp_queue *cmcp_queue)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_queue != NULL);
+
+    /* queued message buffers have to be popped and freed before */
+    VSP_ASSERT(cmcp_queue->head == cmcp_queue->tail);
+
+    /* clean up; kept events are dropped */
+    close(cmcp_queue->wake_pipe[0]);
+    close(cmcp_queue->wake_pipe[1]);
+    if (cmcp_queue->kept_events != NULL) {
+        VSP_FREE(cmcp_queue->kept_events);
+    }
+
+    /* free memory */
+    VSP_FREE(cmcp_queue->entries);
+    VSP_FREE(cmcp_queue);
+}
+
+int vsp_cmcp_queue_push(vsp_cmcp_queue *cmcp_queue, uint16_t sender_id,
+    int data_length, void *message_buffer)
+{
+    int ret;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_queue != NULL);
+
+    /* events kept before have to be appended first to keep the order */
+    ret = -1;
+    if (vsp_cmcp_queue_flush(cmcp_queue) == 0) {
+        ret = vsp_cmcp_queue_append(cmcp_queue, sender_id, data_length,
+            message_buffer);
+    }
+    if (ret != 0) {
+        if (message_buffer == NULL) {
+            /* queue is full: keep event until entries are popped */
+            vsp_cmcp_queue_keep_event(cmcp_queue, sender_id);
+            return 0;
+        }
+        /* queue is full: count dropped entry for back-pressure statistics */
+        __atomic_store_n(&cmcp_queue->drop_count, cmcp_queue->drop_count + 1,
+            __ATOMIC_RELAXED);
+        vsp_error_set_num(EAGAIN);
+        return -1;
+    }
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_queue_flush(vsp_cmcp_queue *cmcp_queue)
+{
+    int index;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_queue != NULL);
+
+    /* append kept events in order as long as they fit */
+    for (index = 0; index < cmcp_queue->kept_event_count; ++index) {
+        if (vsp_cmcp_queue_append(cmcp_queue,
+            cmcp_queue->kept_events[index], 0, NULL) != 0) {
+            break;
+        }
+    }
+
+    /* move remaining events to the front */
+    if (index > 0) {
+        cmcp_queue->kept_event_count -= index;
+        memmove(cmcp_queue->kept_events, cmcp_queue->kept_events + index,
+            cmcp_queue->kept_event_count * sizeof(uint16_t));
+    }
+
+    return cmcp_queue->kept_event_count;
+}
+
+int vsp_cmcp_queue_pop(vsp_cmcp_queue *cmcp_queue, uint16_t *sender_id,
+    int *data_length, void **message_buffer)
+{
+    vsp_cmcp_queue_entry *entry;
+    unsigned int head;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_queue != NULL && sender_id != NULL && data_length != NULL
+        && message_buffer != NULL);
+
+    /* only the consumer writes head, so it can be read without ordering */
+    head = cmcp_queue->head;
+    if (__atomic_load_n(&cmcp_queue->tail, __ATOMIC_SEQ_CST) == head) {
+        /* queue is empty */
+        vsp_error_set_num(EAGAIN);
+        return -1;
+    }
+
+    /* read entry, then release its slot to the producer */
+    entry = &cmcp_queue->entries[head & cmcp_queue->mask];
+    *message_buffer = entry->message_buffer;
+    *data_length = entry->data_length;
+    *sender_id = entry->sender_id;
+    __atomic_store_n(&cmcp_queue->head, head + 1, __ATOMIC_SEQ_CST);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_queue_get_fd(vsp_cmcp_queue *cmcp_queue)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_queue != NULL);
+
+    return cmcp_queue->wake_pipe[0];
+}
+
+void vsp_cmcp_queue_acknowledge(vsp_cmcp_queue *cmcp_queue)
+{
+    char wake_buffer[16];
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_queue != NULL);
+
+    /* drain wake-up pipe */
+    while (read(cmcp_queue->wake_pipe[0], wake_buffer,
+        sizeof(wake_buffer)) > 0) {
+        /* nothing to do */
+    }
+
+    /* entries pushed before draining may not have woken the consumer again */
+    if (vsp_cmcp_queue_get_count(cmcp_queue) > 0) {
+        vsp_cmcp_queue_wake(cmcp_queue);
+    }
+}
+
+int vsp_cmcp_queue_get_count(vsp_cmcp_queue *cmcp_queue)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_queue != NULL);
+
+    return (int) (__atomic_load_n(&cmcp_queue->tail, __ATOMIC_ACQUIRE)
+        - __atomic_load_n(&cmcp_queue->head, __ATOMIC_ACQUIRE));
+}
+
+uint64_t vsp_cmcp_queue_get_drop_count(vsp_cmcp_queue *cmcp_queue)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_queue != NULL);
+
+    return __atomic_load_n(&cmcp_queue->drop_count, __ATOMIC_RELAXED);
+}
+
+void vsp_cmcp_queue_wake(vsp_cmcp_queue *cmcp_queue)
+{
+    int ret;
+
+    ret = (int) write(cmcp_queue->wake_pipe[1], "", 1);
+    (void) ret;
+}
+
+int vsp_cmcp_queue_append(vsp_cmcp_queue *cmcp_queue, uint16_t sender_id,
+    int data_length, void *message_buffer)
+{
+    vsp_cmcp_queue_entry *entry;
+    unsigned int tail;
+    unsigned int head;
+
+    /* only the producer writes tail, so it can be read without ordering */
+    tail = cmcp_queue->tail;
+    head = __atomic_load_n(&cmcp_queue->head, __ATOMIC_ACQUIRE);
+    if (tail - head > cmcp_queue->mask) {
+        /* queue is full */
+        return -1;
+    }
+
+    /* fill entry, then publish it to the consumer */
+    entry = &cmcp_queue->entries[tail & cmcp_queue->mask];
+    entry->message_buffer = message_buffer;
+    entry->data_length = data_length;
+    entry->sender_id = sender_id;
+    __atomic_store_n(&cmcp_queue->tail, tail + 1, __ATOMIC_SEQ_CST);
+
+    /* wake up consumer if it has popped all entries before this one; the
+     * sequentially consistent accesses ensure that either the consumer sees
+     * the new entry or this thread sees the consumer's progress */
+    if (__atomic_load_n(&cmcp_queue->head, __ATOMIC_SEQ_CST) == tail) {
+        vsp_cmcp_queue_wake(cmcp_queue);
+    }
+
+    /* success */
+    return 0;
+}
+
+void vsp_cmcp_queue_keep_event(vsp_cmcp_queue *cmcp_queue, uint16_t sender_id)
+{
+    uint16_t *kept_events;
+
+    if (cmcp_queue->kept_event_count == cmcp_queue->kept_event_capacity) {
+        /* kept event list is full: double its capacity */
+        cmcp_queue->kept_event_capacity =
+            (cmcp_queue->kept_event_capacity == 0
+            ? VSP_CMCP_QUEUE_INITIAL_EVENT_CAPACITY
+            : 2 * cmcp_queue->kept_event_capacity);
+        VSP_ALLOC_N(kept_events,
+            cmcp_queue->kept_event_capacity * sizeof(uint16_t));
+        if (cmcp_queue->kept_events != NULL) {
+            memcpy(kept_events, cmcp_queue->kept_events,
+                cmcp_queue->kept_event_count * sizeof(uint16_t));
+            VSP_FREE(cmcp_queue->kept_events);
+        }
+        cmcp_queue->kept_events = kept_events;
+    }
+    cmcp_queue->kept_events[cmcp_queue->kept_event_count] = sender_id;
+    ++cmcp_queue->kept_event_count;
+}
@@ -0,0 +1,92 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#if !defined VSP_CMCP_QUEUE_H_INCLUDED
+#define VSP_CMCP_QUEUE_H_INCLUDED
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif /* defined __cplusplus */
+
+/** Bounded lock-free ring buffer handing received message buffers from the
+ * reception thread (single producer) to one application thread (single
+ * consumer). Pushing and popping do not lock; a wake-up file descriptor is
+ * only written when the consumer may be waiting for an empty queue. */
+struct vsp_cmcp_queue;
+
+/** Define type vsp_cmcp_queue to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_queue vsp_cmcp_queue;
+
+/**
+ * Create new vsp_cmcp_queue object holding at least capacity entries.
+ * The capacity is rounded up to a power of two and has to be positive.
+ * Returned pointer should be freed with vsp_cmcp_queue_free().
+ * Returns NULL and sets vsp_error_num() if failed.
+ */
+vsp_cmcp_queue *vsp_cmcp_queue_create(int capacity);
+
+/**
+ * Free vsp_cmcp_queue object. The queue has to be empty.
+ * Object should be created with vsp_cmcp_queue_create().
+ */
+void vsp_cmcp_queue_free(vsp_cmcp_queue *cmcp_queue);
+
+/**
+ * Append an entry. Has to be called from the producer thread only.
+ * message_buffer may be NULL to queue an event of the sender without message.
+ * Events are never dropped: if the queue is full, they are kept by the
+ * producer and appended by later calls of this function or
+ * vsp_cmcp_queue_flush(). Messages are dropped while events are kept, so
+ * that no message overtakes an event.
+ * Returns non-zero, counts a dropped entry and sets vsp_error_num() to EAGAIN
+ * if a message was dropped.
+ */
+int vsp_cmcp_queue_push(vsp_cmcp_queue *cmcp_queue, uint16_t sender_id,
+    int data_length, void *message_buffer);
+
+/**
+ * Append events kept because the queue was full, as far as they fit.
+ * Has to be called from the producer thread only.
+ * Returns the number of events still kept.
+ */
+int vsp_cmcp_queue_flush(vsp_cmcp_queue *cmcp_queue);
+
+/**
+ * Remove the oldest entry. Has to be called from the consumer thread only.
+ * Returns non-zero and sets vsp_error_num() to EAGAIN if the queue is empty.
+ */
+int vsp_cmcp_queue_pop(vsp_cmcp_queue *cmcp_queue, uint16_t *sender_id,
+    int *data_length, void **message_buffer);
+
+/**
+ * Get file descriptor that is readable while entries may be queued.
+ * The consumer has to call vsp_cmcp_queue_acknowledge() after popping.
+ */
+int vsp_cmcp_queue_get_fd(vsp_cmcp_queue *cmcp_queue);
+
+/**
+ * Reset the wake-up file descriptor after popping entries, keeping it
+ * readable if entries are left.
+ * Has to be called from the consumer thread only.
+ */
+void vsp_cmcp_queue_acknowledge(vsp_cmcp_queue *cmcp_queue);
+
+/** Get the number of currently queued entries. */
+int vsp_cmcp_queue_get_count(vsp_cmcp_queue *cmcp_queue);
+
+/** Get the number of entries dropped because the queue was full. */
+uint64_t vsp_cmcp_queue_get_drop_count(vsp_cmcp_queue *cmcp_queue);
+
+#if defined __cplusplus
+}
+#endif /* defined __cplusplus */
+
+#endif /* !defined VSP_CMCP_QUEUE_H_INCLUDED */
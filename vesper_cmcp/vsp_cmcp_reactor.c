@@ -0,0 +1,402 @@
+/**
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "vsp_cmcp_reactor.h"
+#include "vsp_cmcp_node.h"
+
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+/** Initial number of nodes fitting into a reactor thread. */
+#define VSP_CMCP_REACTOR_INITIAL_NODE_CAPACITY 8
+
+/** Reception thread of a reactor and the nodes it drives. */
+struct vsp_cmcp_reactor_thread {
+    /** Thread handle. */
+    pthread_t thread;
+    /** Mutex locking the node list. It is held by the thread while walking
+     * the node list and released while waiting for events and while calling
+     * into a node, whose callback functions may attach and detach nodes. */
+    pthread_mutex_t mutex;
+    /** Signaled whenever the thread returns from a node. */
+    pthread_cond_t node_condition;
+    /** Node the thread currently calls into with the mutex released, or
+     * NULL. Detaching it waits until the thread has returned from it. */
+    vsp_cmcp_node *active_node;
+    /** Nodes driven by this thread. */
+    vsp_cmcp_node **nodes;
+    /** Number of nodes driven by this thread. Modified with the mutex locked,
+     * but read atomically by other threads choosing a thread to attach to. */
+    int node_count;
+    /** Number of nodes fitting into the node list. */
+    int node_capacity;
+    /** Incremented whenever the node list changes, so that the thread does
+     * not handle events of nodes that were detached while it was waiting. */
+    unsigned int generation;
+    /** Non-zero while the thread should keep running. */
+    int running;
+    /** Pipe used to wake up the thread. Index 0 is the read end, index 1 the
+     * write end. */
+    int wake_pipe[2];
+};
+
+/** Define type vsp_cmcp_reactor_thread to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_reactor_thread vsp_cmcp_reactor_thread;
+
+/** Pool of message reception threads. */
+struct vsp_cmcp_reactor {
+    /** Number of threads. */
+    int thread_count;
+    /** Threads and their node lists. */
+    vsp_cmcp_reactor_thread *threads;
+};
+
+/** Event loop running in every reactor thread. */
+static void *vsp_cmcp_reactor_run(void *param);
+
+/** Wake up a reactor thread so that it rebuilds its list of events. */
+static void vsp_cmcp_reactor_wake(vsp_cmcp_reactor_thread *reactor_thread);
+
+/** Mark the node as active and unlock the mutex of the reactor thread before
+ * calling into the node. */
+static void vsp_cmcp_reactor_enter_node(
+    vsp_cmcp_reactor_thread *reactor_thread, vsp_cmcp_node *cmcp_node);
+
+/** Lock the mutex of the reactor thread again after calling into the active
+ * node and wake up threads waiting to detach it. */
+static void vsp_cmcp_reactor_leave_node(
+    vsp_cmcp_reactor_thread *reactor_thread);
+
+vsp_cmcp_reactor *vsp_cmcp_reactor_create(int thread_count)
+{
+    vsp_cmcp_reactor *cmcp_reactor;
+    vsp_cmcp_reactor_thread *reactor_thread;
+    int index;
+    int ret;
+
+    if (thread_count <= 0) {
+        /* one thread per online CPU */
+        thread_count = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        if (thread_count <= 0) {
+            thread_count = 1;
+        }
+    }
+
+    /* allocate memory */
+    VSP_ALLOC(cmcp_reactor, vsp_cmcp_reactor);
+    VSP_ALLOC_N(cmcp_reactor->threads,
+        thread_count * sizeof(vsp_cmcp_reactor_thread));
+    cmcp_reactor->thread_count = thread_count;
+
+    /* initialize and start threads */
+    for (index = 0; index < thread_count; ++index) {
+        reactor_thread = &cmcp_reactor->threads[index];
+        ret = pipe(reactor_thread->wake_pipe);
+        /* vsp_error_num() is set by pipe() */
+        VSP_CHECK(ret == 0, goto error_exit);
+        /* neither waking up nor draining the pipe may block */
+        ret = fcntl(reactor_thread->wake_pipe[0], F_SETFL, O_NONBLOCK);
+        if (ret != -1) {
+            ret = fcntl(reactor_thread->wake_pipe[1], F_SETFL, O_NONBLOCK);
+        }
+        /* vsp_error_num() is set by fcntl() */
+        VSP_CHECK(ret != -1, close(reactor_thread->wake_pipe[0]);
+            close(reactor_thread->wake_pipe[1]); goto error_exit);
+        pthread_mutex_init(&reactor_thread->mutex, NULL);
+        pthread_cond_init(&reactor_thread->node_condition, NULL);
+        reactor_thread->active_node = NULL;
+        reactor_thread->nodes = NULL;
+        reactor_thread->node_count = 0;
+        reactor_thread->node_capacity = 0;
+        reactor_thread->generation = 0;
+        reactor_thread->running = 1;
+        ret = pthread_create(&reactor_thread->thread, NULL,
+            vsp_cmcp_reactor_run, reactor_thread);
+        /* check for pthread errors */
+        VSP_ASSERT(ret == 0);
+    }
+
+    /* return struct pointer */
+    return cmcp_reactor;
+
+    error_exit:
+        /* stop and free threads started so far */
+        cmcp_reactor->thread_count = index;
+        vsp_cmcp_reactor_free(cmcp_reactor);
+        return NULL;
+}
+
+void vsp_cmcp_reactor_free(vsp_cmcp_reactor *cmcp_reactor)
+{
+    vsp_cmcp_reactor_thread *reactor_thread;
+    int index;
+    int ret;
+
+    /* check parameter */
+    VSP_CHECK(cmcp_reactor != NULL, return);
+
+    for (index = 0; index < cmcp_reactor->thread_count; ++index) {
+        reactor_thread = &cmcp_reactor->threads[index];
+        /* all nodes have to be detached */
+        VSP_ASSERT(reactor_thread->node_count == 0);
+        /* stop thread */
+        pthread_mutex_lock(&reactor_thread->mutex);
+        reactor_thread->running = 0;
+        pthread_mutex_unlock(&reactor_thread->mutex);
+        vsp_cmcp_reactor_wake(reactor_thread);
+        ret = pthread_join(reactor_thread->thread, NULL);
+        /* check if thread has successfully stopped */
+        VSP_ASSERT(ret == 0);
+        /* clean up */
+        pthread_cond_destroy(&reactor_thread->node_condition);
+        pthread_mutex_destroy(&reactor_thread->mutex);
+        close(reactor_thread->wake_pipe[0]);
+        close(reactor_thread->wake_pipe[1]);
+        if (reactor_thread->nodes != NULL) {
+            VSP_FREE(reactor_thread->nodes);
+        }
+    }
+
+    /* free memory */
+    VSP_FREE(cmcp_reactor->threads);
+    VSP_FREE(cmcp_reactor);
+}
+
+int vsp_cmcp_reactor_get_thread_count(vsp_cmcp_reactor *cmcp_reactor)
+{
+    /* check parameter */
+    VSP_CHECK(cmcp_reactor != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    return cmcp_reactor->thread_count;
+}
+
+void vsp_cmcp_reactor_attach(vsp_cmcp_reactor *cmcp_reactor,
+    vsp_cmcp_node *cmcp_node)
+{
+    vsp_cmcp_reactor_thread *reactor_thread;
+    vsp_cmcp_node **nodes;
+    int node_count;
+    int min_node_count;
+    int index;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_reactor != NULL && cmcp_node != NULL);
+
+    /* choose the thread driving the fewest nodes; the node counts are only
+     * read as a hint without locking the mutexes of the threads */
+    reactor_thread = &cmcp_reactor->threads[0];
+    min_node_count = __atomic_load_n(&reactor_thread->node_count,
+        __ATOMIC_RELAXED);
+    for (index = 1; index < cmcp_reactor->thread_count; ++index) {
+        node_count = __atomic_load_n(&cmcp_reactor->threads[index].node_count,
+            __ATOMIC_RELAXED);
+        if (node_count < min_node_count) {
+            reactor_thread = &cmcp_reactor->threads[index];
+            min_node_count = node_count;
+        }
+    }
+
+    pthread_mutex_lock(&reactor_thread->mutex);
+    if (reactor_thread->node_count == reactor_thread->node_capacity) {
+        /* node list is full: double its capacity */
+        reactor_thread->node_capacity = (reactor_thread->node_capacity == 0
+            ? VSP_CMCP_REACTOR_INITIAL_NODE_CAPACITY
+            : 2 * reactor_thread->node_capacity);
+        VSP_ALLOC_N(nodes,
+            reactor_thread->node_capacity * sizeof(vsp_cmcp_node*));
+        if (reactor_thread->nodes != NULL) {
+            memcpy(nodes, reactor_thread->nodes,
+                reactor_thread->node_count * sizeof(vsp_cmcp_node*));
+            VSP_FREE(reactor_thread->nodes);
+        }
+        reactor_thread->nodes = nodes;
+    }
+    reactor_thread->nodes[reactor_thread->node_count] = cmcp_node;
+    __atomic_store_n(&reactor_thread->node_count,
+        reactor_thread->node_count + 1, __ATOMIC_RELAXED);
+    ++reactor_thread->generation;
+    pthread_mutex_unlock(&reactor_thread->mutex);
+
+    /* let the thread wait for events of the new node */
+    vsp_cmcp_reactor_wake(reactor_thread);
+}
+
+void vsp_cmcp_reactor_detach(vsp_cmcp_reactor *cmcp_reactor,
+    vsp_cmcp_node *cmcp_node)
+{
+    vsp_cmcp_reactor_thread *reactor_thread;
+    int thread_index;
+    int index;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_reactor != NULL && cmcp_node != NULL);
+
+    for (thread_index = 0; thread_index < cmcp_reactor->thread_count;
+        ++thread_index) {
+        reactor_thread = &cmcp_reactor->threads[thread_index];
+        /* the thread only calls into nodes still in its node list */
+        pthread_mutex_lock(&reactor_thread->mutex);
+        for (index = 0; index < reactor_thread->node_count; ++index) {
+            if (reactor_thread->nodes[index] == cmcp_node) {
+                /* last node takes the place of the detached node */
+                __atomic_store_n(&reactor_thread->node_count,
+                    reactor_thread->node_count - 1, __ATOMIC_RELAXED);
+                reactor_thread->nodes[index] =
+                    reactor_thread->nodes[reactor_thread->node_count];
+                ++reactor_thread->generation;
+                /* a node must not be detached by its own callback functions,
+                 * the thread would wait for itself */
+                VSP_ASSERT(reactor_thread->active_node != cmcp_node
+                    || !pthread_equal(pthread_self(), reactor_thread->thread));
+                /* wait until the thread has returned from the node */
+                while (reactor_thread->active_node == cmcp_node) {
+                    pthread_cond_wait(&reactor_thread->node_condition,
+                        &reactor_thread->mutex);
+                }
+                pthread_mutex_unlock(&reactor_thread->mutex);
+                vsp_cmcp_reactor_wake(reactor_thread);
+                return;
+            }
+        }
+        pthread_mutex_unlock(&reactor_thread->mutex);
+    }
+
+    /* node has to be attached */
+    VSP_ASSERT(0);
+}
+
+void *vsp_cmcp_reactor_run(void *param)
+{
+    vsp_cmcp_reactor_thread *reactor_thread;
+    vsp_cmcp_node *cmcp_node;
+    struct pollfd *poll_fds;
+    int poll_fd_capacity;
+    int poll_fd_count;
+    unsigned int generation;
+    int timeout;
+    int node_timeout;
+    int index;
+    int ret;
+    char wake_buffer[16];
+
+    /* check parameter */
+    VSP_ASSERT(param != NULL);
+
+    /* initialize local variables */
+    reactor_thread = (vsp_cmcp_reactor_thread*) param;
+    poll_fds = NULL;
+    poll_fd_capacity = 0;
+
+    pthread_mutex_lock(&reactor_thread->mutex);
+    while (reactor_thread->running) {
+        /* send heartbeats and invoke regular callbacks; nodes attached or
+         * detached meanwhile wake up the thread, so none of them is missed
+         * for longer than one iteration */
+        timeout = -1;
+        for (index = 0; index < reactor_thread->node_count; ++index) {
+            cmcp_node = reactor_thread->nodes[index];
+            vsp_cmcp_reactor_enter_node(reactor_thread, cmcp_node);
+            node_timeout = vsp_cmcp_node_process(cmcp_node);
+            vsp_cmcp_reactor_leave_node(reactor_thread);
+            if (timeout < 0 || node_timeout < timeout) {
+                timeout = node_timeout;
+            }
+        }
+
+        /* grow event list to the capacity of the node list */
+        if (poll_fd_capacity < reactor_thread->node_capacity + 1) {
+            if (poll_fds != NULL) {
+                VSP_FREE(poll_fds);
+            }
+            poll_fd_capacity = reactor_thread->node_capacity + 1;
+            VSP_ALLOC_N(poll_fds, poll_fd_capacity * sizeof(struct pollfd));
+        }
+
+        /* collect events */
+        poll_fds[0].fd = reactor_thread->wake_pipe[0];
+        poll_fds[0].events = POLLIN;
+        poll_fds[0].revents = 0;
+        for (index = 0; index < reactor_thread->node_count; ++index) {
+            poll_fds[index + 1].fd =
+                vsp_cmcp_node_get_receive_fd(reactor_thread->nodes[index]);
+            poll_fds[index + 1].events = POLLIN;
+            poll_fds[index + 1].revents = 0;
+        }
+        poll_fd_count = reactor_thread->node_count + 1;
+        generation = reactor_thread->generation;
+
+        /* sleep until a message is pending, the thread is woken up or the
+         * next heartbeat or callback deadline of any node is reached */
+        pthread_mutex_unlock(&reactor_thread->mutex);
+        ret = poll(poll_fds, poll_fd_count, timeout);
+        if (ret > 0 && (poll_fds[0].revents & POLLIN) != 0) {
+            /* drain wake-up pipe */
+            while (read(reactor_thread->wake_pipe[0], wake_buffer,
+                sizeof(wake_buffer)) > 0) {
+                /* nothing to do */
+            }
+        }
+        pthread_mutex_lock(&reactor_thread->mutex);
+
+        /* ignore events if nodes were attached or detached meanwhile */
+        if (ret <= 0 || generation != reactor_thread->generation) {
+            continue;
+        }
+        for (index = 1; index < poll_fd_count; ++index) {
+            if ((poll_fds[index].revents & POLLIN) != 0) {
+                /* receive a batch of messages of this node */
+                cmcp_node = reactor_thread->nodes[index - 1];
+                vsp_cmcp_reactor_enter_node(reactor_thread, cmcp_node);
+                vsp_cmcp_node_receive_batch(cmcp_node);
+                vsp_cmcp_reactor_leave_node(reactor_thread);
+                /* a callback function attached or detached nodes, so the
+                 * remaining events are polled again */
+                if (generation != reactor_thread->generation) {
+                    break;
+                }
+            }
+        }
+    }
+    pthread_mutex_unlock(&reactor_thread->mutex);
+
+    /* clean up */
+    if (poll_fds != NULL) {
+        VSP_FREE(poll_fds);
+    }
+
+    /* success */
+    return (void*) 0;
+}
+
+void vsp_cmcp_reactor_wake(vsp_cmcp_reactor_thread *reactor_thread)
+{
+    int ret;
+
+    /* if the pipe is full, the thread is woken up anyway */
+    ret = (int) write(reactor_thread->wake_pipe[1], "", 1);
+    (void) ret;
+}
+
+void vsp_cmcp_reactor_enter_node(vsp_cmcp_reactor_thread *reactor_thread,
+    vsp_cmcp_node *cmcp_node)
+{
+    reactor_thread->active_node = cmcp_node;
+    pthread_mutex_unlock(&reactor_thread->mutex);
+}
+
+void vsp_cmcp_reactor_leave_node(vsp_cmcp_reactor_thread *reactor_thread)
+{
+    pthread_mutex_lock(&reactor_thread->mutex);
+    reactor_thread->active_node = NULL;
+    pthread_cond_broadcast(&reactor_thread->node_condition);
+}
@@ -0,0 +1,78 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#if !defined VSP_CMCP_REACTOR_H_INCLUDED
+#define VSP_CMCP_REACTOR_H_INCLUDED
+
+#include <vesper_util/vsp_api.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif /* defined __cplusplus */
+
+/** Pool of message reception threads shared by several servers and clients.
+ * By default every server and client runs its own reception thread. Servers
+ * and clients attached to a reactor are distributed over its threads instead,
+ * each thread waiting for the messages and timers of all its nodes at once.
+ * A reactor thread does not lock its node list while invoking the callback
+ * functions of its servers and clients, so these callback functions may bind,
+ * connect and free other servers and clients using the same reactor, but not
+ * free the server or client invoking them. Connecting a client from such a
+ * callback function times out if its server is driven by the same thread. */
+struct vsp_cmcp_reactor;
+
+/** Define type vsp_cmcp_reactor to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_reactor vsp_cmcp_reactor;
+
+/**
+ * Create new vsp_cmcp_reactor object and start its threads.
+ * If thread_count is not positive, one thread per online CPU is started.
+ * Returned pointer should be freed with vsp_cmcp_reactor_free().
+ * Returns NULL and sets vsp_error_num() if failed.
+ */
+VSP_API vsp_cmcp_reactor *vsp_cmcp_reactor_create(int thread_count);
+
+/**
+ * Stop threads and free vsp_cmcp_reactor object.
+ * All servers and clients using this reactor have to be freed before.
+ * Object should be created with vsp_cmcp_reactor_create().
+ */
+VSP_API void vsp_cmcp_reactor_free(vsp_cmcp_reactor *cmcp_reactor);
+
+/**
+ * Get the number of threads of the reactor.
+ * Returns -1 and sets vsp_error_num() if cmcp_reactor is NULL.
+ */
+VSP_API int vsp_cmcp_reactor_get_thread_count(vsp_cmcp_reactor *cmcp_reactor);
+
+/** Internal node type driven by reactor threads, see vsp_cmcp_node.h. */
+struct vsp_cmcp_node;
+
+/**
+ * Add node to the least loaded thread of the reactor.
+ * The reactor thread invokes vsp_cmcp_node_process() and
+ * vsp_cmcp_node_receive_batch() until the node is detached.
+ * Used internally by vsp_cmcp_node_start(), not exported from the library.
+ */
+void vsp_cmcp_reactor_attach(vsp_cmcp_reactor *cmcp_reactor,
+    struct vsp_cmcp_node *cmcp_node);
+
+/**
+ * Remove node from its reactor thread and wait until the thread does not use
+ * the node anymore.
+ * Used internally by vsp_cmcp_node_stop(), not exported from the library.
+ */
+void vsp_cmcp_reactor_detach(vsp_cmcp_reactor *cmcp_reactor,
+    struct vsp_cmcp_node *cmcp_node);
+
+#if defined __cplusplus
+}
+#endif /* defined __cplusplus */
+
+#endif /* !defined VSP_CMCP_REACTOR_H_INCLUDED */
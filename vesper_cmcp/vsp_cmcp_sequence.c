@@ -0,0 +1,213 @@
+/**
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "vsp_cmcp_sequence.h"
+
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
+#include <string.h>
+
+/** Initial number of table entries. Has to be a power of two. */
+#define VSP_CMCP_SEQUENCE_INITIAL_CAPACITY 16
+
+/** Expected sequence number of a pair of sender and topic ID. */
+struct vsp_cmcp_sequence_entry {
+    /** Sender ID in the upper and topic ID in the lower 16 bits. */
+    uint32_t key;
+    /** Next expected sequence number. */
+    uint32_t next_sequence;
+    /** Non-zero if the entry is in use. */
+    int used;
+};
+
+/** Define type vsp_cmcp_sequence_entry to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_sequence_entry vsp_cmcp_sequence_entry;
+
+/** Hash table of expected sequence numbers. */
+struct vsp_cmcp_sequence {
+    /** Number of entries minus one; the capacity is a power of two. */
+    uint32_t mask;
+    /** Number of used entries. */
+    uint32_t count;
+    /** Table entries. */
+    vsp_cmcp_sequence_entry *entries;
+};
+
+/** Find the entry of the specified key or the free entry to insert it. */
+static vsp_cmcp_sequence_entry *vsp_cmcp_sequence_find(
+    vsp_cmcp_sequence *cmcp_sequence, uint32_t key);
+
+/** Insert an unused entry of the specified key, growing the table if
+ * necessary. Its sequence number has to be set by the caller. */
+static vsp_cmcp_sequence_entry *vsp_cmcp_sequence_insert(
+    vsp_cmcp_sequence *cmcp_sequence, uint32_t key);
+
+/** Allocate a table with the specified capacity and insert all used entries
+ * again. The capacity has to be a power of two larger than the count. */
+static void vsp_cmcp_sequence_rehash(vsp_cmcp_sequence *cmcp_sequence,
+    uint32_t capacity);
+
+vsp_cmcp_sequence *vsp_cmcp_sequence_create(void)
+{
+    vsp_cmcp_sequence *cmcp_sequence;
+
+    /* allocate memory */
+    VSP_ALLOC(cmcp_sequence, vsp_cmcp_sequence);
+    VSP_ALLOC_N(cmcp_sequence->entries, VSP_CMCP_SEQUENCE_INITIAL_CAPACITY
+        * sizeof(vsp_cmcp_sequence_entry));
+    /* initialize struct data */
+    cmcp_sequence->mask = VSP_CMCP_SEQUENCE_INITIAL_CAPACITY - 1;
+    cmcp_sequence->count = 0;
+    memset(cmcp_sequence->entries, 0, VSP_CMCP_SEQUENCE_INITIAL_CAPACITY
+        * sizeof(vsp_cmcp_sequence_entry));
+    /* return struct pointer */
+    return cmcp_sequence;
+}
+
+void vsp_cmcp_sequence_free(vsp_cmcp_sequence *cmcp_sequence)
+{
+    /* check parameter */
+    VSP_ASSERT(cmcp_sequence != NULL);
+
+    /* free memory */
+    VSP_FREE(cmcp_sequence->entries);
+    VSP_FREE(cmcp_sequence);
+}
+
+int32_t vsp_cmcp_sequence_check(vsp_cmcp_sequence *cmcp_sequence,
+    uint16_t sender_id, uint16_t topic_id, uint32_t sequence,
+    uint32_t *expected_sequence)
+{
+    vsp_cmcp_sequence_entry *entry;
+    uint32_t key;
+    int32_t difference;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_sequence != NULL && expected_sequence != NULL);
+
+    key = ((uint32_t) sender_id << 16) | topic_id;
+    entry = vsp_cmcp_sequence_find(cmcp_sequence, key);
+    if (!entry->used) {
+        /* first message of this pair starts its sequence */
+        entry = vsp_cmcp_sequence_insert(cmcp_sequence, key);
+        entry->next_sequence = sequence;
+    }
+
+    /* sequence numbers wrap around, so compare them by their difference */
+    *expected_sequence = entry->next_sequence;
+    difference = (int32_t) (sequence - entry->next_sequence);
+    if (difference >= 0) {
+        entry->next_sequence = sequence + 1;
+    }
+    return difference;
+}
+
+uint32_t vsp_cmcp_sequence_next(vsp_cmcp_sequence *cmcp_sequence,
+    uint16_t sender_id, uint16_t topic_id)
+{
+    vsp_cmcp_sequence_entry *entry;
+    uint32_t key;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_sequence != NULL);
+
+    key = ((uint32_t) sender_id << 16) | topic_id;
+    entry = vsp_cmcp_sequence_find(cmcp_sequence, key);
+    if (!entry->used) {
+        /* first message of this pair starts its sequence */
+        entry = vsp_cmcp_sequence_insert(cmcp_sequence, key);
+        entry->next_sequence = 0;
+    }
+    return entry->next_sequence++;
+}
+
+void vsp_cmcp_sequence_remove(vsp_cmcp_sequence *cmcp_sequence,
+    uint16_t sender_id)
+{
+    uint32_t index;
+    uint32_t removed_count;
+
+    /* check parameter */
+    VSP_ASSERT(cmcp_sequence != NULL);
+
+    /* mark entries of the sender as unused */
+    removed_count = 0;
+    for (index = 0; index <= cmcp_sequence->mask; ++index) {
+        if (cmcp_sequence->entries[index].used
+            && (cmcp_sequence->entries[index].key >> 16) == sender_id) {
+            cmcp_sequence->entries[index].used = 0;
+            ++removed_count;
+        }
+    }
+
+    /* unused entries break the probe sequences of following entries, so
+     * insert the remaining entries again */
+    if (removed_count > 0) {
+        cmcp_sequence->count -= removed_count;
+        vsp_cmcp_sequence_rehash(cmcp_sequence, cmcp_sequence->mask + 1);
+    }
+}
+
+vsp_cmcp_sequence_entry *vsp_cmcp_sequence_find(
+    vsp_cmcp_sequence *cmcp_sequence, uint32_t key)
+{
+    uint32_t index;
+
+    /* multiplicative hashing spreads consecutive sender IDs */
+    index = (key * (uint32_t) 2654435761u) & cmcp_sequence->mask;
+    /* linear probing; the table always has free entries */
+    while (cmcp_sequence->entries[index].used
+        && cmcp_sequence->entries[index].key != key) {
+        index = (index + 1) & cmcp_sequence->mask;
+    }
+    return &cmcp_sequence->entries[index];
+}
+
+vsp_cmcp_sequence_entry *vsp_cmcp_sequence_insert(
+    vsp_cmcp_sequence *cmcp_sequence, uint32_t key)
+{
+    vsp_cmcp_sequence_entry *entry;
+
+    /* keep the load factor at most one half, so probing stays short */
+    if ((cmcp_sequence->count + 1) * 2 > cmcp_sequence->mask + 1) {
+        vsp_cmcp_sequence_rehash(cmcp_sequence, 2 * (cmcp_sequence->mask + 1));
+    }
+    entry = vsp_cmcp_sequence_find(cmcp_sequence, key);
+    entry->key = key;
+    entry->used = 1;
+    ++cmcp_sequence->count;
+    return entry;
+}
+
+void vsp_cmcp_sequence_rehash(vsp_cmcp_sequence *cmcp_sequence,
+    uint32_t capacity)
+{
+    vsp_cmcp_sequence_entry *old_entries;
+    vsp_cmcp_sequence_entry *entry;
+    uint32_t old_capacity;
+    uint32_t index;
+
+    /* allocate new entries */
+    old_entries = cmcp_sequence->entries;
+    old_capacity = cmcp_sequence->mask + 1;
+    VSP_ALLOC_N(cmcp_sequence->entries,
+        capacity * sizeof(vsp_cmcp_sequence_entry));
+    memset(cmcp_sequence->entries, 0,
+        capacity * sizeof(vsp_cmcp_sequence_entry));
+    cmcp_sequence->mask = capacity - 1;
+
+    /* insert used entries again */
+    for (index = 0; index < old_capacity; ++index) {
+        if (old_entries[index].used) {
+            entry = vsp_cmcp_sequence_find(cmcp_sequence,
+                old_entries[index].key);
+            *entry = old_entries[index];
+        }
+    }
+    VSP_FREE(old_entries);
+}
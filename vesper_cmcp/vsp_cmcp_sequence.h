@@ -0,0 +1,74 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#if !defined VSP_CMCP_SEQUENCE_H_INCLUDED
+#define VSP_CMCP_SEQUENCE_H_INCLUDED
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif /* defined __cplusplus */
+
+/** Table of the next sequence number per pair of sender and topic ID, either
+ * expected from received messages to detect gaps or assigned to sent
+ * messages. The table is an open addressing hash table growing with the
+ * number of pairs seen. It is not locked and has to be used by a single
+ * thread at a time only. */
+struct vsp_cmcp_sequence;
+
+/** Define type vsp_cmcp_sequence to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_sequence vsp_cmcp_sequence;
+
+/**
+ * Create new empty vsp_cmcp_sequence object.
+ * Returned pointer should be freed with vsp_cmcp_sequence_free().
+ * Returns NULL and sets vsp_error_num() if failed.
+ */
+vsp_cmcp_sequence *vsp_cmcp_sequence_create(void);
+
+/**
+ * Free vsp_cmcp_sequence object.
+ * Object should be created with vsp_cmcp_sequence_create().
+ */
+void vsp_cmcp_sequence_free(vsp_cmcp_sequence *cmcp_sequence);
+
+/**
+ * Check the sequence number of a message received from the sender on the
+ * topic and update the next expected sequence number.
+ * Returns the difference between the received and the expected sequence
+ * number: zero if the message is in order or the first one of the pair,
+ * the number of skipped sequence numbers if messages are missing, or a
+ * negative number for a message arriving after a later one, which does not
+ * change the expected sequence number.
+ * The expected sequence number is stored in expected_sequence.
+ */
+int32_t vsp_cmcp_sequence_check(vsp_cmcp_sequence *cmcp_sequence,
+    uint16_t sender_id, uint16_t topic_id, uint32_t sequence,
+    uint32_t *expected_sequence);
+
+/**
+ * Get the sequence number of the next message sent by the sender on the topic
+ * and advance it. The sequence of a new pair starts at zero.
+ */
+uint32_t vsp_cmcp_sequence_next(vsp_cmcp_sequence *cmcp_sequence,
+    uint16_t sender_id, uint16_t topic_id);
+
+/**
+ * Remove the expected sequence numbers of all topics of the sender, e.g. when
+ * it disconnected. A later message of the sender starts a new sequence.
+ */
+void vsp_cmcp_sequence_remove(vsp_cmcp_sequence *cmcp_sequence,
+    uint16_t sender_id);
+
+#if defined __cplusplus
+}
+#endif /* defined __cplusplus */
+
+#endif /* !defined VSP_CMCP_SEQUENCE_H_INCLUDED */
@@ -8,23 +8,72 @@
 
 #include "vsp_cmcp_server.h"
 #include "vsp_cmcp_command.h"
+#include "vsp_cmcp_dispatch.h"
 #include "vsp_cmcp_node.h"
+#include "vsp_cmcp_queue.h"
+#include "vsp_cmcp_stream.h"
 
 #include <vesper_util/vsp_error.h>
 #include <vesper_util/vsp_time.h>
 #include <vesper_util/vsp_util.h>
+#include <string.h>
 
-#define VSP_CMCP_SERVER_MAX_PEERS 16
+/** Default maximum number of registered client peers. */
+#define VSP_CMCP_SERVER_DEFAULT_MAX_PEERS 16
+
+/** Initial capacity of the client peer table. */
+#define VSP_CMCP_SERVER_INITIAL_PEER_CAPACITY 16
+
+/** Milliseconds between attempts to queue disconnection events that did not
+ * fit into the full receive queue. */
+#define VSP_CMCP_SERVER_QUEUE_RETRY_TIMEOUT 10
 
 /** Data of a network node connected to server. */
 struct vsp_cmcp_server_peer {
+    /** ID of this peer. */
+    uint16_t id;
     /** The time when the connection to this peer times out. */
     struct timespec time_connection_timeout;
+    /** Index of the peer timing out before this one, or -1. */
+    int timeout_previous;
+    /** Index of the peer timing out after this one, or -1. */
+    int timeout_next;
+    /** Protocol features supported by this peer. */
+    uint32_t features;
+    /** Bit set of multicast groups joined by this peer. */
+    uint32_t groups[VSP_CMCP_GROUP_COUNT / 32];
 };
 
 /** Define type vsp_cmcp_server_peer to avoid 'struct' keyword. */
 typedef struct vsp_cmcp_server_peer vsp_cmcp_server_peer;
 
+/** Members of a multicast group, counted by the protocol features the
+ * message sent to the group has to be compatible with. */
+struct vsp_cmcp_server_group {
+    /** Number of registered client peers which joined this group. */
+    int member_count;
+    /** Number of members able to receive large data list items. */
+    int large_items_count;
+    /** Number of members requesting traced messages. */
+    int trace_count;
+};
+
+/** Define type vsp_cmcp_server_group to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_server_group vsp_cmcp_server_group;
+
+/** Client peer table replaced when the table was grown. */
+struct vsp_cmcp_server_retired_table {
+    /** Table retired before this one, or NULL. */
+    struct vsp_cmcp_server_retired_table *next;
+    /** Retired client peers. */
+    vsp_cmcp_server_peer *clients;
+    /** Retired hash index. */
+    int *client_index;
+};
+
+/** Define type vsp_cmcp_server_retired_table to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_server_retired_table vsp_cmcp_server_retired_table;
+
 /** State and other data used for network connection. */
 struct vsp_cmcp_server {
     /** Basic node and finite-state machine data. */
@@ -32,11 +81,34 @@ struct vsp_cmcp_server {
     /** ID identifying this server in the network. */
     uint16_t id;
     /** Number of registered client peers. */
-    uint16_t client_count;
-    /** Client peer IDs. */
-    uint16_t client_ids[VSP_CMCP_SERVER_MAX_PEERS];
-    /** Client peer data. */
-    vsp_cmcp_server_peer *client_data[VSP_CMCP_SERVER_MAX_PEERS];
+    int client_count;
+    /** Number of client peers fitting into the allocated peer table. */
+    int client_capacity;
+    /** Maximum number of registered client peers. */
+    int max_client_count;
+    /** Registered client peers, stored contiguously. */
+    vsp_cmcp_server_peer *clients;
+    /** Hash index over client peer IDs with two slots per peer, using linear
+     * probing. Slots store the peer index plus one, zero marks free slots. */
+    int *client_index;
+    /** Sequence counter of the client peer table, odd while the reception
+     * thread modifies the table. Sending threads read the table without
+     * locking and retry if the counter changed meanwhile. */
+    unsigned int peer_sequence;
+    /** Tables replaced by growing the client peer table. Sending threads may
+     * still read them, so they are only freed with the server. */
+    vsp_cmcp_server_retired_table *retired_tables;
+    /** Multicast groups, modified by the reception thread together with the
+     * client peer table and read by sending threads the same way. */
+    vsp_cmcp_server_group *groups;
+    /** Index of the client peer timing out first, or -1.
+     * All peers use the same timeout duration, so appending refreshed peers
+     * keeps this list ordered by deadline. */
+    int timeout_first;
+    /** Index of the client peer timing out last, or -1. */
+    int timeout_last;
+    /** Time read once per reception loop iteration, used for deadlines. */
+    struct timespec time_now;
     /** Callback function parameter. */
     void *callback_param;
     /** Client announcement callback function. */
@@ -45,30 +117,134 @@ struct vsp_cmcp_server {
     vsp_cmcp_server_disconnect_cb disconnect_cb;
     /** Message callback function. */
     vsp_cmcp_server_message_cb message_cb;
+    /** Number of worker threads invoking the message callback function, or
+     * zero to invoke it from the reception thread. */
+    int worker_count;
+    /** Maximum number of messages queued for every worker thread. */
+    int worker_queue_capacity;
+    /** Worker threads invoking the message callback function, created on
+     * binding if worker_count is positive, or NULL. */
+    vsp_cmcp_dispatch *cmcp_dispatch;
+    /** Capacity of the receive queue, or zero to invoke the message callback
+     * function without queueing messages. */
+    int receive_queue_capacity;
+    /** Queue handing received messages to vsp_cmcp_server_process_messages(),
+     * created on binding if receive_queue_capacity is positive, or NULL. */
+    vsp_cmcp_queue *receive_queue;
+    /** Message object reused to parse every message popped from the receive
+     * queue, or NULL. */
+    vsp_cmcp_message *queue_message;
+    /** Outgoing and incoming streams. */
+    vsp_cmcp_stream_table *stream_table;
+    /** Stream chunk callback function. */
+    vsp_cmcp_server_stream_cb stream_cb;
+    /** Trace callback function. */
+    vsp_cmcp_trace_cb trace_cb;
+    /** Sequence gap callback function. */
+    vsp_cmcp_gap_cb gap_cb;
 };
 
 /** Regular callback function invoked by cmcp_node.
- * This function will be called regularly. */
-static void vsp_cmcp_server_regular_callback(void *param);
+ * This function will be called regularly.
+ * Returns the number of milliseconds until the next client peer times out or
+ * disconnection events are queued again, or -1 if nothing is pending. */
+static int vsp_cmcp_server_regular_callback(void *param);
 
 /** Message callback function invoked by cmcp_node.
  * This function will be called for every received message. */
 static void vsp_cmcp_server_message_callback(void *param,
     vsp_cmcp_message *cmcp_message);
 
+/** Callback function invoked by cmcp_dispatch from a worker thread.
+ * This function will be called for every received data message and, with
+ * data list NULL, for every disconnected client. */
+static void vsp_cmcp_server_dispatch_callback(void *param, uint16_t client_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
+
+/** Take the buffer of the message currently handled and append it to the
+ * receive queue. If the queue is full, the message is dropped. */
+static void vsp_cmcp_server_queue_message(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id);
+
+/** Pop and free all messages of the receive queue without handling them. */
+static void vsp_cmcp_server_clear_receive_queue(vsp_cmcp_server *cmcp_server);
+
+/** Trace callback function invoked by cmcp_node.
+ * This function will be called for every received traced message. */
+static void vsp_cmcp_server_trace_callback(void *param,
+    const vsp_cmcp_trace *cmcp_trace);
+
+/** Gap callback function invoked by cmcp_node.
+ * This function will be called for every gap in the sequence numbers of
+ * received traced messages. */
+static void vsp_cmcp_server_gap_callback(void *param, uint16_t sender_id,
+    uint16_t topic_id, uint32_t expected_sequence, uint32_t lost_count);
+
+/** Stream chunk callback function invoked by stream_table.
+ * This function will be called for every received stream chunk. */
+static void vsp_cmcp_server_stream_callback(void *param, uint16_t client_id,
+    uint16_t stream_id, uint32_t chunk_length, void *chunk_data);
+
 /** Handle an internal CMCP control message. */
 void vsp_cmcp_server_handle_control_message(vsp_cmcp_server *cmcp_server,
     uint16_t sender_id, uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
 
 /** Try to register newly connected client and send (negative) acknowledge. */
 static void vsp_cmcp_server_register_client(vsp_cmcp_server *cmcp_server,
-    uint16_t client_id, uint64_t client_nonce);
+    uint16_t client_id, uint64_t client_nonce, uint32_t client_features);
 
 /** Search for client peer ID in registered peers.
  * Returns client peer index if found and -1 else. */
 static int vsp_cmcp_server_find_client(
     vsp_cmcp_server *cmcp_server, uint16_t client_id);
 
+/** Search for client peer ID in registered peers from any thread.
+ * The features of the client peer are stored if client_features is not NULL.
+ * Returns zero if found and non-zero else. */
+static int vsp_cmcp_server_lookup_client(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, uint32_t *client_features);
+
+/** Start modifying the client peer table, which only the reception thread
+ * does. Threads looking up client peers meanwhile retry afterwards. */
+static void vsp_cmcp_server_begin_peer_update(vsp_cmcp_server *cmcp_server);
+
+/** Finish modifying the client peer table. */
+static void vsp_cmcp_server_end_peer_update(vsp_cmcp_server *cmcp_server);
+
+/** Remove a client peer from the deadline-ordered timeout list. */
+static void vsp_cmcp_server_unlink_timeout(vsp_cmcp_server *cmcp_server,
+    int index);
+
+/** Set the timeout of a client peer, which is not in the timeout list, to
+ * VSP_CMCP_NODE_CONNECTION_TIMEOUT after the current time and append it to
+ * the timeout list. */
+static void vsp_cmcp_server_append_timeout(vsp_cmcp_server *cmcp_server,
+    int index);
+
+/** Double the capacity of the client peer table and rebuild its hash index. */
+static void vsp_cmcp_server_grow_clients(vsp_cmcp_server *cmcp_server);
+
+/** Get the hash index slot where probing for the client ID starts in a peer
+ * table of the specified capacity. */
+static int vsp_cmcp_server_hash_client(int client_capacity,
+    uint16_t client_id);
+
+/** Get the hash index slot referring to the client peer with the specified
+ * index. The client peer has to be registered. */
+static int vsp_cmcp_server_find_client_slot(vsp_cmcp_server *cmcp_server,
+    int index);
+
+/** Add the client peer with the specified index to a multicast group, or
+ * remove it if join is zero. Joining twice or leaving a group the client peer
+ * has not joined does nothing. Has to be called between
+ * vsp_cmcp_server_begin_peer_update() and vsp_cmcp_server_end_peer_update(). */
+static void vsp_cmcp_server_update_group(vsp_cmcp_server *cmcp_server,
+    int index, uint16_t group_id, int join);
+
+/** Read the member counts of a multicast group from any thread. */
+static void vsp_cmcp_server_lookup_group(vsp_cmcp_server *cmcp_server,
+    uint16_t group_id, vsp_cmcp_server_group *group);
+
 /** Deregister the client with the specified ID.
  * Future messages of this ID will be ignored (except announcements). */
 static void vsp_cmcp_server_deregister_client(vsp_cmcp_server *cmcp_server,
@@ -88,30 +264,89 @@ vsp_cmcp_server *vsp_cmcp_server_create(void)
         VSP_FREE(cmcp_server); return NULL);
     /* get node ID */
     cmcp_server->id = vsp_cmcp_node_get_id(cmcp_server->cmcp_node);
-    /* no client peers registered yet */
+    /* initialize stream table */
+    cmcp_server->stream_table = vsp_cmcp_stream_table_create(
+        cmcp_server->cmcp_node, vsp_cmcp_server_stream_callback, cmcp_server);
+    /* vsp_error_num() is set by vsp_cmcp_stream_table_create() */
+    VSP_CHECK(cmcp_server->stream_table != NULL,
+        vsp_cmcp_node_free(cmcp_server->cmcp_node); VSP_FREE(cmcp_server);
+        return NULL);
+    /* no client peers registered yet; table is allocated on demand */
     cmcp_server->client_count = 0;
+    cmcp_server->client_capacity = 0;
+    cmcp_server->max_client_count = VSP_CMCP_SERVER_DEFAULT_MAX_PEERS;
+    cmcp_server->clients = NULL;
+    cmcp_server->client_index = NULL;
+    cmcp_server->peer_sequence = 0;
+    cmcp_server->retired_tables = NULL;
+    /* no multicast group has members yet */
+    VSP_ALLOC_N(cmcp_server->groups,
+        VSP_CMCP_GROUP_COUNT * sizeof(vsp_cmcp_server_group));
+    memset(cmcp_server->groups, 0,
+        VSP_CMCP_GROUP_COUNT * sizeof(vsp_cmcp_server_group));
+    cmcp_server->timeout_first = -1;
+    cmcp_server->timeout_last = -1;
+    vsp_time_real_timespec(&cmcp_server->time_now);
     /* initialize callback parameter and functions */
     cmcp_server->callback_param = NULL;
     cmcp_server->announcement_cb = NULL;
     cmcp_server->disconnect_cb = NULL;
     cmcp_server->message_cb = NULL;
+    cmcp_server->stream_cb = NULL;
+    cmcp_server->trace_cb = NULL;
+    cmcp_server->gap_cb = NULL;
+    /* invoke message callback function from reception thread by default */
+    cmcp_server->worker_count = 0;
+    cmcp_server->worker_queue_capacity = 0;
+    cmcp_server->cmcp_dispatch = NULL;
+    cmcp_server->receive_queue_capacity = 0;
+    cmcp_server->receive_queue = NULL;
+    cmcp_server->queue_message = NULL;
     /* return struct pointer */
     return cmcp_server;
 }
 
 void vsp_cmcp_server_free(vsp_cmcp_server *cmcp_server)
 {
+    vsp_cmcp_server_retired_table *retired_table;
+
     /* check parameter */
     VSP_CHECK(cmcp_server != NULL, return);
 
+    if (cmcp_server->cmcp_dispatch != NULL) {
+        /* stop reception thread, then let workers handle queued messages
+         * while the sockets can still be used to reply */
+        vsp_cmcp_node_stop(cmcp_server->cmcp_node);
+        vsp_cmcp_dispatch_free(cmcp_server->cmcp_dispatch);
+    }
+
+    if (cmcp_server->receive_queue != NULL) {
+        /* stop reception thread, then drop messages not processed yet */
+        vsp_cmcp_node_stop(cmcp_server->cmcp_node);
+        vsp_cmcp_server_clear_receive_queue(cmcp_server);
+        vsp_cmcp_queue_free(cmcp_server->receive_queue);
+        vsp_cmcp_message_free(cmcp_server->queue_message);
+    }
+
     /* free node base type */
     vsp_cmcp_node_free(cmcp_server->cmcp_node);
 
-    /* clean up registered client peer data */
-    for (; cmcp_server->client_count > 0; --cmcp_server->client_count) {
-        /* when n elements are left, the (n-1)'th element is freed */
-        VSP_FREE(cmcp_server->client_data[cmcp_server->client_count - 1]);
+    /* free stream table */
+    vsp_cmcp_stream_table_free(cmcp_server->stream_table);
+
+    /* clean up client peer table */
+    if (cmcp_server->clients != NULL) {
+        VSP_FREE(cmcp_server->clients);
+        VSP_FREE(cmcp_server->client_index);
     }
+    while (cmcp_server->retired_tables != NULL) {
+        retired_table = cmcp_server->retired_tables;
+        cmcp_server->retired_tables = retired_table->next;
+        VSP_FREE(retired_table->clients);
+        VSP_FREE(retired_table->client_index);
+        VSP_FREE(retired_table);
+    }
+    VSP_FREE(cmcp_server->groups);
 
     /* free memory */
     VSP_FREE(cmcp_server);
@@ -157,6 +392,242 @@ void vsp_cmcp_server_set_message_cb(vsp_cmcp_server *cmcp_server,
     cmcp_server->message_cb = message_cb;
 }
 
+void vsp_cmcp_server_set_stream_cb(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_server_stream_cb stream_cb)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL, return);
+
+    /* set callback function */
+    cmcp_server->stream_cb = stream_cb;
+}
+
+void vsp_cmcp_server_set_trace_cb(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_trace_cb trace_cb)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL, return);
+
+    /* set callback function; peers are only asked for trace data if set */
+    cmcp_server->trace_cb = trace_cb;
+    vsp_cmcp_node_set_trace_callback(cmcp_server->cmcp_node,
+        trace_cb != NULL ? vsp_cmcp_server_trace_callback : NULL);
+}
+
+void vsp_cmcp_server_set_gap_cb(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_gap_cb gap_cb)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL, return);
+
+    /* set callback function; peers are only asked for trace data if set */
+    cmcp_server->gap_cb = gap_cb;
+    vsp_cmcp_node_set_gap_callback(cmcp_server->cmcp_node,
+        gap_cb != NULL ? vsp_cmcp_server_gap_callback : NULL);
+}
+
+int vsp_cmcp_server_set_receive_batch_size(vsp_cmcp_server *cmcp_server,
+    int batch_size)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && batch_size > 0,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* set batch size of node base type */
+    vsp_cmcp_node_set_receive_batch_size(cmcp_server->cmcp_node, batch_size);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_server_set_reactor(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_reactor *cmcp_reactor)
+{
+    /* check parameter; reactor may be NULL */
+    VSP_CHECK(cmcp_server != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    /* set reactor of node base type; fails if sockets are initialized */
+    return vsp_cmcp_node_set_reactor(cmcp_server->cmcp_node, cmcp_reactor);
+}
+
+int vsp_cmcp_server_set_max_clients(vsp_cmcp_server *cmcp_server,
+    int max_client_count)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && max_client_count > 0,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* set maximum number of client peers */
+    cmcp_server->max_client_count = max_client_count;
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_server_set_worker_count(vsp_cmcp_server *cmcp_server,
+    int worker_count, int queue_capacity)
+{
+    /* check parameters; queue capacity is ignored without worker threads */
+    VSP_CHECK(cmcp_server != NULL && worker_count >= 0
+        && (worker_count == 0 || queue_capacity > 0),
+        vsp_error_set_num(EINVAL); return -1);
+    /* check if worker threads are not yet started */
+    VSP_CHECK(cmcp_server->cmcp_dispatch == NULL,
+        vsp_error_set_num(EALREADY); return -1);
+
+    /* set number of worker threads started on binding */
+    cmcp_server->worker_count = worker_count;
+    cmcp_server->worker_queue_capacity = queue_capacity;
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_server_set_receive_queue(vsp_cmcp_server *cmcp_server,
+    int capacity)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && capacity >= 0,
+        vsp_error_set_num(EINVAL); return -1);
+    /* check if receive queue is not yet created */
+    VSP_CHECK(cmcp_server->receive_queue == NULL,
+        vsp_error_set_num(EALREADY); return -1);
+
+    /* set capacity of receive queue created on binding */
+    cmcp_server->receive_queue_capacity = capacity;
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_server_get_receive_fd(vsp_cmcp_server *cmcp_server)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && cmcp_server->receive_queue != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    return vsp_cmcp_queue_get_fd(cmcp_server->receive_queue);
+}
+
+int vsp_cmcp_server_process_messages(vsp_cmcp_server *cmcp_server,
+    int max_count)
+{
+    int count;
+    int data_length;
+    void *message_buffer;
+    uint16_t client_id;
+    vsp_cmcp_datalist *cmcp_datalist;
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && cmcp_server->receive_queue != NULL
+        && max_count > 0, vsp_error_set_num(EINVAL); return -1);
+
+    for (count = 0; count < max_count; ++count) {
+        ret = vsp_cmcp_queue_pop(cmcp_server->receive_queue, &client_id,
+            &data_length, &message_buffer);
+        if (ret != 0) {
+            /* no more queued messages */
+            break;
+        }
+        if (message_buffer == NULL) {
+            /* client was disconnected after its queued messages */
+            if (cmcp_server->disconnect_cb != NULL) {
+                cmcp_server->disconnect_cb(cmcp_server->callback_param,
+                    client_id);
+            }
+            continue;
+        }
+        /* parse message in place; it was already checked when received */
+        ret = vsp_cmcp_message_parse(cmcp_server->queue_message, data_length,
+            message_buffer);
+        if (ret == 0 && cmcp_server->message_cb != NULL) {
+            /* callback function registered; invoke it, letting it take over
+             * the message buffer */
+            cmcp_datalist =
+                vsp_cmcp_message_get_datalist(cmcp_server->queue_message);
+            vsp_cmcp_datalist_attach_buffer(cmcp_datalist, message_buffer, 1);
+            cmcp_server->message_cb(cmcp_server->callback_param, client_id,
+                vsp_cmcp_message_get_command_id(cmcp_server->queue_message),
+                cmcp_datalist);
+            if (vsp_cmcp_datalist_detach_buffer(cmcp_datalist) != 0) {
+                /* message buffer is owned by the callback function now */
+                continue;
+            }
+        }
+        vsp_cmcp_node_free_message(message_buffer);
+    }
+
+    /* keep file descriptor readable if messages are left */
+    vsp_cmcp_queue_acknowledge(cmcp_server->receive_queue);
+
+    return count;
+}
+
+int vsp_cmcp_server_get_receive_queue_stats(vsp_cmcp_server *cmcp_server,
+    int *queued_count, uint64_t *dropped_count)
+{
+    /* check parameters; statistics pointers may be NULL */
+    VSP_CHECK(cmcp_server != NULL && cmcp_server->receive_queue != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    if (queued_count != NULL) {
+        *queued_count = vsp_cmcp_queue_get_count(cmcp_server->receive_queue);
+    }
+    if (dropped_count != NULL) {
+        *dropped_count =
+            vsp_cmcp_queue_get_drop_count(cmcp_server->receive_queue);
+    }
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_server_get_worker_queue_stats(vsp_cmcp_server *cmcp_server,
+    int *queued_count, uint64_t *dropped_count)
+{
+    /* check parameters; statistics pointers may be NULL */
+    VSP_CHECK(cmcp_server != NULL && cmcp_server->cmcp_dispatch != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    if (queued_count != NULL) {
+        *queued_count = vsp_cmcp_dispatch_get_count(cmcp_server->cmcp_dispatch);
+    }
+    if (dropped_count != NULL) {
+        *dropped_count =
+            vsp_cmcp_dispatch_get_drop_count(cmcp_server->cmcp_dispatch);
+    }
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_server_get_stats(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_stats *cmcp_stats)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && cmcp_stats != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* copy counters of node base type */
+    vsp_cmcp_node_get_stats(cmcp_server->cmcp_node, cmcp_stats);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_server_get_latency(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_latency_type latency_type, vsp_cmcp_latency *cmcp_latency)
+{
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && cmcp_latency != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* vsp_error_num() is set by vsp_cmcp_node_get_latency() */
+    return vsp_cmcp_node_get_latency(cmcp_server->cmcp_node, latency_type,
+        cmcp_latency);
+}
+
 int vsp_cmcp_server_bind(vsp_cmcp_server *cmcp_server,
     const char *publish_address, const char *subscribe_address)
 {
@@ -172,7 +643,25 @@ int vsp_cmcp_server_bind(vsp_cmcp_server *cmcp_server,
     /* vsp_error_num() is set by vsp_cmcp_node_connect() */
     VSP_CHECK(ret == 0, return -1);
 
-    /* start worker thread */
+    if (cmcp_server->receive_queue_capacity > 0) {
+        /* create receive queue before messages are received */
+        cmcp_server->receive_queue = vsp_cmcp_queue_create(
+            cmcp_server->receive_queue_capacity);
+        /* in case of failure vsp_error_num() is already set */
+        VSP_ASSERT(cmcp_server->receive_queue != NULL);
+        cmcp_server->queue_message = vsp_cmcp_message_create_view();
+        /* in case of failure vsp_error_num() is already set */
+        VSP_ASSERT(cmcp_server->queue_message != NULL);
+    } else if (cmcp_server->worker_count > 0) {
+        /* start worker threads before messages are received */
+        cmcp_server->cmcp_dispatch = vsp_cmcp_dispatch_create(
+            cmcp_server->worker_count, cmcp_server->worker_queue_capacity,
+            vsp_cmcp_server_dispatch_callback, cmcp_server);
+        /* in case of failure vsp_error_num() is already set */
+        VSP_ASSERT(cmcp_server->cmcp_dispatch != NULL);
+    }
+
+    /* start reception thread */
     vsp_cmcp_node_start(cmcp_server->cmcp_node);
 
     /* sockets successfully bound */
@@ -183,19 +672,27 @@ int vsp_cmcp_server_send(vsp_cmcp_server *cmcp_server,
     uint16_t client_id, uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
 {
     int ret;
-    int client_index;
+    uint32_t client_features;
 
     /* check parameters */
     VSP_CHECK(cmcp_server != NULL, vsp_error_set_num(EINVAL); return -1);
 
     /* try to find client in registered peers */
-    client_index = vsp_cmcp_server_find_client(cmcp_server, client_id);
-    VSP_CHECK(client_index >= 0, vsp_error_set_num(EINVAL); return -1);
+    ret = vsp_cmcp_server_lookup_client(cmcp_server, client_id,
+        &client_features);
+    VSP_CHECK(ret == 0, vsp_error_set_num(EINVAL); return -1);
+
+    /* check if client is able to receive large data list items */
+    VSP_CHECK(cmcp_datalist == NULL
+        || vsp_cmcp_datalist_has_large_items(cmcp_datalist) == 0
+        || (client_features & VSP_CMCP_FEATURE_LARGE_ITEMS) != 0,
+        vsp_error_set_num(EMSGSIZE); return -1);
 
-    /* send message */
+    /* send message, traced if requested by the client */
     ret = vsp_cmcp_node_create_send_message(cmcp_server->cmcp_node,
         VSP_CMCP_MESSAGE_TYPE_DATA, client_id, cmcp_server->id,
-        command_id, cmcp_datalist);
+        command_id, cmcp_datalist,
+        (client_features & VSP_CMCP_FEATURE_TRACE) != 0);
 
     /* vsp_error_num() is set by vsp_cmcp_node_create_send_message() */
     VSP_CHECK(ret == 0, return -1);
@@ -204,25 +701,233 @@ int vsp_cmcp_server_send(vsp_cmcp_server *cmcp_server,
     return 0;
 }
 
-void vsp_cmcp_server_regular_callback(void *param)
+int vsp_cmcp_server_send_batch(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, int message_count, const uint16_t *command_ids,
+    vsp_cmcp_datalist **cmcp_datalists)
+{
+    int ret;
+    uint32_t client_features;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && message_count > 0 && command_ids != NULL
+        && cmcp_datalists != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    /* try to find client in registered peers */
+    ret = vsp_cmcp_server_lookup_client(cmcp_server, client_id,
+        &client_features);
+    VSP_CHECK(ret == 0, vsp_error_set_num(EINVAL); return -1);
+
+    /* send batch message, traced if requested by the client */
+    ret = vsp_cmcp_node_create_send_batch(cmcp_server->cmcp_node,
+        VSP_CMCP_MESSAGE_TYPE_DATA, client_id, cmcp_server->id,
+        message_count, command_ids, cmcp_datalists,
+        (client_features & VSP_CMCP_FEATURE_TRACE) != 0);
+
+    /* vsp_error_num() is set by vsp_cmcp_node_create_send_batch() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* messages sent successfully */
+    return 0;
+}
+
+int vsp_cmcp_server_send_packet(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, vsp_cmcp_packet *cmcp_packet)
+{
+    int ret;
+    uint32_t client_features;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && cmcp_packet != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* try to find client in registered peers */
+    ret = vsp_cmcp_server_lookup_client(cmcp_server, client_id,
+        &client_features);
+    VSP_CHECK(ret == 0, vsp_error_set_num(EINVAL); return -1);
+
+    /* check if client is able to receive large data list items */
+    VSP_CHECK(vsp_cmcp_packet_has_large_items(cmcp_packet) == 0
+        || (client_features & VSP_CMCP_FEATURE_LARGE_ITEMS) != 0,
+        vsp_error_set_num(EMSGSIZE); return -1);
+
+    /* send encoded message, traced if requested by the client */
+    ret = vsp_cmcp_node_send_packet(cmcp_server->cmcp_node, client_id,
+        cmcp_server->id, cmcp_packet,
+        (client_features & VSP_CMCP_FEATURE_TRACE) != 0);
+
+    /* vsp_error_num() is set by vsp_cmcp_node_send_packet() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* message sent successfully */
+    return 0;
+}
+
+int vsp_cmcp_server_send_group(vsp_cmcp_server *cmcp_server,
+    uint16_t group_id, uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
+{
+    int ret;
+    vsp_cmcp_server_group group;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && group_id < VSP_CMCP_GROUP_COUNT,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* get current members */
+    vsp_cmcp_server_lookup_group(cmcp_server, group_id, &group);
+    if (group.member_count == 0) {
+        /* nobody would receive the message */
+        return 0;
+    }
+
+    /* check if all members are able to receive large data list items */
+    VSP_CHECK(cmcp_datalist == NULL
+        || vsp_cmcp_datalist_has_large_items(cmcp_datalist) == 0
+        || group.large_items_count == group.member_count,
+        vsp_error_set_num(EMSGSIZE); return -1);
+
+    /* send message once to the group topic, traced if requested by all
+     * members, as they receive the same message buffer */
+    ret = vsp_cmcp_node_create_send_message(cmcp_server->cmcp_node,
+        VSP_CMCP_MESSAGE_TYPE_DATA, VSP_CMCP_GROUP_TOPIC_ID + group_id,
+        cmcp_server->id, command_id, cmcp_datalist,
+        group.trace_count == group.member_count);
+
+    /* vsp_error_num() is set by vsp_cmcp_node_create_send_message() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* message sent successfully */
+    return 0;
+}
+
+int vsp_cmcp_server_get_group_size(vsp_cmcp_server *cmcp_server,
+    uint16_t group_id)
+{
+    vsp_cmcp_server_group group;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && group_id < VSP_CMCP_GROUP_COUNT,
+        vsp_error_set_num(EINVAL); return -1);
+
+    vsp_cmcp_server_lookup_group(cmcp_server, group_id, &group);
+    return group.member_count;
+}
+
+int vsp_cmcp_server_stream_open(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, uint16_t stream_id)
+{
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    /* check if client is registered */
+    VSP_CHECK(vsp_cmcp_server_lookup_client(cmcp_server, client_id, NULL) == 0,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* open stream */
+    ret = vsp_cmcp_stream_open(cmcp_server->stream_table, client_id,
+        stream_id);
+    /* vsp_error_num() is set by vsp_cmcp_stream_open() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_server_stream_push(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, uint16_t stream_id, uint32_t chunk_length,
+    void *chunk_data)
+{
+    int ret;
+    uint32_t client_features;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL && chunk_length > 0 && chunk_data != NULL,
+        vsp_error_set_num(EINVAL); return -1);
+
+    /* try to find client in registered peers */
+    ret = vsp_cmcp_server_lookup_client(cmcp_server, client_id,
+        &client_features);
+    VSP_CHECK(ret == 0, vsp_error_set_num(EINVAL); return -1);
+
+    /* check if client is able to receive large chunks */
+    VSP_CHECK(chunk_length < VSP_CMCP_DATALIST_EXTENDED_LENGTH
+        || (client_features & VSP_CMCP_FEATURE_LARGE_ITEMS) != 0,
+        vsp_error_set_num(EMSGSIZE); return -1);
+
+    /* send chunk, waiting for credit if necessary */
+    ret = vsp_cmcp_stream_push(cmcp_server->stream_table, client_id,
+        cmcp_server->id, client_id, stream_id, chunk_length, chunk_data);
+    /* vsp_error_num() is set by vsp_cmcp_stream_push() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_server_stream_close(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, uint16_t stream_id)
+{
+    int ret;
+
+    /* check parameters */
+    VSP_CHECK(cmcp_server != NULL, vsp_error_set_num(EINVAL); return -1);
+
+    /* close stream, waiting for the client to process all chunks */
+    ret = vsp_cmcp_stream_close(cmcp_server->stream_table, client_id,
+        cmcp_server->id, client_id, stream_id);
+    /* vsp_error_num() is set by vsp_cmcp_stream_close() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_server_regular_callback(void *param)
 {
     vsp_cmcp_server *cmcp_server;
     int index;
+    int timeout;
 
     /* check parameters; failures are silently ignored */
-    VSP_CHECK(param != NULL, return);
+    VSP_CHECK(param != NULL, return -1);
 
     cmcp_server = (vsp_cmcp_server*) param;
 
-    /* check if client peer connections have timed out */
-    for (index = 0; index < cmcp_server->client_count; ++index) {
-        if (vsp_time_real_timespec_passed(
-            &cmcp_server->client_data[index]->time_connection_timeout) == 0) {
-            /* client peer connection timed out */
-            vsp_cmcp_server_deregister_client(cmcp_server,
-                cmcp_server->client_ids[index]);
-        }
+    /* read the clock once for all deadlines until the next invocation */
+    vsp_time_real_timespec(&cmcp_server->time_now);
+
+    /* deregister timed out client peers; the timeout list is ordered by
+     * deadline, so only expired peers are visited */
+    index = cmcp_server->timeout_first;
+    while (index >= 0 && vsp_time_timespec_passed(
+        &cmcp_server->clients[index].time_connection_timeout,
+        &cmcp_server->time_now) == 0) {
+        /* client peer connection timed out */
+        vsp_cmcp_node_count_timeout(cmcp_server->cmcp_node);
+        vsp_cmcp_server_deregister_client(cmcp_server,
+            cmcp_server->clients[index].id);
+        index = cmcp_server->timeout_first;
+    }
+
+    /* time until next client peer times out; no deadline if no client peers
+     * are registered */
+    timeout = -1;
+    if (index >= 0) {
+        timeout = (int) vsp_time_timespec_milliseconds_until(
+            &cmcp_server->clients[index].time_connection_timeout,
+            &cmcp_server->time_now);
+    }
+
+    /* retry queueing disconnection events until the application thread has
+     * made room in the receive queue */
+    if (cmcp_server->receive_queue != NULL
+        && vsp_cmcp_queue_flush(cmcp_server->receive_queue) > 0
+        && (timeout < 0 || timeout > VSP_CMCP_SERVER_QUEUE_RETRY_TIMEOUT)) {
+        timeout = VSP_CMCP_SERVER_QUEUE_RETRY_TIMEOUT;
     }
+
+    return timeout;
 }
 
 void vsp_cmcp_server_message_callback(void *param,
@@ -256,9 +961,8 @@ void vsp_cmcp_server_message_callback(void *param,
     client_index = vsp_cmcp_server_find_client(cmcp_server, sender_id);
     if (client_index >= 0) {
         /* reset client peer timeout time */
-        vsp_time_real_timespec_from_now(
-            &cmcp_server->client_data[client_index]->time_connection_timeout,
-            VSP_CMCP_NODE_CONNECTION_TIMEOUT);
+        vsp_cmcp_server_unlink_timeout(cmcp_server, client_index);
+        vsp_cmcp_server_append_timeout(cmcp_server, client_index);
     }
 
     /* check if internal control message received */
@@ -278,7 +982,16 @@ void vsp_cmcp_server_message_callback(void *param,
          * supported yet */
         VSP_CHECK(client_index >= 0, return);
         /* handle data message */
-        if (cmcp_server->message_cb != NULL) {
+        if (cmcp_server->receive_queue != NULL) {
+            /* hand message buffer over to the application thread */
+            vsp_cmcp_server_queue_message(cmcp_server, sender_id);
+        } else if (cmcp_server->cmcp_dispatch != NULL) {
+            /* copy message and let a worker thread invoke the callback
+             * function; messages exceeding the worker queue are dropped and
+             * counted, other failures are silently ignored */
+            vsp_cmcp_dispatch_push(cmcp_server->cmcp_dispatch, sender_id,
+                command_id, cmcp_datalist);
+        } else if (cmcp_server->message_cb != NULL) {
             /* callback function registered; invoke it */
             cmcp_server->message_cb(cmcp_server->callback_param, sender_id,
                 command_id, cmcp_datalist);
@@ -286,32 +999,163 @@ void vsp_cmcp_server_message_callback(void *param,
     }
 }
 
+void vsp_cmcp_server_dispatch_callback(void *param, uint16_t client_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
+{
+    vsp_cmcp_server *cmcp_server;
+
+    /* check parameter; data list is NULL for disconnected clients */
+    VSP_ASSERT(param != NULL);
+
+    cmcp_server = (vsp_cmcp_server*) param;
+    if (cmcp_datalist == NULL) {
+        if (cmcp_server->disconnect_cb != NULL) {
+            /* callback function registered; invoke it */
+            cmcp_server->disconnect_cb(cmcp_server->callback_param, client_id);
+        }
+    } else if (cmcp_server->message_cb != NULL) {
+        /* callback function registered; invoke it */
+        cmcp_server->message_cb(cmcp_server->callback_param, client_id,
+            command_id, cmcp_datalist);
+    }
+}
+
+void vsp_cmcp_server_queue_message(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id)
+{
+    void *message_buffer;
+    int data_length;
+    int ret;
+
+    /* take message buffer without copying it */
+    message_buffer = vsp_cmcp_node_take_message(cmcp_server->cmcp_node,
+        &data_length);
+    ret = vsp_cmcp_queue_push(cmcp_server->receive_queue, client_id,
+        data_length, message_buffer);
+    if (ret != 0) {
+        /* queue is full: drop message; the drop is counted by the queue */
+        vsp_cmcp_node_free_message(message_buffer);
+    }
+}
+
+void vsp_cmcp_server_clear_receive_queue(vsp_cmcp_server *cmcp_server)
+{
+    void *message_buffer;
+    int data_length;
+    uint16_t client_id;
+
+    while (vsp_cmcp_queue_pop(cmcp_server->receive_queue, &client_id,
+            &data_length, &message_buffer) == 0) {
+        if (message_buffer != NULL) {
+            vsp_cmcp_node_free_message(message_buffer);
+        }
+    }
+}
+
+void vsp_cmcp_server_trace_callback(void *param,
+    const vsp_cmcp_trace *cmcp_trace)
+{
+    vsp_cmcp_server *cmcp_server;
+
+    /* check parameters; failures are silently ignored */
+    VSP_CHECK(param != NULL && cmcp_trace != NULL, return);
+
+    cmcp_server = (vsp_cmcp_server*) param;
+
+    if (cmcp_server->trace_cb != NULL) {
+        /* callback function registered; invoke it */
+        cmcp_server->trace_cb(cmcp_server->callback_param, cmcp_trace);
+    }
+}
+
+void vsp_cmcp_server_gap_callback(void *param, uint16_t sender_id,
+    uint16_t topic_id, uint32_t expected_sequence, uint32_t lost_count)
+{
+    vsp_cmcp_server *cmcp_server;
+
+    /* check parameter; failures are silently ignored */
+    VSP_CHECK(param != NULL, return);
+
+    cmcp_server = (vsp_cmcp_server*) param;
+
+    if (cmcp_server->gap_cb != NULL) {
+        /* callback function registered; invoke it */
+        cmcp_server->gap_cb(cmcp_server->callback_param, sender_id, topic_id,
+            expected_sequence, lost_count);
+    }
+}
+
+void vsp_cmcp_server_stream_callback(void *param, uint16_t client_id,
+    uint16_t stream_id, uint32_t chunk_length, void *chunk_data)
+{
+    vsp_cmcp_server *cmcp_server;
+
+    cmcp_server = (vsp_cmcp_server*) param;
+
+    if (cmcp_server->stream_cb != NULL) {
+        /* callback function registered; invoke it */
+        cmcp_server->stream_cb(cmcp_server->callback_param, client_id,
+            stream_id, chunk_length, chunk_data);
+    }
+}
+
 void vsp_cmcp_server_handle_control_message(vsp_cmcp_server *cmcp_server,
     uint16_t sender_id, uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
 {
-    /* handle only client commands */
-    VSP_CHECK((sender_id & 1) == 1, return);
+    int ret;
+
+    /* handle only client commands; client IDs never use group topic IDs */
+    VSP_CHECK((sender_id & 1) == 1 && sender_id < VSP_CMCP_GROUP_TOPIC_ID,
+        return);
     if (command_id == VSP_CMCP_COMMAND_CLIENT_ANNOUNCE) {
         /* client announcement received */
-        uint64_t *client_nonce;
+        uint64_t client_nonce;
+        uint32_t client_features;
         /* get client nonce */
-        client_nonce = vsp_cmcp_datalist_get_data_item(cmcp_datalist,
-            VSP_CMCP_PARAMETER_NONCE, sizeof(uint64_t));
+        ret = vsp_cmcp_datalist_get_u64(cmcp_datalist,
+            VSP_CMCP_PARAMETER_NONCE, 1, &client_nonce);
         /* check data list item (nonce); failures are silently ignored */
-        VSP_CHECK(client_nonce != NULL, return);
+        VSP_CHECK(ret == 0, return);
+        /* get client features; older clients do not send them */
+        ret = vsp_cmcp_datalist_get_u32(cmcp_datalist,
+            VSP_CMCP_PARAMETER_FEATURES, 1, &client_features);
         /* try to register client peer */
-        vsp_cmcp_server_register_client(cmcp_server, sender_id, *client_nonce);
+        vsp_cmcp_server_register_client(cmcp_server, sender_id, client_nonce,
+            ret == 0 ? client_features : 0);
     } else if (command_id == VSP_CMCP_COMMAND_CLIENT_DISCONNECT) {
         /* client disconnection received; deregister client */
         vsp_cmcp_server_deregister_client(cmcp_server, sender_id);
+    } else if (command_id == VSP_CMCP_COMMAND_CLIENT_JOIN_GROUP
+        || command_id == VSP_CMCP_COMMAND_CLIENT_LEAVE_GROUP) {
+        /* group membership changed; accept only registered clients */
+        uint16_t group_id;
+        int index;
+        ret = vsp_cmcp_datalist_get_u16(cmcp_datalist,
+            VSP_CMCP_PARAMETER_GROUP_ID, 1, &group_id);
+        index = vsp_cmcp_server_find_client(cmcp_server, sender_id);
+        /* check data list item and client; failures are silently ignored */
+        VSP_CHECK(ret == 0 && group_id < VSP_CMCP_GROUP_COUNT && index >= 0,
+            return);
+        vsp_cmcp_server_begin_peer_update(cmcp_server);
+        vsp_cmcp_server_update_group(cmcp_server, index, group_id,
+            command_id == VSP_CMCP_COMMAND_CLIENT_JOIN_GROUP);
+        vsp_cmcp_server_end_peer_update(cmcp_server);
+    } else if (command_id >= VSP_CMCP_COMMAND_STREAM_CHUNK
+        && command_id <= VSP_CMCP_COMMAND_STREAM_CREDIT) {
+        /* stream message received; accept only registered clients */
+        VSP_CHECK(vsp_cmcp_server_find_client(cmcp_server, sender_id) >= 0,
+            return);
+        vsp_cmcp_stream_handle_message(cmcp_server->stream_table, sender_id,
+            cmcp_server->id, sender_id, command_id, cmcp_datalist);
     }
 }
 
 void vsp_cmcp_server_register_client(vsp_cmcp_server *cmcp_server,
-    uint16_t client_id, uint64_t client_nonce)
+    uint16_t client_id, uint64_t client_nonce, uint32_t client_features)
 {
     vsp_cmcp_datalist *cmcp_datalist;
     int ret, success;
+    uint32_t server_features;
 
     /* create data list containing client nonce */
     cmcp_datalist = vsp_cmcp_datalist_create();
@@ -322,13 +1166,20 @@ void vsp_cmcp_server_register_client(vsp_cmcp_server *cmcp_server,
         sizeof(client_nonce), &client_nonce);
     /* check for errors */
     VSP_ASSERT(ret == 0);
+    /* add supported protocol features as data list item */
+    server_features = vsp_cmcp_node_get_features(cmcp_server->cmcp_node);
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist,
+        VSP_CMCP_PARAMETER_FEATURES, sizeof(server_features),
+        &server_features);
+    /* check for errors */
+    VSP_ASSERT(ret == 0);
 
     /* try to register client peer ID */
     success = 0;
-    if (vsp_cmcp_server_find_client(cmcp_server, client_id) == 0) {
+    if (vsp_cmcp_server_find_client(cmcp_server, client_id) >= 0) {
         /* client peer ID already registered */
         success = -1;
-    } else if (cmcp_server->client_count >= VSP_CMCP_SERVER_MAX_PEERS) {
+    } else if (cmcp_server->client_count >= cmcp_server->max_client_count) {
         /* maximum number of peers already registered */
         success = -1;
     } else {
@@ -342,17 +1193,33 @@ void vsp_cmcp_server_register_client(vsp_cmcp_server *cmcp_server,
         } else {
             /* register client peer ID */
             vsp_cmcp_server_peer *client;
-            /* create client data struct */
-            VSP_ALLOC(client, vsp_cmcp_server_peer);
-            /* initialize struct data */
-            vsp_time_real_timespec_from_now(&client->time_connection_timeout,
-                VSP_CMCP_NODE_CONNECTION_TIMEOUT);
-            /* store client peer ID */
-            cmcp_server->client_ids[cmcp_server->client_count] = client_id;
-            /* store client peer data */
-            cmcp_server->client_data[cmcp_server->client_count] = client;
+            int slot, mask;
+            vsp_cmcp_server_begin_peer_update(cmcp_server);
+            if (cmcp_server->client_count == cmcp_server->client_capacity) {
+                /* peer table is full */
+                vsp_cmcp_server_grow_clients(cmcp_server);
+            }
+            /* initialize client data in place; ID and features are read
+             * by sending threads */
+            client = &cmcp_server->clients[cmcp_server->client_count];
+            __atomic_store_n(&client->id, client_id, __ATOMIC_RELAXED);
+            vsp_cmcp_server_append_timeout(cmcp_server,
+                cmcp_server->client_count);
+            __atomic_store_n(&client->features,
+                client_features & VSP_CMCP_FEATURES, __ATOMIC_RELAXED);
+            memset(client->groups, 0, sizeof(client->groups));
+            /* add client peer to hash index; the index is never full */
+            mask = 2 * cmcp_server->client_capacity - 1;
+            slot = vsp_cmcp_server_hash_client(cmcp_server->client_capacity,
+                client_id);
+            while (cmcp_server->client_index[slot] != 0) {
+                slot = (slot + 1) & mask;
+            }
+            __atomic_store_n(&cmcp_server->client_index[slot],
+                cmcp_server->client_count + 1, __ATOMIC_RELAXED);
             /* increment client peer count */
             ++cmcp_server->client_count;
+            vsp_cmcp_server_end_peer_update(cmcp_server);
             /* success */
             success = 0;
         }
@@ -364,15 +1231,16 @@ void vsp_cmcp_server_register_client(vsp_cmcp_server *cmcp_server,
         ret = vsp_cmcp_node_create_send_message(cmcp_server->cmcp_node,
             VSP_CMCP_MESSAGE_TYPE_CONTROL,
             client_id, cmcp_server->id,
-            VSP_CMCP_COMMAND_SERVER_ACK_CLIENT, cmcp_datalist);
+            VSP_CMCP_COMMAND_SERVER_ACK_CLIENT, cmcp_datalist, 0);
         /* check for errors */
         VSP_CHECK(ret == 0, /* failures are silently ignored */);
     } else {
         /* new client peer ID rejected, send negative acknowledge message */
+        vsp_cmcp_node_count_nack(cmcp_server->cmcp_node);
         ret = vsp_cmcp_node_create_send_message(cmcp_server->cmcp_node,
             VSP_CMCP_MESSAGE_TYPE_CONTROL,
             client_id, cmcp_server->id,
-            VSP_CMCP_COMMAND_SERVER_NACK_CLIENT, cmcp_datalist);
+            VSP_CMCP_COMMAND_SERVER_NACK_CLIENT, cmcp_datalist, 0);
         /* check for errors */
         VSP_CHECK(ret == 0, /* failures are silently ignored */);
     }
@@ -384,45 +1252,392 @@ void vsp_cmcp_server_register_client(vsp_cmcp_server *cmcp_server,
 int vsp_cmcp_server_find_client(vsp_cmcp_server *cmcp_server,
     uint16_t client_id)
 {
+    int slot;
+    int mask;
     int index;
 
-    for (index = 0; index < cmcp_server->client_count; ++index) {
-        if (cmcp_server->client_ids[index] == client_id) {
+    /* check if peer table is allocated */
+    if (cmcp_server->client_capacity == 0) {
+        return -1;
+    }
+
+    mask = 2 * cmcp_server->client_capacity - 1;
+    slot = vsp_cmcp_server_hash_client(cmcp_server->client_capacity,
+        client_id);
+    /* linear probing until a free slot is reached */
+    while (cmcp_server->client_index[slot] != 0) {
+        index = cmcp_server->client_index[slot] - 1;
+        if (cmcp_server->clients[index].id == client_id) {
             /* client peer ID found */
             return index;
         }
+        slot = (slot + 1) & mask;
     }
 
     /* client peer ID not found */
     return -1;
 }
 
+int vsp_cmcp_server_lookup_client(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, uint32_t *client_features)
+{
+    unsigned int sequence;
+    int capacity;
+    vsp_cmcp_server_peer *clients;
+    int *client_index;
+    int slot;
+    int mask;
+    int index;
+    int probe_count;
+    int found;
+    uint32_t features;
+
+    do {
+        /* wait until the reception thread does not modify the table */
+        sequence = __atomic_load_n(&cmcp_server->peer_sequence,
+            __ATOMIC_ACQUIRE);
+        if ((sequence & 1) != 0) {
+            continue;
+        }
+        /* the arrays are only read if they match the capacity, as tables
+         * are not freed while the server exists */
+        capacity = __atomic_load_n(&cmcp_server->client_capacity,
+            __ATOMIC_RELAXED);
+        clients = __atomic_load_n(&cmcp_server->clients, __ATOMIC_ACQUIRE);
+        client_index = __atomic_load_n(&cmcp_server->client_index,
+            __ATOMIC_ACQUIRE);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&cmcp_server->peer_sequence, __ATOMIC_RELAXED)
+            != sequence) {
+            continue;
+        }
+        found = 0;
+        features = 0;
+        if (capacity > 0) {
+            /* linear probing as in vsp_cmcp_server_find_client(); concurrent
+             * modifications may leave the index inconsistent, so probing is
+             * bounded and the result is discarded if the counter changed */
+            mask = 2 * capacity - 1;
+            slot = vsp_cmcp_server_hash_client(capacity, client_id);
+            for (probe_count = 0; probe_count <= mask; ++probe_count) {
+                index = __atomic_load_n(&client_index[slot],
+                    __ATOMIC_RELAXED) - 1;
+                if (index < 0 || index >= capacity) {
+                    break;
+                }
+                if (__atomic_load_n(&clients[index].id, __ATOMIC_RELAXED)
+                    == client_id) {
+                    found = 1;
+                    features = __atomic_load_n(&clients[index].features,
+                        __ATOMIC_RELAXED);
+                    break;
+                }
+                slot = (slot + 1) & mask;
+            }
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((sequence & 1) != 0 || __atomic_load_n(
+        &cmcp_server->peer_sequence, __ATOMIC_RELAXED) != sequence);
+
+    /* client peer ID not found */
+    VSP_CHECK(found != 0, return -1);
+
+    /* client peer ID found */
+    if (client_features != NULL) {
+        *client_features = features;
+    }
+    return 0;
+}
+
+void vsp_cmcp_server_begin_peer_update(vsp_cmcp_server *cmcp_server)
+{
+    /* odd counter makes readers retry; the fence orders the following
+     * modifications after the counter update */
+    __atomic_store_n(&cmcp_server->peer_sequence,
+        cmcp_server->peer_sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void vsp_cmcp_server_end_peer_update(vsp_cmcp_server *cmcp_server)
+{
+    /* even counter publishes the modified table */
+    __atomic_store_n(&cmcp_server->peer_sequence,
+        cmcp_server->peer_sequence + 1, __ATOMIC_RELEASE);
+}
+
+void vsp_cmcp_server_unlink_timeout(vsp_cmcp_server *cmcp_server,
+    int index)
+{
+    vsp_cmcp_server_peer *client;
+
+    client = &cmcp_server->clients[index];
+    if (client->timeout_previous >= 0) {
+        cmcp_server->clients[client->timeout_previous].timeout_next =
+            client->timeout_next;
+    } else {
+        cmcp_server->timeout_first = client->timeout_next;
+    }
+    if (client->timeout_next >= 0) {
+        cmcp_server->clients[client->timeout_next].timeout_previous =
+            client->timeout_previous;
+    } else {
+        cmcp_server->timeout_last = client->timeout_previous;
+    }
+}
+
+void vsp_cmcp_server_append_timeout(vsp_cmcp_server *cmcp_server,
+    int index)
+{
+    vsp_cmcp_server_peer *client;
+
+    client = &cmcp_server->clients[index];
+    /* deadline relative to the time read by the regular callback */
+    client->time_connection_timeout = cmcp_server->time_now;
+    vsp_time_timespec_add(&client->time_connection_timeout,
+        VSP_CMCP_NODE_CONNECTION_TIMEOUT);
+    /* append to the end of the list */
+    client->timeout_previous = cmcp_server->timeout_last;
+    client->timeout_next = -1;
+    if (cmcp_server->timeout_last >= 0) {
+        cmcp_server->clients[cmcp_server->timeout_last].timeout_next = index;
+    } else {
+        cmcp_server->timeout_first = index;
+    }
+    cmcp_server->timeout_last = index;
+}
+
+void vsp_cmcp_server_grow_clients(vsp_cmcp_server *cmcp_server)
+{
+    int capacity;
+    int index;
+    int slot;
+    int mask;
+    vsp_cmcp_server_peer *clients;
+    int *client_index;
+    vsp_cmcp_server_retired_table *retired_table;
+
+    if (cmcp_server->client_capacity == 0) {
+        capacity = VSP_CMCP_SERVER_INITIAL_PEER_CAPACITY;
+    } else {
+        capacity = 2 * cmcp_server->client_capacity;
+    }
+
+    /* move client peers to new table */
+    VSP_ALLOC_N(clients, capacity * sizeof(vsp_cmcp_server_peer));
+    if (cmcp_server->clients != NULL) {
+        memcpy(clients, cmcp_server->clients,
+            cmcp_server->client_count * sizeof(vsp_cmcp_server_peer));
+        /* sending threads may still read the old table; as the capacity
+         * doubles, retired tables use less memory than the current one */
+        VSP_ALLOC(retired_table, vsp_cmcp_server_retired_table);
+        retired_table->next = cmcp_server->retired_tables;
+        retired_table->clients = cmcp_server->clients;
+        retired_table->client_index = cmcp_server->client_index;
+        cmcp_server->retired_tables = retired_table;
+    }
+
+    /* rebuild hash index with two slots per peer */
+    VSP_ALLOC_N(client_index, 2 * capacity * sizeof(int));
+    memset(client_index, 0, 2 * capacity * sizeof(int));
+    mask = 2 * capacity - 1;
+    for (index = 0; index < cmcp_server->client_count; ++index) {
+        slot = vsp_cmcp_server_hash_client(capacity, clients[index].id);
+        while (client_index[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        client_index[slot] = index + 1;
+    }
+
+    /* publish the filled tables to sending threads */
+    __atomic_store_n(&cmcp_server->clients, clients, __ATOMIC_RELEASE);
+    __atomic_store_n(&cmcp_server->client_index, client_index,
+        __ATOMIC_RELEASE);
+    __atomic_store_n(&cmcp_server->client_capacity, capacity,
+        __ATOMIC_RELAXED);
+}
+
+int vsp_cmcp_server_hash_client(int client_capacity, uint16_t client_id)
+{
+    /* client IDs are odd, so the lowest bit carries no information;
+     * multiplicative hashing spreads the remaining bits over the index */
+    return (int) ((client_id * 40503UL) >> 3)
+        & (2 * client_capacity - 1);
+}
+
+int vsp_cmcp_server_find_client_slot(vsp_cmcp_server *cmcp_server,
+    int index)
+{
+    int slot;
+    int mask;
+
+    mask = 2 * cmcp_server->client_capacity - 1;
+    slot = vsp_cmcp_server_hash_client(cmcp_server->client_capacity,
+        cmcp_server->clients[index].id);
+    while (cmcp_server->client_index[slot] != index + 1) {
+        /* the client peer is registered, so its slot is found */
+        VSP_ASSERT(cmcp_server->client_index[slot] != 0);
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void vsp_cmcp_server_update_group(vsp_cmcp_server *cmcp_server,
+    int index, uint16_t group_id, int join)
+{
+    vsp_cmcp_server_peer *client;
+    vsp_cmcp_server_group *group;
+    uint32_t group_bit;
+    int change;
+
+    client = &cmcp_server->clients[index];
+    group = &cmcp_server->groups[group_id];
+    group_bit = (uint32_t) 1 << (group_id % 32);
+    if (((client->groups[group_id / 32] & group_bit) != 0) == (join != 0)) {
+        /* membership does not change */
+        return;
+    }
+
+    /* update membership and member counts */
+    change = (join != 0 ? 1 : -1);
+    client->groups[group_id / 32] ^= group_bit;
+    __atomic_store_n(&group->member_count, group->member_count + change,
+        __ATOMIC_RELAXED);
+    if ((client->features & VSP_CMCP_FEATURE_LARGE_ITEMS) != 0) {
+        __atomic_store_n(&group->large_items_count,
+            group->large_items_count + change, __ATOMIC_RELAXED);
+    }
+    if ((client->features & VSP_CMCP_FEATURE_TRACE) != 0) {
+        __atomic_store_n(&group->trace_count, group->trace_count + change,
+            __ATOMIC_RELAXED);
+    }
+}
+
+void vsp_cmcp_server_lookup_group(vsp_cmcp_server *cmcp_server,
+    uint16_t group_id, vsp_cmcp_server_group *group)
+{
+    unsigned int sequence;
+    vsp_cmcp_server_group *groups;
+
+    groups = cmcp_server->groups;
+    do {
+        /* read counters consistently, as in vsp_cmcp_server_lookup_client() */
+        sequence = __atomic_load_n(&cmcp_server->peer_sequence,
+            __ATOMIC_ACQUIRE);
+        group->member_count = __atomic_load_n(
+            &groups[group_id].member_count, __ATOMIC_RELAXED);
+        group->large_items_count = __atomic_load_n(
+            &groups[group_id].large_items_count, __ATOMIC_RELAXED);
+        group->trace_count = __atomic_load_n(
+            &groups[group_id].trace_count, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    } while ((sequence & 1) != 0 || __atomic_load_n(
+        &cmcp_server->peer_sequence, __ATOMIC_RELAXED) != sequence);
+}
+
 void vsp_cmcp_server_deregister_client(vsp_cmcp_server *cmcp_server,
     uint16_t client_id)
 {
     int index;
+    int slot;
+    int next_slot;
+    int home_slot;
+    int mask;
+    uint16_t group_id;
+    int ret;
 
     /* find client ID */
     index = vsp_cmcp_server_find_client(cmcp_server, client_id);
-    /* check for errors */
-    VSP_ASSERT(index >= 0);
+    /* ignore clients which are not registered */
+    VSP_CHECK(index >= 0, return);
 
-    /* free memory */
-    VSP_FREE(cmcp_server->client_data[index]);
+    vsp_cmcp_server_begin_peer_update(cmcp_server);
+
+    /* remove client peer from hash index; following entries of the probe
+     * sequence are shifted back so that no tombstones are needed */
+    mask = 2 * cmcp_server->client_capacity - 1;
+    slot = vsp_cmcp_server_find_client_slot(cmcp_server, index);
+    next_slot = (slot + 1) & mask;
+    while (cmcp_server->client_index[next_slot] != 0) {
+        home_slot = vsp_cmcp_server_hash_client(cmcp_server->client_capacity,
+            cmcp_server->clients[cmcp_server->client_index[next_slot] - 1].id);
+        /* move entry if its home slot is not between the free slot and
+         * its current slot (cyclically) */
+        if (((next_slot - home_slot) & mask) >= ((next_slot - slot) & mask)) {
+            __atomic_store_n(&cmcp_server->client_index[slot],
+                cmcp_server->client_index[next_slot], __ATOMIC_RELAXED);
+            slot = next_slot;
+        }
+        next_slot = (next_slot + 1) & mask;
+    }
+    __atomic_store_n(&cmcp_server->client_index[slot], 0, __ATOMIC_RELAXED);
+
+    /* remove client peer from timeout list and its multicast groups */
+    vsp_cmcp_server_unlink_timeout(cmcp_server, index);
+    for (group_id = 0; group_id < VSP_CMCP_GROUP_COUNT; ++group_id) {
+        vsp_cmcp_server_update_group(cmcp_server, index, group_id, 0);
+    }
 
     /* move array entries */
     /* last registered client will be at the position of the deleted client */
     --cmcp_server->client_count;
-    cmcp_server->client_ids[index] =
-        cmcp_server->client_ids[cmcp_server->client_count];
-    cmcp_server->client_data[index] =
-        cmcp_server->client_data[cmcp_server->client_count];
+    if (index != cmcp_server->client_count) {
+        vsp_cmcp_server_peer *client;
+        vsp_cmcp_server_peer *moved_client;
+        slot = vsp_cmcp_server_find_client_slot(cmcp_server,
+            cmcp_server->client_count);
+        __atomic_store_n(&cmcp_server->client_index[slot], index + 1,
+            __ATOMIC_RELAXED);
+        /* copy entry field by field, as sending threads read ID and
+         * features */
+        client = &cmcp_server->clients[index];
+        moved_client = &cmcp_server->clients[cmcp_server->client_count];
+        __atomic_store_n(&client->id, moved_client->id, __ATOMIC_RELAXED);
+        __atomic_store_n(&client->features, moved_client->features,
+            __ATOMIC_RELAXED);
+        client->time_connection_timeout =
+            moved_client->time_connection_timeout;
+        client->timeout_previous = moved_client->timeout_previous;
+        client->timeout_next = moved_client->timeout_next;
+        memcpy(client->groups, moved_client->groups, sizeof(client->groups));
+        /* update timeout list links to the moved client peer */
+        if (client->timeout_previous >= 0) {
+            cmcp_server->clients[client->timeout_previous].timeout_next =
+                index;
+        } else {
+            cmcp_server->timeout_first = index;
+        }
+        if (client->timeout_next >= 0) {
+            cmcp_server->clients[client->timeout_next].timeout_previous =
+                index;
+        } else {
+            cmcp_server->timeout_last = index;
+        }
+    }
+
+    vsp_cmcp_server_end_peer_update(cmcp_server);
+
+    /* drop streams of this client peer and wake up blocked stream senders */
+    vsp_cmcp_stream_remove_peer(cmcp_server->stream_table, client_id);
 
-    /* unsubscribe from messages from this client peer */
+    /* unsubscribe from messages from this client peer and forget its
+     * sequence numbers, so the table does not grow with client churn */
     vsp_cmcp_node_unsubscribe(cmcp_server->cmcp_node, client_id);
+    vsp_cmcp_node_remove_sender(cmcp_server->cmcp_node, client_id);
 
     /* invoke callback function */
-    if (cmcp_server->disconnect_cb != NULL) {
+    if (cmcp_server->receive_queue != NULL) {
+        /* let the application thread invoke it after processing all queued
+         * messages of the client; if the queue is full, the event is kept
+         * and queued by the regular callback function later */
+        ret = vsp_cmcp_queue_push(cmcp_server->receive_queue, client_id, 0,
+            NULL);
+        /* events are never dropped */
+        VSP_ASSERT(ret == 0);
+    } else if (cmcp_server->cmcp_dispatch != NULL) {
+        /* let the worker of this client invoke it after handling all queued
+         * messages of the client; failures are silently ignored */
+        vsp_cmcp_dispatch_push(cmcp_server->cmcp_dispatch, client_id, 0, NULL);
+    } else if (cmcp_server->disconnect_cb != NULL) {
         /* callback function registered; invoke it */
         cmcp_server->disconnect_cb(cmcp_server->callback_param, client_id);
     }
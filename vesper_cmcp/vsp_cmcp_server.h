@@ -11,6 +11,9 @@
 #define VSP_CMCP_SERVER_H_INCLUDED
 
 #include "vsp_cmcp_datalist.h"
+#include "vsp_cmcp_packet.h"
+#include "vsp_cmcp_reactor.h"
+#include "vsp_cmcp_stats.h"
 
 #include <vesper_util/vsp_api.h>
 #include <stdint.h>
@@ -44,6 +47,14 @@ typedef void (*vsp_cmcp_server_disconnect_cb)(void*, uint16_t);
 typedef void (*vsp_cmcp_server_message_cb)(void*, uint16_t, uint16_t,
     vsp_cmcp_datalist*);
 
+/** Callback function invoked for every received stream chunk.
+ * The parameters are the callback parameter set by
+ * vsp_cmcp_server_set_callback_param(), the client ID, the stream ID, the
+ * chunk length and the chunk data. The end of a stream is signaled by chunk
+ * length zero and chunk data NULL. */
+typedef void (*vsp_cmcp_server_stream_cb)(void*, uint16_t, uint16_t, uint32_t,
+    void*);
+
 /**
  * Create new vsp_cmcp_server object.
  * Returned pointer should be freed with vsp_cmcp_server_free().
@@ -87,6 +98,172 @@ VSP_API void vsp_cmcp_server_set_disconnect_cb(vsp_cmcp_server *cmcp_server,
 VSP_API void vsp_cmcp_server_set_message_cb(vsp_cmcp_server *cmcp_server,
     vsp_cmcp_server_message_cb message_cb);
 
+/**
+ * Set callback function invoked for every received stream chunk.
+ * Chunks of a stream are passed in order, followed by the end of the stream.
+ * If stream_cb is NULL, the callback function is cleared and received chunks
+ * are dropped; flow control credit is returned to the sender anyway.
+ */
+VSP_API void vsp_cmcp_server_set_stream_cb(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_server_stream_cb stream_cb);
+
+/**
+ * Set callback function invoked with the send time and sequence number of
+ * every received data message, see vsp_cmcp_trace.
+ * Only if this or the gap callback function is set, clients are asked to wrap
+ * their data messages with trace data, which costs 18 bytes per message.
+ * This is negotiated when a client connects, so the callback function should
+ * be set before vsp_cmcp_server_bind().
+ * If trace_cb is NULL, the callback function is cleared.
+ */
+VSP_API void vsp_cmcp_server_set_trace_cb(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_trace_cb trace_cb);
+
+/**
+ * Set callback function invoked when the sequence numbers of data messages
+ * received from a client skip one or more numbers, see vsp_cmcp_gap_cb.
+ * Gaps are counted in vsp_cmcp_stats with or without callback function, but
+ * only detected if clients wrap their data messages with trace data, i.e.
+ * if this or the trace callback function is set before
+ * vsp_cmcp_server_bind().
+ * If gap_cb is NULL, the callback function is cleared.
+ */
+VSP_API void vsp_cmcp_server_set_gap_cb(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_gap_cb gap_cb);
+
+/**
+ * Set maximum number of messages received in a batch by the internal message
+ * reception thread before heartbeats and client timeouts are handled again.
+ * Larger batches reduce the overhead per message under high load.
+ * The default value is 64 (VSP_CMCP_NODE_DEFAULT_RECEIVE_BATCH_SIZE).
+ * This function should be called before vsp_cmcp_server_bind().
+ * Returns non-zero and sets vsp_error_num() if batch_size is not positive.
+ */
+VSP_API int vsp_cmcp_server_set_receive_batch_size(
+    vsp_cmcp_server *cmcp_server, int batch_size);
+
+/**
+ * Receive messages in a thread of the specified reactor instead of an own
+ * internal message reception thread. Many servers and clients can share the
+ * threads of one reactor. The reactor must not be freed before this server.
+ * Callback functions of all nodes of a reactor thread are invoked from that
+ * thread, so they should return quickly. They may bind, connect and free
+ * other servers and clients of the same reactor, but must not free this
+ * server.
+ * This function has to be called before vsp_cmcp_server_bind().
+ * cmcp_reactor may be NULL to use an own reception thread.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_server_set_reactor(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_reactor *cmcp_reactor);
+
+/**
+ * Set maximum number of registered clients. Further announced clients will be
+ * rejected. Already registered clients are kept if the limit is lowered.
+ * The peer table grows on demand, so large limits do not allocate memory
+ * upfront. The default value is 16.
+ * Returns non-zero and sets vsp_error_num() if max_client_count is not
+ * positive.
+ */
+VSP_API int vsp_cmcp_server_set_max_clients(vsp_cmcp_server *cmcp_server,
+    int max_client_count);
+
+/**
+ * Set number of worker threads invoking the message callback function.
+ * Received data messages are copied and handed to the worker assigned to
+ * their client, so messages of one client are handled in order, while
+ * messages of different clients are handled in parallel. A slow message
+ * callback function then does not delay reception and heartbeats.
+ * At most queue_capacity messages are queued for every worker; further
+ * messages are dropped and counted, see
+ * vsp_cmcp_server_get_worker_queue_stats().
+ * The disconnection callback function is invoked by the same worker after all
+ * messages of the client; other callback functions are still invoked from
+ * the reception thread.
+ * The default value is 0, invoking the message callback function from the
+ * reception thread without copying messages.
+ * This function has to be called before vsp_cmcp_server_bind().
+ * Returns non-zero and sets vsp_error_num() if worker_count is negative,
+ * queue_capacity is not positive while worker_count is, or worker threads are
+ * already started.
+ */
+VSP_API int vsp_cmcp_server_set_worker_count(vsp_cmcp_server *cmcp_server,
+    int worker_count, int queue_capacity);
+
+/**
+ * Hand received messages over to an application thread instead of invoking
+ * the message callback function from the reception thread.
+ * Received message buffers are appended to a bounded lock-free queue without
+ * copying them. The application waits until the file descriptor returned by
+ * vsp_cmcp_server_get_receive_fd() is readable, e.g. with poll(), and calls
+ * vsp_cmcp_server_process_messages() to invoke the message callback function
+ * for queued messages. The disconnection callback function is queued as well,
+ * after all messages of the client. If the queue is full, it is queued as soon
+ * as messages were processed, and further messages are dropped and counted
+ * until then, see vsp_cmcp_server_get_receive_queue_stats().
+ * capacity is rounded up to a power of two. The default value is 0, invoking
+ * the message callback function from the reception thread. Worker threads set
+ * by vsp_cmcp_server_set_worker_count() are not used with a receive queue.
+ * This function has to be called before vsp_cmcp_server_bind().
+ * Returns non-zero and sets vsp_error_num() if capacity is negative or the
+ * queue is already created.
+ */
+VSP_API int vsp_cmcp_server_set_receive_queue(vsp_cmcp_server *cmcp_server,
+    int capacity);
+
+/**
+ * Get file descriptor that is readable while messages are queued.
+ * The file descriptor must only be used for waiting, not for reading.
+ * Returns -1 and sets vsp_error_num() if no receive queue is used.
+ */
+VSP_API int vsp_cmcp_server_get_receive_fd(vsp_cmcp_server *cmcp_server);
+
+/**
+ * Invoke callback functions for at most max_count queued messages in the
+ * calling thread. Must not be called by several threads at once.
+ * Returns the number of processed messages, or -1 and sets vsp_error_num()
+ * if no receive queue is used or max_count is not positive.
+ */
+VSP_API int vsp_cmcp_server_process_messages(vsp_cmcp_server *cmcp_server,
+    int max_count);
+
+/**
+ * Get the number of currently queued messages and the number of messages
+ * dropped so far because the receive queue was full.
+ * queued_count and dropped_count may be NULL.
+ * Returns non-zero and sets vsp_error_num() if no receive queue is used.
+ */
+VSP_API int vsp_cmcp_server_get_receive_queue_stats(
+    vsp_cmcp_server *cmcp_server, int *queued_count, uint64_t *dropped_count);
+
+/**
+ * Get the number of messages currently queued for all worker threads and the
+ * number of messages dropped so far because a worker queue was full.
+ * queued_count and dropped_count may be NULL.
+ * Returns non-zero and sets vsp_error_num() if no worker threads are used.
+ */
+VSP_API int vsp_cmcp_server_get_worker_queue_stats(
+    vsp_cmcp_server *cmcp_server, int *queued_count, uint64_t *dropped_count);
+
+/**
+ * Get a snapshot of the message and connection counters of this server.
+ * May be called from any thread at any time.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_server_get_stats(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_stats *cmcp_stats);
+
+/**
+ * Get percentiles of the durations of handling received messages or of
+ * sending messages, depending on latency_type. A slow message callback
+ * function shows up in the handling durations before it delays heartbeats
+ * long enough to let peers time out.
+ * May be called from any thread at any time.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_server_get_latency(vsp_cmcp_server *cmcp_server,
+    vsp_cmcp_latency_type latency_type, vsp_cmcp_latency *cmcp_latency);
+
 /**
  * Initialize sockets and wait for incoming connections.
  * An internal message reception thread is started.
@@ -99,11 +276,98 @@ VSP_API int vsp_cmcp_server_bind(vsp_cmcp_server *cmcp_server,
  * Send a message to the specified client.
  * The specified command_id has to be lower than 2^15, i.e. MSB cleared.
  * This function blocks until the message could be sent.
+ * Several threads may send messages at once without locking, also while
+ * clients connect or disconnect. Each call encodes into its own message buffer,
+ * so only the data list must not be modified meanwhile.
  * Returns non-zero and sets vsp_error_num() if failed.
  */
 VSP_API int vsp_cmcp_server_send(vsp_cmcp_server *cmcp_server,
     uint16_t client_id, uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
 
+/**
+ * Send several messages to the specified client, packed into a single network
+ * message. The client receives them as separate messages in the same order.
+ * message_count command IDs and data lists are read from the specified arrays;
+ * data list entries may be NULL. Each data list has to be shorter than 64 KiB.
+ * The specified command IDs have to be lower than 2^15, i.e. MSB cleared.
+ * This function blocks until the message could be sent.
+ * Like vsp_cmcp_server_send(), it may be called by several threads at once.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_server_send_batch(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, int message_count, const uint16_t *command_ids,
+    vsp_cmcp_datalist **cmcp_datalists);
+
+/**
+ * Send a message encoded in advance with vsp_cmcp_packet_create() to the
+ * specified client. The same packet may be sent to any number of clients,
+ * also by several threads at once; only its encoded buffer is copied for each
+ * of them, the data list is not encoded again.
+ * Packets with large data list items are rejected unless the client is able
+ * to receive them.
+ * The packet is not freed by this function.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_server_send_packet(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, vsp_cmcp_packet *cmcp_packet);
+
+/**
+ * Send a message to all clients which joined the specified multicast group
+ * using vsp_cmcp_client_join_group(). The message is encoded and passed to
+ * the network library once, regardless of the number of group members.
+ * group_id has to be lower than 256. Nothing is sent if the group has no
+ * members. Messages with large data list items are rejected unless all
+ * members are able to receive them, and messages are only traced if all
+ * members requested it. As long as one member did not, members with trace or
+ * gap callback functions receive group messages without trace data, so
+ * neither callback function is invoked for them.
+ * The specified command_id has to be lower than 2^15, i.e. MSB cleared.
+ * Like vsp_cmcp_server_send(), it may be called by several threads at once.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_server_send_group(vsp_cmcp_server *cmcp_server,
+    uint16_t group_id, uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
+
+/**
+ * Get the number of registered clients which joined the specified multicast
+ * group. group_id has to be lower than 256.
+ * Returns -1 and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_server_get_group_size(vsp_cmcp_server *cmcp_server,
+    uint16_t group_id);
+
+/**
+ * Open a stream to the specified client, used to transfer a large payload as
+ * a sequence of chunks without buffering all of it.
+ * The stream ID is chosen by the caller and has to be unused for this client.
+ * Different streams may be used by different threads at once.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_server_stream_open(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, uint16_t stream_id);
+
+/**
+ * Send the next chunk of an open stream to the specified client.
+ * This function blocks while the client has not yet processed too many
+ * previously sent chunks, so the memory used by a stream stays bounded.
+ * It must not be called from a callback function of this server.
+ * If the client disconnects, waiting is stopped and this function fails;
+ * the stream still has to be closed.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_server_stream_push(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, uint16_t stream_id, uint32_t chunk_length,
+    void *chunk_data);
+
+/**
+ * Close an open stream to the specified client.
+ * This function blocks until the client processed all chunks.
+ * It must not be called from a callback function of this server.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+VSP_API int vsp_cmcp_server_stream_close(vsp_cmcp_server *cmcp_server,
+    uint16_t client_id, uint16_t stream_id);
+
 #if defined __cplusplus
 }
 #endif /* defined __cplusplus */
@@ -6,30 +6,51 @@
  * Full license text is under the file "LICENSE" provided with this code.
  */
 
+#if defined __linux__
+  /* syscall() is not declared in strict C89 mode otherwise */
+  #define _DEFAULT_SOURCE
+#endif /* defined __linux__ */
+
 #include "vsp_cmcp_state.h"
 
 #include <vesper_util/vsp_error.h>
 #include <vesper_util/vsp_util.h>
+#include <limits.h>
 #include <pthread.h>
 
-/** State storage with locking and waiting for change capabilities. */
+#if defined __linux__
+  #include <linux/futex.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+  /** Wait on the state value with futexes instead of the condition variable. */
+  #define VSP_CMCP_STATE_FUTEX
+#endif /* defined __linux__ */
+
+/** State storage with lock-free reads and waiting for change capabilities. */
 struct vsp_cmcp_state {
-    /** Finite state machine flag. */
-    volatile int state;
-    /** Mutex locking state changes. */
+    /** Finite state machine flag, only accessed atomically. */
+    int state;
+    /** Number of threads waiting for a state change, only accessed
+     * atomically. Setting the state only wakes threads if this is positive. */
+    int waiter_count;
+    /** Mutex kept for vsp_cmcp_state_lock() and the condition variable. */
     pthread_mutex_t mutex;
-    /** Condition variable used to wait for state changes. */
+    /** Condition variable used to wait for state changes if futexes are not
+     * available. */
     pthread_cond_t condition;
 };
 
 /**
- * Wait for the current state to change or the time to pass timeout_time.
+ * Wait for the current state to differ from observed_state or the time to pass
+ * timeout_time. Spurious wake-ups may occur.
+ * The mutex has to be locked; it is released while waiting, so that several
+ * threads can wait at once, and locked again before returning.
  * If timeout_time is NULL, this function does not time out.
- * Returns zero if succeeded and current state changed.
+ * Returns zero if woken up or the state has already changed.
  * Returns non-zero and sets vsp_error_num() if timed out.
  */
-int vsp_cmcp_state_wait(vsp_cmcp_state *cmcp_state,
-    struct timespec *timeout_time);
+static int vsp_cmcp_state_wait(vsp_cmcp_state *cmcp_state,
+    int observed_state, struct timespec *timeout_time);
 
 vsp_cmcp_state *vsp_cmcp_state_create(int initial_state)
 {
@@ -38,6 +59,7 @@ vsp_cmcp_state *vsp_cmcp_state_create(int initial_state)
     VSP_ALLOC(cmcp_state, vsp_cmcp_state);
     /* initialize struct data */
     cmcp_state->state = initial_state;
+    cmcp_state->waiter_count = 0;
     pthread_mutex_init(&cmcp_state->mutex, NULL);
     pthread_cond_init(&cmcp_state->condition, NULL);
     /* return struct pointer */
@@ -48,6 +70,8 @@ void vsp_cmcp_state_free(vsp_cmcp_state *cmcp_state)
 {
     /* check parameter */
     VSP_ASSERT(cmcp_state != NULL);
+    /* no thread may wait anymore */
+    VSP_ASSERT(cmcp_state->waiter_count == 0);
     /* destroy mutex and condition variable */
     pthread_mutex_destroy(&cmcp_state->mutex);
     pthread_cond_destroy(&cmcp_state->condition);
@@ -59,22 +83,31 @@ int vsp_cmcp_state_get(vsp_cmcp_state *cmcp_state)
 {
     /* check parameter */
     VSP_ASSERT(cmcp_state != NULL);
-    /* return state value */
-    return cmcp_state->state;
+    /* return state value; data written before setting it is visible */
+    return __atomic_load_n(&cmcp_state->state, __ATOMIC_ACQUIRE);
 }
 
 void vsp_cmcp_state_set(vsp_cmcp_state *cmcp_state, int state)
 {
     /* check parameter */
     VSP_ASSERT(cmcp_state != NULL);
-    /* lock state mutex */
+    /* update state value; the sequentially consistent store and load ensure
+     * that either waiting threads see the new state or it sees them */
+    __atomic_store_n(&cmcp_state->state, state, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&cmcp_state->waiter_count, __ATOMIC_SEQ_CST) == 0) {
+        /* no thread to wake up */
+        return;
+    }
+#if defined VSP_CMCP_STATE_FUTEX
+    /* wake up all waiting threads */
+    syscall(SYS_futex, &cmcp_state->state, FUTEX_WAKE_PRIVATE, INT_MAX,
+        NULL, NULL, 0);
+#else
+    /* waiting threads hold the mutex until they wait on the condition */
     pthread_mutex_lock(&cmcp_state->mutex);
-    /* update state value */
-    cmcp_state->state = state;
-    /* signal waiting threads */
     pthread_cond_broadcast(&cmcp_state->condition);
-    /* unlock state mutex */
     pthread_mutex_unlock(&cmcp_state->mutex);
+#endif /* defined VSP_CMCP_STATE_FUTEX */
 }
 
 void vsp_cmcp_state_lock(vsp_cmcp_state *cmcp_state)
@@ -97,15 +130,39 @@ void vsp_cmcp_state_unlock(vsp_cmcp_state *cmcp_state)
     VSP_ASSERT(ret == 0);
 }
 
-int vsp_cmcp_state_wait(vsp_cmcp_state *cmcp_state,
+int vsp_cmcp_state_wait(vsp_cmcp_state *cmcp_state, int observed_state,
     struct timespec *timeout_time)
 {
     int ret;
     int success;
 
     success = 0;
+#if defined VSP_CMCP_STATE_FUTEX
+    /* release the mutex like pthread_cond_wait() does; the futex does not
+     * need it, as it only sleeps while the state equals observed_state */
+    pthread_mutex_unlock(&cmcp_state->mutex);
+    /* sleep while the state value equals observed_state; the absolute
+     * timeout is measured with the real-time clock like vsp_time */
+    ret = (int) syscall(SYS_futex, &cmcp_state->state,
+        FUTEX_WAIT_BITSET_PRIVATE | FUTEX_CLOCK_REALTIME, observed_state,
+        timeout_time, NULL, FUTEX_BITSET_MATCH_ANY);
+    if (ret != 0 && errno == ETIMEDOUT) {
+        vsp_error_set_num(ETIMEDOUT);
+        success = -1;
+    } else {
+        /* woken up, state already changed or interrupted by a signal */
+        VSP_ASSERT(ret == 0 || errno == EAGAIN || errno == EINTR);
+    }
+    pthread_mutex_lock(&cmcp_state->mutex);
+#else
+    /* the mutex is locked by the caller, so state changes cannot be missed
+     * before waiting on the condition */
+    if (__atomic_load_n(&cmcp_state->state, __ATOMIC_SEQ_CST)
+        != observed_state) {
+        return 0;
+    }
     if (timeout_time != NULL) {
-        /* wait until thread is running, with timeout */
+        /* wait until state changes, with timeout */
         ret = pthread_cond_timedwait(&cmcp_state->condition,
             &cmcp_state->mutex, timeout_time);
         if (ret == ETIMEDOUT) {
@@ -115,10 +172,11 @@ int vsp_cmcp_state_wait(vsp_cmcp_state *cmcp_state,
             VSP_ASSERT(ret == 0);
         }
     } else {
-        /* wait until thread is running, without timeout */
+        /* wait until state changes, without timeout */
         ret = pthread_cond_wait(&cmcp_state->condition, &cmcp_state->mutex);
         VSP_ASSERT(ret == 0);
     }
+#endif /* defined VSP_CMCP_STATE_FUTEX */
     /* success */
     return success;
 }
@@ -127,19 +185,54 @@ int vsp_cmcp_state_await_state(vsp_cmcp_state *cmcp_state, int state,
     struct timespec *timeout_time)
 {
     int ret;
+    int current_state;
 
     /* check parameters */
     VSP_ASSERT(cmcp_state != NULL);
 
+    /* register as waiting thread before reading the state */
+    __atomic_add_fetch(&cmcp_state->waiter_count, 1, __ATOMIC_SEQ_CST);
     /* initialize local variable */
     ret = 0;
+    current_state = __atomic_load_n(&cmcp_state->state, __ATOMIC_SEQ_CST);
     /* loop until specified state is set or timed out */
-    while (ret == 0 && cmcp_state->state != state) {
-        ret = vsp_cmcp_state_wait(cmcp_state, timeout_time);
+    while (ret == 0 && current_state != state) {
+        ret = vsp_cmcp_state_wait(cmcp_state, current_state, timeout_time);
+        current_state = __atomic_load_n(&cmcp_state->state, __ATOMIC_SEQ_CST);
     }
+    __atomic_sub_fetch(&cmcp_state->waiter_count, 1, __ATOMIC_SEQ_CST);
 
     /* check if specified state is set */
-    VSP_CHECK(cmcp_state->state == state,
+    VSP_CHECK(current_state == state,
+        vsp_error_set_num(ETIMEDOUT); return -1);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_state_await_minimum(vsp_cmcp_state *cmcp_state,
+    int minimum_state, struct timespec *timeout_time)
+{
+    int ret;
+    int current_state;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_state != NULL);
+
+    /* register as waiting thread before reading the state */
+    __atomic_add_fetch(&cmcp_state->waiter_count, 1, __ATOMIC_SEQ_CST);
+    /* initialize local variable */
+    ret = 0;
+    current_state = __atomic_load_n(&cmcp_state->state, __ATOMIC_SEQ_CST);
+    /* loop until specified state is reached or timed out */
+    while (ret == 0 && current_state < minimum_state) {
+        ret = vsp_cmcp_state_wait(cmcp_state, current_state, timeout_time);
+        current_state = __atomic_load_n(&cmcp_state->state, __ATOMIC_SEQ_CST);
+    }
+    __atomic_sub_fetch(&cmcp_state->waiter_count, 1, __ATOMIC_SEQ_CST);
+
+    /* check if specified state is reached */
+    VSP_CHECK(current_state >= minimum_state,
         vsp_error_set_num(ETIMEDOUT); return -1);
 
     /* success */
@@ -16,7 +16,9 @@
 extern "C" {
 #endif /* defined __cplusplus */
 
-/** State storage with mutex locking and waiting for change capabilities. */
+/** State storage with lock-free reads and waiting for change capabilities.
+ * On Linux, threads wait for state changes using futexes, otherwise using a
+ * condition variable. */
 struct vsp_cmcp_server;
 
 /** Define type vsp_cmcp_state to avoid 'struct' keyword. */
@@ -41,13 +43,16 @@ void vsp_cmcp_state_free(vsp_cmcp_state *cmcp_state);
 
 /**
  * Get the current state.
+ * The state is read with a single atomic load with acquire semantics, so data
+ * written before setting the state is visible afterwards.
  * cmcp_state must not be NULL. Aborts if failed.
  */
 int vsp_cmcp_state_get(vsp_cmcp_state *cmcp_state);
 
 /**
  * Set the current state.
- * Locks the mutex while changing the state value, and signals waiting threads.
+ * The state is written atomically with release semantics. Waiting threads are
+ * woken up; if no thread is waiting, no lock is taken and no system call made.
  */
 void vsp_cmcp_state_set(vsp_cmcp_state *cmcp_state, int state);
 
@@ -65,8 +70,8 @@ void vsp_cmcp_state_unlock(vsp_cmcp_state *cmcp_state);
 
 /**
  * Wait for the specified state or the time to pass timeout_time.
- * The mutex has to be locked and will not be unlocked when calling this
- * function.
+ * The mutex has to be locked. It is released while waiting, so several
+ * threads may wait at once, and locked again before this function returns.
  * If timeout_time is NULL, this function does not time out.
  * Returns zero if succeeded and the specified state was set.
  * Returns non-zero and sets vsp_error_num() if timed out.
@@ -74,6 +79,18 @@ void vsp_cmcp_state_unlock(vsp_cmcp_state *cmcp_state);
 int vsp_cmcp_state_await_state(vsp_cmcp_state *cmcp_state, int state,
     struct timespec *timeout_time);
 
+/**
+ * Wait for the state to reach at least the specified value or the time to pass
+ * timeout_time. This is used for states counting up, e.g. acknowledged items.
+ * The mutex has to be locked. It is released while waiting, so several
+ * threads may wait at once, and locked again before this function returns.
+ * If timeout_time is NULL, this function does not time out.
+ * Returns zero if succeeded and the state is at least minimum_state.
+ * Returns non-zero and sets vsp_error_num() if timed out.
+ */
+int vsp_cmcp_state_await_minimum(vsp_cmcp_state *cmcp_state,
+    int minimum_state, struct timespec *timeout_time);
+
 #if defined __cplusplus
 }
 #endif /* defined __cplusplus */
@@ -0,0 +1,144 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#if !defined VSP_CMCP_STATS_H_INCLUDED
+#define VSP_CMCP_STATS_H_INCLUDED
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif /* defined __cplusplus */
+
+/** Snapshot of the counters of a server or client.
+ * All counters start at zero when the server or client is created. They are
+ * updated without locking, so a snapshot taken while messages are sent or
+ * received may combine counter values of slightly different times. */
+struct vsp_cmcp_stats {
+    /** Number of sent network messages; a batch message counts once. */
+    uint64_t messages_sent;
+    /** Total length of sent network messages in bytes. */
+    uint64_t bytes_sent;
+    /** Number of received network messages. */
+    uint64_t messages_received;
+    /** Total length of received network messages in bytes. */
+    uint64_t bytes_received;
+    /** Number of received messages dropped because they could not be
+     * parsed. */
+    uint64_t parse_failures;
+    /** Number of received messages dropped because of an invalid sender ID. */
+    uint64_t filtered_messages;
+    /** Number of negative acknowledges sent to rejected clients by a server,
+     * or received from servers by a client. */
+    uint64_t nacks;
+    /** Number of peer connections that timed out. */
+    uint64_t timeouts;
+    /** Number of sent heartbeat signals. */
+    uint64_t heartbeats_sent;
+    /** Total time in nanoseconds spent handling received messages in the
+     * reception thread, including message callback functions invoked by it. */
+    uint64_t callback_nanoseconds;
+    /** Number of received messages wrapped with send time and sequence number
+     * by their sender, see vsp_cmcp_trace. */
+    uint64_t traced_messages;
+    /** Number of gaps detected in the sequence numbers of traced messages,
+     * see vsp_cmcp_gap_cb. */
+    uint64_t sequence_gaps;
+    /** Number of sequence numbers skipped by the detected gaps. */
+    uint64_t lost_messages;
+    /** Number of traced messages received after a message with a higher
+     * sequence number of the same sender and topic. They were counted in
+     * lost_messages before, so lost_messages minus late_messages estimates
+     * the number of messages actually lost. */
+    uint64_t late_messages;
+};
+
+/** Define type vsp_cmcp_stats to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_stats vsp_cmcp_stats;
+
+/** Latency histogram types. */
+typedef enum {
+    /** Duration of handling a received message in the reception thread,
+     * including the message callback function invoked by it. */
+    VSP_CMCP_LATENCY_CALLBACK,
+    /** Duration of passing a sent message to the network library. */
+    VSP_CMCP_LATENCY_SEND,
+    /** One-way latency of traced messages from the sender to the reception
+     * thread, see vsp_cmcp_trace. */
+    VSP_CMCP_LATENCY_TRANSIT
+} vsp_cmcp_latency_type;
+
+/** Snapshot of a latency histogram of a server or client.
+ * Durations are recorded in logarithmic buckets; percentiles are reported as
+ * the upper bound of their bucket, at most 12.5 percent above the recorded
+ * durations. All durations are in nanoseconds. */
+struct vsp_cmcp_latency {
+    /** Number of recorded durations. */
+    uint64_t count;
+    /** Median duration. */
+    uint64_t p50;
+    /** 90th percentile duration. */
+    uint64_t p90;
+    /** 99th percentile duration. */
+    uint64_t p99;
+    /** 99.9th percentile duration. */
+    uint64_t p999;
+    /** Maximum duration. */
+    uint64_t max;
+};
+
+/** Define type vsp_cmcp_latency to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_latency vsp_cmcp_latency;
+
+/** Trace data of a received message. Peers wrap data messages with their
+ * send time and a sequence number if the receiving server or client has a
+ * trace or gap callback function. Times are read from the monotonic clock,
+ * which is only shared by processes on the same host; between hosts the
+ * latency includes the clock offset. */
+struct vsp_cmcp_trace {
+    /** ID of the sending peer. */
+    uint16_t sender_id;
+    /** Topic ID the message was sent to. */
+    uint16_t topic_id;
+    /** Sequence number counted by the sender per topic, starting at zero.
+     * Missing numbers indicate dropped messages. */
+    uint32_t sequence;
+    /** Monotonic time in nanoseconds when the message was sent. */
+    uint64_t send_time;
+    /** Monotonic time in nanoseconds when the message was received. */
+    uint64_t receive_time;
+};
+
+/** Define type vsp_cmcp_trace to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_trace vsp_cmcp_trace;
+
+/** Callback function invoked by the reception thread for every received
+ * traced message, before the message is handled. The parameters are the
+ * callback parameter set by vsp_cmcp_server_set_callback_param() or
+ * vsp_cmcp_client_set_callback_param() and the trace data, which is only
+ * valid until the callback function returns. */
+typedef void (*vsp_cmcp_trace_cb)(void*, const vsp_cmcp_trace*);
+
+/** Callback function invoked by the reception thread when the sequence
+ * numbers of traced messages skip one or more numbers, before the message
+ * following the gap is handled. Messages are lost this way if the receive
+ * buffer of a subscriber overflows. A message sent concurrently with a
+ * later one of the same sender and topic may also arrive after it, which
+ * reports a gap first and then counts the message as late. The
+ * sequences of a peer are forgotten when it disconnects or times out. The
+ * parameters are the callback parameter, the sender ID, the topic ID, the
+ * expected sequence number and the number of skipped sequence numbers. */
+typedef void (*vsp_cmcp_gap_cb)(void*, uint16_t, uint16_t, uint32_t,
+    uint32_t);
+
+#if defined __cplusplus
+}
+#endif /* defined __cplusplus */
+
+#endif /* !defined VSP_CMCP_STATS_H_INCLUDED */
@@ -0,0 +1,481 @@
+/**
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "vsp_cmcp_stream.h"
+#include "vsp_cmcp_command.h"
+#include "vsp_cmcp_state.h"
+
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_time.h>
+#include <vesper_util/vsp_util.h>
+#include <limits.h>
+#include <pthread.h>
+
+/** Sender side data of a stream. */
+struct vsp_cmcp_stream_outgoing {
+    /** Non-zero if this stream slot is used. */
+    int open;
+    /** Receiving peer ID. */
+    uint16_t peer_id;
+    /** Stream ID. */
+    uint16_t stream_id;
+    /** Number of chunks sent. */
+    int sent_count;
+    /** Number of chunks the receiver processed, updated on credit. */
+    vsp_cmcp_state *acknowledged_count;
+    /** Non-zero if the receiver disconnected, so the stream can only be
+     * closed. */
+    int peer_removed;
+};
+
+/** Define type vsp_cmcp_stream_outgoing to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_stream_outgoing vsp_cmcp_stream_outgoing;
+
+/** Receiver side data of a stream. */
+struct vsp_cmcp_stream_incoming {
+    /** Non-zero if this stream slot is used. */
+    int open;
+    /** Sending peer ID. */
+    uint16_t peer_id;
+    /** Stream ID. */
+    uint16_t stream_id;
+    /** Sequence number of the next expected chunk. */
+    uint32_t received_count;
+};
+
+/** Define type vsp_cmcp_stream_incoming to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_stream_incoming vsp_cmcp_stream_incoming;
+
+/** Outgoing and incoming streams of a node. */
+struct vsp_cmcp_stream_table {
+    /** Node used to send messages. */
+    vsp_cmcp_node *cmcp_node;
+    /** Mutex locking outgoing stream slots, which are opened and closed by
+     * application threads and looked up by the reception thread. */
+    pthread_mutex_t mutex;
+    /** Outgoing stream slots. */
+    vsp_cmcp_stream_outgoing outgoing[VSP_CMCP_STREAM_MAX_STREAMS];
+    /** Incoming stream slots, only used by the reception thread. */
+    vsp_cmcp_stream_incoming incoming[VSP_CMCP_STREAM_MAX_STREAMS];
+    /** Callback function parameter. */
+    void *callback_param;
+    /** Chunk callback function. */
+    vsp_cmcp_stream_chunk_cb chunk_callback;
+};
+
+/** Search for an open outgoing stream. The mutex has to be locked.
+ * Returns slot index if found and -1 else. */
+static int vsp_cmcp_stream_find_outgoing(vsp_cmcp_stream_table *stream_table,
+    uint16_t peer_id, uint16_t stream_id);
+
+/** Search for an open incoming stream.
+ * Returns slot index if found and -1 else. */
+static int vsp_cmcp_stream_find_incoming(vsp_cmcp_stream_table *stream_table,
+    uint16_t peer_id, uint16_t stream_id);
+
+/** Send a stream control message with stream ID and sequence parameters and
+ * an optional chunk.
+ * Returns non-zero and sets vsp_error_num() if failed. */
+static int vsp_cmcp_stream_send(vsp_cmcp_stream_table *stream_table,
+    uint16_t topic_id, uint16_t sender_id, uint16_t command_id,
+    uint16_t stream_id, uint32_t sequence, uint32_t chunk_length,
+    void *chunk_data);
+
+/** Wait until the receiver processed at least the specified number of chunks.
+ * Returns non-zero and sets vsp_error_num() if timed out or the receiver
+ * disconnected. */
+static int vsp_cmcp_stream_await_credit(vsp_cmcp_stream_table *stream_table,
+    vsp_cmcp_stream_outgoing *stream, int acknowledged_count);
+
+vsp_cmcp_stream_table *vsp_cmcp_stream_table_create(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_stream_chunk_cb chunk_callback, void *callback_param)
+{
+    vsp_cmcp_stream_table *stream_table;
+    int index;
+
+    /* check parameters */
+    VSP_ASSERT(cmcp_node != NULL && chunk_callback != NULL);
+    /* allocate memory */
+    VSP_ALLOC(stream_table, vsp_cmcp_stream_table);
+    /* initialize struct data */
+    stream_table->cmcp_node = cmcp_node;
+    pthread_mutex_init(&stream_table->mutex, NULL);
+    for (index = 0; index < VSP_CMCP_STREAM_MAX_STREAMS; ++index) {
+        stream_table->outgoing[index].open = 0;
+        stream_table->outgoing[index].acknowledged_count =
+            vsp_cmcp_state_create(0);
+        /* in case of failure vsp_error_num() is already set */
+        VSP_ASSERT(stream_table->outgoing[index].acknowledged_count != NULL);
+        stream_table->incoming[index].open = 0;
+    }
+    stream_table->callback_param = callback_param;
+    stream_table->chunk_callback = chunk_callback;
+    /* return struct pointer */
+    return stream_table;
+}
+
+void vsp_cmcp_stream_table_free(vsp_cmcp_stream_table *stream_table)
+{
+    int index;
+
+    /* check parameter */
+    VSP_ASSERT(stream_table != NULL);
+
+    for (index = 0; index < VSP_CMCP_STREAM_MAX_STREAMS; ++index) {
+        vsp_cmcp_state_free(stream_table->outgoing[index].acknowledged_count);
+    }
+    pthread_mutex_destroy(&stream_table->mutex);
+
+    /* free memory */
+    VSP_FREE(stream_table);
+}
+
+int vsp_cmcp_stream_open(vsp_cmcp_stream_table *stream_table,
+    uint16_t peer_id, uint16_t stream_id)
+{
+    int index;
+    int free_index;
+
+    /* check parameters */
+    VSP_ASSERT(stream_table != NULL);
+
+    pthread_mutex_lock(&stream_table->mutex);
+    /* check stream was not opened yet and find free slot */
+    free_index = -1;
+    for (index = 0; index < VSP_CMCP_STREAM_MAX_STREAMS; ++index) {
+        if (!stream_table->outgoing[index].open) {
+            if (free_index == -1) {
+                free_index = index;
+            }
+        } else if (stream_table->outgoing[index].peer_id == peer_id
+            && stream_table->outgoing[index].stream_id == stream_id) {
+            pthread_mutex_unlock(&stream_table->mutex);
+            vsp_error_set_num(EALREADY);
+            return -1;
+        }
+    }
+    VSP_CHECK(free_index >= 0, pthread_mutex_unlock(&stream_table->mutex);
+        vsp_error_set_num(ENOMEM); return -1);
+
+    /* initialize stream slot */
+    stream_table->outgoing[free_index].open = 1;
+    stream_table->outgoing[free_index].peer_id = peer_id;
+    stream_table->outgoing[free_index].stream_id = stream_id;
+    stream_table->outgoing[free_index].sent_count = 0;
+    stream_table->outgoing[free_index].peer_removed = 0;
+    vsp_cmcp_state_set(stream_table->outgoing[free_index].acknowledged_count,
+        0);
+    pthread_mutex_unlock(&stream_table->mutex);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_stream_push(vsp_cmcp_stream_table *stream_table,
+    uint16_t topic_id, uint16_t sender_id, uint16_t peer_id,
+    uint16_t stream_id, uint32_t chunk_length, void *chunk_data)
+{
+    int ret;
+    int index;
+    vsp_cmcp_stream_outgoing *stream;
+
+    /* check parameters */
+    VSP_ASSERT(stream_table != NULL && chunk_length > 0 && chunk_data != NULL);
+
+    /* find stream; the slot stays valid until the stream is closed */
+    pthread_mutex_lock(&stream_table->mutex);
+    index = vsp_cmcp_stream_find_outgoing(stream_table, peer_id, stream_id);
+    pthread_mutex_unlock(&stream_table->mutex);
+    VSP_CHECK(index >= 0, vsp_error_set_num(ENOENT); return -1);
+    stream = &stream_table->outgoing[index];
+
+    /* wait for credit: at most VSP_CMCP_STREAM_WINDOW chunks in flight */
+    ret = vsp_cmcp_stream_await_credit(stream_table, stream,
+        stream->sent_count + 1 - VSP_CMCP_STREAM_WINDOW);
+    /* vsp_error_num() is set by vsp_cmcp_stream_await_credit() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* send chunk */
+    ret = vsp_cmcp_stream_send(stream_table, topic_id, sender_id,
+        VSP_CMCP_COMMAND_STREAM_CHUNK, stream_id, stream->sent_count,
+        chunk_length, chunk_data);
+    /* vsp_error_num() is set by vsp_cmcp_stream_send() */
+    VSP_CHECK(ret == 0, return -1);
+    ++stream->sent_count;
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_stream_close(vsp_cmcp_stream_table *stream_table,
+    uint16_t topic_id, uint16_t sender_id, uint16_t peer_id,
+    uint16_t stream_id)
+{
+    int ret;
+    int index;
+    vsp_cmcp_stream_outgoing *stream;
+
+    /* check parameters */
+    VSP_ASSERT(stream_table != NULL);
+
+    /* find stream */
+    pthread_mutex_lock(&stream_table->mutex);
+    index = vsp_cmcp_stream_find_outgoing(stream_table, peer_id, stream_id);
+    pthread_mutex_unlock(&stream_table->mutex);
+    VSP_CHECK(index >= 0, vsp_error_set_num(ENOENT); return -1);
+    stream = &stream_table->outgoing[index];
+
+    /* send end of stream and wait until all chunks are processed */
+    ret = vsp_cmcp_stream_send(stream_table, topic_id, sender_id,
+        VSP_CMCP_COMMAND_STREAM_CLOSE, stream_id, stream->sent_count, 0, NULL);
+    if (ret == 0) {
+        ret = vsp_cmcp_stream_await_credit(stream_table, stream,
+            stream->sent_count);
+    }
+
+    /* release stream slot in any case */
+    pthread_mutex_lock(&stream_table->mutex);
+    stream->open = 0;
+    pthread_mutex_unlock(&stream_table->mutex);
+
+    /* vsp_error_num() is set by vsp_cmcp_stream_send() or
+     * vsp_cmcp_stream_await_credit() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* success */
+    return 0;
+}
+
+void vsp_cmcp_stream_handle_message(vsp_cmcp_stream_table *stream_table,
+    uint16_t topic_id, uint16_t sender_id, uint16_t peer_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
+{
+    int index;
+    int ret;
+    uint16_t stream_id;
+    uint32_t sequence;
+    uint32_t chunk_length;
+    void *chunk_data;
+    vsp_cmcp_stream_incoming *stream;
+
+    /* check parameters */
+    VSP_ASSERT(stream_table != NULL && cmcp_datalist != NULL);
+
+    /* get stream ID and sequence number; failures are silently ignored */
+    ret = vsp_cmcp_datalist_get_u16(cmcp_datalist,
+        VSP_CMCP_PARAMETER_STREAM_ID, 1, &stream_id);
+    VSP_CHECK(ret == 0, return);
+    ret = vsp_cmcp_datalist_get_u32(cmcp_datalist,
+        VSP_CMCP_PARAMETER_STREAM_SEQUENCE, 1, &sequence);
+    VSP_CHECK(ret == 0, return);
+
+    if (command_id == VSP_CMCP_COMMAND_STREAM_CREDIT) {
+        /* credit for an outgoing stream received */
+        pthread_mutex_lock(&stream_table->mutex);
+        index = vsp_cmcp_stream_find_outgoing(stream_table, peer_id,
+            stream_id);
+        if (index >= 0 && !stream_table->outgoing[index].peer_removed) {
+            /* wake up waiting sender */
+            vsp_cmcp_state_set(stream_table->outgoing[index].acknowledged_count,
+                (int) sequence);
+        }
+        pthread_mutex_unlock(&stream_table->mutex);
+        return;
+    }
+
+    /* find incoming stream, new streams start with the first chunk */
+    index = vsp_cmcp_stream_find_incoming(stream_table, peer_id, stream_id);
+    if (index < 0 && command_id == VSP_CMCP_COMMAND_STREAM_CHUNK
+        && sequence == 0) {
+        for (index = 0; index < VSP_CMCP_STREAM_MAX_STREAMS
+            && stream_table->incoming[index].open; ++index) {
+            /* search free stream slot */
+        }
+        /* no free stream slot: ignore stream, the sender will time out */
+        VSP_CHECK(index < VSP_CMCP_STREAM_MAX_STREAMS, return);
+        stream_table->incoming[index].open = 1;
+        stream_table->incoming[index].peer_id = peer_id;
+        stream_table->incoming[index].stream_id = stream_id;
+        stream_table->incoming[index].received_count = 0;
+    }
+    VSP_CHECK(index >= 0, return);
+    stream = &stream_table->incoming[index];
+    /* chunks are delivered in order; after a lost chunk the stream stalls and
+     * the sender times out */
+    VSP_CHECK(sequence == stream->received_count, return);
+
+    if (command_id == VSP_CMCP_COMMAND_STREAM_CHUNK) {
+        /* get chunk data */
+        ret = vsp_cmcp_datalist_get_u32(cmcp_datalist,
+            VSP_CMCP_PARAMETER_STREAM_CHUNK_LENGTH, 1, &chunk_length);
+        VSP_CHECK(ret == 0, return);
+        chunk_data = vsp_cmcp_datalist_get_data_item(cmcp_datalist,
+            VSP_CMCP_PARAMETER_STREAM_CHUNK, chunk_length);
+        VSP_CHECK(chunk_data != NULL, return);
+        /* deliver chunk */
+        stream_table->chunk_callback(stream_table->callback_param, peer_id,
+            stream_id, chunk_length, chunk_data);
+        ++stream->received_count;
+        /* return credit for every half window */
+        if (stream->received_count % (VSP_CMCP_STREAM_WINDOW / 2) == 0) {
+            vsp_cmcp_stream_send(stream_table, topic_id, sender_id,
+                VSP_CMCP_COMMAND_STREAM_CREDIT, stream_id,
+                stream->received_count, 0, NULL);
+        }
+    } else if (command_id == VSP_CMCP_COMMAND_STREAM_CLOSE) {
+        /* deliver end of stream */
+        stream_table->chunk_callback(stream_table->callback_param, peer_id,
+            stream_id, 0, NULL);
+        stream->open = 0;
+        /* acknowledge all chunks so the sender returns from closing */
+        vsp_cmcp_stream_send(stream_table, topic_id, sender_id,
+            VSP_CMCP_COMMAND_STREAM_CREDIT, stream_id,
+            stream->received_count, 0, NULL);
+    }
+}
+
+void vsp_cmcp_stream_remove_peer(vsp_cmcp_stream_table *stream_table,
+    uint16_t peer_id)
+{
+    int index;
+
+    /* check parameters */
+    VSP_ASSERT(stream_table != NULL);
+
+    for (index = 0; index < VSP_CMCP_STREAM_MAX_STREAMS; ++index) {
+        if (stream_table->incoming[index].open
+            && stream_table->incoming[index].peer_id == peer_id) {
+            stream_table->incoming[index].open = 0;
+        }
+    }
+
+    /* let outgoing streams fail; they stay open until closed by the sender */
+    pthread_mutex_lock(&stream_table->mutex);
+    for (index = 0; index < VSP_CMCP_STREAM_MAX_STREAMS; ++index) {
+        if (stream_table->outgoing[index].open
+            && stream_table->outgoing[index].peer_id == peer_id) {
+            stream_table->outgoing[index].peer_removed = 1;
+            /* wake up waiting sender */
+            vsp_cmcp_state_set(stream_table->outgoing[index].acknowledged_count,
+                INT_MAX);
+        }
+    }
+    pthread_mutex_unlock(&stream_table->mutex);
+}
+
+int vsp_cmcp_stream_find_outgoing(vsp_cmcp_stream_table *stream_table,
+    uint16_t peer_id, uint16_t stream_id)
+{
+    int index;
+
+    for (index = 0; index < VSP_CMCP_STREAM_MAX_STREAMS; ++index) {
+        if (stream_table->outgoing[index].open
+            && stream_table->outgoing[index].peer_id == peer_id
+            && stream_table->outgoing[index].stream_id == stream_id) {
+            /* stream found */
+            return index;
+        }
+    }
+
+    /* stream not found */
+    return -1;
+}
+
+int vsp_cmcp_stream_find_incoming(vsp_cmcp_stream_table *stream_table,
+    uint16_t peer_id, uint16_t stream_id)
+{
+    int index;
+
+    for (index = 0; index < VSP_CMCP_STREAM_MAX_STREAMS; ++index) {
+        if (stream_table->incoming[index].open
+            && stream_table->incoming[index].peer_id == peer_id
+            && stream_table->incoming[index].stream_id == stream_id) {
+            /* stream found */
+            return index;
+        }
+    }
+
+    /* stream not found */
+    return -1;
+}
+
+int vsp_cmcp_stream_send(vsp_cmcp_stream_table *stream_table,
+    uint16_t topic_id, uint16_t sender_id, uint16_t command_id,
+    uint16_t stream_id, uint32_t sequence, uint32_t chunk_length,
+    void *chunk_data)
+{
+    int ret;
+    vsp_cmcp_datalist *cmcp_datalist;
+
+    /* create data list with stream parameters */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    /* check for errors */
+    VSP_ASSERT(cmcp_datalist != NULL);
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist,
+        VSP_CMCP_PARAMETER_STREAM_ID, sizeof(uint16_t), &stream_id);
+    VSP_ASSERT(ret == 0);
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist,
+        VSP_CMCP_PARAMETER_STREAM_SEQUENCE, sizeof(uint32_t), &sequence);
+    VSP_ASSERT(ret == 0);
+    if (chunk_data != NULL) {
+        ret = vsp_cmcp_datalist_add_item(cmcp_datalist,
+            VSP_CMCP_PARAMETER_STREAM_CHUNK_LENGTH, sizeof(uint32_t),
+            &chunk_length);
+        VSP_ASSERT(ret == 0);
+        ret = vsp_cmcp_datalist_add_item(cmcp_datalist,
+            VSP_CMCP_PARAMETER_STREAM_CHUNK, chunk_length, chunk_data);
+        /* vsp_error_num() is set by vsp_cmcp_datalist_add_item() */
+        VSP_CHECK(ret == 0, vsp_cmcp_datalist_free(cmcp_datalist); return -1);
+    }
+
+    /* send message */
+    ret = vsp_cmcp_node_create_send_message(stream_table->cmcp_node,
+        VSP_CMCP_MESSAGE_TYPE_CONTROL, topic_id, sender_id, command_id,
+        cmcp_datalist, 0);
+
+    /* cleanup */
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* vsp_error_num() is set by vsp_cmcp_node_create_send_message() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* success */
+    return 0;
+}
+
+int vsp_cmcp_stream_await_credit(vsp_cmcp_stream_table *stream_table,
+    vsp_cmcp_stream_outgoing *stream, int acknowledged_count)
+{
+    int ret;
+    int peer_removed;
+    struct timespec time_timeout;
+
+    /* start measuring time for credit timeout */
+    vsp_time_real_timespec_from_now(&time_timeout,
+        VSP_CMCP_NODE_CONNECTION_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(stream->acknowledged_count);
+    /* wait until enough chunks were acknowledged or waiting timed out */
+    ret = vsp_cmcp_state_await_minimum(stream->acknowledged_count,
+        acknowledged_count, &time_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(stream->acknowledged_count);
+
+    /* vsp_error_num() is set by vsp_cmcp_state_await_minimum() */
+    VSP_CHECK(ret == 0, return -1);
+
+    /* check if woken up because the receiver disconnected */
+    pthread_mutex_lock(&stream_table->mutex);
+    peer_removed = stream->peer_removed;
+    pthread_mutex_unlock(&stream_table->mutex);
+    VSP_CHECK(peer_removed == 0, vsp_error_set_num(ECONNRESET); return -1);
+
+    /* success */
+    return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#if !defined VSP_CMCP_STREAM_H_INCLUDED
+#define VSP_CMCP_STREAM_H_INCLUDED
+
+#include "vsp_cmcp_datalist.h"
+#include "vsp_cmcp_node.h"
+
+#include <stdint.h>
+
+#if defined __cplusplus
+extern "C" {
+#endif /* defined __cplusplus */
+
+/** Number of chunks a stream sender may send before waiting for the receiver
+ * to grant credit. Bounds the memory used by in-flight chunks. */
+#define VSP_CMCP_STREAM_WINDOW 8
+
+/** Maximum number of outgoing and of incoming streams per node. */
+#define VSP_CMCP_STREAM_MAX_STREAMS 16
+
+/** Callback function invoked for every received stream chunk.
+ * The parameters are the callback parameter, the peer ID, the stream ID, the
+ * chunk length and the chunk data. The end of a stream is signaled by chunk
+ * length zero and chunk data NULL. */
+typedef void (*vsp_cmcp_stream_chunk_cb)(void*, uint16_t, uint16_t, uint32_t,
+    void*);
+
+/** Outgoing and incoming streams of a node.
+ * Chunks are sent as VSP_CMCP_COMMAND_STREAM_CHUNK control messages. After the
+ * receiver processed VSP_CMCP_STREAM_WINDOW / 2 chunks it returns credit to
+ * the sender, so at most VSP_CMCP_STREAM_WINDOW chunks are in flight. */
+struct vsp_cmcp_stream_table;
+
+/** Define type vsp_cmcp_stream_table to avoid 'struct' keyword. */
+typedef struct vsp_cmcp_stream_table vsp_cmcp_stream_table;
+
+/**
+ * Create new vsp_cmcp_stream_table object sending messages via cmcp_node.
+ * chunk_callback is invoked from the node reception thread.
+ * Returned pointer should be freed with vsp_cmcp_stream_table_free().
+ * Returns NULL and sets vsp_error_num() if failed.
+ */
+vsp_cmcp_stream_table *vsp_cmcp_stream_table_create(vsp_cmcp_node *cmcp_node,
+    vsp_cmcp_stream_chunk_cb chunk_callback, void *callback_param);
+
+/**
+ * Free vsp_cmcp_stream_table object.
+ * Object should be created with vsp_cmcp_stream_table_create().
+ */
+void vsp_cmcp_stream_table_free(vsp_cmcp_stream_table *stream_table);
+
+/**
+ * Open an outgoing stream to the specified peer.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+int vsp_cmcp_stream_open(vsp_cmcp_stream_table *stream_table,
+    uint16_t peer_id, uint16_t stream_id);
+
+/**
+ * Send the next chunk of an open outgoing stream.
+ * Messages are sent with the specified topic and sender ID.
+ * Blocks while VSP_CMCP_STREAM_WINDOW chunks are not yet acknowledged, for at
+ * most VSP_CMCP_NODE_CONNECTION_TIMEOUT milliseconds or until the receiver is
+ * removed by vsp_cmcp_stream_remove_peer().
+ * A stream must not be used by several threads at once.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+int vsp_cmcp_stream_push(vsp_cmcp_stream_table *stream_table,
+    uint16_t topic_id, uint16_t sender_id, uint16_t peer_id,
+    uint16_t stream_id, uint32_t chunk_length, void *chunk_data);
+
+/**
+ * Close an open outgoing stream and wait until the receiver processed all
+ * chunks, for at most VSP_CMCP_NODE_CONNECTION_TIMEOUT milliseconds.
+ * The stream is closed even if waiting failed.
+ * Returns non-zero and sets vsp_error_num() if failed.
+ */
+int vsp_cmcp_stream_close(vsp_cmcp_stream_table *stream_table,
+    uint16_t topic_id, uint16_t sender_id, uint16_t peer_id,
+    uint16_t stream_id);
+
+/**
+ * Handle a received stream control message (vsp_cmcp_stream_command_id).
+ * Credit is returned with the specified topic and sender ID.
+ * This function has to be called from the node reception thread.
+ */
+void vsp_cmcp_stream_handle_message(vsp_cmcp_stream_table *stream_table,
+    uint16_t topic_id, uint16_t sender_id, uint16_t peer_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
+
+/**
+ * Drop incoming streams of a disconnected peer and let outgoing streams to it
+ * fail, waking up senders waiting for credit. Failed outgoing streams still
+ * have to be closed.
+ * This function has to be called from the node reception thread.
+ */
+void vsp_cmcp_stream_remove_peer(vsp_cmcp_stream_table *stream_table,
+    uint16_t peer_id);
+
+#if defined __cplusplus
+}
+#endif /* defined __cplusplus */
+
+#endif /* !defined VSP_CMCP_STREAM_H_INCLUDED */
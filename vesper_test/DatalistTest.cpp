@@ -0,0 +1,95 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "minunit.h"
+#include "vsp_test.h"
+
+#include <vesper_cmcp/Datalist.hpp>
+#include <vesper_util/vsp_error.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+/** Struct stored as data list items by the tests. */
+struct Pose {
+    double position[3];
+    uint32_t flags;
+};
+
+/** Encoding of a Pose as data list items. */
+typedef Vesper::DatalistStruct<
+    Vesper::DatalistField<VSP_TEST_DATALIST_ITEM1_ID, Pose, double[3],
+        &Pose::position>,
+    Vesper::DatalistField<VSP_TEST_DATALIST_ITEM2_ID, Pose, uint32_t,
+        &Pose::flags> > PoseItems;
+
+} /* namespace */
+
+/** Add a struct to a data list and read it back from the binary data. */
+MU_TEST(vsp_test_cmcp_datalist_struct_test);
+
+MU_TEST(vsp_test_cmcp_datalist_struct_test)
+{
+    int ret;
+    int data_length;
+    Pose pose;
+    Pose read_pose;
+    uint8_t *data_pointer;
+    vsp_cmcp_datalist *cmcp_datalist;
+    vsp_cmcp_datalist *cmcp_datalist2;
+
+    pose.position[0] = 0.5;
+    pose.position[1] = -2.0;
+    pose.position[2] = 1e9;
+    pose.flags = VSP_TEST_TRACE_SEQUENCE;
+    memset(&read_pose, 0, sizeof(read_pose));
+
+    /* add all members as data list items */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = PoseItems::add(cmcp_datalist, pose);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* round trip through binary data */
+    data_length = vsp_cmcp_datalist_get_data_length(cmcp_datalist);
+    mu_assert_abort(data_length > 0, vsp_error_str(vsp_error_num()));
+    data_pointer = static_cast<uint8_t*>(malloc(data_length));
+    mu_assert_abort(data_pointer != NULL, vsp_error_str(ENOMEM));
+    ret = vsp_cmcp_datalist_get_data(cmcp_datalist, data_pointer);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    cmcp_datalist2 = vsp_cmcp_datalist_create_parse(data_length,
+        data_pointer);
+    mu_assert_abort(cmcp_datalist2 != NULL, vsp_error_str(vsp_error_num()));
+
+    /* read all members back */
+    ret = PoseItems::get(cmcp_datalist2, read_pose);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(memcmp(read_pose.position, pose.position,
+        sizeof(pose.position)) == 0 && read_pose.flags == pose.flags,
+        vsp_error_str(EINVAL));
+
+    /* members missing in the data list are not read */
+    vsp_cmcp_datalist_free(cmcp_datalist2);
+    cmcp_datalist2 = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist2 != NULL, vsp_error_str(vsp_error_num()));
+    ret = PoseItems::get(cmcp_datalist2, read_pose);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* deallocation */
+    vsp_cmcp_datalist_free(cmcp_datalist2);
+    free(data_pointer);
+    vsp_cmcp_datalist_free(cmcp_datalist);
+}
+
+MU_TEST_SUITE(vsp_test_cmcp_datalist_cpp)
+{
+    MU_RUN_TEST(vsp_test_cmcp_datalist_struct_test);
+}
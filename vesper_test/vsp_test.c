@@ -18,7 +18,12 @@ int main(void)
 {
     MU_RUN_SUITE(vsp_test_cmcp_connection);
     MU_RUN_SUITE(vsp_test_cmcp_datalist);
+    MU_RUN_SUITE(vsp_test_cmcp_datalist_cpp);
+    MU_RUN_SUITE(vsp_test_cmcp_dispatch);
+    MU_RUN_SUITE(vsp_test_cmcp_histogram);
     MU_RUN_SUITE(vsp_test_cmcp_message);
+    MU_RUN_SUITE(vsp_test_cmcp_queue);
+    MU_RUN_SUITE(vsp_test_cmcp_sequence);
     MU_RUN_SUITE(vsp_test_util);
     MU_REPORT();
     if (minunit_fail > 0) {
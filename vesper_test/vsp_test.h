@@ -39,6 +39,11 @@ extern "C" {
 /** Second data list item data. */
 #define VSP_TEST_DATALIST_ITEM2_DATA "World!"
 
+/** Large data list item ID. */
+#define VSP_TEST_DATALIST_LARGE_ITEM_ID 4711
+/** Large data list item length, exceeding 16-bit item lengths. */
+#define VSP_TEST_DATALIST_LARGE_ITEM_LENGTH 200000
+
 
 /** Message topic ID. */
 #define VSP_TEST_MESSAGE_TOPIC_ID 28437
@@ -46,14 +51,76 @@ extern "C" {
 #define VSP_TEST_MESSAGE_SENDER_ID 6391
 /** Message command ID. Has to be lower than 2^15. */
 #define VSP_TEST_MESSAGE_COMMAND_ID 27743
+/** Send time of trace messages. */
+#define VSP_TEST_TRACE_SEND_TIME 81526390417
+/** Sequence number of trace messages. */
+#define VSP_TEST_TRACE_SEQUENCE 42719
+
+/** Stream ID. */
+#define VSP_TEST_STREAM_ID 1543
+/** Number of stream chunks, exceeding the stream flow control window. */
+#define VSP_TEST_STREAM_CHUNK_COUNT 50
+
+/** Number of reactor threads, smaller than the number of nodes. */
+#define VSP_TEST_REACTOR_THREAD_COUNT 1
+
+/** Number of server worker threads invoking the message callback function. */
+#define VSP_TEST_WORKER_COUNT 2
+/** Maximum number of messages queued for every worker thread. */
+#define VSP_TEST_WORKER_QUEUE_CAPACITY 4
+
+/** Capacity of receive queues. Has to be a power of two, at least 2. */
+#define VSP_TEST_RECEIVE_QUEUE_CAPACITY 4
+
+/** Number of threads sending server messages at once. */
+#define VSP_TEST_SENDER_THREAD_COUNT 4
+/** Number of server messages sent by every sending thread. */
+#define VSP_TEST_SENDER_MESSAGE_COUNT 50
+
+/** Number of server messages whose buffers are taken over by the client,
+ * sent singly and once more in a batch. */
+#define VSP_TEST_BUFFER_MESSAGE_COUNT 8
+
+/** Number of clients connected to the server at once, so the server peer
+ * table grows several times. Has to be a multiple of three. */
+#define VSP_TEST_PEER_CLIENT_COUNT 48
+
+/** Number of clients connected and freed at once in every round of the
+ * churn test. Has to be at most VSP_TEST_PEER_CLIENT_COUNT. */
+#define VSP_TEST_CHURN_CLIENT_COUNT 8
+/** Number of rounds of the churn test. The product with
+ * VSP_TEST_CHURN_CLIENT_COUNT has to be at most VSP_TEST_PEER_CLIENT_COUNT. */
+#define VSP_TEST_CHURN_ROUND_COUNT 4
+
+/** Multicast group joined by the client. Has to be lower than 256. */
+#define VSP_TEST_GROUP_ID 42
+
+/** Number of bucket shards of tested histograms. */
+#define VSP_TEST_HISTOGRAM_SHARD_COUNT 3
+/** Number of durations recorded in tested histograms, 1 up to this value. */
+#define VSP_TEST_HISTOGRAM_VALUE_COUNT 1000
+
+/** Number of senders tracked by tested sequence tables, forcing them to grow
+ * several times. */
+#define VSP_TEST_SEQUENCE_SENDER_COUNT 1000
 
 
 /** Test CMCP implementation. */
 MU_TEST_SUITE(vsp_test_cmcp_connection);
 /** Test data list implementation. */
 MU_TEST_SUITE(vsp_test_cmcp_datalist);
+/** Test typed C++ data list wrappers. */
+MU_TEST_SUITE(vsp_test_cmcp_datalist_cpp);
+/** Test latency histogram implementation. */
+MU_TEST_SUITE(vsp_test_cmcp_histogram);
+/** Test message dispatching to worker threads. */
+MU_TEST_SUITE(vsp_test_cmcp_dispatch);
 /** Test CMCP message implementation. */
 MU_TEST_SUITE(vsp_test_cmcp_message);
+/** Test receive queue implementation. */
+MU_TEST_SUITE(vsp_test_cmcp_queue);
+/** Test sequence gap detection implementation. */
+MU_TEST_SUITE(vsp_test_cmcp_sequence);
 /** Test internal utility functions. */
 MU_TEST_SUITE(vsp_test_util);
 
@@ -12,15 +12,23 @@
 
 #include <vesper_cmcp/vsp_cmcp_client.h>
 #include <vesper_cmcp/vsp_cmcp_node.h>
+#include <vesper_cmcp/vsp_cmcp_reactor.h>
 #include <vesper_cmcp/vsp_cmcp_server.h>
 #include <vesper_cmcp/vsp_cmcp_state.h>
 #include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
 #include <errno.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stddef.h>
 #include <string.h>
 
 #define VSP_TEST_CMCP_TIMEOUT 5000
 
+/** Total number of server messages sent by all sending threads. */
+#define VSP_TEST_CMCP_SENT_MESSAGE_COUNT \
+    (VSP_TEST_SENDER_THREAD_COUNT * VSP_TEST_SENDER_MESSAGE_COUNT)
+
 /** Test states. */
 typedef enum {
     /** Client is not connected to server. */
@@ -45,15 +53,106 @@ vsp_cmcp_server *global_cmcp_server;
 /** Global CMCP client object. */
 vsp_cmcp_client *global_cmcp_client;
 
+/** Global CMCP reactor object, or NULL if nodes use own threads. */
+vsp_cmcp_reactor *global_cmcp_reactor;
+
+/** Number of server worker threads, or zero to invoke the message callback
+ * function from the reception thread. */
+int global_cmcp_worker_count;
+
+/** Capacity of the server and client receive queues, or zero to invoke the
+ * message callback functions from the reception threads. */
+int global_cmcp_receive_queue_capacity;
+
 /** Global CMCP client ID. */
 uint16_t global_cmcp_client_id;
 
+/** Number of stream chunks received by the server or the client. */
+uint32_t global_stream_chunk_count;
+
+/** Non-zero if the end of the stream was received by the server or the
+ * client. */
+int global_stream_closed;
+
+/** Number of server messages received by the client. */
+int global_received_message_count;
+
+/** Number of traced messages received by the server. */
+uint32_t global_server_trace_count;
+
+/** Number of traced messages received by the client. */
+uint32_t global_client_trace_count;
+
+/** Number of sequence numbers skipped by messages received by the client. */
+uint32_t global_client_lost_count;
+
+/** Clients connected in addition to global_cmcp_client, or NULL if freed. */
+vsp_cmcp_client *global_peer_clients[VSP_TEST_PEER_CLIENT_COUNT];
+
+/** Client IDs of global_peer_clients, reported by their first message. */
+uint16_t global_peer_client_ids[VSP_TEST_PEER_CLIENT_COUNT];
+
+/** Number of global_peer_clients registered to the server. */
+int global_peer_count;
+
+/** Number of global_peer_clients that reported their client ID. */
+int global_peer_reported_count;
+
+/** Callback parameter of the client message callback function invoked
+ * last. */
+void *global_peer_receiver;
+
+/** Non-zero while the churn test lets threads send server messages. */
+int global_churn_running;
+
+/** Message buffers taken over by the client message callback function. */
+vsp_cmcp_buffer *global_taken_buffers[2 * VSP_TEST_BUFFER_MESSAGE_COUNT];
+
+/** Data list items of the taken message buffers. */
+void *global_taken_items[2 * VSP_TEST_BUFFER_MESSAGE_COUNT];
+
 /** Client announcement callback function. */
 int vsp_test_cmcp_announcement_cb(void *callback_param, uint16_t client_id);
 
 /** Client disconnection callback function. */
 void vsp_test_cmcp_disconnect_cb(void *callback_param, uint16_t client_id);
 
+/** Client announcement callback function counting global_peer_clients. */
+int vsp_test_cmcp_peer_announcement_cb(void *callback_param,
+    uint16_t client_id);
+
+/** Server message callback function storing client IDs of
+ * global_peer_clients. */
+void vsp_test_cmcp_peer_report_cb(void *callback_param, uint16_t client_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
+
+/** Client disconnection callback function counting global_peer_clients. */
+void vsp_test_cmcp_peer_disconnect_cb(void *callback_param,
+    uint16_t client_id);
+
+/** Client message callback function storing the receiving client. */
+void vsp_test_cmcp_peer_message_cb(void *callback_param, uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist);
+
+/** Connect the client passed as parameter; runs in several threads.
+ * Returns NULL if connected. */
+void *vsp_test_cmcp_peer_connect_run(void *param);
+
+/** Server message callback function storing client IDs of
+ * global_peer_clients while sending threads read them. */
+void vsp_test_cmcp_churn_report_cb(void *callback_param, uint16_t client_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
+
+/** Send server messages to the connected client and to the churning
+ * global_peer_clients until global_churn_running is cleared; runs in several
+ * threads. Returns NULL if all messages to the connected client were sent. */
+void *vsp_test_cmcp_churn_sender_run(void *param);
+
+/** Server message callback function freeing the first of global_peer_clients
+ * from the reactor thread driving it. */
+void vsp_test_cmcp_reactor_free_cb(void *callback_param, uint16_t client_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
+
 /** Server message callback function. */
 void vsp_test_cmcp_server_message_cb(void *callback_param, uint16_t client_id,
     uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
@@ -62,6 +161,52 @@ void vsp_test_cmcp_server_message_cb(void *callback_param, uint16_t client_id,
 void vsp_test_cmcp_client_message_cb(void *callback_param, uint16_t command_id,
     vsp_cmcp_datalist *cmcp_datalist);
 
+/** Client message callback function counting messages of sending threads. */
+void vsp_test_cmcp_client_count_cb(void *callback_param, uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist);
+
+/** Client message callback function taking over the message buffers. */
+void vsp_test_cmcp_client_take_cb(void *callback_param, uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist);
+
+/** Send server messages to the connected client; runs in several threads.
+ * Returns NULL if all messages were sent. */
+void *vsp_test_cmcp_sender_run(void *param);
+
+/** Trace callback function of server and client. */
+void vsp_test_cmcp_trace_cb(void *callback_param,
+    const vsp_cmcp_trace *cmcp_trace);
+
+/** Sequence gap callback function of the client. */
+void vsp_test_cmcp_gap_cb(void *callback_param, uint16_t sender_id,
+    uint16_t topic_id, uint32_t expected_sequence, uint32_t lost_count);
+
+/** Server stream chunk callback function. */
+void vsp_test_cmcp_server_stream_cb(void *callback_param, uint16_t client_id,
+    uint16_t stream_id, uint32_t chunk_length, void *chunk_data);
+
+/** Client stream chunk callback function. */
+void vsp_test_cmcp_client_stream_cb(void *callback_param, uint16_t stream_id,
+    uint32_t chunk_length, void *chunk_data);
+
+/** Client stream chunk callback function stalling the client reception
+ * thread on the first chunk until the test thread lets it continue. */
+void vsp_test_cmcp_client_stall_cb(void *callback_param, uint16_t stream_id,
+    uint32_t chunk_length, void *chunk_data);
+
+/** Check that stream chunks are received in order, followed by the end of
+ * the stream, and count them. */
+static void vsp_test_cmcp_check_stream_chunk(uint32_t chunk_length,
+    void *chunk_data);
+
+/** Push stream chunks from the server to the connected client until pushing
+ * fails; runs in its own thread. Returns NULL. */
+void *vsp_test_cmcp_stream_pusher_run(void *param);
+
+/** Stream VSP_TEST_STREAM_CHUNK_COUNT chunks from the server to the
+ * connected client and check that the client received all of them. */
+static void vsp_test_cmcp_stream_to_client(void);
+
 /** Create global_cmcp_server and global_cmcp_client objects. */
 void vsp_test_cmcp_connection_setup(void);
 
@@ -69,7 +214,21 @@ void vsp_test_cmcp_connection_setup(void);
  * global_cmcp_server and global_cmcp_client objects. */
 void vsp_test_cmcp_communication_setup(void);
 
-/** Free global_cmcp_server and global_cmcp_client objects. */
+/** Create global_cmcp_reactor object, then create and connect
+ * global_cmcp_server and global_cmcp_client objects driven by the reactor. */
+void vsp_test_cmcp_reactor_setup(void);
+
+/** Create and connect global_cmcp_server and global_cmcp_client objects,
+ * with server messages handled by worker threads. */
+void vsp_test_cmcp_worker_setup(void);
+
+/** Create and connect global_cmcp_server and global_cmcp_client objects,
+ * with server and client messages handed over to the test thread by receive
+ * queues. */
+void vsp_test_cmcp_receive_queue_setup(void);
+
+/** Free global_cmcp_server and global_cmcp_client objects
+ * and global_cmcp_reactor object if created. */
 void vsp_test_cmcp_connection_teardown(void);
 
 /** Test vsp_cmcp_server_create() and vsp_cmcp_server_free(). */
@@ -90,6 +249,50 @@ MU_TEST(vsp_test_cmcp_client_invalid_parameters);
  * vsp_cmcp_client. */
 MU_TEST(vsp_test_cmcp_communication_test);
 
+/** Test processing client messages and disconnection from the server
+ * receive queue in the test thread. */
+MU_TEST(vsp_test_cmcp_receive_queue_test);
+
+/** Test processing server messages from the client receive queue in the test
+ * thread. */
+MU_TEST(vsp_test_cmcp_client_receive_queue_test);
+
+/** Test sending server messages from several threads at once. */
+MU_TEST(vsp_test_cmcp_concurrent_send_test);
+
+/** Test joining a multicast group and sending server messages to it. */
+MU_TEST(vsp_test_cmcp_group_test);
+
+/** Wait until the number of clients in the tested multicast group equals
+ * group_size. Returns non-zero if waiting timed out. */
+static int vsp_test_cmcp_await_group_size(int group_size);
+
+/** Test sending the same pre-encoded packet to the client several times. */
+MU_TEST(vsp_test_cmcp_packet_test);
+
+/** Test reading data list items of single and batched messages after the
+ * client message callback function returned. */
+MU_TEST(vsp_test_cmcp_buffer_test);
+
+/** Test looking up and sending to many clients after deregistering some of
+ * them in scattered order. */
+MU_TEST(vsp_test_cmcp_peer_table_test);
+
+/** Test registering and deregistering clients while several threads send
+ * server messages. */
+MU_TEST(vsp_test_cmcp_churn_test);
+
+/** Test streaming chunks from the server to the client. */
+MU_TEST(vsp_test_cmcp_server_stream_test);
+
+/** Test failing a blocked server stream when its client disconnects and
+ * streaming to a newly connected client afterwards. */
+MU_TEST(vsp_test_cmcp_stream_reconnect_test);
+
+/** Test freeing a client from a server callback function invoked by the
+ * reactor thread driving both of them. */
+MU_TEST(vsp_test_cmcp_reactor_callback_test);
+
 int vsp_test_cmcp_announcement_cb(void *callback_param, uint16_t client_id)
 {
     /* check if callback parameter equals global server object */
@@ -124,6 +327,174 @@ void vsp_test_cmcp_disconnect_cb(void *callback_param, uint16_t client_id)
     vsp_cmcp_state_set(global_test_state, VSP_TEST_CMCP_DISCONNECTED);
 }
 
+int vsp_test_cmcp_peer_announcement_cb(void *callback_param,
+    uint16_t client_id)
+{
+    /* check if callback parameter equals global server object */
+    mu_assert_abort(callback_param == global_cmcp_server,
+        vsp_error_str(EINVAL));
+    (void) client_id;
+
+    /* the server reception thread is the only one counting */
+    mu_assert_abort(global_peer_count < VSP_TEST_PEER_CLIENT_COUNT,
+        vsp_error_str(EINVAL));
+    ++global_peer_count;
+    /* accept new client */
+    return 0;
+}
+
+void vsp_test_cmcp_peer_report_cb(void *callback_param, uint16_t client_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
+{
+    int ret;
+    uint32_t index;
+
+    /* check if callback parameter equals global server object */
+    mu_assert_abort(callback_param == global_cmcp_server,
+        vsp_error_str(EINVAL));
+    /* check if command ID is valid */
+    mu_assert_abort(command_id == VSP_TEST_MESSAGE_COMMAND_ID,
+        vsp_error_str(EINVAL));
+    /* get index of the reporting client */
+    ret = vsp_cmcp_datalist_get_u32(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        1, &index);
+    mu_assert_abort(ret == 0 && index < VSP_TEST_PEER_CLIENT_COUNT,
+        vsp_error_str(EINVAL));
+
+    /* store client ID; the server reception thread is the only one counting */
+    global_peer_client_ids[index] = client_id;
+    ++global_peer_reported_count;
+    if (global_peer_reported_count == VSP_TEST_PEER_CLIENT_COUNT) {
+        /* update test state */
+        vsp_cmcp_state_set(global_test_state,
+            VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED);
+    }
+}
+
+void vsp_test_cmcp_peer_disconnect_cb(void *callback_param,
+    uint16_t client_id)
+{
+    /* check if callback parameter equals global server object */
+    mu_assert_abort(callback_param == global_cmcp_server,
+        vsp_error_str(EINVAL));
+    (void) client_id;
+
+    /* the server reception thread is the only one counting */
+    --global_peer_count;
+    if (global_peer_count == VSP_TEST_PEER_CLIENT_COUNT / 3) {
+        /* update test state */
+        vsp_cmcp_state_set(global_test_state, VSP_TEST_CMCP_DISCONNECTED);
+    }
+}
+
+void vsp_test_cmcp_peer_message_cb(void *callback_param, uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist)
+{
+    /* check if command ID and data list are valid */
+    mu_assert_abort(command_id == VSP_TEST_MESSAGE_COMMAND_ID
+        && cmcp_datalist != NULL, vsp_error_str(EINVAL));
+
+    /* store receiving client */
+    global_peer_receiver = callback_param;
+    /* update test state */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED);
+}
+
+void *vsp_test_cmcp_peer_connect_run(void *param)
+{
+    int ret;
+
+    /* connect while other threads do the same */
+    ret = vsp_cmcp_client_connect((vsp_cmcp_client*) param,
+        VSP_TEST_SERVER_SUBSCRIBE_ADDRESS, VSP_TEST_SERVER_PUBLISH_ADDRESS);
+    VSP_CHECK(ret == 0, return (void*) -1);
+    return NULL;
+}
+
+void vsp_test_cmcp_reactor_free_cb(void *callback_param, uint16_t client_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
+{
+    /* check if callback parameter equals global server object */
+    mu_assert_abort(callback_param == global_cmcp_server,
+        vsp_error_str(EINVAL));
+    /* check if message was sent by the connected client */
+    mu_assert_abort(client_id == global_cmcp_client_id
+        && command_id == VSP_TEST_MESSAGE_COMMAND_ID, vsp_error_str(EINVAL));
+    (void) cmcp_datalist;
+
+    /* detaching the client from this thread must not wait for the thread */
+    vsp_cmcp_client_free(global_peer_clients[0]);
+    global_peer_clients[0] = NULL;
+    /* update test state */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED);
+}
+
+void vsp_test_cmcp_churn_report_cb(void *callback_param, uint16_t client_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
+{
+    int ret;
+    uint32_t index;
+
+    /* check if callback parameter equals global server object */
+    mu_assert_abort(callback_param == global_cmcp_server,
+        vsp_error_str(EINVAL));
+    /* check if command ID is valid */
+    mu_assert_abort(command_id == VSP_TEST_MESSAGE_COMMAND_ID,
+        vsp_error_str(EINVAL));
+    /* get index of the reporting client */
+    ret = vsp_cmcp_datalist_get_u32(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        1, &index);
+    mu_assert_abort(ret == 0 && index < VSP_TEST_CHURN_CLIENT_COUNT,
+        vsp_error_str(EINVAL));
+
+    /* let sending threads address the client */
+    __atomic_store_n(&global_peer_client_ids[index], client_id,
+        __ATOMIC_RELAXED);
+}
+
+void *vsp_test_cmcp_churn_sender_run(void *param)
+{
+    vsp_cmcp_datalist *cmcp_datalist;
+    uint16_t client_id;
+    int index;
+    int ret;
+
+    (void) param;
+
+    /* create data list used by this thread only */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    VSP_CHECK(cmcp_datalist != NULL, return (void*) -1);
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    VSP_CHECK(ret == 0, vsp_cmcp_datalist_free(cmcp_datalist);
+        return (void*) -1);
+
+    /* look up clients while the reception thread changes the peer table */
+    while (ret == 0
+        && __atomic_load_n(&global_churn_running, __ATOMIC_RELAXED) != 0) {
+        for (index = 0; index < VSP_TEST_CHURN_CLIENT_COUNT; ++index) {
+            client_id = __atomic_load_n(&global_peer_client_ids[index],
+                __ATOMIC_RELAXED);
+            if (client_id != 0) {
+                /* client may be deregistered meanwhile; failures are
+                 * expected */
+                vsp_cmcp_server_send(global_cmcp_server, client_id,
+                    VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
+            }
+        }
+        /* the connected client has to be found all the time */
+        ret = vsp_cmcp_server_send(global_cmcp_server, global_cmcp_client_id,
+            VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
+    }
+
+    /* clean up */
+    vsp_cmcp_datalist_free(cmcp_datalist);
+    VSP_CHECK(ret == 0, return (void*) -1);
+    return NULL;
+}
+
 void vsp_test_cmcp_server_message_cb(void *callback_param, uint16_t client_id,
     uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
 {
@@ -174,6 +545,10 @@ void vsp_test_cmcp_client_message_cb(void *callback_param, uint16_t command_id,
     mu_assert_abort(data_item_pointer != NULL, vsp_error_str(vsp_error_num()));
     mu_assert(memcmp(data_item_pointer, VSP_TEST_DATALIST_ITEM1_DATA,
         VSP_TEST_DATALIST_ITEM1_LENGTH) == 0, vsp_error_str(EINVAL));
+    /* get large data list item */
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist,
+        VSP_TEST_DATALIST_LARGE_ITEM_ID, VSP_TEST_DATALIST_LARGE_ITEM_LENGTH);
+    mu_assert(data_item_pointer != NULL, vsp_error_str(vsp_error_num()));
 
     /* check if test state is correct */
     mu_assert_abort(vsp_cmcp_state_get(global_test_state)
@@ -182,6 +557,223 @@ void vsp_test_cmcp_client_message_cb(void *callback_param, uint16_t command_id,
     vsp_cmcp_state_set(global_test_state, VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED);
 }
 
+void vsp_test_cmcp_client_count_cb(void *callback_param, uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist)
+{
+    /* check if callback parameter equals global client object */
+    mu_assert_abort(callback_param == global_cmcp_client,
+        vsp_error_str(EINVAL));
+    /* check if command ID and data list are valid */
+    mu_assert_abort(command_id == VSP_TEST_MESSAGE_COMMAND_ID
+        && cmcp_datalist != NULL, vsp_error_str(EINVAL));
+
+    /* the client reception thread is the only one counting */
+    ++global_received_message_count;
+    if (global_received_message_count == VSP_TEST_CMCP_SENT_MESSAGE_COUNT) {
+        /* update test state */
+        vsp_cmcp_state_set(global_test_state,
+            VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED);
+    }
+}
+
+void vsp_test_cmcp_client_take_cb(void *callback_param, uint16_t command_id,
+    vsp_cmcp_datalist *cmcp_datalist)
+{
+    int index;
+
+    /* check if callback parameter equals global client object */
+    mu_assert_abort(callback_param == global_cmcp_client,
+        vsp_error_str(EINVAL));
+    /* check if command ID and data list are valid */
+    mu_assert_abort(command_id == VSP_TEST_MESSAGE_COMMAND_ID
+        && cmcp_datalist != NULL, vsp_error_str(EINVAL));
+
+    /* keep item pointer and the buffer it points into */
+    index = global_received_message_count;
+    mu_assert_abort(index < 2 * VSP_TEST_BUFFER_MESSAGE_COUNT,
+        vsp_error_str(EINVAL));
+    global_taken_items[index] = vsp_cmcp_datalist_get_data_item(cmcp_datalist,
+        VSP_TEST_DATALIST_ITEM1_ID, VSP_TEST_DATALIST_ITEM1_LENGTH);
+    mu_assert_abort(global_taken_items[index] != NULL,
+        vsp_error_str(vsp_error_num()));
+    global_taken_buffers[index] = vsp_cmcp_datalist_take_buffer(cmcp_datalist);
+    mu_assert_abort(global_taken_buffers[index] != NULL,
+        vsp_error_str(vsp_error_num()));
+
+    /* the client reception thread is the only one counting */
+    ++global_received_message_count;
+    if (global_received_message_count == 2 * VSP_TEST_BUFFER_MESSAGE_COUNT) {
+        /* update test state */
+        vsp_cmcp_state_set(global_test_state,
+            VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED);
+    }
+}
+
+void *vsp_test_cmcp_sender_run(void *param)
+{
+    vsp_cmcp_datalist *cmcp_datalist;
+    int index;
+    int ret;
+
+    (void) param;
+
+    /* create data list used by this thread only */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    VSP_CHECK(cmcp_datalist != NULL, return (void*) -1);
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    VSP_CHECK(ret == 0, vsp_cmcp_datalist_free(cmcp_datalist);
+        return (void*) -1);
+
+    /* send server messages while other threads do the same */
+    for (index = 0; index < VSP_TEST_SENDER_MESSAGE_COUNT && ret == 0;
+        ++index) {
+        ret = vsp_cmcp_server_send(global_cmcp_server, global_cmcp_client_id,
+            VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
+    }
+
+    /* clean up */
+    vsp_cmcp_datalist_free(cmcp_datalist);
+    VSP_CHECK(ret == 0, return (void*) -1);
+    return NULL;
+}
+
+void *vsp_test_cmcp_stream_pusher_run(void *param)
+{
+    uint32_t chunk_index;
+    int ret;
+
+    (void) param;
+
+    /* push until the client stops returning credit and disconnects */
+    chunk_index = 0;
+    do {
+        ret = vsp_cmcp_server_stream_push(global_cmcp_server,
+            global_cmcp_client_id, VSP_TEST_STREAM_ID, sizeof(chunk_index),
+            &chunk_index);
+        ++chunk_index;
+    } while (ret == 0);
+    return NULL;
+}
+
+void vsp_test_cmcp_trace_cb(void *callback_param,
+    const vsp_cmcp_trace *cmcp_trace)
+{
+    /* check if trace data is valid; both peers use the same clock */
+    mu_assert_abort(cmcp_trace != NULL
+        && cmcp_trace->send_time <= cmcp_trace->receive_time,
+        vsp_error_str(EINVAL));
+
+    if (callback_param == global_cmcp_server) {
+        /* client sends to its own topic from a single thread, so sequence
+         * numbers arrive in order */
+        mu_assert_abort(cmcp_trace->sender_id == global_cmcp_client_id
+            && cmcp_trace->topic_id == global_cmcp_client_id,
+            vsp_error_str(EINVAL));
+        mu_assert(cmcp_trace->sequence == global_server_trace_count,
+            vsp_error_str(EINVAL));
+        ++global_server_trace_count;
+    } else {
+        /* server messages may be sent by several threads at once */
+        mu_assert_abort(callback_param == global_cmcp_client
+            && (cmcp_trace->topic_id == global_cmcp_client_id
+            || cmcp_trace->topic_id
+            == VSP_CMCP_GROUP_TOPIC_ID + VSP_TEST_GROUP_ID),
+            vsp_error_str(EINVAL));
+        ++global_client_trace_count;
+    }
+}
+
+void vsp_test_cmcp_gap_cb(void *callback_param, uint16_t sender_id,
+    uint16_t topic_id, uint32_t expected_sequence, uint32_t lost_count)
+{
+    /* gaps are only expected in server messages sent by several threads */
+    mu_assert_abort(callback_param == global_cmcp_client
+        && topic_id == global_cmcp_client_id && lost_count > 0,
+        vsp_error_str(EINVAL));
+    (void) sender_id;
+    (void) expected_sequence;
+    global_client_lost_count += lost_count;
+}
+
+void vsp_test_cmcp_server_stream_cb(void *callback_param, uint16_t client_id,
+    uint16_t stream_id, uint32_t chunk_length, void *chunk_data)
+{
+    /* check if callback parameter equals global server object */
+    mu_assert_abort(callback_param == global_cmcp_server,
+        vsp_error_str(EINVAL));
+    /* check if client ID and stream ID are valid */
+    mu_assert_abort(client_id == global_cmcp_client_id, vsp_error_str(EINVAL));
+    mu_assert_abort(stream_id == VSP_TEST_STREAM_ID, vsp_error_str(EINVAL));
+    /* check and count chunk */
+    vsp_test_cmcp_check_stream_chunk(chunk_length, chunk_data);
+}
+
+void vsp_test_cmcp_client_stream_cb(void *callback_param, uint16_t stream_id,
+    uint32_t chunk_length, void *chunk_data)
+{
+    /* check if callback parameter equals global client object */
+    mu_assert_abort(callback_param == global_cmcp_client,
+        vsp_error_str(EINVAL));
+    /* check if stream ID is valid */
+    mu_assert_abort(stream_id == VSP_TEST_STREAM_ID, vsp_error_str(EINVAL));
+    /* check and count chunk */
+    vsp_test_cmcp_check_stream_chunk(chunk_length, chunk_data);
+}
+
+void vsp_test_cmcp_client_stall_cb(void *callback_param, uint16_t stream_id,
+    uint32_t chunk_length, void *chunk_data)
+{
+    int ret;
+    struct timespec time_test_timeout;
+
+    (void) callback_param;
+    (void) stream_id;
+    (void) chunk_length;
+    (void) chunk_data;
+
+    /* only stall on the first chunk */
+    VSP_CHECK(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, return);
+    /* let the test thread know that no credit is returned anymore */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED);
+
+    /* start measuring time for test timeout */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(global_test_state);
+    /* wait until the test thread disconnects the client */
+    ret = vsp_cmcp_state_await_state(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED, &time_test_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(global_test_state);
+    /* check if test was successful */
+    mu_assert(ret == 0, vsp_error_str(ETIMEDOUT));
+}
+
+void vsp_test_cmcp_check_stream_chunk(uint32_t chunk_length,
+    void *chunk_data)
+{
+    /* check if stream is still open */
+    mu_assert_abort(global_stream_closed == 0, vsp_error_str(EINVAL));
+
+    if (chunk_data == NULL) {
+        /* end of stream received */
+        mu_assert(chunk_length == 0, vsp_error_str(EINVAL));
+        global_stream_closed = 1;
+    } else {
+        /* check if chunks are received in order */
+        mu_assert_abort(chunk_length == sizeof(uint32_t),
+            vsp_error_str(EINVAL));
+        mu_assert(*((uint32_t*) chunk_data) == global_stream_chunk_count,
+            vsp_error_str(EINVAL));
+        ++global_stream_chunk_count;
+    }
+}
+
 void vsp_test_cmcp_connection_setup(void)
 {
     /* initialize test state to NULL */
@@ -205,6 +797,28 @@ void vsp_test_cmcp_communication_setup(void)
     global_test_state = vsp_cmcp_state_create(VSP_TEST_CMCP_NOT_CONNECTED);
     mu_assert_abort(global_test_state != NULL, vsp_error_str(vsp_error_num()));
 
+    /* let reactor threads receive messages if reactor is created */
+    if (global_cmcp_reactor != NULL) {
+        ret = vsp_cmcp_server_set_reactor(global_cmcp_server,
+            global_cmcp_reactor);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+        ret = vsp_cmcp_client_set_reactor(global_cmcp_client,
+            global_cmcp_reactor);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    }
+
+    /* let worker threads handle server messages if requested */
+    ret = vsp_cmcp_server_set_worker_count(global_cmcp_server,
+        global_cmcp_worker_count, VSP_TEST_WORKER_QUEUE_CAPACITY);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    /* hand server and client messages over to the test thread if requested */
+    ret = vsp_cmcp_server_set_receive_queue(global_cmcp_server,
+        global_cmcp_receive_queue_capacity);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_client_set_receive_queue(global_cmcp_client,
+        global_cmcp_receive_queue_capacity);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+
     /* register server callback parameter */
     vsp_cmcp_server_set_callback_param(global_cmcp_server, global_cmcp_server);
     /* register server callback functions */
@@ -214,12 +828,25 @@ void vsp_test_cmcp_communication_setup(void)
         vsp_test_cmcp_disconnect_cb);
     vsp_cmcp_server_set_message_cb(global_cmcp_server,
         vsp_test_cmcp_server_message_cb);
+    vsp_cmcp_server_set_stream_cb(global_cmcp_server,
+        vsp_test_cmcp_server_stream_cb);
+    vsp_cmcp_server_set_trace_cb(global_cmcp_server, vsp_test_cmcp_trace_cb);
+    /* no stream chunks and traced messages received yet */
+    global_stream_chunk_count = 0;
+    global_stream_closed = 0;
+    global_server_trace_count = 0;
+    global_client_trace_count = 0;
+    global_client_lost_count = 0;
 
     /* register client callback parameter */
     vsp_cmcp_client_set_callback_param(global_cmcp_client, global_cmcp_client);
     /* register client callback functions */
     vsp_cmcp_client_set_message_cb(global_cmcp_client,
         vsp_test_cmcp_client_message_cb);
+    vsp_cmcp_client_set_stream_cb(global_cmcp_client,
+        vsp_test_cmcp_client_stream_cb);
+    vsp_cmcp_client_set_trace_cb(global_cmcp_client, vsp_test_cmcp_trace_cb);
+    vsp_cmcp_client_set_gap_cb(global_cmcp_client, vsp_test_cmcp_gap_cb);
 
     /* bind server */
     ret = vsp_cmcp_server_bind(global_cmcp_server,
@@ -231,6 +858,43 @@ void vsp_test_cmcp_communication_setup(void)
     mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
 }
 
+void vsp_test_cmcp_reactor_setup(void)
+{
+    /* create reactor shared by server and client */
+    global_cmcp_reactor =
+        vsp_cmcp_reactor_create(VSP_TEST_REACTOR_THREAD_COUNT);
+    mu_assert_abort(global_cmcp_reactor != NULL,
+        vsp_error_str(vsp_error_num()));
+    mu_assert_abort(vsp_cmcp_reactor_get_thread_count(global_cmcp_reactor)
+        == VSP_TEST_REACTOR_THREAD_COUNT, vsp_error_str(EINVAL));
+
+    /* create and connect server and client */
+    vsp_test_cmcp_communication_setup();
+}
+
+void vsp_test_cmcp_worker_setup(void)
+{
+    /* handle server messages in worker threads */
+    global_cmcp_worker_count = VSP_TEST_WORKER_COUNT;
+
+    /* create and connect server and client */
+    vsp_test_cmcp_communication_setup();
+
+    /* worker threads cannot be changed after binding */
+    mu_assert_abort(vsp_cmcp_server_set_worker_count(global_cmcp_server, 1,
+        VSP_TEST_WORKER_QUEUE_CAPACITY) != 0,
+        VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+}
+
+void vsp_test_cmcp_receive_queue_setup(void)
+{
+    /* hand server and client messages over to the test thread */
+    global_cmcp_receive_queue_capacity = VSP_TEST_RECEIVE_QUEUE_CAPACITY;
+
+    /* create and connect server and client */
+    vsp_test_cmcp_communication_setup();
+}
+
 void vsp_test_cmcp_connection_teardown(void)
 {
     /* free client */
@@ -248,6 +912,14 @@ void vsp_test_cmcp_connection_teardown(void)
         vsp_cmcp_state_free(global_test_state);
         global_test_state = NULL;
     }
+    /* free reactor after all of its nodes */
+    if (global_cmcp_reactor != NULL) {
+        vsp_cmcp_reactor_free(global_cmcp_reactor);
+        global_cmcp_reactor = NULL;
+    }
+    /* invoke message callback function from reception thread again */
+    global_cmcp_worker_count = 0;
+    global_cmcp_receive_queue_capacity = 0;
 }
 
 MU_TEST(vsp_test_cmcp_server_allocation)
@@ -275,22 +947,114 @@ MU_TEST(vsp_test_cmcp_client_allocation)
 MU_TEST(vsp_test_cmcp_server_invalid_parameters)
 {
     int ret;
+    uint16_t command_id = VSP_TEST_MESSAGE_COMMAND_ID;
+    vsp_cmcp_datalist *cmcp_datalist = NULL;
+    vsp_cmcp_stats cmcp_stats;
+    vsp_cmcp_latency cmcp_latency;
 
     /* invalid server deallocation */
     vsp_cmcp_server_free(NULL);
 
-    /* invalid server bind: server object NULL */
-    ret = vsp_cmcp_server_bind(NULL,
-        VSP_TEST_SERVER_PUBLISH_ADDRESS, VSP_TEST_SERVER_SUBSCRIBE_ADDRESS);
+    /* invalid receive batch size */
+    ret = vsp_cmcp_server_set_receive_batch_size(NULL, 1);
     mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
-
-    /* invalid server bind: address NULL */
-    ret = vsp_cmcp_server_bind(global_cmcp_server,
-        NULL, VSP_TEST_SERVER_SUBSCRIBE_ADDRESS);
+    ret = vsp_cmcp_server_set_receive_batch_size(global_cmcp_server, 0);
     mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
 
-    ret = vsp_cmcp_server_bind(global_cmcp_server,
-        VSP_TEST_SERVER_PUBLISH_ADDRESS, NULL);
+    /* invalid maximum client count */
+    ret = vsp_cmcp_server_set_max_clients(NULL, 1);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_set_max_clients(global_cmcp_server, 0);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid worker thread count */
+    ret = vsp_cmcp_server_set_worker_count(NULL, 1,
+        VSP_TEST_WORKER_QUEUE_CAPACITY);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_set_worker_count(global_cmcp_server, -1,
+        VSP_TEST_WORKER_QUEUE_CAPACITY);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    /* invalid worker queue: no capacity or no worker threads used */
+    ret = vsp_cmcp_server_set_worker_count(global_cmcp_server, 1, 0);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_get_worker_queue_stats(global_cmcp_server, NULL,
+        NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid receive queue: negative capacity or no queue used */
+    ret = vsp_cmcp_server_set_receive_queue(global_cmcp_server, -1);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_get_receive_fd(global_cmcp_server);
+    mu_assert(ret < 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_process_messages(global_cmcp_server, 1);
+    mu_assert(ret < 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_get_receive_queue_stats(global_cmcp_server, NULL,
+        NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid statistics: server object or stats struct NULL */
+    ret = vsp_cmcp_server_get_stats(NULL, &cmcp_stats);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_get_stats(global_cmcp_server, NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid latency: server object or latency struct NULL, unknown type */
+    ret = vsp_cmcp_server_get_latency(NULL, VSP_CMCP_LATENCY_SEND,
+        &cmcp_latency);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_get_latency(global_cmcp_server,
+        VSP_CMCP_LATENCY_SEND, NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_get_latency(global_cmcp_server,
+        (vsp_cmcp_latency_type) -1, &cmcp_latency);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid reactor */
+    ret = vsp_cmcp_server_set_reactor(NULL, NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    vsp_cmcp_reactor_free(NULL);
+    ret = vsp_cmcp_reactor_get_thread_count(NULL);
+    mu_assert(ret < 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid server batch send: server object NULL, empty or unknown client */
+    ret = vsp_cmcp_server_send_batch(NULL, 1, 1, &command_id, &cmcp_datalist);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_send_batch(global_cmcp_server, 1, 0, &command_id,
+        &cmcp_datalist);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_send_batch(global_cmcp_server, 1, 1, NULL,
+        &cmcp_datalist);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_send_batch(global_cmcp_server, 1, 1, &command_id,
+        &cmcp_datalist);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid server stream usage: server object NULL, unknown client */
+    ret = vsp_cmcp_server_stream_open(NULL, 1, VSP_TEST_STREAM_ID);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_stream_open(global_cmcp_server, 1,
+        VSP_TEST_STREAM_ID);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_stream_push(global_cmcp_server, 1,
+        VSP_TEST_STREAM_ID, VSP_TEST_DATALIST_ITEM1_LENGTH,
+        VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_stream_close(global_cmcp_server, 1,
+        VSP_TEST_STREAM_ID);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid server bind: server object NULL */
+    ret = vsp_cmcp_server_bind(NULL,
+        VSP_TEST_SERVER_PUBLISH_ADDRESS, VSP_TEST_SERVER_SUBSCRIBE_ADDRESS);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid server bind: address NULL */
+    ret = vsp_cmcp_server_bind(global_cmcp_server,
+        NULL, VSP_TEST_SERVER_SUBSCRIBE_ADDRESS);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    ret = vsp_cmcp_server_bind(global_cmcp_server,
+        VSP_TEST_SERVER_PUBLISH_ADDRESS, NULL);
     mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
 
     /* invalid server bind: address empty */
@@ -306,10 +1070,75 @@ MU_TEST(vsp_test_cmcp_server_invalid_parameters)
 MU_TEST(vsp_test_cmcp_client_invalid_parameters)
 {
     int ret;
+    uint16_t command_id = VSP_TEST_MESSAGE_COMMAND_ID;
+    vsp_cmcp_datalist *cmcp_datalist = NULL;
+    vsp_cmcp_stats cmcp_stats;
+    vsp_cmcp_latency cmcp_latency;
 
     /* invalid client deallocation */
     vsp_cmcp_client_free(NULL);
 
+    /* invalid receive batch size */
+    ret = vsp_cmcp_client_set_receive_batch_size(NULL, 1);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_set_receive_batch_size(global_cmcp_client, 0);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid reactor */
+    ret = vsp_cmcp_client_set_reactor(NULL, NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid receive queue: negative capacity or no queue used */
+    ret = vsp_cmcp_client_set_receive_queue(global_cmcp_client, -1);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_get_receive_fd(global_cmcp_client);
+    mu_assert(ret < 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_process_messages(global_cmcp_client, 1);
+    mu_assert(ret < 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_get_receive_queue_stats(global_cmcp_client, NULL,
+        NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid client batch send: client object NULL, empty or not connected */
+    ret = vsp_cmcp_client_send_batch(NULL, 1, &command_id, &cmcp_datalist);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_send_batch(global_cmcp_client, 0, &command_id,
+        &cmcp_datalist);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_send_batch(global_cmcp_client, 1, &command_id, NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_send_batch(global_cmcp_client, 1, &command_id,
+        &cmcp_datalist);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid statistics: client object or stats struct NULL */
+    ret = vsp_cmcp_client_get_stats(NULL, &cmcp_stats);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_get_stats(global_cmcp_client, NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid latency: client object or latency struct NULL, unknown type */
+    ret = vsp_cmcp_client_get_latency(NULL, VSP_CMCP_LATENCY_CALLBACK,
+        &cmcp_latency);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_get_latency(global_cmcp_client,
+        VSP_CMCP_LATENCY_CALLBACK, NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_get_latency(global_cmcp_client,
+        (vsp_cmcp_latency_type) -1, &cmcp_latency);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* invalid client stream usage: client object NULL or not connected */
+    ret = vsp_cmcp_client_stream_open(NULL, VSP_TEST_STREAM_ID);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_stream_open(global_cmcp_client, VSP_TEST_STREAM_ID);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_stream_push(global_cmcp_client, VSP_TEST_STREAM_ID,
+        0, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_client_stream_close(global_cmcp_client, VSP_TEST_STREAM_ID);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
     /* invalid client connect: client object NULL */
     ret = vsp_cmcp_client_connect(NULL,
         VSP_TEST_SERVER_SUBSCRIBE_ADDRESS, VSP_TEST_SERVER_PUBLISH_ADDRESS);
@@ -338,7 +1167,11 @@ MU_TEST(vsp_test_cmcp_communication_test)
 {
     int ret;
     vsp_cmcp_datalist *cmcp_datalist;
+    uint8_t *large_item_data;
+    uint32_t chunk_index;
     struct timespec time_test_timeout;
+    vsp_cmcp_stats cmcp_stats;
+    vsp_cmcp_latency cmcp_latency;
 
     /* check if test state is correct */
     mu_assert_abort(vsp_cmcp_state_get(global_test_state)
@@ -351,12 +1184,20 @@ MU_TEST(vsp_test_cmcp_communication_test)
     ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
         VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
     mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    /* add a large data list item, supported by both peers */
+    large_item_data = calloc(1, VSP_TEST_DATALIST_LARGE_ITEM_LENGTH);
+    mu_assert_abort(large_item_data != NULL, vsp_error_str(ENOMEM));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist,
+        VSP_TEST_DATALIST_LARGE_ITEM_ID, VSP_TEST_DATALIST_LARGE_ITEM_LENGTH,
+        large_item_data);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
     /* send server message */
     ret = vsp_cmcp_server_send(global_cmcp_server, global_cmcp_client_id,
         VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
     mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
     /* free data list */
     vsp_cmcp_datalist_free(cmcp_datalist);
+    VSP_FREE(large_item_data);
 
     /* start measuring time for test timeout */
     vsp_time_real_timespec_from_now(&time_test_timeout,
@@ -372,6 +1213,46 @@ MU_TEST(vsp_test_cmcp_communication_test)
     /* check if test was successful */
     mu_assert(ret == 0, vsp_error_str(ETIMEDOUT));
 
+    /* client received at least the acknowledge and the large server message */
+    ret = vsp_cmcp_client_get_stats(global_cmcp_client, &cmcp_stats);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(cmcp_stats.messages_received >= 2
+        && cmcp_stats.bytes_received > VSP_TEST_DATALIST_LARGE_ITEM_LENGTH
+        && cmcp_stats.messages_sent >= 1 && cmcp_stats.parse_failures == 0
+        && cmcp_stats.filtered_messages == 0 && cmcp_stats.nacks == 0
+        && cmcp_stats.timeouts == 0, vsp_error_str(EINVAL));
+    /* every received message was handled in the callback function */
+    ret = vsp_cmcp_client_get_latency(global_cmcp_client,
+        VSP_CMCP_LATENCY_CALLBACK, &cmcp_latency);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(cmcp_latency.count >= 2 && cmcp_latency.p50 <= cmcp_latency.p99
+        && cmcp_latency.p99 <= cmcp_latency.max, vsp_error_str(EINVAL));
+    /* only the server data message was traced, as requested by the client */
+    mu_assert(cmcp_stats.traced_messages == 1 && global_client_trace_count == 1,
+        vsp_error_str(EINVAL));
+    mu_assert(cmcp_stats.sequence_gaps == 0 && cmcp_stats.lost_messages == 0
+        && global_client_lost_count == 0, vsp_error_str(EINVAL));
+    ret = vsp_cmcp_client_get_latency(global_cmcp_client,
+        VSP_CMCP_LATENCY_TRANSIT, &cmcp_latency);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(cmcp_latency.count == 1, vsp_error_str(EINVAL));
+
+    /* stream more chunks to server than fit into the flow control window */
+    ret = vsp_cmcp_client_stream_open(global_cmcp_client, VSP_TEST_STREAM_ID);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    for (chunk_index = 0; chunk_index < VSP_TEST_STREAM_CHUNK_COUNT;
+        ++chunk_index) {
+        ret = vsp_cmcp_client_stream_push(global_cmcp_client,
+            VSP_TEST_STREAM_ID, sizeof(chunk_index), &chunk_index);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    }
+    /* close stream; returns after the server processed all chunks */
+    ret = vsp_cmcp_client_stream_close(global_cmcp_client,
+        VSP_TEST_STREAM_ID);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(global_stream_chunk_count == VSP_TEST_STREAM_CHUNK_COUNT
+        && global_stream_closed != 0, vsp_error_str(EINVAL));
+
     /* create data list */
     cmcp_datalist = vsp_cmcp_datalist_create();
     mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
@@ -403,19 +1284,913 @@ MU_TEST(vsp_test_cmcp_communication_test)
     vsp_cmcp_state_unlock(global_test_state);
     /* check if test was successful */
     mu_assert(ret == 0, vsp_error_str(ETIMEDOUT));
+
+    /* server sent at least the acknowledge and the large server message and
+     * received the announcement, stream chunks and the client message */
+    ret = vsp_cmcp_server_get_stats(global_cmcp_server, &cmcp_stats);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(cmcp_stats.messages_sent >= 2
+        && cmcp_stats.bytes_sent > VSP_TEST_DATALIST_LARGE_ITEM_LENGTH
+        && cmcp_stats.messages_received >= VSP_TEST_STREAM_CHUNK_COUNT
+        && cmcp_stats.parse_failures == 0 && cmcp_stats.filtered_messages == 0
+        && cmcp_stats.nacks == 0 && cmcp_stats.timeouts == 0
+        && cmcp_stats.traced_messages == 1 && global_server_trace_count == 1
+        && cmcp_stats.sequence_gaps == 0 && cmcp_stats.late_messages == 0,
+        vsp_error_str(EINVAL));
+    /* every sent message was timed */
+    ret = vsp_cmcp_server_get_latency(global_cmcp_server,
+        VSP_CMCP_LATENCY_SEND, &cmcp_latency);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(cmcp_latency.count >= 2
+        && cmcp_latency.p50 <= cmcp_latency.max, vsp_error_str(EINVAL));
 }
 
-MU_TEST_SUITE(vsp_test_cmcp_connection)
+MU_TEST(vsp_test_cmcp_receive_queue_test)
 {
-    MU_RUN_TEST(vsp_test_cmcp_server_allocation);
-    MU_RUN_TEST(vsp_test_cmcp_client_allocation);
+    int ret;
+    vsp_cmcp_datalist *cmcp_datalist;
+    struct pollfd poll_fd;
+    int queued_count;
+    uint64_t dropped_count;
 
-    MU_SUITE_CONFIGURE(&vsp_test_cmcp_connection_setup,
-        &vsp_test_cmcp_connection_teardown);
-    MU_RUN_TEST(vsp_test_cmcp_server_invalid_parameters);
-    MU_RUN_TEST(vsp_test_cmcp_client_invalid_parameters);
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+    /* skip sending a server message */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED);
 
-    MU_SUITE_CONFIGURE(&vsp_test_cmcp_communication_setup,
-        &vsp_test_cmcp_connection_teardown);
-    MU_RUN_TEST(vsp_test_cmcp_communication_test);
+    /* create data list */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    /* add a data list item */
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM2_ID,
+        VSP_TEST_DATALIST_ITEM2_LENGTH, VSP_TEST_DATALIST_ITEM2_DATA);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    /* send client message */
+    ret = vsp_cmcp_client_send(global_cmcp_client, VSP_TEST_MESSAGE_COMMAND_ID,
+        cmcp_datalist);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    /* free data list */
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* disconnect client by freeing it */
+    vsp_cmcp_client_free(global_cmcp_client);
+    global_cmcp_client = NULL;
+
+    /* process queued message and disconnection in this thread, in order */
+    poll_fd.fd = vsp_cmcp_server_get_receive_fd(global_cmcp_server);
+    poll_fd.events = POLLIN;
+    while (vsp_cmcp_state_get(global_test_state)
+        != VSP_TEST_CMCP_DISCONNECTED) {
+        poll_fd.revents = 0;
+        ret = poll(&poll_fd, 1, VSP_TEST_CMCP_TIMEOUT);
+        mu_assert_abort(ret > 0, vsp_error_str(ETIMEDOUT));
+        ret = vsp_cmcp_server_process_messages(global_cmcp_server,
+            VSP_TEST_RECEIVE_QUEUE_CAPACITY);
+        mu_assert_abort(ret >= 0, vsp_error_str(vsp_error_num()));
+    }
+
+    /* all messages processed, none dropped */
+    ret = vsp_cmcp_server_get_receive_queue_stats(global_cmcp_server,
+        &queued_count, &dropped_count);
+    mu_assert(ret == 0 && queued_count == 0 && dropped_count == 0,
+        vsp_error_str(EINVAL));
+}
+
+MU_TEST(vsp_test_cmcp_client_receive_queue_test)
+{
+    int ret;
+    int index;
+    vsp_cmcp_datalist *cmcp_datalist;
+    struct pollfd poll_fd;
+    int queued_count;
+    uint64_t dropped_count;
+
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* count messages instead of checking a single one */
+    global_received_message_count = 0;
+    vsp_cmcp_client_set_message_cb(global_cmcp_client,
+        vsp_test_cmcp_client_count_cb);
+
+    /* create data list */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* send server messages one by one and process each of them in this
+     * thread, so the receive queue never overflows */
+    poll_fd.fd = vsp_cmcp_client_get_receive_fd(global_cmcp_client);
+    poll_fd.events = POLLIN;
+    for (index = 0; index < VSP_TEST_CMCP_SENT_MESSAGE_COUNT; ++index) {
+        ret = vsp_cmcp_server_send(global_cmcp_server, global_cmcp_client_id,
+            VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+        while (global_received_message_count == index) {
+            poll_fd.revents = 0;
+            ret = poll(&poll_fd, 1, VSP_TEST_CMCP_TIMEOUT);
+            mu_assert_abort(ret > 0, vsp_error_str(ETIMEDOUT));
+            ret = vsp_cmcp_client_process_messages(global_cmcp_client,
+                VSP_TEST_RECEIVE_QUEUE_CAPACITY);
+            mu_assert_abort(ret >= 0, vsp_error_str(vsp_error_num()));
+        }
+    }
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* all messages processed in order, none dropped */
+    mu_assert(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED, vsp_error_str(EINVAL));
+    ret = vsp_cmcp_client_get_receive_queue_stats(global_cmcp_client,
+        &queued_count, &dropped_count);
+    mu_assert(ret == 0 && queued_count == 0 && dropped_count == 0,
+        vsp_error_str(EINVAL));
+}
+
+MU_TEST(vsp_test_cmcp_concurrent_send_test)
+{
+    int ret;
+    int index;
+    pthread_t sender_threads[VSP_TEST_SENDER_THREAD_COUNT];
+    void *sender_result;
+    struct timespec time_test_timeout;
+    vsp_cmcp_stats cmcp_stats;
+
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* count messages instead of checking a single one */
+    global_received_message_count = 0;
+    vsp_cmcp_client_set_message_cb(global_cmcp_client,
+        vsp_test_cmcp_client_count_cb);
+
+    /* send messages from several threads without locking */
+    for (index = 0; index < VSP_TEST_SENDER_THREAD_COUNT; ++index) {
+        ret = pthread_create(&sender_threads[index], NULL,
+            vsp_test_cmcp_sender_run, NULL);
+        mu_assert_abort(ret == 0, vsp_error_str(ret));
+    }
+    for (index = 0; index < VSP_TEST_SENDER_THREAD_COUNT; ++index) {
+        ret = pthread_join(sender_threads[index], &sender_result);
+        mu_assert_abort(ret == 0, vsp_error_str(ret));
+        mu_assert(sender_result == NULL, vsp_error_str(EINVAL));
+    }
+
+    /* start measuring time for test timeout */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(global_test_state);
+    /* wait until all messages received or waiting timed out */
+    ret = vsp_cmcp_state_await_state(global_test_state,
+        VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED, &time_test_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(global_test_state);
+    /* check if test was successful */
+    mu_assert(ret == 0, vsp_error_str(ETIMEDOUT));
+
+    /* all messages arrived; concurrent senders may reorder them, but every
+     * reported gap is filled by a late message */
+    ret = vsp_cmcp_client_get_stats(global_cmcp_client, &cmcp_stats);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(cmcp_stats.lost_messages == cmcp_stats.late_messages
+        && global_client_lost_count == cmcp_stats.late_messages,
+        vsp_error_str(EINVAL));
+
+    /* skip sending a client message */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED);
+}
+
+int vsp_test_cmcp_await_group_size(int group_size)
+{
+    struct timespec time_test_timeout;
+
+    /* the server handles group commands asynchronously, so poll its state */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+    while (vsp_cmcp_server_get_group_size(global_cmcp_server,
+        VSP_TEST_GROUP_ID) != group_size) {
+        if (vsp_time_real_timespec_passed(&time_test_timeout) == 0) {
+            return -1;
+        }
+        poll(NULL, 0, 1);
+    }
+    return 0;
+}
+
+MU_TEST(vsp_test_cmcp_group_test)
+{
+    vsp_cmcp_datalist *cmcp_datalist;
+    vsp_cmcp_stats cmcp_stats;
+    struct timespec time_test_timeout;
+    int index;
+    int ret;
+
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* group IDs are limited */
+    ret = vsp_cmcp_client_join_group(global_cmcp_client, VSP_CMCP_GROUP_COUNT);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_send_group(global_cmcp_server, VSP_CMCP_GROUP_COUNT,
+        VSP_TEST_MESSAGE_COMMAND_ID, NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_get_group_size(global_cmcp_server,
+        VSP_CMCP_GROUP_COUNT);
+    mu_assert(ret == -1, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* count messages instead of checking a single one */
+    global_received_message_count = 0;
+    vsp_cmcp_client_set_message_cb(global_cmcp_client,
+        vsp_test_cmcp_client_count_cb);
+
+    /* join group */
+    mu_assert(vsp_cmcp_server_get_group_size(global_cmcp_server,
+        VSP_TEST_GROUP_ID) == 0, vsp_error_str(EINVAL));
+    ret = vsp_cmcp_client_join_group(global_cmcp_client, VSP_TEST_GROUP_ID);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    ret = vsp_test_cmcp_await_group_size(1);
+    mu_assert_abort(ret == 0, vsp_error_str(ETIMEDOUT));
+
+    /* send messages to the group */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    for (index = 0; index < VSP_TEST_CMCP_SENT_MESSAGE_COUNT; ++index) {
+        ret = vsp_cmcp_server_send_group(global_cmcp_server,
+            VSP_TEST_GROUP_ID, VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    }
+
+    /* start measuring time for test timeout */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(global_test_state);
+    /* wait until all messages received or waiting timed out */
+    ret = vsp_cmcp_state_await_state(global_test_state,
+        VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED, &time_test_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(global_test_state);
+    /* check if test was successful */
+    mu_assert(ret == 0, vsp_error_str(ETIMEDOUT));
+
+    /* group messages were traced in order, as requested by the client */
+    ret = vsp_cmcp_client_get_stats(global_cmcp_client, &cmcp_stats);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(cmcp_stats.traced_messages == VSP_TEST_CMCP_SENT_MESSAGE_COUNT
+        && cmcp_stats.sequence_gaps == 0, vsp_error_str(EINVAL));
+
+    /* leave group; messages to the empty group are not sent */
+    ret = vsp_cmcp_client_leave_group(global_cmcp_client, VSP_TEST_GROUP_ID);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    ret = vsp_test_cmcp_await_group_size(0);
+    mu_assert_abort(ret == 0, vsp_error_str(ETIMEDOUT));
+    ret = vsp_cmcp_server_send_group(global_cmcp_server, VSP_TEST_GROUP_ID,
+        VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* skip sending a client message */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED);
+}
+
+MU_TEST(vsp_test_cmcp_packet_test)
+{
+    vsp_cmcp_datalist *cmcp_datalist;
+    vsp_cmcp_packet *cmcp_packet;
+    vsp_cmcp_stats cmcp_stats;
+    struct timespec time_test_timeout;
+    int index;
+    int ret;
+
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* count messages instead of checking a single one */
+    global_received_message_count = 0;
+    vsp_cmcp_client_set_message_cb(global_cmcp_client,
+        vsp_test_cmcp_client_count_cb);
+
+    /* encode packet once; data list is not needed afterwards */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    cmcp_packet = vsp_cmcp_packet_create(VSP_TEST_MESSAGE_COMMAND_ID,
+        cmcp_datalist);
+    mu_assert_abort(cmcp_packet != NULL, vsp_error_str(vsp_error_num()));
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* invalid parameters */
+    ret = vsp_cmcp_server_send_packet(global_cmcp_server,
+        global_cmcp_client_id, NULL);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_server_send_packet(global_cmcp_server,
+        global_cmcp_client_id + 2, cmcp_packet);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* send packet several times */
+    for (index = 0; index < VSP_TEST_CMCP_SENT_MESSAGE_COUNT; ++index) {
+        ret = vsp_cmcp_server_send_packet(global_cmcp_server,
+            global_cmcp_client_id, cmcp_packet);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    }
+    vsp_cmcp_packet_free(cmcp_packet);
+
+    /* start measuring time for test timeout */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(global_test_state);
+    /* wait until all messages received or waiting timed out */
+    ret = vsp_cmcp_state_await_state(global_test_state,
+        VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED, &time_test_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(global_test_state);
+    /* check if test was successful */
+    mu_assert(ret == 0, vsp_error_str(ETIMEDOUT));
+
+    /* every copy of the packet was traced with its own sequence number */
+    ret = vsp_cmcp_client_get_stats(global_cmcp_client, &cmcp_stats);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(cmcp_stats.traced_messages == VSP_TEST_CMCP_SENT_MESSAGE_COUNT
+        && cmcp_stats.sequence_gaps == 0, vsp_error_str(EINVAL));
+
+    /* skip sending a client message */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED);
+}
+
+MU_TEST(vsp_test_cmcp_buffer_test)
+{
+    vsp_cmcp_datalist *cmcp_datalist;
+    vsp_cmcp_datalist *cmcp_datalists[VSP_TEST_BUFFER_MESSAGE_COUNT];
+    uint16_t command_ids[VSP_TEST_BUFFER_MESSAGE_COUNT];
+    struct timespec time_test_timeout;
+    int index;
+    int ret;
+
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* take over message buffers instead of checking a single message */
+    global_received_message_count = 0;
+    vsp_cmcp_client_set_message_cb(global_cmcp_client,
+        vsp_test_cmcp_client_take_cb);
+
+    /* create data list */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* send single messages, then the same number of messages in one batch
+     * sharing a single buffer */
+    for (index = 0; index < VSP_TEST_BUFFER_MESSAGE_COUNT; ++index) {
+        ret = vsp_cmcp_server_send(global_cmcp_server, global_cmcp_client_id,
+            VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+        command_ids[index] = VSP_TEST_MESSAGE_COMMAND_ID;
+        cmcp_datalists[index] = cmcp_datalist;
+    }
+    ret = vsp_cmcp_server_send_batch(global_cmcp_server, global_cmcp_client_id,
+        VSP_TEST_BUFFER_MESSAGE_COUNT, command_ids, cmcp_datalists);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* start measuring time for test timeout */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(global_test_state);
+    /* wait until all messages received or waiting timed out */
+    ret = vsp_cmcp_state_await_state(global_test_state,
+        VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED, &time_test_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(global_test_state);
+    /* check if test was successful */
+    mu_assert_abort(ret == 0, vsp_error_str(ETIMEDOUT));
+
+    /* items are still valid after the callback function returned; records of
+     * the batch share one buffer, which is freed with its last reference */
+    for (index = 0; index < 2 * VSP_TEST_BUFFER_MESSAGE_COUNT; ++index) {
+        mu_assert(memcmp(global_taken_items[index],
+            VSP_TEST_DATALIST_ITEM1_DATA, VSP_TEST_DATALIST_ITEM1_LENGTH) == 0,
+            vsp_error_str(EINVAL));
+        vsp_cmcp_buffer_free(global_taken_buffers[index]);
+    }
+
+    /* skip sending a client message */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED);
+}
+
+void vsp_test_cmcp_stream_to_client(void)
+{
+    int ret;
+    uint32_t chunk_index;
+
+    /* no stream chunks received yet */
+    global_stream_chunk_count = 0;
+    global_stream_closed = 0;
+
+    /* stream more chunks to client than fit into the flow control window */
+    ret = vsp_cmcp_server_stream_open(global_cmcp_server,
+        global_cmcp_client_id, VSP_TEST_STREAM_ID);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    for (chunk_index = 0; chunk_index < VSP_TEST_STREAM_CHUNK_COUNT;
+        ++chunk_index) {
+        ret = vsp_cmcp_server_stream_push(global_cmcp_server,
+            global_cmcp_client_id, VSP_TEST_STREAM_ID, sizeof(chunk_index),
+            &chunk_index);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    }
+    /* close stream; returns after the client processed all chunks */
+    ret = vsp_cmcp_server_stream_close(global_cmcp_server,
+        global_cmcp_client_id, VSP_TEST_STREAM_ID);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(global_stream_chunk_count == VSP_TEST_STREAM_CHUNK_COUNT
+        && global_stream_closed != 0, vsp_error_str(EINVAL));
+}
+
+MU_TEST(vsp_test_cmcp_peer_table_test)
+{
+    int ret;
+    int index;
+    int step;
+    uint32_t peer_index;
+    pthread_t connect_threads[VSP_TEST_PEER_CLIENT_COUNT];
+    void *connect_result;
+    vsp_cmcp_datalist *cmcp_datalist;
+    struct timespec time_test_timeout;
+
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* accept more clients than fit into the initial peer table */
+    ret = vsp_cmcp_server_set_max_clients(global_cmcp_server,
+        VSP_TEST_PEER_CLIENT_COUNT + 1);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    vsp_cmcp_server_set_announcement_cb(global_cmcp_server,
+        vsp_test_cmcp_peer_announcement_cb);
+    vsp_cmcp_server_set_disconnect_cb(global_cmcp_server,
+        vsp_test_cmcp_peer_disconnect_cb);
+    vsp_cmcp_server_set_message_cb(global_cmcp_server,
+        vsp_test_cmcp_peer_report_cb);
+    vsp_cmcp_server_set_trace_cb(global_cmcp_server, NULL);
+    vsp_cmcp_client_set_message_cb(global_cmcp_client,
+        vsp_test_cmcp_peer_message_cb);
+    global_peer_count = 0;
+    global_peer_reported_count = 0;
+
+    /* connect clients at once, so they are registered in arbitrary order */
+    for (index = 0; index < VSP_TEST_PEER_CLIENT_COUNT; ++index) {
+        global_peer_clients[index] = vsp_cmcp_client_create();
+        mu_assert_abort(global_peer_clients[index] != NULL,
+            vsp_error_str(vsp_error_num()));
+        vsp_cmcp_client_set_callback_param(global_peer_clients[index],
+            global_peer_clients[index]);
+        vsp_cmcp_client_set_message_cb(global_peer_clients[index],
+            vsp_test_cmcp_peer_message_cb);
+        ret = pthread_create(&connect_threads[index], NULL,
+            vsp_test_cmcp_peer_connect_run, global_peer_clients[index]);
+        mu_assert_abort(ret == 0, vsp_error_str(ret));
+    }
+    for (index = 0; index < VSP_TEST_PEER_CLIENT_COUNT; ++index) {
+        ret = pthread_join(connect_threads[index], &connect_result);
+        mu_assert_abort(ret == 0, vsp_error_str(ret));
+        mu_assert_abort(connect_result == NULL, vsp_error_str(ENOTCONN));
+    }
+
+    /* let every client report its index to learn its client ID */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_u32(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        1, &peer_index);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    for (peer_index = 0; peer_index < VSP_TEST_PEER_CLIENT_COUNT;
+        ++peer_index) {
+        ret = vsp_cmcp_client_send(global_peer_clients[peer_index],
+            VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    }
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* start measuring time for test timeout */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(global_test_state);
+    /* wait until all clients reported or waiting timed out */
+    ret = vsp_cmcp_state_await_state(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED, &time_test_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(global_test_state);
+    /* check if test was successful */
+    mu_assert_abort(ret == 0, vsp_error_str(ETIMEDOUT));
+    mu_assert(global_peer_count == VSP_TEST_PEER_CLIENT_COUNT,
+        vsp_error_str(EINVAL));
+
+    /* disconnect two of three clients in scattered order; the step width is
+     * coprime to the number of clients, so every client is visited once */
+    for (step = 0; step < VSP_TEST_PEER_CLIENT_COUNT; ++step) {
+        index = (step * 7) % VSP_TEST_PEER_CLIENT_COUNT;
+        if (index % 3 != 0) {
+            vsp_cmcp_client_free(global_peer_clients[index]);
+            global_peer_clients[index] = NULL;
+        }
+    }
+
+    /* start measuring time for test timeout */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(global_test_state);
+    /* wait until the clients are deregistered or waiting timed out */
+    ret = vsp_cmcp_state_await_state(global_test_state,
+        VSP_TEST_CMCP_DISCONNECTED, &time_test_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(global_test_state);
+    /* check if test was successful */
+    mu_assert_abort(ret == 0, vsp_error_str(ETIMEDOUT));
+
+    /* create data list */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* every remaining client is found and receives its message, sending to
+     * deregistered clients fails */
+    for (index = -1; index < VSP_TEST_PEER_CLIENT_COUNT; ++index) {
+        vsp_cmcp_state_set(global_test_state, VSP_TEST_CMCP_CONNECTED);
+        ret = vsp_cmcp_server_send(global_cmcp_server, index < 0
+            ? global_cmcp_client_id : global_peer_client_ids[index],
+            VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
+        if (index >= 0 && global_peer_clients[index] == NULL) {
+            mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+            continue;
+        }
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+
+        /* start measuring time for test timeout */
+        vsp_time_real_timespec_from_now(&time_test_timeout,
+            VSP_TEST_CMCP_TIMEOUT);
+
+        /* lock state mutex */
+        vsp_cmcp_state_lock(global_test_state);
+        /* wait until the message is received or waiting timed out */
+        ret = vsp_cmcp_state_await_state(global_test_state,
+            VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED, &time_test_timeout);
+        /* unlock state mutex */
+        vsp_cmcp_state_unlock(global_test_state);
+        /* check if test was successful */
+        mu_assert_abort(ret == 0, vsp_error_str(ETIMEDOUT));
+        mu_assert(global_peer_receiver == (index < 0
+            ? global_cmcp_client : global_peer_clients[index]),
+            vsp_error_str(EINVAL));
+    }
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* disconnect remaining clients */
+    for (index = 0; index < VSP_TEST_PEER_CLIENT_COUNT; ++index) {
+        if (global_peer_clients[index] != NULL) {
+            vsp_cmcp_client_free(global_peer_clients[index]);
+            global_peer_clients[index] = NULL;
+        }
+    }
+}
+
+MU_TEST(vsp_test_cmcp_churn_test)
+{
+    int ret;
+    int index;
+    int round;
+    uint32_t peer_index;
+    pthread_t sender_threads[VSP_TEST_SENDER_THREAD_COUNT];
+    pthread_t connect_threads[VSP_TEST_CHURN_CLIENT_COUNT];
+    void *thread_result;
+    vsp_cmcp_datalist *cmcp_datalist;
+
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* accept clients of every round even if earlier ones are still
+     * registered */
+    ret = vsp_cmcp_server_set_max_clients(global_cmcp_server,
+        VSP_TEST_PEER_CLIENT_COUNT + 1);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    vsp_cmcp_server_set_announcement_cb(global_cmcp_server,
+        vsp_test_cmcp_peer_announcement_cb);
+    vsp_cmcp_server_set_disconnect_cb(global_cmcp_server,
+        vsp_test_cmcp_peer_disconnect_cb);
+    vsp_cmcp_server_set_message_cb(global_cmcp_server,
+        vsp_test_cmcp_churn_report_cb);
+    vsp_cmcp_server_set_trace_cb(global_cmcp_server, NULL);
+    vsp_cmcp_client_set_message_cb(global_cmcp_client,
+        vsp_test_cmcp_client_count_cb);
+    vsp_cmcp_client_set_trace_cb(global_cmcp_client, NULL);
+    vsp_cmcp_client_set_gap_cb(global_cmcp_client, NULL);
+    global_received_message_count = 0;
+    global_peer_count = 0;
+    memset(global_peer_client_ids, 0, sizeof(global_peer_client_ids));
+    global_churn_running = 1;
+
+    /* send messages from several threads during all rounds */
+    for (index = 0; index < VSP_TEST_SENDER_THREAD_COUNT; ++index) {
+        ret = pthread_create(&sender_threads[index], NULL,
+            vsp_test_cmcp_churn_sender_run, NULL);
+        mu_assert_abort(ret == 0, vsp_error_str(ret));
+    }
+
+    /* create data list reporting the index of a client */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_u32(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        1, &peer_index);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+
+    for (round = 0; round < VSP_TEST_CHURN_ROUND_COUNT; ++round) {
+        /* register clients at once, growing and changing the peer table */
+        for (index = 0; index < VSP_TEST_CHURN_CLIENT_COUNT; ++index) {
+            global_peer_clients[index] = vsp_cmcp_client_create();
+            mu_assert_abort(global_peer_clients[index] != NULL,
+                vsp_error_str(vsp_error_num()));
+            ret = pthread_create(&connect_threads[index], NULL,
+                vsp_test_cmcp_peer_connect_run, global_peer_clients[index]);
+            mu_assert_abort(ret == 0, vsp_error_str(ret));
+        }
+        for (index = 0; index < VSP_TEST_CHURN_CLIENT_COUNT; ++index) {
+            ret = pthread_join(connect_threads[index], &thread_result);
+            mu_assert_abort(ret == 0, vsp_error_str(ret));
+            mu_assert_abort(thread_result == NULL, vsp_error_str(ENOTCONN));
+        }
+
+        /* let the sending threads address the new clients */
+        for (peer_index = 0; peer_index < VSP_TEST_CHURN_CLIENT_COUNT;
+            ++peer_index) {
+            ret = vsp_cmcp_client_send(global_peer_clients[peer_index],
+                VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist);
+            mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+        }
+
+        /* deregister clients in scattered order while messages are sent */
+        for (index = 0; index < VSP_TEST_CHURN_CLIENT_COUNT; ++index) {
+            peer_index = (index * 3) % VSP_TEST_CHURN_CLIENT_COUNT;
+            vsp_cmcp_client_free(global_peer_clients[peer_index]);
+            global_peer_clients[peer_index] = NULL;
+        }
+    }
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* stop sending threads; the connected client was found every time */
+    __atomic_store_n(&global_churn_running, 0, __ATOMIC_RELAXED);
+    for (index = 0; index < VSP_TEST_SENDER_THREAD_COUNT; ++index) {
+        ret = pthread_join(sender_threads[index], &thread_result);
+        mu_assert_abort(ret == 0, vsp_error_str(ret));
+        mu_assert(thread_result == NULL, vsp_error_str(EINVAL));
+    }
+
+    /* skip sending a client message */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED);
+}
+
+MU_TEST(vsp_test_cmcp_server_stream_test)
+{
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* stream chunks to the client */
+    vsp_test_cmcp_stream_to_client();
+
+    /* skip sending a client message */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED);
+}
+
+MU_TEST(vsp_test_cmcp_stream_reconnect_test)
+{
+    int ret;
+    pthread_t pusher_thread;
+    struct timespec time_test_timeout;
+
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* stall the client on the first chunk, so the pusher runs out of credit */
+    vsp_cmcp_client_set_stream_cb(global_cmcp_client,
+        vsp_test_cmcp_client_stall_cb);
+    ret = vsp_cmcp_server_stream_open(global_cmcp_server,
+        global_cmcp_client_id, VSP_TEST_STREAM_ID);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    ret = pthread_create(&pusher_thread, NULL,
+        vsp_test_cmcp_stream_pusher_run, NULL);
+    mu_assert_abort(ret == 0, vsp_error_str(ret));
+
+    /* start measuring time for test timeout */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(global_test_state);
+    /* wait until the client stalls or waiting timed out */
+    ret = vsp_cmcp_state_await_state(global_test_state,
+        VSP_TEST_CMCP_SERVER_MESSAGE_RECEIVED, &time_test_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(global_test_state);
+    /* check if test was successful */
+    mu_assert_abort(ret == 0, vsp_error_str(ETIMEDOUT));
+
+    /* let the client continue and disconnect it by freeing it */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED);
+    vsp_cmcp_client_free(global_cmcp_client);
+    global_cmcp_client = NULL;
+
+    /* start measuring time for test timeout, which is shorter than the
+     * stream credit timeout */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(global_test_state);
+    /* wait until the client is deregistered or waiting timed out */
+    ret = vsp_cmcp_state_await_state(global_test_state,
+        VSP_TEST_CMCP_DISCONNECTED, &time_test_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(global_test_state);
+    /* check if test was successful */
+    mu_assert_abort(ret == 0, vsp_error_str(ETIMEDOUT));
+
+    /* the blocked pusher is woken up by the deregistration */
+    ret = pthread_join(pusher_thread, NULL);
+    mu_assert_abort(ret == 0, vsp_error_str(ret));
+    mu_assert(vsp_time_real_timespec_passed(&time_test_timeout) != 0,
+        vsp_error_str(ETIMEDOUT));
+    /* the failed stream can still be closed */
+    ret = vsp_cmcp_server_stream_close(global_cmcp_server,
+        global_cmcp_client_id, VSP_TEST_STREAM_ID);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* connect a new client */
+    vsp_cmcp_state_set(global_test_state, VSP_TEST_CMCP_NOT_CONNECTED);
+    global_cmcp_client = vsp_cmcp_client_create();
+    mu_assert_abort(global_cmcp_client != NULL, vsp_error_str(vsp_error_num()));
+    vsp_cmcp_client_set_callback_param(global_cmcp_client, global_cmcp_client);
+    vsp_cmcp_client_set_stream_cb(global_cmcp_client,
+        vsp_test_cmcp_client_stream_cb);
+    ret = vsp_cmcp_client_connect(global_cmcp_client,
+        VSP_TEST_SERVER_SUBSCRIBE_ADDRESS, VSP_TEST_SERVER_PUBLISH_ADDRESS);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* the same stream ID can be used again for the new client */
+    vsp_test_cmcp_stream_to_client();
+
+    /* skip sending a client message */
+    vsp_cmcp_state_set(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED);
+}
+
+MU_TEST(vsp_test_cmcp_reactor_callback_test)
+{
+    int ret;
+    struct timespec time_test_timeout;
+
+    /* check if test state is correct */
+    mu_assert_abort(vsp_cmcp_state_get(global_test_state)
+        == VSP_TEST_CMCP_CONNECTED, vsp_error_str(EINVAL));
+
+    /* connect another client driven by the same reactor */
+    vsp_cmcp_server_set_announcement_cb(global_cmcp_server,
+        vsp_test_cmcp_peer_announcement_cb);
+    vsp_cmcp_server_set_disconnect_cb(global_cmcp_server, NULL);
+    vsp_cmcp_server_set_message_cb(global_cmcp_server,
+        vsp_test_cmcp_reactor_free_cb);
+    global_peer_count = 0;
+    global_peer_clients[0] = vsp_cmcp_client_create();
+    mu_assert_abort(global_peer_clients[0] != NULL,
+        vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_client_set_reactor(global_peer_clients[0],
+        global_cmcp_reactor);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_client_connect(global_peer_clients[0],
+        VSP_TEST_SERVER_SUBSCRIBE_ADDRESS, VSP_TEST_SERVER_PUBLISH_ADDRESS);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(global_peer_count == 1, vsp_error_str(EINVAL));
+
+    /* let the server message callback function free the other client */
+    ret = vsp_cmcp_client_send(global_cmcp_client,
+        VSP_TEST_MESSAGE_COMMAND_ID, NULL);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* start measuring time for test timeout */
+    vsp_time_real_timespec_from_now(&time_test_timeout,
+        VSP_TEST_CMCP_TIMEOUT);
+
+    /* lock state mutex */
+    vsp_cmcp_state_lock(global_test_state);
+    /* wait until the client is freed or waiting timed out */
+    ret = vsp_cmcp_state_await_state(global_test_state,
+        VSP_TEST_CMCP_CLIENT_MESSAGE_RECEIVED, &time_test_timeout);
+    /* unlock state mutex */
+    vsp_cmcp_state_unlock(global_test_state);
+    /* check if test was successful */
+    mu_assert_abort(ret == 0, vsp_error_str(ETIMEDOUT));
+    mu_assert(global_peer_clients[0] == NULL, vsp_error_str(EINVAL));
+}
+
+MU_TEST_SUITE(vsp_test_cmcp_connection)
+{
+    MU_RUN_TEST(vsp_test_cmcp_server_allocation);
+    MU_RUN_TEST(vsp_test_cmcp_client_allocation);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_connection_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_server_invalid_parameters);
+    MU_RUN_TEST(vsp_test_cmcp_client_invalid_parameters);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_communication_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_communication_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_reactor_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_communication_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_reactor_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_reactor_callback_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_worker_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_communication_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_receive_queue_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_receive_queue_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_receive_queue_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_client_receive_queue_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_communication_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_concurrent_send_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_communication_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_group_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_communication_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_packet_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_communication_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_buffer_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_communication_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_peer_table_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_communication_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_churn_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_communication_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_server_stream_test);
+
+    MU_SUITE_CONFIGURE(&vsp_test_cmcp_communication_setup,
+        &vsp_test_cmcp_connection_teardown);
+    MU_RUN_TEST(vsp_test_cmcp_stream_reconnect_test);
 }
@@ -33,6 +33,16 @@ MU_TEST(vsp_test_cmcp_datalist_invalid_parameters);
 /** Create data list and test adding and reading items. */
 MU_TEST(vsp_test_cmcp_datalist_test);
 
+/** Test data lists with more than VSP_CMCP_DATALIST_INLINE_ITEMS items. */
+MU_TEST(vsp_test_cmcp_datalist_growth_test);
+
+/** Test data list items using the extended item length encoding. */
+MU_TEST(vsp_test_cmcp_datalist_large_item_test);
+
+/** Add typed single values and arrays and read them back from binary data
+ * stored at an odd offset. */
+MU_TEST(vsp_test_cmcp_datalist_typed_test);
+
 void vsp_test_cmcp_datalist_setup(void)
 {
     /* allocation */
@@ -120,6 +130,14 @@ MU_TEST(vsp_test_cmcp_datalist_invalid_parameters)
     data_item_pointer = vsp_cmcp_datalist_get_data_item(global_cmcp_datalist,
         VSP_TEST_DATALIST_ITEM1_ID, VSP_TEST_DATALIST_ITEM1_LENGTH + 1);
     mu_assert(data_item_pointer == NULL, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* take buffer with NULL object */
+    mu_assert(vsp_cmcp_datalist_take_buffer(NULL) == NULL,
+        VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* take buffer of data list not belonging to a received message */
+    mu_assert(vsp_cmcp_datalist_take_buffer(global_cmcp_datalist) == NULL,
+        VSP_TEST_INVALID_PARAMETER_ACCEPTED);
 }
 
 MU_TEST(vsp_test_cmcp_datalist_test)
@@ -190,10 +208,223 @@ MU_TEST(vsp_test_cmcp_datalist_test)
     vsp_cmcp_datalist_free(cmcp_datalist2);
 }
 
+MU_TEST(vsp_test_cmcp_datalist_growth_test)
+{
+    vsp_cmcp_datalist *cmcp_datalist2;
+    int ret;
+    int i;
+    int data_length;
+    int found_count;
+    uint16_t data_item_ids[1000];
+    void *data_pointer;
+    uint16_t *data_item_pointer;
+
+    /* insert items with scattered IDs and each ID as data */
+    for (i = 0; i < 1000; ++i) {
+        data_item_ids[i] = (uint16_t) (i * 263 + 17);
+        ret = vsp_cmcp_datalist_add_item(global_cmcp_datalist,
+            data_item_ids[i], sizeof(uint16_t), &data_item_ids[i]);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    }
+
+    /* insert data ID a second time and check for rejection */
+    ret = vsp_cmcp_datalist_add_item(global_cmcp_datalist, data_item_ids[500],
+        sizeof(uint16_t), &data_item_ids[500]);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* serialize data list */
+    data_length = vsp_cmcp_datalist_get_data_length(global_cmcp_datalist);
+    mu_assert_abort(data_length == 1000 * (4 + sizeof(uint16_t)),
+        vsp_error_str(EINVAL));
+    data_pointer = malloc(data_length);
+    mu_assert_abort(data_pointer != NULL, vsp_error_str(ENOMEM));
+    ret = vsp_cmcp_datalist_get_data(global_cmcp_datalist, data_pointer);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* parse twice into the same object, reusing its grown storage */
+    cmcp_datalist2 = vsp_cmcp_datalist_create_parse(data_length, data_pointer);
+    mu_assert_abort(cmcp_datalist2 != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_parse(cmcp_datalist2, data_length, data_pointer);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_datalist_get_data_length(cmcp_datalist2) == data_length,
+        vsp_error_str(EINVAL));
+
+    /* get back all items and verify data */
+    found_count = 0;
+    for (i = 0; i < 1000; ++i) {
+        data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist2,
+            data_item_ids[i], sizeof(uint16_t));
+        if (data_item_pointer != NULL
+            && memcmp(data_item_pointer, &data_item_ids[i],
+                sizeof(uint16_t)) == 0) {
+            ++found_count;
+        }
+    }
+    mu_assert(found_count == 1000, vsp_error_str(EINVAL));
+
+    /* get back item data for unknown item ID and check for failure */
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist2,
+        data_item_ids[0] + 1, sizeof(uint16_t));
+    mu_assert(data_item_pointer == NULL, vsp_error_str(EINVAL));
+
+    /* deallocation */
+    VSP_FREE(data_pointer);
+    vsp_cmcp_datalist_free(cmcp_datalist2);
+}
+
+MU_TEST(vsp_test_cmcp_datalist_large_item_test)
+{
+    vsp_cmcp_datalist *cmcp_datalist2;
+    int ret;
+    int data_length;
+    uint8_t *large_item_data;
+    void *data_pointer;
+    void *data_item_pointer;
+
+    /* create large item data */
+    large_item_data = malloc(VSP_TEST_DATALIST_LARGE_ITEM_LENGTH);
+    mu_assert_abort(large_item_data != NULL, vsp_error_str(ENOMEM));
+    memset(large_item_data, 0xa5, VSP_TEST_DATALIST_LARGE_ITEM_LENGTH);
+
+    /* insert small and large items */
+    ret = vsp_cmcp_datalist_add_item(global_cmcp_datalist,
+        VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_datalist_has_large_items(global_cmcp_datalist) == 0,
+        vsp_error_str(EINVAL));
+    ret = vsp_cmcp_datalist_add_item(global_cmcp_datalist,
+        VSP_TEST_DATALIST_LARGE_ITEM_ID, VSP_TEST_DATALIST_LARGE_ITEM_LENGTH,
+        large_item_data);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_datalist_has_large_items(global_cmcp_datalist) == 1,
+        vsp_error_str(EINVAL));
+
+    /* large item needs 4 additional bytes for its length */
+    data_length = vsp_cmcp_datalist_get_data_length(global_cmcp_datalist);
+    mu_assert_abort(data_length == VSP_TEST_DATALIST_ITEM1_LENGTH + 4
+        + VSP_TEST_DATALIST_LARGE_ITEM_LENGTH + 8, vsp_error_str(EINVAL));
+    data_pointer = malloc(data_length);
+    mu_assert_abort(data_pointer != NULL, vsp_error_str(ENOMEM));
+    ret = vsp_cmcp_datalist_get_data(global_cmcp_datalist, data_pointer);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* construct second data list using binary data array */
+    cmcp_datalist2 = vsp_cmcp_datalist_create_parse(data_length, data_pointer);
+    mu_assert_abort(cmcp_datalist2 != NULL, vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_datalist_get_data_length(cmcp_datalist2) == data_length,
+        vsp_error_str(EINVAL));
+
+    /* get back data list items and verify data */
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist2,
+        VSP_TEST_DATALIST_ITEM1_ID, VSP_TEST_DATALIST_ITEM1_LENGTH);
+    mu_assert_abort(data_item_pointer != NULL, vsp_error_str(vsp_error_num()));
+    mu_assert(memcmp(data_item_pointer, VSP_TEST_DATALIST_ITEM1_DATA,
+        VSP_TEST_DATALIST_ITEM1_LENGTH) == 0, vsp_error_str(EINVAL));
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist2,
+        VSP_TEST_DATALIST_LARGE_ITEM_ID, VSP_TEST_DATALIST_LARGE_ITEM_LENGTH);
+    mu_assert_abort(data_item_pointer != NULL, vsp_error_str(vsp_error_num()));
+    mu_assert(memcmp(data_item_pointer, large_item_data,
+        VSP_TEST_DATALIST_LARGE_ITEM_LENGTH) == 0, vsp_error_str(EINVAL));
+    vsp_cmcp_datalist_free(cmcp_datalist2);
+
+    /* truncated large item is not parsed */
+    cmcp_datalist2 = vsp_cmcp_datalist_create_parse(data_length - 1,
+        data_pointer);
+    mu_assert_abort(cmcp_datalist2 != NULL, vsp_error_str(vsp_error_num()));
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist2,
+        VSP_TEST_DATALIST_LARGE_ITEM_ID, VSP_TEST_DATALIST_LARGE_ITEM_LENGTH);
+    mu_assert(data_item_pointer == NULL, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* deallocation */
+    VSP_FREE(data_pointer);
+    VSP_FREE(large_item_data);
+    vsp_cmcp_datalist_free(cmcp_datalist2);
+}
+
+MU_TEST(vsp_test_cmcp_datalist_typed_test)
+{
+    int ret;
+    int data_length;
+    uint16_t value_u16;
+    uint64_t values_u64[3];
+    double value_f64;
+    uint16_t read_u16;
+    uint64_t read_u64[3];
+    double read_f64;
+    uint8_t *data_pointer;
+    vsp_cmcp_datalist *cmcp_datalist2;
+
+    /* insert single values and array */
+    value_u16 = VSP_TEST_DATALIST_ITEM1_ID;
+    values_u64[0] = VSP_TEST_TRACE_SEND_TIME;
+    values_u64[1] = 0;
+    values_u64[2] = UINT64_MAX;
+    value_f64 = 0.25;
+    ret = vsp_cmcp_datalist_add_u16(global_cmcp_datalist,
+        VSP_TEST_DATALIST_ITEM1_ID, 1, &value_u16);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_u64(global_cmcp_datalist,
+        VSP_TEST_DATALIST_ITEM2_ID, 3, values_u64);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_f64(global_cmcp_datalist,
+        VSP_TEST_DATALIST_LARGE_ITEM_ID, 1, &value_f64);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    /* invalid number of values */
+    ret = vsp_cmcp_datalist_add_u16(global_cmcp_datalist,
+        VSP_TEST_DATALIST_ITEM1_ID + 1, 0, &value_u16);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* get binary data at an odd offset, so items are not aligned */
+    data_length = vsp_cmcp_datalist_get_data_length(global_cmcp_datalist);
+    data_pointer = malloc(data_length + 1);
+    mu_assert_abort(data_pointer != NULL, vsp_error_str(ENOMEM));
+    ret = vsp_cmcp_datalist_get_data(global_cmcp_datalist, data_pointer + 1);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    cmcp_datalist2 = vsp_cmcp_datalist_create_parse(data_length,
+        data_pointer + 1);
+    mu_assert_abort(cmcp_datalist2 != NULL, vsp_error_str(vsp_error_num()));
+
+    /* read values */
+    ret = vsp_cmcp_datalist_get_u16(cmcp_datalist2,
+        VSP_TEST_DATALIST_ITEM1_ID, 1, &read_u16);
+    mu_assert(ret == 0 && read_u16 == value_u16,
+        vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_datalist_get_item_length(cmcp_datalist2,
+        VSP_TEST_DATALIST_ITEM2_ID) == 3 * sizeof(uint64_t),
+        vsp_error_str(EINVAL));
+    ret = vsp_cmcp_datalist_get_u64(cmcp_datalist2,
+        VSP_TEST_DATALIST_ITEM2_ID, 3, read_u64);
+    mu_assert(ret == 0 && memcmp(read_u64, values_u64, sizeof(read_u64)) == 0,
+        vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_get_f64(cmcp_datalist2,
+        VSP_TEST_DATALIST_LARGE_ITEM_ID, 1, &read_f64);
+    mu_assert(ret == 0 && read_f64 == value_f64,
+        vsp_error_str(vsp_error_num()));
+
+    /* number of values or type does not match item length */
+    ret = vsp_cmcp_datalist_get_u64(cmcp_datalist2,
+        VSP_TEST_DATALIST_ITEM2_ID, 2, read_u64);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    ret = vsp_cmcp_datalist_get_u64(cmcp_datalist2,
+        VSP_TEST_DATALIST_ITEM1_ID, 1, read_u64);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    mu_assert(vsp_cmcp_datalist_get_item_length(cmcp_datalist2,
+        VSP_TEST_DATALIST_ITEM1_ID + 1) < 0,
+        VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* deallocation */
+    VSP_FREE(data_pointer);
+    vsp_cmcp_datalist_free(cmcp_datalist2);
+}
+
 MU_TEST_SUITE(vsp_test_cmcp_datalist)
 {
     MU_SUITE_CONFIGURE(&vsp_test_cmcp_datalist_setup,
         &vsp_test_cmcp_datalist_teardown);
     MU_RUN_TEST(vsp_test_cmcp_datalist_invalid_parameters);
     MU_RUN_TEST(vsp_test_cmcp_datalist_test);
+    MU_RUN_TEST(vsp_test_cmcp_datalist_growth_test);
+    MU_RUN_TEST(vsp_test_cmcp_datalist_large_item_test);
+    MU_RUN_TEST(vsp_test_cmcp_datalist_typed_test);
 }
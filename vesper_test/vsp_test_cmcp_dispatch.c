@@ -0,0 +1,134 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "minunit.h"
+#include "vsp_test.h"
+
+#include <vesper_cmcp/vsp_cmcp_dispatch.h>
+#include <vesper_util/vsp_error.h>
+#include <errno.h>
+#include <pthread.h>
+
+/** Mutex locking the dispatch test state. */
+pthread_mutex_t global_dispatch_mutex;
+/** Condition signaled when the dispatch test state changes. */
+pthread_cond_t global_dispatch_condition;
+/** Number of messages and events handled by the worker thread. */
+int global_dispatch_handled_count;
+/** Number of events handled by the worker thread. */
+int global_dispatch_event_count;
+/** Non-zero while the worker thread has to wait in the callback function. */
+int global_dispatch_blocked;
+
+/** Block the only worker, fill its queue until messages are dropped and
+ * events are kept, then let it handle all queued entries. */
+MU_TEST(vsp_test_cmcp_dispatch_test);
+
+/** Dispatch callback function counting messages and events and waiting while
+ * the worker thread is blocked. */
+static void vsp_test_cmcp_dispatch_cb(void *param, uint16_t sender_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist);
+
+void vsp_test_cmcp_dispatch_cb(void *param, uint16_t sender_id,
+    uint16_t command_id, vsp_cmcp_datalist *cmcp_datalist)
+{
+    (void) param;
+    (void) sender_id;
+    (void) command_id;
+
+    pthread_mutex_lock(&global_dispatch_mutex);
+    ++global_dispatch_handled_count;
+    if (cmcp_datalist == NULL) {
+        ++global_dispatch_event_count;
+    }
+    pthread_cond_broadcast(&global_dispatch_condition);
+    while (global_dispatch_blocked) {
+        pthread_cond_wait(&global_dispatch_condition, &global_dispatch_mutex);
+    }
+    pthread_mutex_unlock(&global_dispatch_mutex);
+}
+
+MU_TEST(vsp_test_cmcp_dispatch_test)
+{
+    vsp_cmcp_dispatch *cmcp_dispatch;
+    vsp_cmcp_datalist *cmcp_datalist;
+    int index;
+    int ret;
+
+    /* invalid worker count and queue capacity */
+    cmcp_dispatch = vsp_cmcp_dispatch_create(0,
+        VSP_TEST_WORKER_QUEUE_CAPACITY, vsp_test_cmcp_dispatch_cb, NULL);
+    mu_assert(cmcp_dispatch == NULL, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+    cmcp_dispatch = vsp_cmcp_dispatch_create(1, 0, vsp_test_cmcp_dispatch_cb,
+        NULL);
+    mu_assert(cmcp_dispatch == NULL, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* initialize test state */
+    pthread_mutex_init(&global_dispatch_mutex, NULL);
+    pthread_cond_init(&global_dispatch_condition, NULL);
+    global_dispatch_handled_count = 0;
+    global_dispatch_event_count = 0;
+    global_dispatch_blocked = 1;
+
+    /* create single worker and data list */
+    cmcp_dispatch = vsp_cmcp_dispatch_create(1,
+        VSP_TEST_WORKER_QUEUE_CAPACITY, vsp_test_cmcp_dispatch_cb, NULL);
+    mu_assert_abort(cmcp_dispatch != NULL, vsp_error_str(vsp_error_num()));
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM2_ID,
+        VSP_TEST_DATALIST_ITEM2_LENGTH, VSP_TEST_DATALIST_ITEM2_DATA);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* block worker in the callback function of the first message */
+    pthread_mutex_lock(&global_dispatch_mutex);
+    ret = vsp_cmcp_dispatch_push(cmcp_dispatch, 1, 0, cmcp_datalist);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    while (global_dispatch_handled_count == 0) {
+        pthread_cond_wait(&global_dispatch_condition, &global_dispatch_mutex);
+    }
+
+    /* fill queue */
+    for (index = 0; index < VSP_TEST_WORKER_QUEUE_CAPACITY; ++index) {
+        ret = vsp_cmcp_dispatch_push(cmcp_dispatch, 1, 0, cmcp_datalist);
+        mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    }
+
+    /* full queue drops further messages and counts them */
+    ret = vsp_cmcp_dispatch_push(cmcp_dispatch, 1, 0, cmcp_datalist);
+    mu_assert(ret != 0 && vsp_error_num() == EAGAIN, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_dispatch_get_drop_count(cmcp_dispatch) == 1,
+        vsp_error_str(EINVAL));
+
+    /* full queue keeps events */
+    ret = vsp_cmcp_dispatch_push(cmcp_dispatch, 1, 0, NULL);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_dispatch_get_count(cmcp_dispatch)
+        == VSP_TEST_WORKER_QUEUE_CAPACITY + 1, vsp_error_str(EINVAL));
+
+    /* let worker handle all queued entries */
+    global_dispatch_blocked = 0;
+    pthread_cond_broadcast(&global_dispatch_condition);
+    pthread_mutex_unlock(&global_dispatch_mutex);
+    vsp_cmcp_dispatch_free(cmcp_dispatch);
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* first message, queued messages and the event were handled */
+    mu_assert(global_dispatch_handled_count
+        == VSP_TEST_WORKER_QUEUE_CAPACITY + 2
+        && global_dispatch_event_count == 1, vsp_error_str(EINVAL));
+
+    pthread_cond_destroy(&global_dispatch_condition);
+    pthread_mutex_destroy(&global_dispatch_mutex);
+}
+
+MU_TEST_SUITE(vsp_test_cmcp_dispatch)
+{
+    MU_RUN_TEST(vsp_test_cmcp_dispatch_test);
+}
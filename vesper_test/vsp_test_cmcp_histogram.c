@@ -0,0 +1,140 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "minunit.h"
+#include "vsp_test.h"
+
+#include <vesper_cmcp/vsp_cmcp_histogram.h>
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
+#include <pthread.h>
+#include <stddef.h>
+
+/** Record known durations and check the reported percentiles. */
+MU_TEST(vsp_test_cmcp_histogram_test);
+
+/** Record durations from two threads and check they use separate shards. */
+MU_TEST(vsp_test_cmcp_histogram_shard_test);
+
+/** Histogram shared by the recorder threads. */
+vsp_cmcp_histogram *global_cmcp_histogram;
+
+/** Record a duration and store the used shard in the int param points to;
+ * runs in several threads. Returns NULL. */
+void *vsp_test_cmcp_histogram_recorder_run(void *param);
+
+/** Check whether a reported percentile lies within the bucket precision
+ * above the exact value. Returns non-zero if it does. */
+static int vsp_test_cmcp_histogram_matches(uint64_t percentile,
+    uint64_t exact_value);
+
+int vsp_test_cmcp_histogram_matches(uint64_t percentile, uint64_t exact_value)
+{
+    return percentile >= exact_value
+        && percentile <= exact_value + exact_value / 8;
+}
+
+MU_TEST(vsp_test_cmcp_histogram_test)
+{
+    vsp_cmcp_histogram *cmcp_histogram;
+    vsp_cmcp_latency cmcp_latency;
+    uint64_t value;
+
+    /* invalid shard count */
+    cmcp_histogram = vsp_cmcp_histogram_create(0);
+    mu_assert(cmcp_histogram == NULL, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    cmcp_histogram =
+        vsp_cmcp_histogram_create(VSP_TEST_HISTOGRAM_SHARD_COUNT);
+    mu_assert_abort(cmcp_histogram != NULL, vsp_error_str(vsp_error_num()));
+
+    /* empty histogram */
+    vsp_cmcp_histogram_get_latency(cmcp_histogram, &cmcp_latency);
+    mu_assert(cmcp_latency.count == 0 && cmcp_latency.p50 == 0
+        && cmcp_latency.max == 0, vsp_error_str(EINVAL));
+
+    /* small values are counted exactly */
+    for (value = 1; value <= 4; ++value) {
+        vsp_cmcp_histogram_record(cmcp_histogram, value);
+    }
+    vsp_cmcp_histogram_get_latency(cmcp_histogram, &cmcp_latency);
+    mu_assert(cmcp_latency.count == 4 && cmcp_latency.p50 == 2
+        && cmcp_latency.max == 4, vsp_error_str(EINVAL));
+
+    /* larger values are rounded up to their bucket bound */
+    for (value = 5; value <= VSP_TEST_HISTOGRAM_VALUE_COUNT; ++value) {
+        vsp_cmcp_histogram_record(cmcp_histogram, value);
+    }
+    vsp_cmcp_histogram_get_latency(cmcp_histogram, &cmcp_latency);
+    mu_assert(cmcp_latency.count == VSP_TEST_HISTOGRAM_VALUE_COUNT,
+        vsp_error_str(EINVAL));
+    mu_assert(vsp_test_cmcp_histogram_matches(cmcp_latency.p50,
+        VSP_TEST_HISTOGRAM_VALUE_COUNT / 2), vsp_error_str(EINVAL));
+    mu_assert(vsp_test_cmcp_histogram_matches(cmcp_latency.p90,
+        VSP_TEST_HISTOGRAM_VALUE_COUNT * 9 / 10), vsp_error_str(EINVAL));
+    mu_assert(vsp_test_cmcp_histogram_matches(cmcp_latency.p99,
+        VSP_TEST_HISTOGRAM_VALUE_COUNT * 99 / 100), vsp_error_str(EINVAL));
+    mu_assert(vsp_test_cmcp_histogram_matches(cmcp_latency.max,
+        VSP_TEST_HISTOGRAM_VALUE_COUNT), vsp_error_str(EINVAL));
+
+    /* values beyond the largest bucket are counted in the largest bucket */
+    vsp_cmcp_histogram_record(cmcp_histogram, (uint64_t) 1 << 62);
+    vsp_cmcp_histogram_get_latency(cmcp_histogram, &cmcp_latency);
+    mu_assert(cmcp_latency.count == VSP_TEST_HISTOGRAM_VALUE_COUNT + 1
+        && cmcp_latency.max > VSP_TEST_HISTOGRAM_VALUE_COUNT
+        && vsp_test_cmcp_histogram_matches(cmcp_latency.p99,
+        VSP_TEST_HISTOGRAM_VALUE_COUNT * 99 / 100), vsp_error_str(EINVAL));
+
+    vsp_cmcp_histogram_free(cmcp_histogram);
+}
+
+void *vsp_test_cmcp_histogram_recorder_run(void *param)
+{
+    vsp_cmcp_histogram_record(global_cmcp_histogram, 1);
+    *((int *) param) = vsp_cmcp_histogram_get_shard(global_cmcp_histogram);
+    return NULL;
+}
+
+MU_TEST(vsp_test_cmcp_histogram_shard_test)
+{
+    int ret;
+    int index;
+    pthread_t recorder_thread;
+    int shards[2];
+    vsp_cmcp_latency cmcp_latency;
+
+    global_cmcp_histogram =
+        vsp_cmcp_histogram_create(VSP_TEST_HISTOGRAM_SHARD_COUNT);
+    mu_assert_abort(global_cmcp_histogram != NULL,
+        vsp_error_str(vsp_error_num()));
+
+    /* threads started one after another get consecutive thread numbers */
+    for (index = 0; index < 2; ++index) {
+        ret = pthread_create(&recorder_thread, NULL,
+            vsp_test_cmcp_histogram_recorder_run, &shards[index]);
+        mu_assert_abort(ret == 0, vsp_error_str(ret));
+        ret = pthread_join(recorder_thread, NULL);
+        mu_assert_abort(ret == 0, vsp_error_str(ret));
+    }
+    mu_assert(shards[0] != shards[1], vsp_error_str(EINVAL));
+
+    /* both recordings are merged */
+    vsp_cmcp_histogram_get_latency(global_cmcp_histogram, &cmcp_latency);
+    mu_assert(cmcp_latency.count == 2 && cmcp_latency.max == 1,
+        vsp_error_str(EINVAL));
+
+    vsp_cmcp_histogram_free(global_cmcp_histogram);
+    global_cmcp_histogram = NULL;
+}
+
+MU_TEST_SUITE(vsp_test_cmcp_histogram)
+{
+    MU_RUN_TEST(vsp_test_cmcp_histogram_test);
+    MU_RUN_TEST(vsp_test_cmcp_histogram_shard_test);
+}
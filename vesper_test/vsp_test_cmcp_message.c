@@ -19,6 +19,21 @@
 /** Create message and test creating binary data and parse it. */
 MU_TEST(vsp_test_cmcp_message_test);
 
+/** Write binary message data without message object and parse it. */
+MU_TEST(vsp_test_cmcp_message_inline_test);
+
+/** Parse several binary messages using the same message object. */
+MU_TEST(vsp_test_cmcp_message_view_test);
+
+/** Test writing batch messages and parsing their records. */
+MU_TEST(vsp_test_cmcp_message_batch_test);
+
+/** Test wrapping a message into a trace message and parsing it. */
+MU_TEST(vsp_test_cmcp_message_trace_test);
+
+/** Encode a message into a packet once and copy it for two destinations. */
+MU_TEST(vsp_test_cmcp_message_packet_test);
+
 MU_TEST(vsp_test_cmcp_message_test)
 {
     vsp_cmcp_datalist *cmcp_datalist1, *cmcp_datalist2;
@@ -112,7 +127,370 @@ MU_TEST(vsp_test_cmcp_message_test)
     vsp_cmcp_message_free(cmcp_message2);
 }
 
+MU_TEST(vsp_test_cmcp_message_inline_test)
+{
+    vsp_cmcp_datalist *cmcp_datalist1, *cmcp_datalist2;
+    vsp_cmcp_message *cmcp_message;
+    int ret;
+    int data_length;
+    void *data_pointer;
+    void *data_item_pointer;
+
+    /* get binary data array length without data list */
+    data_length = vsp_cmcp_message_get_inline_data_length(NULL);
+    mu_assert(data_length == VSP_CMCP_MESSAGE_HEADER_LENGTH,
+        vsp_error_str(EINVAL));
+
+    /* allocate data list and insert data list item */
+    cmcp_datalist1 = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist1 != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist1, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* get binary data array length */
+    data_length = vsp_cmcp_message_get_inline_data_length(cmcp_datalist1);
+    mu_assert_abort(data_length == (VSP_TEST_DATALIST_ITEM1_LENGTH + 4
+        + VSP_CMCP_MESSAGE_HEADER_LENGTH), vsp_error_str(EINVAL));
+    /* allocate array and write binary data */
+    data_pointer = malloc(data_length);
+    mu_assert_abort(data_pointer != NULL, vsp_error_str(ENOMEM));
+    vsp_cmcp_message_get_inline_data(VSP_CMCP_MESSAGE_TYPE_CONTROL,
+        VSP_TEST_MESSAGE_TOPIC_ID, VSP_TEST_MESSAGE_SENDER_ID,
+        VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist1, data_pointer);
+
+    /* parse binary data array and verify message */
+    cmcp_message = vsp_cmcp_message_create_parse(data_length, data_pointer);
+    mu_assert_abort(cmcp_message != NULL, vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_message_get_type(cmcp_message)
+        == VSP_CMCP_MESSAGE_TYPE_CONTROL, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_message_get_topic_id(cmcp_message)
+        == VSP_TEST_MESSAGE_TOPIC_ID, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_message_get_sender_id(cmcp_message)
+        == VSP_TEST_MESSAGE_SENDER_ID, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_message_get_command_id(cmcp_message)
+        == VSP_TEST_MESSAGE_COMMAND_ID, vsp_error_str(EINVAL));
+    cmcp_datalist2 = vsp_cmcp_message_get_datalist(cmcp_message);
+    mu_assert_abort(cmcp_datalist2 != NULL, vsp_error_str(vsp_error_num()));
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist2,
+        VSP_TEST_DATALIST_ITEM1_ID, VSP_TEST_DATALIST_ITEM1_LENGTH);
+    mu_assert_abort(data_item_pointer != NULL, vsp_error_str(vsp_error_num()));
+    mu_assert(memcmp(data_item_pointer, VSP_TEST_DATALIST_ITEM1_DATA,
+        VSP_TEST_DATALIST_ITEM1_LENGTH) == 0, vsp_error_str(EINVAL));
+
+    /* deallocation; cmcp_datalist2 will be freed by cmcp_message */
+    VSP_FREE(data_pointer);
+    vsp_cmcp_datalist_free(cmcp_datalist1);
+    vsp_cmcp_message_free(cmcp_message);
+}
+
+MU_TEST(vsp_test_cmcp_message_view_test)
+{
+    vsp_cmcp_datalist *cmcp_datalist;
+    vsp_cmcp_message *cmcp_message;
+    int ret;
+    int data_length1, data_length2;
+    uint8_t *data_pointer1, *data_pointer2;
+    void *data_item_pointer;
+
+    /* write message with first data list item */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    data_length1 = vsp_cmcp_message_get_inline_data_length(cmcp_datalist);
+    data_pointer1 = malloc(data_length1);
+    mu_assert_abort(data_pointer1 != NULL, vsp_error_str(ENOMEM));
+    vsp_cmcp_message_get_inline_data(VSP_CMCP_MESSAGE_TYPE_DATA,
+        VSP_TEST_MESSAGE_TOPIC_ID, VSP_TEST_MESSAGE_SENDER_ID,
+        VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist, data_pointer1);
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* write message with second data list item */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM2_ID,
+        VSP_TEST_DATALIST_ITEM2_LENGTH, VSP_TEST_DATALIST_ITEM2_DATA);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    data_length2 = vsp_cmcp_message_get_inline_data_length(cmcp_datalist);
+    data_pointer2 = malloc(data_length2);
+    mu_assert_abort(data_pointer2 != NULL, vsp_error_str(ENOMEM));
+    vsp_cmcp_message_get_inline_data(VSP_CMCP_MESSAGE_TYPE_DATA,
+        VSP_TEST_MESSAGE_TOPIC_ID, VSP_TEST_MESSAGE_SENDER_ID,
+        VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist, data_pointer2);
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* parse both messages with the same message object */
+    cmcp_message = vsp_cmcp_message_create_view();
+    mu_assert_abort(cmcp_message != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_message_parse(cmcp_message, data_length1, data_pointer1);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_message_parse(cmcp_message, data_length2, data_pointer2);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* only items of the second message are accessible */
+    cmcp_datalist = vsp_cmcp_message_get_datalist(cmcp_message);
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist,
+        VSP_TEST_DATALIST_ITEM1_ID, VSP_TEST_DATALIST_ITEM1_LENGTH);
+    mu_assert(data_item_pointer == NULL, vsp_error_str(EINVAL));
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist,
+        VSP_TEST_DATALIST_ITEM2_ID, VSP_TEST_DATALIST_ITEM2_LENGTH);
+    mu_assert_abort(data_item_pointer != NULL, vsp_error_str(vsp_error_num()));
+    mu_assert(memcmp(data_item_pointer, VSP_TEST_DATALIST_ITEM2_DATA,
+        VSP_TEST_DATALIST_ITEM2_LENGTH) == 0, vsp_error_str(EINVAL));
+
+    /* truncated message header is rejected */
+    ret = vsp_cmcp_message_parse(cmcp_message,
+        VSP_CMCP_MESSAGE_HEADER_LENGTH - 1, data_pointer1);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* deallocation */
+    VSP_FREE(data_pointer1);
+    VSP_FREE(data_pointer2);
+    vsp_cmcp_message_free(cmcp_message);
+}
+
+MU_TEST(vsp_test_cmcp_message_batch_test)
+{
+    vsp_cmcp_datalist *cmcp_datalists[2];
+    vsp_cmcp_datalist *cmcp_datalist;
+    vsp_cmcp_message *cmcp_message;
+    uint16_t command_ids[2];
+    int ret;
+    int data_length;
+    int offset;
+    uint8_t *data_pointer;
+    void *data_item_pointer;
+
+    /* first record has a data list item, second one has no data list */
+    cmcp_datalists[0] = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalists[0] != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalists[0],
+        VSP_TEST_DATALIST_ITEM1_ID, VSP_TEST_DATALIST_ITEM1_LENGTH,
+        VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    cmcp_datalists[1] = NULL;
+    command_ids[0] = VSP_TEST_MESSAGE_COMMAND_ID;
+    command_ids[1] = VSP_TEST_MESSAGE_COMMAND_ID + 1;
+
+    /* write batch message */
+    data_length = vsp_cmcp_message_get_batch_data_length(2, cmcp_datalists);
+    mu_assert_abort(data_length == VSP_CMCP_MESSAGE_HEADER_LENGTH
+        + 2 * VSP_CMCP_MESSAGE_RECORD_HEADER_LENGTH
+        + vsp_cmcp_datalist_get_data_length(cmcp_datalists[0]),
+        vsp_error_str(EINVAL));
+    data_pointer = malloc(data_length);
+    mu_assert_abort(data_pointer != NULL, vsp_error_str(ENOMEM));
+    vsp_cmcp_message_get_batch_data(VSP_CMCP_MESSAGE_TYPE_DATA,
+        VSP_TEST_MESSAGE_TOPIC_ID, VSP_TEST_MESSAGE_SENDER_ID, 2, command_ids,
+        cmcp_datalists, data_pointer);
+    vsp_cmcp_datalist_free(cmcp_datalists[0]);
+
+    /* parse batch message header */
+    cmcp_message = vsp_cmcp_message_create_view();
+    mu_assert_abort(cmcp_message != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_message_parse(cmcp_message, data_length, data_pointer);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert_abort(vsp_cmcp_message_is_batch(cmcp_message) != 0,
+        vsp_error_str(EINVAL));
+
+    /* parse first record */
+    offset = VSP_CMCP_MESSAGE_HEADER_LENGTH;
+    ret = vsp_cmcp_message_parse_batch_record(cmcp_message, data_length,
+        data_pointer, &offset);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_message_is_batch(cmcp_message) == 0,
+        vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_message_get_type(cmcp_message)
+        == VSP_CMCP_MESSAGE_TYPE_DATA, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_message_get_topic_id(cmcp_message)
+        == VSP_TEST_MESSAGE_TOPIC_ID, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_message_get_sender_id(cmcp_message)
+        == VSP_TEST_MESSAGE_SENDER_ID, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_message_get_command_id(cmcp_message)
+        == VSP_TEST_MESSAGE_COMMAND_ID, vsp_error_str(EINVAL));
+    cmcp_datalist = vsp_cmcp_message_get_datalist(cmcp_message);
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist,
+        VSP_TEST_DATALIST_ITEM1_ID, VSP_TEST_DATALIST_ITEM1_LENGTH);
+    mu_assert_abort(data_item_pointer != NULL, vsp_error_str(vsp_error_num()));
+    mu_assert(memcmp(data_item_pointer, VSP_TEST_DATALIST_ITEM1_DATA,
+        VSP_TEST_DATALIST_ITEM1_LENGTH) == 0, vsp_error_str(EINVAL));
+
+    /* parse second record */
+    ret = vsp_cmcp_message_parse_batch_record(cmcp_message, data_length,
+        data_pointer, &offset);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_message_get_command_id(cmcp_message)
+        == VSP_TEST_MESSAGE_COMMAND_ID + 1, vsp_error_str(EINVAL));
+    cmcp_datalist = vsp_cmcp_message_get_datalist(cmcp_message);
+    mu_assert(vsp_cmcp_datalist_get_data_length(cmcp_datalist) == 0,
+        vsp_error_str(EINVAL));
+
+    /* no record left */
+    ret = vsp_cmcp_message_parse_batch_record(cmcp_message, data_length,
+        data_pointer, &offset);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* truncated record is rejected */
+    offset = VSP_CMCP_MESSAGE_HEADER_LENGTH;
+    ret = vsp_cmcp_message_parse_batch_record(cmcp_message, data_length - 5,
+        data_pointer, &offset);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* deallocation */
+    VSP_FREE(data_pointer);
+    vsp_cmcp_message_free(cmcp_message);
+}
+
+MU_TEST(vsp_test_cmcp_message_trace_test)
+{
+    vsp_cmcp_datalist *cmcp_datalist;
+    vsp_cmcp_message *cmcp_message;
+    int ret;
+    int data_length;
+    int offset;
+    uint8_t *data_pointer;
+    void *data_item_pointer;
+    uint64_t send_time;
+    uint32_t sequence;
+
+    /* allocate data list and insert data list item */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+
+    /* write trace headers followed by the traced message */
+    offset = VSP_CMCP_MESSAGE_HEADER_LENGTH
+        + VSP_CMCP_MESSAGE_TRACE_HEADER_LENGTH;
+    data_length = offset
+        + vsp_cmcp_message_get_inline_data_length(cmcp_datalist);
+    data_pointer = malloc(data_length);
+    mu_assert_abort(data_pointer != NULL, vsp_error_str(ENOMEM));
+    vsp_cmcp_message_get_trace_data(VSP_TEST_MESSAGE_TOPIC_ID,
+        VSP_TEST_MESSAGE_SENDER_ID, VSP_TEST_TRACE_SEND_TIME,
+        VSP_TEST_TRACE_SEQUENCE, data_pointer);
+    vsp_cmcp_message_get_inline_data(VSP_CMCP_MESSAGE_TYPE_DATA,
+        VSP_TEST_MESSAGE_TOPIC_ID, VSP_TEST_MESSAGE_SENDER_ID,
+        VSP_TEST_MESSAGE_COMMAND_ID, cmcp_datalist, data_pointer + offset);
+    vsp_cmcp_datalist_free(cmcp_datalist);
+
+    /* parse trace message header */
+    cmcp_message = vsp_cmcp_message_create_view();
+    mu_assert_abort(cmcp_message != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_message_parse(cmcp_message, data_length, data_pointer);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert_abort(vsp_cmcp_message_is_trace(cmcp_message) != 0,
+        vsp_error_str(EINVAL));
+
+    /* truncated trace message is rejected */
+    ret = vsp_cmcp_message_parse_trace(cmcp_message, offset - 1,
+        data_pointer, &send_time, &sequence);
+    mu_assert(ret != 0, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* parse trace header and traced message */
+    ret = vsp_cmcp_message_parse(cmcp_message, data_length, data_pointer);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_message_parse_trace(cmcp_message, data_length,
+        data_pointer, &send_time, &sequence);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(send_time == VSP_TEST_TRACE_SEND_TIME
+        && sequence == VSP_TEST_TRACE_SEQUENCE, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_message_is_trace(cmcp_message) == 0,
+        vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_message_get_type(cmcp_message)
+        == VSP_CMCP_MESSAGE_TYPE_DATA, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_message_get_command_id(cmcp_message)
+        == VSP_TEST_MESSAGE_COMMAND_ID, vsp_error_str(EINVAL));
+    cmcp_datalist = vsp_cmcp_message_get_datalist(cmcp_message);
+    data_item_pointer = vsp_cmcp_datalist_get_data_item(cmcp_datalist,
+        VSP_TEST_DATALIST_ITEM1_ID, VSP_TEST_DATALIST_ITEM1_LENGTH);
+    mu_assert_abort(data_item_pointer != NULL, vsp_error_str(vsp_error_num()));
+    mu_assert(memcmp(data_item_pointer, VSP_TEST_DATALIST_ITEM1_DATA,
+        VSP_TEST_DATALIST_ITEM1_LENGTH) == 0, vsp_error_str(EINVAL));
+
+    /* deallocation */
+    VSP_FREE(data_pointer);
+    vsp_cmcp_message_free(cmcp_message);
+}
+
+MU_TEST(vsp_test_cmcp_message_packet_test)
+{
+    vsp_cmcp_datalist *cmcp_datalist;
+    vsp_cmcp_packet *cmcp_packet;
+    vsp_cmcp_message *cmcp_message;
+    int ret;
+    int data_length;
+    int index;
+    void *data_pointer;
+    void *data_item_pointer;
+
+    /* command IDs with MSB set are invalid */
+    cmcp_packet = vsp_cmcp_packet_create(0x8000, NULL);
+    mu_assert(cmcp_packet == NULL, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* encode packet; data list is not needed afterwards */
+    cmcp_datalist = vsp_cmcp_datalist_create();
+    mu_assert_abort(cmcp_datalist != NULL, vsp_error_str(vsp_error_num()));
+    ret = vsp_cmcp_datalist_add_item(cmcp_datalist, VSP_TEST_DATALIST_ITEM1_ID,
+        VSP_TEST_DATALIST_ITEM1_LENGTH, VSP_TEST_DATALIST_ITEM1_DATA);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    cmcp_packet = vsp_cmcp_packet_create(VSP_TEST_MESSAGE_COMMAND_ID,
+        cmcp_datalist);
+    mu_assert_abort(cmcp_packet != NULL, vsp_error_str(vsp_error_num()));
+    vsp_cmcp_datalist_free(cmcp_datalist);
+    mu_assert(vsp_cmcp_packet_has_large_items(cmcp_packet) == 0,
+        vsp_error_str(EINVAL));
+    data_length = vsp_cmcp_packet_get_data_length(cmcp_packet);
+    mu_assert_abort(data_length == (VSP_TEST_DATALIST_ITEM1_LENGTH + 4
+        + VSP_CMCP_MESSAGE_HEADER_LENGTH), vsp_error_str(EINVAL));
+
+    /* second reference keeps the packet alive after the first is dropped */
+    vsp_cmcp_packet_retain(cmcp_packet);
+    vsp_cmcp_packet_free(cmcp_packet);
+
+    /* copy packet for two destinations and verify each message */
+    data_pointer = malloc(data_length);
+    mu_assert_abort(data_pointer != NULL, vsp_error_str(ENOMEM));
+    cmcp_message = vsp_cmcp_message_create_view();
+    mu_assert_abort(cmcp_message != NULL, vsp_error_str(vsp_error_num()));
+    for (index = 0; index < 2; ++index) {
+        vsp_cmcp_packet_get_data(cmcp_packet,
+            VSP_TEST_MESSAGE_TOPIC_ID + index, VSP_TEST_MESSAGE_SENDER_ID,
+            data_pointer);
+        ret = vsp_cmcp_message_parse(cmcp_message, data_length, data_pointer);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+        mu_assert(vsp_cmcp_message_get_type(cmcp_message)
+            == VSP_CMCP_MESSAGE_TYPE_DATA, vsp_error_str(EINVAL));
+        mu_assert(vsp_cmcp_message_get_topic_id(cmcp_message)
+            == VSP_TEST_MESSAGE_TOPIC_ID + index, vsp_error_str(EINVAL));
+        mu_assert(vsp_cmcp_message_get_sender_id(cmcp_message)
+            == VSP_TEST_MESSAGE_SENDER_ID, vsp_error_str(EINVAL));
+        mu_assert(vsp_cmcp_message_get_command_id(cmcp_message)
+            == VSP_TEST_MESSAGE_COMMAND_ID, vsp_error_str(EINVAL));
+        data_item_pointer = vsp_cmcp_datalist_get_data_item(
+            vsp_cmcp_message_get_datalist(cmcp_message),
+            VSP_TEST_DATALIST_ITEM1_ID, VSP_TEST_DATALIST_ITEM1_LENGTH);
+        mu_assert_abort(data_item_pointer != NULL,
+            vsp_error_str(vsp_error_num()));
+        mu_assert(memcmp(data_item_pointer, VSP_TEST_DATALIST_ITEM1_DATA,
+            VSP_TEST_DATALIST_ITEM1_LENGTH) == 0, vsp_error_str(EINVAL));
+    }
+
+    /* deallocation; last reference frees the packet */
+    VSP_FREE(data_pointer);
+    vsp_cmcp_message_free(cmcp_message);
+    vsp_cmcp_packet_free(cmcp_packet);
+}
+
 MU_TEST_SUITE(vsp_test_cmcp_message)
 {
     MU_RUN_TEST(vsp_test_cmcp_message_test);
+    MU_RUN_TEST(vsp_test_cmcp_message_inline_test);
+    MU_RUN_TEST(vsp_test_cmcp_message_view_test);
+    MU_RUN_TEST(vsp_test_cmcp_message_batch_test);
+    MU_RUN_TEST(vsp_test_cmcp_message_trace_test);
+    MU_RUN_TEST(vsp_test_cmcp_message_packet_test);
 }
@@ -0,0 +1,130 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "minunit.h"
+#include "vsp_test.h"
+
+#include <vesper_cmcp/vsp_cmcp_queue.h>
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
+#include <errno.h>
+#include <poll.h>
+
+/** Fill a queue until messages are dropped and events are kept, then pop all
+ * entries in order. */
+MU_TEST(vsp_test_cmcp_queue_test);
+
+/** Check whether the wake-up file descriptor of a queue is readable.
+ * Returns non-zero if it is readable. */
+static int vsp_test_cmcp_queue_readable(vsp_cmcp_queue *cmcp_queue);
+
+int vsp_test_cmcp_queue_readable(vsp_cmcp_queue *cmcp_queue)
+{
+    struct pollfd poll_fd;
+
+    poll_fd.fd = vsp_cmcp_queue_get_fd(cmcp_queue);
+    poll_fd.events = POLLIN;
+    poll_fd.revents = 0;
+    return poll(&poll_fd, 1, 0) > 0 && (poll_fd.revents & POLLIN) != 0;
+}
+
+MU_TEST(vsp_test_cmcp_queue_test)
+{
+    vsp_cmcp_queue *cmcp_queue;
+    int values[VSP_TEST_RECEIVE_QUEUE_CAPACITY];
+    int index;
+    int ret;
+    uint16_t sender_id;
+    int data_length;
+    void *message_buffer;
+
+    /* invalid capacity */
+    cmcp_queue = vsp_cmcp_queue_create(0);
+    mu_assert(cmcp_queue == NULL, VSP_TEST_INVALID_PARAMETER_ACCEPTED);
+
+    /* capacity is rounded up to a power of two */
+    cmcp_queue = vsp_cmcp_queue_create(VSP_TEST_RECEIVE_QUEUE_CAPACITY - 1);
+    mu_assert_abort(cmcp_queue != NULL, vsp_error_str(vsp_error_num()));
+    mu_assert(!vsp_test_cmcp_queue_readable(cmcp_queue),
+        vsp_error_str(EINVAL));
+
+    /* fill queue */
+    for (index = 0; index < VSP_TEST_RECEIVE_QUEUE_CAPACITY; ++index) {
+        ret = vsp_cmcp_queue_push(cmcp_queue, (uint16_t) index, index,
+            &values[index]);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    }
+    mu_assert(vsp_test_cmcp_queue_readable(cmcp_queue), vsp_error_str(EINVAL));
+
+    /* full queue drops further messages and counts them */
+    ret = vsp_cmcp_queue_push(cmcp_queue, 0, 0, &values[0]);
+    mu_assert(ret != 0 && vsp_error_num() == EAGAIN, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_queue_get_count(cmcp_queue)
+        == VSP_TEST_RECEIVE_QUEUE_CAPACITY, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_queue_get_drop_count(cmcp_queue) == 1,
+        vsp_error_str(EINVAL));
+
+    /* full queue keeps events; messages must not overtake them */
+    ret = vsp_cmcp_queue_push(cmcp_queue, VSP_TEST_RECEIVE_QUEUE_CAPACITY, 0,
+        NULL);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_queue_flush(cmcp_queue) == 1, vsp_error_str(EINVAL));
+    ret = vsp_cmcp_queue_push(cmcp_queue, 0, 0, &values[0]);
+    mu_assert(ret != 0 && vsp_error_num() == EAGAIN, vsp_error_str(EINVAL));
+    mu_assert(vsp_cmcp_queue_get_drop_count(cmcp_queue) == 2,
+        vsp_error_str(EINVAL));
+
+    /* pop some entries; file descriptor stays readable */
+    for (index = 0; index < VSP_TEST_RECEIVE_QUEUE_CAPACITY / 2; ++index) {
+        ret = vsp_cmcp_queue_pop(cmcp_queue, &sender_id, &data_length,
+            &message_buffer);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+        mu_assert(sender_id == index && data_length == index
+            && message_buffer == &values[index], vsp_error_str(EINVAL));
+    }
+    vsp_cmcp_queue_acknowledge(cmcp_queue);
+    mu_assert(vsp_test_cmcp_queue_readable(cmcp_queue), vsp_error_str(EINVAL));
+
+    /* kept event is appended to the queue before the next message */
+    ret = vsp_cmcp_queue_push(cmcp_queue, 0, 0, &values[0]);
+    mu_assert(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(vsp_cmcp_queue_flush(cmcp_queue) == 0, vsp_error_str(EINVAL));
+
+    /* pop remaining entries in order */
+    for (; index < VSP_TEST_RECEIVE_QUEUE_CAPACITY; ++index) {
+        ret = vsp_cmcp_queue_pop(cmcp_queue, &sender_id, &data_length,
+            &message_buffer);
+        mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+        mu_assert(sender_id == index && data_length == index
+            && message_buffer == &values[index], vsp_error_str(EINVAL));
+    }
+    ret = vsp_cmcp_queue_pop(cmcp_queue, &sender_id, &data_length,
+        &message_buffer);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(sender_id == VSP_TEST_RECEIVE_QUEUE_CAPACITY
+        && message_buffer == NULL, vsp_error_str(EINVAL));
+    ret = vsp_cmcp_queue_pop(cmcp_queue, &sender_id, &data_length,
+        &message_buffer);
+    mu_assert_abort(ret == 0, vsp_error_str(vsp_error_num()));
+    mu_assert(sender_id == 0 && message_buffer == &values[0],
+        vsp_error_str(EINVAL));
+    ret = vsp_cmcp_queue_pop(cmcp_queue, &sender_id, &data_length,
+        &message_buffer);
+    mu_assert(ret != 0 && vsp_error_num() == EAGAIN, vsp_error_str(EINVAL));
+    vsp_cmcp_queue_acknowledge(cmcp_queue);
+    mu_assert(!vsp_test_cmcp_queue_readable(cmcp_queue),
+        vsp_error_str(EINVAL));
+
+    vsp_cmcp_queue_free(cmcp_queue);
+}
+
+MU_TEST_SUITE(vsp_test_cmcp_queue)
+{
+    MU_RUN_TEST(vsp_test_cmcp_queue_test);
+}
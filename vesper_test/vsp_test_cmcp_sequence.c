@@ -0,0 +1,198 @@
+/**
+ * \file
+ * \authors Max Mertens
+ *
+ * Copyright (c) 2014, Max Mertens. All rights reserved.
+ * This file is licensed under the "BSD 3-Clause License".
+ * Full license text is under the file "LICENSE" provided with this code.
+ */
+
+#include "minunit.h"
+#include "vsp_test.h"
+
+#include <vesper_cmcp/vsp_cmcp_sequence.h>
+#include <vesper_util/vsp_error.h>
+#include <vesper_util/vsp_util.h>
+
+/** Check sequences in order, with gaps, late messages and wrap-around. */
+MU_TEST(vsp_test_cmcp_sequence_test);
+
+/** Track many pairs of sender and topic ID, so the table has to grow. */
+MU_TEST(vsp_test_cmcp_sequence_grow_test);
+
+/** Remove senders and check the sequences of the remaining ones. */
+MU_TEST(vsp_test_cmcp_sequence_remove_test);
+
+/** Assign sequence numbers to sent messages of many topics. */
+MU_TEST(vsp_test_cmcp_sequence_next_test);
+
+MU_TEST(vsp_test_cmcp_sequence_test)
+{
+    vsp_cmcp_sequence *cmcp_sequence;
+    uint32_t expected_sequence;
+    int32_t difference;
+
+    cmcp_sequence = vsp_cmcp_sequence_create();
+    mu_assert_abort(cmcp_sequence != NULL, vsp_error_str(vsp_error_num()));
+
+    /* first message starts the sequence, following one is in order */
+    difference = vsp_cmcp_sequence_check(cmcp_sequence,
+        VSP_TEST_MESSAGE_SENDER_ID, VSP_TEST_MESSAGE_TOPIC_ID,
+        VSP_TEST_TRACE_SEQUENCE, &expected_sequence);
+    mu_assert(difference == 0 && expected_sequence == VSP_TEST_TRACE_SEQUENCE,
+        vsp_error_str(EINVAL));
+    difference = vsp_cmcp_sequence_check(cmcp_sequence,
+        VSP_TEST_MESSAGE_SENDER_ID, VSP_TEST_MESSAGE_TOPIC_ID,
+        VSP_TEST_TRACE_SEQUENCE + 1, &expected_sequence);
+    mu_assert(difference == 0
+        && expected_sequence == VSP_TEST_TRACE_SEQUENCE + 1,
+        vsp_error_str(EINVAL));
+
+    /* other topic of the same sender has its own sequence */
+    difference = vsp_cmcp_sequence_check(cmcp_sequence,
+        VSP_TEST_MESSAGE_SENDER_ID, VSP_TEST_MESSAGE_TOPIC_ID + 1, 0,
+        &expected_sequence);
+    mu_assert(difference == 0, vsp_error_str(EINVAL));
+
+    /* skipped sequence numbers are reported as gap */
+    difference = vsp_cmcp_sequence_check(cmcp_sequence,
+        VSP_TEST_MESSAGE_SENDER_ID, VSP_TEST_MESSAGE_TOPIC_ID,
+        VSP_TEST_TRACE_SEQUENCE + 5, &expected_sequence);
+    mu_assert(difference == 3
+        && expected_sequence == VSP_TEST_TRACE_SEQUENCE + 2,
+        vsp_error_str(EINVAL));
+
+    /* late message does not change the expected sequence number */
+    difference = vsp_cmcp_sequence_check(cmcp_sequence,
+        VSP_TEST_MESSAGE_SENDER_ID, VSP_TEST_MESSAGE_TOPIC_ID,
+        VSP_TEST_TRACE_SEQUENCE + 3, &expected_sequence);
+    mu_assert(difference == -3
+        && expected_sequence == VSP_TEST_TRACE_SEQUENCE + 6,
+        vsp_error_str(EINVAL));
+    difference = vsp_cmcp_sequence_check(cmcp_sequence,
+        VSP_TEST_MESSAGE_SENDER_ID, VSP_TEST_MESSAGE_TOPIC_ID,
+        VSP_TEST_TRACE_SEQUENCE + 6, &expected_sequence);
+    mu_assert(difference == 0, vsp_error_str(EINVAL));
+
+    /* sequence numbers wrap around without gap */
+    difference = vsp_cmcp_sequence_check(cmcp_sequence,
+        VSP_TEST_MESSAGE_SENDER_ID + 1, VSP_TEST_MESSAGE_TOPIC_ID,
+        UINT32_MAX, &expected_sequence);
+    mu_assert(difference == 0, vsp_error_str(EINVAL));
+    difference = vsp_cmcp_sequence_check(cmcp_sequence,
+        VSP_TEST_MESSAGE_SENDER_ID + 1, VSP_TEST_MESSAGE_TOPIC_ID, 0,
+        &expected_sequence);
+    mu_assert(difference == 0 && expected_sequence == 0,
+        vsp_error_str(EINVAL));
+
+    vsp_cmcp_sequence_free(cmcp_sequence);
+}
+
+MU_TEST(vsp_test_cmcp_sequence_grow_test)
+{
+    vsp_cmcp_sequence *cmcp_sequence;
+    uint32_t expected_sequence;
+    int32_t difference;
+    uint16_t sender_id;
+    int round;
+
+    cmcp_sequence = vsp_cmcp_sequence_create();
+    mu_assert_abort(cmcp_sequence != NULL, vsp_error_str(vsp_error_num()));
+
+    /* every sender keeps its own sequence while the table grows */
+    for (round = 0; round < 2; ++round) {
+        for (sender_id = 0; sender_id < VSP_TEST_SEQUENCE_SENDER_COUNT;
+            ++sender_id) {
+            difference = vsp_cmcp_sequence_check(cmcp_sequence, sender_id,
+                VSP_TEST_MESSAGE_TOPIC_ID, sender_id + (uint32_t) round,
+                &expected_sequence);
+            mu_assert_abort(difference == 0
+                && expected_sequence == sender_id + (uint32_t) round,
+                vsp_error_str(EINVAL));
+        }
+    }
+
+    vsp_cmcp_sequence_free(cmcp_sequence);
+}
+
+MU_TEST(vsp_test_cmcp_sequence_remove_test)
+{
+    vsp_cmcp_sequence *cmcp_sequence;
+    uint32_t expected_sequence;
+    int32_t difference;
+    uint16_t sender_id;
+
+    cmcp_sequence = vsp_cmcp_sequence_create();
+    mu_assert_abort(cmcp_sequence != NULL, vsp_error_str(vsp_error_num()));
+
+    /* start sequences of two topics per sender */
+    for (sender_id = 0; sender_id < VSP_TEST_SEQUENCE_SENDER_COUNT;
+        ++sender_id) {
+        vsp_cmcp_sequence_check(cmcp_sequence, sender_id,
+            VSP_TEST_MESSAGE_TOPIC_ID, sender_id, &expected_sequence);
+        vsp_cmcp_sequence_check(cmcp_sequence, sender_id,
+            VSP_TEST_MESSAGE_TOPIC_ID + 1, sender_id, &expected_sequence);
+    }
+
+    /* remove every other sender, including all of its topics */
+    for (sender_id = 0; sender_id < VSP_TEST_SEQUENCE_SENDER_COUNT;
+        sender_id += 2) {
+        vsp_cmcp_sequence_remove(cmcp_sequence, sender_id);
+    }
+    /* removing an unknown sender does nothing */
+    vsp_cmcp_sequence_remove(cmcp_sequence, VSP_TEST_SEQUENCE_SENDER_COUNT);
+
+    /* removed senders start new sequences, the others continue theirs */
+    for (sender_id = 0; sender_id < VSP_TEST_SEQUENCE_SENDER_COUNT;
+        ++sender_id) {
+        difference = vsp_cmcp_sequence_check(cmcp_sequence, sender_id,
+            VSP_TEST_MESSAGE_TOPIC_ID + 1, VSP_TEST_TRACE_SEQUENCE,
+            &expected_sequence);
+        if (sender_id % 2 == 0) {
+            mu_assert_abort(difference == 0
+                && expected_sequence == VSP_TEST_TRACE_SEQUENCE,
+                vsp_error_str(EINVAL));
+        } else {
+            mu_assert_abort(expected_sequence == sender_id + (uint32_t) 1,
+                vsp_error_str(EINVAL));
+        }
+    }
+
+    vsp_cmcp_sequence_free(cmcp_sequence);
+}
+
+MU_TEST(vsp_test_cmcp_sequence_next_test)
+{
+    vsp_cmcp_sequence *cmcp_sequence;
+    uint32_t sequence;
+    uint16_t topic_id;
+    int round;
+
+    cmcp_sequence = vsp_cmcp_sequence_create();
+    mu_assert_abort(cmcp_sequence != NULL, vsp_error_str(vsp_error_num()));
+
+    /* every topic counts its own sequence from zero while the table grows */
+    for (round = 0; round < 2; ++round) {
+        for (topic_id = 0; topic_id < VSP_TEST_SEQUENCE_SENDER_COUNT;
+            ++topic_id) {
+            sequence = vsp_cmcp_sequence_next(cmcp_sequence,
+                VSP_TEST_MESSAGE_SENDER_ID, topic_id);
+            mu_assert_abort(sequence == (uint32_t) round,
+                vsp_error_str(EINVAL));
+        }
+    }
+    /* another sender on the same topic starts its own sequence */
+    sequence = vsp_cmcp_sequence_next(cmcp_sequence,
+        VSP_TEST_MESSAGE_SENDER_ID + 1, 0);
+    mu_assert(sequence == 0, vsp_error_str(EINVAL));
+
+    vsp_cmcp_sequence_free(cmcp_sequence);
+}
+
+MU_TEST_SUITE(vsp_test_cmcp_sequence)
+{
+    MU_RUN_TEST(vsp_test_cmcp_sequence_test);
+    MU_RUN_TEST(vsp_test_cmcp_sequence_grow_test);
+    MU_RUN_TEST(vsp_test_cmcp_sequence_remove_test);
+    MU_RUN_TEST(vsp_test_cmcp_sequence_next_test);
+}
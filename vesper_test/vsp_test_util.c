@@ -26,6 +26,12 @@ MU_TEST(vsp_test_random_test);
 /** Check time measurement functions. */
 MU_TEST(vsp_test_time_test);
 
+/** Check timespec arithmetic functions. */
+MU_TEST(vsp_test_timespec_test);
+
+/** Check that the monotonic clock does not fall back to real time. */
+MU_TEST(vsp_test_monotonic_test);
+
 MU_TEST(vsp_test_error_test)
 {
     int error;
@@ -67,9 +73,11 @@ MU_TEST(vsp_test_time_test)
 {
     double realtime_before, realtime_after;
     double cputime_before, cputime_after;
+    uint64_t monotonic_before, monotonic_after;
 
     realtime_before = vsp_time_real_double();
     cputime_before = vsp_time_cpu_double();
+    monotonic_before = vsp_time_monotonic_nanoseconds();
 
     do {
         realtime_after = vsp_time_real_double();
@@ -80,6 +88,54 @@ MU_TEST(vsp_test_time_test)
     /* check if duration is positive */
     mu_assert(realtime_after > realtime_before, "Real time values invalid.");
     mu_assert(cputime_after > cputime_before, "CPU time values invalid.");
+    monotonic_after = vsp_time_monotonic_nanoseconds();
+    mu_assert(monotonic_after > monotonic_before,
+        "Monotonic time values invalid.");
+}
+
+MU_TEST(vsp_test_timespec_test)
+{
+    struct timespec time;
+    struct timespec now;
+
+    /* add milliseconds with nanosecond overflow */
+    now.tv_sec = 10;
+    now.tv_nsec = 600000000l;
+    time = now;
+    vsp_time_timespec_add(&time, 1400);
+    mu_assert(time.tv_sec == 12 && time.tv_nsec == 0,
+        "Time addition invalid.");
+
+    /* check passed time against a single reading */
+    mu_assert(vsp_time_timespec_passed(&time, &now) != 0,
+        "Future time reported as passed.");
+    mu_assert(vsp_time_timespec_passed(&now, &time) == 0,
+        "Past time not reported as passed.");
+
+    /* check remaining time, rounded up to whole milliseconds */
+    mu_assert(vsp_time_timespec_milliseconds_until(&time, &now) == 1400,
+        "Remaining time invalid.");
+    now.tv_nsec += 1;
+    mu_assert(vsp_time_timespec_milliseconds_until(&time, &now) == 1400,
+        "Remaining time not rounded up.");
+    mu_assert(vsp_time_timespec_milliseconds_until(&now, &time) == 0,
+        "Remaining time of past time invalid.");
+}
+
+MU_TEST(vsp_test_monotonic_test)
+{
+#if defined __linux__
+    struct timespec now;
+    uint64_t realtime;
+    uint64_t monotonic;
+
+    vsp_time_real_timespec(&now);
+    realtime = (uint64_t) now.tv_sec * 1000000000 + (uint64_t) now.tv_nsec;
+    monotonic = vsp_time_monotonic_nanoseconds();
+    /* CLOCK_MONOTONIC counts from boot, far less than time since epoch */
+    mu_assert(monotonic < realtime / 2,
+        "Monotonic time falls back to real time.");
+#endif /* defined __linux__ */
 }
 
 MU_TEST_SUITE(vsp_test_util)
@@ -87,4 +143,6 @@ MU_TEST_SUITE(vsp_test_util)
     MU_RUN_TEST(vsp_test_error_test);
     MU_RUN_TEST(vsp_test_random_test);
     MU_RUN_TEST(vsp_test_time_test);
+    MU_RUN_TEST(vsp_test_timespec_test);
+    MU_RUN_TEST(vsp_test_monotonic_test);
 }
@@ -6,6 +6,13 @@
  * Full license text is under the file "LICENSE" provided with this code.
  */
 
+#if !defined(_WIN32) \
+    && (!defined(_POSIX_C_SOURCE) || _POSIX_C_SOURCE < 200112L)
+  /* clock_gettime() is not declared in strict C89 mode otherwise */
+  #undef _POSIX_C_SOURCE
+  #define _POSIX_C_SOURCE 200112L
+#endif /* !defined(_POSIX_C_SOURCE) || _POSIX_C_SOURCE < 200112L */
+
 #include "vsp_time.h"
 #include "vsp_util.h"
 
@@ -76,10 +83,22 @@ void vsp_time_real_timespec_from_now(struct timespec *time,
     unsigned int milliseconds)
 {
     vsp_time_real_timespec(time);
+    vsp_time_timespec_add(time, milliseconds);
+}
+
+int vsp_time_real_timespec_passed(struct timespec *time)
+{
+    struct timespec now;
+    vsp_time_real_timespec(&now);
+    return vsp_time_timespec_passed(time, &now);
+}
+
+void vsp_time_timespec_add(struct timespec *time, unsigned int milliseconds)
+{
     /* add fractional seconds */
     time->tv_nsec += (milliseconds % 1000) * 1000000l;
     /* remove overflow */
-    if (time->tv_nsec > 1000000000l) {
+    if (time->tv_nsec >= 1000000000l) {
         time->tv_nsec -= 1000000000l;
         time->tv_sec += 1;
     }
@@ -87,18 +106,38 @@ void vsp_time_real_timespec_from_now(struct timespec *time,
     time->tv_sec += milliseconds / 1000;
 }
 
-int vsp_time_real_timespec_passed(struct timespec *time)
+int vsp_time_timespec_passed(const struct timespec *time,
+    const struct timespec *now)
 {
-    struct timespec now;
-    vsp_time_real_timespec(&now);
-    if (now.tv_sec > time->tv_sec
-        || (now.tv_sec == time->tv_sec && now.tv_nsec > time->tv_nsec)) {
+    if (now->tv_sec > time->tv_sec
+        || (now->tv_sec == time->tv_sec && now->tv_nsec > time->tv_nsec)) {
         return 0;
     } else {
         return -1;
     }
 }
 
+unsigned int vsp_time_timespec_milliseconds_until(const struct timespec *time,
+    const struct timespec *now)
+{
+    long seconds;
+    long nanoseconds;
+
+    if (vsp_time_timespec_passed(time, now) == 0) {
+        /* time has passed */
+        return 0;
+    }
+    seconds = (long) (time->tv_sec - now->tv_sec);
+    nanoseconds = time->tv_nsec - now->tv_nsec;
+    /* borrow a second to keep nanoseconds non-negative */
+    if (nanoseconds < 0) {
+        nanoseconds += 1000000000l;
+        seconds -= 1;
+    }
+    /* round up partial milliseconds */
+    return (unsigned int) (seconds * 1000 + (nanoseconds + 999999l) / 1000000l);
+}
+
 double vsp_time_real_double(void)
 {
     struct timespec time;
@@ -106,6 +145,35 @@ double vsp_time_real_double(void)
     return ((double) time.tv_sec) + ((double) time.tv_nsec / 1000000000.0);
 }
 
+uint64_t vsp_time_monotonic_nanoseconds(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    /* convert seconds and remainder separately to avoid overflows */
+    return (uint64_t) (counter.QuadPart / frequency.QuadPart) * 1000000000
+        + (uint64_t) (counter.QuadPart % frequency.QuadPart) * 1000000000
+        / (uint64_t) frequency.QuadPart;
+
+#else
+    struct timespec time;
+    #if defined(_POSIX_C_SOURCE) && _POSIX_C_SOURCE >= 200112L \
+        && defined(_POSIX_TIMERS) && (_POSIX_TIMERS > 0) \
+        && defined(CLOCK_MONOTONIC)
+    if (clock_gettime(CLOCK_MONOTONIC, &time) != -1) {
+        return (uint64_t) time.tv_sec * 1000000000
+            + (uint64_t) time.tv_nsec;
+    }
+    /* else fall through */
+    #endif /* defined(_POSIX_TIMERS) && defined(CLOCK_MONOTONIC) */
+    /* fall back to real time */
+    vsp_time_real_timespec(&time);
+    return (uint64_t) time.tv_sec * 1000000000 + (uint64_t) time.tv_nsec;
+#endif /* defined(_WIN32) */
+}
+
 /*
  * The following function was written by David Robert Nadeau
  * from http://NadeauSoftware.com/ and distributed under the
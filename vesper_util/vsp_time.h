@@ -10,6 +10,8 @@
 #if !defined VSP_TIME_H_INCLUDED
 #define VSP_TIME_H_INCLUDED
 
+#include <stdint.h>
+
 #if defined __cplusplus
 extern "C" {
 #endif /* defined __cplusplus */
@@ -53,11 +55,37 @@ void vsp_time_real_timespec_from_now(struct timespec *time,
  */
 int vsp_time_real_timespec_passed(struct timespec *time);
 
+/**
+ * Add an amount of milliseconds to a timespec struct.
+ */
+void vsp_time_timespec_add(struct timespec *time, unsigned int milliseconds);
+
+/**
+ * Returns zero if a specified time has passed at the time specified by now.
+ * This allows checking many times against a single clock reading.
+ */
+int vsp_time_timespec_passed(const struct timespec *time,
+    const struct timespec *now);
+
+/**
+ * Get the number of milliseconds from now until a specified time, rounded up.
+ * Returns zero if the time has already passed.
+ */
+unsigned int vsp_time_timespec_milliseconds_until(const struct timespec *time,
+    const struct timespec *now);
+
 /**
  * Get real (wall clock) time since epoch in seconds.
  */
 double vsp_time_real_double(void);
 
+/**
+ * Get monotonic time in nanoseconds since an arbitrary start time.
+ * Unlike the real time, it does not jump when the wall clock is adjusted,
+ * so it is used for measuring elapsed times.
+ */
+uint64_t vsp_time_monotonic_nanoseconds(void);
+
 /**
  * Get the amount of CPU time used by the current process in seconds.
  * Returns -1.0 if an error occurred.